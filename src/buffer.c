@@ -3,24 +3,67 @@
 //       01/08/2026
 
 #include "buffer.h"
+#include "checksum.h"
 #include "db-init.h"
 #include "globals.h"
+#include "page-compress.h"
+#include "wal.h"
 #include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
 
-BufferPool *createBufferPool() {
+// What a thread that entered a pool keeps of it
+typedef struct {
+    BufferPool *pool;         // NULL while the thread is in no pool
+    PoolAccess access;
+    PageWindow window;        // POOL_WRITE, the frames are latched exclusively
+    char *copies;             // POOL_READ, two pages the last reads were copied to
+    size_t copy_size;         // Bytes of each copy, the page size of the largest pool read so far
+    int next_copy;
+} PoolSession;
+
+static _Thread_local PoolSession session;
+
+// The copies outlive a session so a thread allocates them once, they are freed when it exits
+static pthread_key_t copies_key;
+static pthread_once_t copies_key_once = PTHREAD_ONCE_INIT;
+
+static void createCopiesKey(void) { pthread_key_create(&copies_key, free); }
+
+BufferPool *createBufferPool(size_t page_size) {
     BufferPool *buffer = malloc(sizeof(BufferPool));
-    buffer->num_pages = 0;
-    buffer->pages = malloc(sizeof(char *) * BUFFER_SIZE);
-    buffer->page_ids = malloc(sizeof(size_t) * BUFFER_SIZE);
-    buffer->dirty_flags = malloc(sizeof(int) * BUFFER_SIZE);
+    if (!buffer) {
+        return NULL;
+    }
+    buffer->frames = calloc(BUFFER_SIZE, sizeof(BufferFrame));
+    if (!buffer->frames) {
+        free(buffer);
+        return NULL;
+    }
 
     for (int i = 0; i < BUFFER_SIZE; i++) {
-        buffer->pages[i] = malloc(PAGE_SIZE);
-        buffer->dirty_flags[i] = 0;
+        buffer->frames[i].next = -1;
+        pthread_rwlock_init(&buffer->frames[i].latch, NULL);
     }
+    for (int p = 0; p < BUFFER_PARTITIONS; p++) {
+        pthread_mutex_init(&buffer->partitions[p].lock, NULL);
+        buffer->partitions[p].head = -1;
+    }
+    pthread_mutex_init(&buffer->clock_lock, NULL);
+    buffer->clock_hand = 0;
+    buffer->page_size = page_size;
+    buffer->window.frames[0] = -1;
+    buffer->window.frames[1] = -1;
+    buffer->no_steal = 0;
+    pthread_mutex_init(&buffer->deferred_lock, NULL);
+    buffer->deferred = NULL;
+    buffer->deferred_count = 0;
+    buffer->deferred_capacity = 0;
+    buffer->checksums = 0;
+    buffer->wal = NULL;
 
     return (buffer);
 }
@@ -31,131 +74,609 @@ int freeBufferPool(BufferPool *buffer) {
         return 0;
     }
 
-    free(buffer->dirty_flags);
-    free(buffer->page_ids);
-
-    for (int i = 0; i < buffer->num_pages; i++) {
-        free(buffer->pages[i]);
+    for (int i = 0; i < BUFFER_SIZE; i++) {
+        free(buffer->frames[i].page);
+        free(buffer->frames[i].base);
+        pthread_rwlock_destroy(&buffer->frames[i].latch);
+    }
+    free(buffer->frames);
+    for (int p = 0; p < BUFFER_PARTITIONS; p++) {
+        pthread_mutex_destroy(&buffer->partitions[p].lock);
     }
 
-    free(buffer->pages);
+    for (size_t i = 0; i < buffer->deferred_count; i++) {
+        free(buffer->deferred[i].page);
+        free(buffer->deferred[i].base);
+    }
+    free(buffer->deferred);
+    pthread_mutex_destroy(&buffer->deferred_lock);
+    pthread_mutex_destroy(&buffer->clock_lock);
     free(buffer);
 
     return 0;
 }
 
-int flushPage(BufferPool *buffer, MagBase *db, int pageIndex) {
+static BufferPartition *partitionOf(BufferPool *buffer, size_t pageId) {
+    return &buffer->partitions[pageId & (BUFFER_PARTITIONS - 1)];
+}
+
+// Find the frame holding a page, the caller holds the lock of its partition
+// Returns the frame, or -1 if the page is not in the pool
+static int findFrame(BufferPool *buffer, BufferPartition *partition, size_t pageId) {
+    for (int f = partition->head; f >= 0; f = buffer->frames[f].next) {
+        if (buffer->frames[f].page_id == pageId) {
+            return f;
+        }
+    }
+    return -1;
+}
+
+// Take a frame out of its partition, the caller holds the lock of the partition
+static void unlinkFrame(BufferPool *buffer, BufferPartition *partition, int frame) {
+    int *link = &partition->head;
+    while (*link != frame) {
+        link = &buffer->frames[*link].next;
+    }
+    *link = buffer->frames[frame].next;
+    buffer->frames[frame].next = -1;
+    buffer->frames[frame].flags = 0;
+}
+
+// Drop a pin, the page id of a pinned frame does not change so it finds the partition
+static void unpinFrame(BufferPool *buffer, int frame) {
+    BufferPartition *partition = partitionOf(buffer, buffer->frames[frame].page_id);
+    pthread_mutex_lock(&partition->lock);
+    buffer->frames[frame].pins--;
+    pthread_mutex_unlock(&partition->lock);
+}
+
+// Write one page at its place in the file, after the log it depends on and sealing it first when
+// the pool has checksums. With compress it may be stored as a compressed image
+// Returns 0 on success, -1 on error
+static int writePage(BufferPool *buffer, int fd, size_t pageId, char *page, size_t page_size, bool compress) {
+    if (buffer->wal && walSync(buffer->wal) != 0) {
+        return -1;
+    }
+    if (buffer->checksums) {
+        sealPage(page, page_size);
+    }
+    return storePage(fd, pageId, page, page_size, compress);
+}
 
-    if (!buffer || !db || pageIndex < 0 ||
-        pageIndex >= buffer->num_pages) // Make sure all parameters are valid
+// Read a page from its slot in the file, expanding a compressed image. A page past the end of
+// the file reads as zeros. With a logged image (image_length bytes), a page that fails or that
+// has no checksum to tell whether it is whole is replaced by the image
+// Returns 1 if it was stored compressed, 0 if not, -1 on error or if it fails its checksum
+static int loadPage(BufferPool *buffer, int fd, size_t pageId, char *page, size_t page_size, const char *image,
+                    size_t image_length) {
+    ssize_t bytes_read = pread(fd, page, page_size, (off_t)(pageId * page_size));
+    if (bytes_read < 0) {
         return -1;
+    }
+    memset(page + bytes_read, 0, page_size - (size_t)bytes_read);
+
+    // An image is shorter than its slot when it is the last page of the file
+    int expanded = expandPage(page, page_size);
+    if (expanded == 0 && (size_t)bytes_read < page_size) {
+        // A new page
+        memset(page, 0, page_size);
+        return 0;
+    }
+    if (expanded < 0 || !buffer->checksums || !pageChecksumValid(page, page_size)) {
+        if (image) {
+            memcpy(page, image, image_length);
+            memset(page + image_length, 0, page_size - image_length);
+            return 0;
+        }
+        if (expanded < 0 || buffer->checksums) {
+            fprintf(stderr, "Page %zu failed its checksum, the file is corrupted\n", pageId);
+            return -1;
+        }
+    }
+    return expanded;
+}
 
-    if (fseek(db->file_pointer, buffer->page_ids[pageIndex] * PAGE_SIZE, SEEK_SET) != 0) {
-        fprintf(stderr, "Failed to seek while flushing file");
+// Move the pending page of a frame to the deferred list, the frame gives up its page buffers.
+// The base image is committed but may not be in the file yet, it is written first so a rollback
+// can drop the page. The caller holds the lock of the frame's partition
+static int deferPage(BufferPool *buffer, BufferFrame *frame, int fd, size_t page_size) {
+    bool compress = (frame->flags & FRAME_COMPRESS) != 0;
+    if (writePage(buffer, fd, frame->page_id, frame->base, page_size, compress) != 0) {
+        fprintf(stderr, "Failed to write back page %zu on eviction\n", frame->page_id);
+        return -1;
     }
-    if (fwrite(buffer->pages[pageIndex], PAGE_SIZE, 1, db->file_pointer) != 0) {
-        fprintf(stderr, "Failed to write while flushing file");
+
+    pthread_mutex_lock(&buffer->deferred_lock);
+    if (buffer->deferred_count == buffer->deferred_capacity) {
+        size_t capacity = buffer->deferred_capacity ? buffer->deferred_capacity * 2 : 16;
+        DeferredPage *grown = realloc(buffer->deferred, capacity * sizeof(DeferredPage));
+        if (!grown) {
+            pthread_mutex_unlock(&buffer->deferred_lock);
+            return -1;
+        }
+        buffer->deferred = grown;
+        buffer->deferred_capacity = capacity;
     }
 
-    fflush(db->file_pointer); // Ensure OS wrote file
-    buffer->dirty_flags[pageIndex] = 0;
+    DeferredPage *deferred = &buffer->deferred[buffer->deferred_count++];
+    deferred->page_id = frame->page_id;
+    deferred->page = frame->page;
+    deferred->base = frame->base;
+    deferred->compress = compress;
+    pthread_mutex_unlock(&buffer->deferred_lock);
+
+    frame->page = NULL;
+    frame->base = NULL;
+    frame->flags &= (uint8_t)~(FRAME_PENDING | FRAME_DIRTY);
     return 0;
 }
 
-int addToBuffer(BufferPool *buffer, size_t pageId, char *pageData, MagBase *db) {
-    if (!buffer) {
-        return 0;
+// Bring a deferred page back into a frame
+// Returns 1 if the page was deferred, 0 otherwise
+static int undeferPage(BufferPool *buffer, size_t pageId, BufferFrame *frame) {
+    pthread_mutex_lock(&buffer->deferred_lock);
+    for (size_t i = 0; i < buffer->deferred_count; i++) {
+        if (buffer->deferred[i].page_id != pageId) {
+            continue;
+        }
+
+        free(frame->page);
+        free(frame->base);
+        frame->page = buffer->deferred[i].page;
+        frame->base = buffer->deferred[i].base;
+        frame->flags |= FRAME_PENDING | FRAME_DIRTY;
+        if (buffer->deferred[i].compress) {
+            frame->flags |= FRAME_COMPRESS;
+        }
+        buffer->deferred[i] = buffer->deferred[--buffer->deferred_count];
+        pthread_mutex_unlock(&buffer->deferred_lock);
+        return 1;
     }
+    pthread_mutex_unlock(&buffer->deferred_lock);
+    return 0;
+}
+
+// Write back or defer the page of an unpinned frame and take it out of its partition, the caller
+// holds the lock of the partition
+// Returns 0 on success, -1 on error
+static int evictFrame(BufferPool *buffer, BufferPartition *partition, int f, int fd, size_t page_size) {
+    BufferFrame *frame = &buffer->frames[f];
 
-    size_t positionInBuffer = -1; // The loop below checks the buffer to see if the page id
-                                  // already exists, if it doesn't the value stays -1
-    for (int i = 0; i < buffer->num_pages; i++) {
-        if (buffer->page_ids[i] == pageId) { // If the page is in the buffer, move it to the front
-            positionInBuffer = pageId;
+    // An uncommitted page may not reach the file before its log records, park it in memory
+    if (buffer->no_steal && (frame->flags & FRAME_PENDING)) {
+        if (deferPage(buffer, frame, fd, page_size) != 0) {
+            return -1;
+        }
+    } else if (frame->flags & FRAME_DIRTY) {
+        // Write the victim back first, dropping it would lose the modification
+        bool compress = (frame->flags & FRAME_COMPRESS) != 0;
+        if (writePage(buffer, fd, frame->page_id, frame->page, page_size, compress) != 0) {
+            fprintf(stderr, "Failed to write back page %zu on eviction\n", frame->page_id);
+            return -1;
         }
     }
+    unlinkFrame(buffer, partition, f);
+    return 0;
+}
 
-    if (positionInBuffer != -1) { // If in buffer move to front
-        char *temp = buffer->pages[positionInBuffer];
-        memmove(&buffer->pages[1], &buffer->pages[0], sizeof(char *) * positionInBuffer);
-        buffer->pages[0] = temp;
-        buffer->dirty_flags[0] = 1;
-        return 0;
+// Take a frame for pageId, evicting the page it holds, and link it pinned into partition. The
+// caller holds the lock of partition, the partitions of victims are only tried so two threads
+// loading pages never wait on each other. Frames that were used since the hand last passed
+// get a second chance
+// Returns the frame, or -1 if every frame stays pinned or on error
+static int claimFrame(BufferPool *buffer, BufferPartition *partition, size_t pageId, int fd, size_t page_size) {
+    pthread_mutex_lock(&buffer->clock_lock);
+
+    int claimed = -1;
+    for (int step = 0; step < BUFFER_SIZE * 4 && claimed < 0; step++) {
+        int f = buffer->clock_hand;
+        buffer->clock_hand = (buffer->clock_hand + 1) % BUFFER_SIZE;
+
+        // A frame's page id only changes under clock_lock, so it names the partition to lock
+        BufferFrame *frame = &buffer->frames[f];
+        BufferPartition *victim = partitionOf(buffer, frame->page_id);
+        if (victim != partition && pthread_mutex_trylock(&victim->lock) != 0) {
+            continue;
+        }
+
+        int status = 0;
+        if (!(frame->flags & FRAME_IN_USE)) {
+            claimed = f;
+        } else if (frame->pins == 0) {
+            if (frame->flags & FRAME_REFERENCED) {
+                frame->flags &= (uint8_t)~FRAME_REFERENCED;
+            } else if ((status = evictFrame(buffer, victim, f, fd, page_size)) == 0) {
+                claimed = f;
+            }
+        }
+        if (victim != partition) {
+            pthread_mutex_unlock(&victim->lock);
+        }
+        if (status != 0) {
+            pthread_mutex_unlock(&buffer->clock_lock);
+            return -1;
+        }
+    }
+
+    if (claimed < 0) {
+        pthread_mutex_unlock(&buffer->clock_lock);
+        fprintf(stderr, "Every buffer frame is pinned, page %zu cannot be loaded\n", pageId);
+        return -1;
+    }
+
+    BufferFrame *frame = &buffer->frames[claimed];
+    if (!frame->page) {
+        frame->page = malloc(buffer->page_size);
+    }
+    if (buffer->no_steal && !frame->base) {
+        frame->base = malloc(buffer->page_size);
+    }
+    if (!frame->page || (buffer->no_steal && !frame->base)) {
+        pthread_mutex_unlock(&buffer->clock_lock);
+        return -1;
+    }
+
+    frame->page_id = pageId;
+    frame->flags = FRAME_IN_USE | FRAME_REFERENCED;
+    frame->pins = 1;
+    frame->next = partition->head;
+    partition->head = claimed;
+    pthread_mutex_unlock(&buffer->clock_lock);
+    return claimed;
+}
+
+// Pin the frame holding a page, reading the page into a claimed frame when the pool does not
+// hold it (see loadPage for image). The partition stays locked while the page is read, so a
+// page is only read once
+// Returns the frame, or -1 on error or if the page fails its checksum
+static int pinPage(BufferPool *buffer, size_t pageId, int fd, size_t page_size, const char *image,
+                   size_t image_length) {
+    BufferPartition *partition = partitionOf(buffer, pageId);
+    pthread_mutex_lock(&partition->lock);
+
+    int f = findFrame(buffer, partition, pageId);
+    if (f >= 0) {
+        buffer->frames[f].pins++;
+        buffer->frames[f].flags |= FRAME_REFERENCED;
+        pthread_mutex_unlock(&partition->lock);
+        return f;
+    }
+
+    f = claimFrame(buffer, partition, pageId, fd, page_size);
+    if (f < 0) {
+        pthread_mutex_unlock(&partition->lock);
+        return -1;
+    }
+    BufferFrame *frame = &buffer->frames[f];
+
+    // A parked uncommitted page is newer than the file
+    if (buffer->no_steal && undeferPage(buffer, pageId, frame)) {
+        pthread_mutex_unlock(&partition->lock);
+        return f;
+    }
+
+    int loaded = loadPage(buffer, fd, pageId, frame->page, page_size, image, image_length);
+    if (loaded < 0) {
+        // Leave the frame empty-handed so the next lookup reads the page again
+        unlinkFrame(buffer, partition, f);
+        frame->pins = 0;
+        pthread_mutex_unlock(&partition->lock);
+        return -1;
+    }
+    // A page stored compressed stays compressed
+    if (loaded > 0) {
+        frame->flags |= FRAME_COMPRESS;
     }
 
-    if (buffer->num_pages == BUFFER_SIZE) { // If the buffer is full, then flush oldest
-        if (buffer->dirty_flags[BUFFER_SIZE - 1]) {
-            flushPage(buffer, db, BUFFER_SIZE - 1);
+    if (buffer->no_steal) {
+        memcpy(frame->base, frame->page, page_size);
+    }
+    pthread_mutex_unlock(&partition->lock);
+    return f;
+}
+
+// Unpin (and unlatch) every page of a window
+static void releaseWindow(BufferPool *buffer, PageWindow *window, bool latched) {
+    for (int i = 0; i < 2; i++) {
+        int f = window->frames[i];
+        if (f < 0) {
+            continue;
+        }
+        if (latched) {
+            pthread_rwlock_unlock(&buffer->frames[f].latch);
         }
-        buffer->num_pages--;
+        unpinFrame(buffer, f);
+        window->frames[i] = -1;
+    }
+}
+
+// Before a thread latches frames itself it lets go of the ones its window holds
+static void releaseSessionWindow(BufferPool *buffer) {
+    if (session.pool == buffer && session.access == POOL_WRITE) {
+        releaseWindow(buffer, &session.window, true);
     }
+}
 
-    memmove(&buffer->pages[1], &buffer->pages[0],
-            sizeof(char *) * buffer->num_pages); // Shifts down all the pointers in memory the
-                                                 // size of a char pointer
-    memcpy(buffer->pages[0], pageData,
-           PAGE_SIZE); // Copies the data of the pageData to the first slot in the array
-    buffer->page_ids[0] = pageId;
-    buffer->dirty_flags[0] = 1;
-    buffer->num_pages++;
+int enterBufferPool(BufferPool *buffer, PoolAccess access) {
+    if (!buffer || session.pool) {
+        return -1;
+    }
 
+    if (access == POOL_READ && session.copy_size < buffer->page_size) {
+        pthread_once(&copies_key_once, createCopiesKey);
+        char *copies = realloc(session.copies, 2 * buffer->page_size);
+        if (!copies) {
+            return -1;
+        }
+        session.copies = copies;
+        session.copy_size = buffer->page_size;
+        pthread_setspecific(copies_key, session.copies);
+    }
+
+    session.pool = buffer;
+    session.access = access;
+    session.window.frames[0] = -1;
+    session.window.frames[1] = -1;
     return 0;
 }
 
-char *readPageFromBuffer(BufferPool *buffer, size_t pageId, FILE *file_pointer, size_t page_size) {
-    if (!buffer || !file_pointer) {
+void leaveBufferPool(BufferPool *buffer) {
+    if (!buffer || session.pool != buffer) {
+        return;
+    }
+    releaseSessionWindow(buffer);
+    session.pool = NULL;
+}
+
+bool isPoolWriter(BufferPool *buffer) { return session.pool != buffer || session.access != POOL_READ; }
+
+void releasePageWindow(BufferPool *buffer) {
+    if (buffer) {
+        releaseSessionWindow(buffer);
+    }
+}
+
+// Copy a page out under a shared latch, for POOL_READ threads
+static char *copyPage(BufferPool *buffer, size_t pageId, int fd, size_t page_size) {
+    int f = pinPage(buffer, pageId, fd, page_size, NULL, 0);
+    if (f < 0) {
         return NULL;
     }
 
-    // Check if page is already in buffer
-    for (int i = 0; i < buffer->num_pages; i++) {
-        if (buffer->page_ids[i] == pageId) {
-            return buffer->pages[i];
+    char *copy = session.copies + session.next_copy * session.copy_size;
+    session.next_copy ^= 1;
+    pthread_rwlock_rdlock(&buffer->frames[f].latch);
+    memcpy(copy, buffer->frames[f].page, page_size);
+    pthread_rwlock_unlock(&buffer->frames[f].latch);
+    unpinFrame(buffer, f);
+    return copy;
+}
+
+// Hand out a page through the window of the calling writer, the pool's own without a session
+// Returns NULL on error or if the page fails its checksum
+static char *windowPage(BufferPool *buffer, size_t pageId, int fd, size_t page_size, const char *image,
+                        size_t image_length) {
+    bool latched = session.pool == buffer;
+    PageWindow *window = latched ? &session.window : &buffer->window;
+
+    // Pages of the window are pinned, their ids cannot change
+    int newest = window->frames[1];
+    if (newest >= 0 && buffer->frames[newest].page_id == pageId) {
+        return buffer->frames[newest].page;
+    }
+    int oldest = window->frames[0];
+    if (oldest >= 0 && buffer->frames[oldest].page_id == pageId) {
+        window->frames[0] = newest;
+        window->frames[1] = oldest;
+        return buffer->frames[oldest].page;
+    }
+
+    // The oldest page is let go first, the page handed out just before stays valid
+    if (oldest >= 0) {
+        if (latched) {
+            pthread_rwlock_unlock(&buffer->frames[oldest].latch);
         }
+        unpinFrame(buffer, oldest);
     }
+    window->frames[0] = newest;
+    window->frames[1] = -1;
 
-    // Page not in buffer, need to load it
-    int slot = -1;
+    int f = pinPage(buffer, pageId, fd, page_size, image, image_length);
+    if (f < 0) {
+        return NULL;
+    }
+    if (latched) {
+        pthread_rwlock_wrlock(&buffer->frames[f].latch);
+    }
+    window->frames[1] = f;
+    return buffer->frames[f].page;
+}
+
+char *readPageFromBuffer(BufferPool *buffer, size_t pageId, FILE *file_pointer, size_t page_size) {
+    if (!buffer || !file_pointer) {
+        return NULL;
+    }
+    int fd = fileno(file_pointer);
 
-    // If buffer not full, use next available slot
-    if (buffer->num_pages < BUFFER_SIZE) {
-        slot = buffer->num_pages;
-        buffer->num_pages++;
-    } else {
-        // Buffer full, reuse slot 0 (simple FIFO eviction)
-        slot = 0;
+    if (session.pool == buffer && session.access == POOL_READ) {
+        return copyPage(buffer, pageId, fd, page_size);
     }
+    return windowPage(buffer, pageId, fd, page_size, NULL, 0);
+}
 
-    // Read page from disk into the buffer slot
-    if (fseek(file_pointer, pageId * page_size, SEEK_SET) != 0) {
+char *readPageOrImage(BufferPool *buffer, size_t pageId, FILE *file_pointer, size_t page_size, const char *image,
+                      size_t length) {
+    if (!buffer || !file_pointer || !image || length > page_size || !isPoolWriter(buffer)) {
         return NULL;
     }
+    return windowPage(buffer, pageId, fileno(file_pointer), page_size, image, length);
+}
 
-    size_t bytes_read = fread(buffer->pages[slot], page_size, 1, file_pointer);
-    if (bytes_read != 1) {
-        // If read fails (e.g., new page), initialize with zeros
-        memset(buffer->pages[slot], 0, page_size);
+int copyPageFromBuffer(BufferPool *buffer, size_t pageId, int fd, size_t page_size, char *out, size_t length) {
+    if (!buffer || !out || length > page_size) {
+        return -1;
     }
 
-    buffer->page_ids[slot] = pageId;
-    buffer->dirty_flags[slot] = 0;
+    // A writer copies the pages it holds without latching them again
+    if (session.pool == buffer && session.access == POOL_WRITE) {
+        for (int i = 0; i < 2; i++) {
+            int f = session.window.frames[i];
+            if (f >= 0 && buffer->frames[f].page_id == pageId) {
+                memcpy(out, buffer->frames[f].page, length);
+                return 0;
+            }
+        }
+    }
+
+    // A cached copy may be newer than the file, so it wins
+    BufferPartition *partition = partitionOf(buffer, pageId);
+    pthread_mutex_lock(&partition->lock);
+    int f = findFrame(buffer, partition, pageId);
+    if (f >= 0) {
+        buffer->frames[f].pins++;
+        pthread_mutex_unlock(&partition->lock);
+
+        pthread_rwlock_rdlock(&buffer->frames[f].latch);
+        memcpy(out, buffer->frames[f].page, length);
+        pthread_rwlock_unlock(&buffer->frames[f].latch);
+        unpinFrame(buffer, f);
+        return 0;
+    }
+
+    // Pages move between the frames and the deferred list under the partition lock
+    pthread_mutex_lock(&buffer->deferred_lock);
+    for (size_t i = 0; i < buffer->deferred_count; i++) {
+        if (buffer->deferred[i].page_id == pageId) {
+            memcpy(out, buffer->deferred[i].page, length);
+            pthread_mutex_unlock(&buffer->deferred_lock);
+            pthread_mutex_unlock(&partition->lock);
+            return 0;
+        }
+    }
+    pthread_mutex_unlock(&buffer->deferred_lock);
+    pthread_mutex_unlock(&partition->lock);
+
+    // Not cached, read straight from the file without taking a frame so a big scan
+    // does not push everything else out of the pool. A compressed image needs the whole page
+    char *page = length == page_size ? out : malloc(page_size);
+    if (!page) {
+        return -1;
+    }
+    int loaded = loadPage(buffer, fd, pageId, page, page_size, NULL, 0);
+    if (page != out) {
+        memcpy(out, page, length);
+        free(page);
+    }
+    return loaded < 0 ? -1 : 0;
+}
 
-    return buffer->pages[slot];
+void prefetchPages(int fd, const uint64_t *pages, uint64_t count, size_t page_size) {
+    uint64_t i = 0;
+    while (i < count) {
+        // One hint per run of consecutive pages
+        uint64_t run = 1;
+        while (i + run < count && pages[i + run] == pages[i] + run) {
+            run++;
+        }
+        posix_fadvise(fd, (off_t)(pages[i] * page_size), (off_t)(run * page_size), POSIX_FADV_WILLNEED);
+        i += run;
+    }
 }
 
 int markPageDirty(BufferPool *buffer, size_t pageId) {
-    if (!buffer) {
+    if (!buffer || (session.pool == buffer && session.access == POOL_READ)) {
         return -1;
     }
 
-    for (int i = 0; i < buffer->num_pages; i++) {
-        if (buffer->page_ids[i] == pageId) {
-            buffer->dirty_flags[i] = 1;
-            return 0;
+    BufferPartition *partition = partitionOf(buffer, pageId);
+    pthread_mutex_lock(&partition->lock);
+    int f = findFrame(buffer, partition, pageId);
+    if (f >= 0) {
+        buffer->frames[f].flags |= FRAME_DIRTY;
+        if (buffer->no_steal) {
+            buffer->frames[f].flags |= FRAME_PENDING;
         }
     }
+    pthread_mutex_unlock(&partition->lock);
+
+    return f >= 0 ? 0 : -1;  // -1 if the page is not in the buffer
+}
+
+int markPageCompressed(BufferPool *buffer, size_t pageId, bool compress) {
+    if (!buffer || (session.pool == buffer && session.access == POOL_READ)) {
+        return -1;
+    }
 
-    return -1;  // Page not found in buffer
+    BufferPartition *partition = partitionOf(buffer, pageId);
+    pthread_mutex_lock(&partition->lock);
+    int f = findFrame(buffer, partition, pageId);
+    if (f >= 0) {
+        if (compress) {
+            buffer->frames[f].flags |= FRAME_COMPRESS;
+        } else {
+            buffer->frames[f].flags &= (uint8_t)~FRAME_COMPRESS;
+        }
+    }
+    pthread_mutex_unlock(&partition->lock);
+    return f >= 0 ? 0 : -1;
+}
+
+typedef int (*FrameVisitor)(BufferPool *buffer, BufferFrame *frame, void *context);
+
+// Call visit for every frame with the flags in want and none in skip, pinned and latched
+// exclusively. The flags in clear are taken off every frame visit returns 0 for
+// Returns 0 on success, the first nonzero value visit returned otherwise
+static int visitFrames(BufferPool *buffer, uint8_t want, uint8_t skip, uint8_t clear, FrameVisitor visit,
+                       void *context) {
+    releaseSessionWindow(buffer);
+
+    int selected[BUFFER_SIZE];
+    int result = 0;
+    for (int p = 0; p < BUFFER_PARTITIONS && result == 0; p++) {
+        BufferPartition *partition = &buffer->partitions[p];
+        int count = 0;
+
+        pthread_mutex_lock(&partition->lock);
+        for (int f = partition->head; f >= 0; f = buffer->frames[f].next) {
+            uint8_t flags = buffer->frames[f].flags;
+            if ((flags & want) == want && !(flags & skip)) {
+                buffer->frames[f].pins++;
+                selected[count++] = f;
+            }
+        }
+        pthread_mutex_unlock(&partition->lock);
+
+        for (int i = 0; i < count; i++) {
+            BufferFrame *frame = &buffer->frames[selected[i]];
+            int visited = -1;
+            if (result == 0) {
+                pthread_rwlock_wrlock(&frame->latch);
+                visited = visit(buffer, frame, context);
+                pthread_rwlock_unlock(&frame->latch);
+                if (visited != 0) {
+                    result = visited;
+                }
+            }
+
+            pthread_mutex_lock(&partition->lock);
+            if (visited == 0) {
+                frame->flags &= (uint8_t)~clear;
+            }
+            frame->pins--;
+            pthread_mutex_unlock(&partition->lock);
+        }
+    }
+    return result;
+}
+
+static int flushFrame(BufferPool *buffer, BufferFrame *frame, void *context) {
+    MagBase *db = context;
+    bool compress = (frame->flags & FRAME_COMPRESS) != 0;
+    if (writePage(buffer, fileno(db->file_pointer), frame->page_id, frame->page, db->page_size, compress) != 0) {
+        fprintf(stderr, "Failed to write while flushing page %zu\n", frame->page_id);
+        return -1;
+    }
+    return 0;
 }
 
 int flushAllDirtyPages(BufferPool *buffer, MagBase *db) {
@@ -163,20 +684,174 @@ int flushAllDirtyPages(BufferPool *buffer, MagBase *db) {
         return -1;
     }
 
-    for (int i = 0; i < buffer->num_pages; i++) {
-        if (buffer->dirty_flags[i]) {
-            if (fseek(db->file_pointer, buffer->page_ids[i] * db->page_size, SEEK_SET) != 0) {
-                fprintf(stderr, "Failed to seek while flushing page %zu\n", buffer->page_ids[i]);
-                return -1;
-            }
-            if (fwrite(buffer->pages[i], db->page_size, 1, db->file_pointer) != 1) {
-                fprintf(stderr, "Failed to write while flushing page %zu\n", buffer->page_ids[i]);
-                return -1;
+    // Uncommitted pages wait for their log records, see commitDatabase
+    uint8_t skip = buffer->no_steal ? FRAME_PENDING : 0;
+    return visitFrames(buffer, FRAME_DIRTY, skip, FRAME_DIRTY, flushFrame, db) == 0 ? 0 : -1;
+}
+
+int enableNoSteal(BufferPool *buffer) {
+    if (!buffer || buffer->no_steal) {
+        return buffer ? 0 : -1;
+    }
+
+    // Frames get their base image when they are claimed, the ones in use get it now
+    for (int i = 0; i < BUFFER_SIZE; i++) {
+        BufferFrame *frame = &buffer->frames[i];
+        if (!frame->page) {
+            continue;
+        }
+        frame->base = malloc(buffer->page_size);
+        if (!frame->base) {
+            return -1;
+        }
+        memcpy(frame->base, frame->page, buffer->page_size);
+    }
+
+    buffer->no_steal = 1;
+    return 0;
+}
+
+void enablePageChecksums(BufferPool *buffer) {
+    if (buffer) {
+        buffer->checksums = 1;
+    }
+}
+
+typedef struct {
+    int (*visit)(void *context, size_t page_id, char *page, const char *base);
+    void *context;
+} PendingVisit;
+
+static int visitPendingFrame(BufferPool *buffer, BufferFrame *frame, void *context) {
+    (void)buffer;
+    PendingVisit *pending = context;
+    return pending->visit(pending->context, frame->page_id, frame->page, frame->base);
+}
+
+int visitPendingPages(BufferPool *buffer, int (*visit)(void *context, size_t page_id, char *page, const char *base),
+                      void *context) {
+    if (!buffer || !visit || !buffer->no_steal) {
+        return -1;
+    }
+
+    PendingVisit pending = {visit, context};
+    int result = visitFrames(buffer, FRAME_PENDING, 0, 0, visitPendingFrame, &pending);
+    if (result != 0) {
+        return result;
+    }
+
+    // Deferred pages are only reachable through the list, which its lock keeps in place
+    pthread_mutex_lock(&buffer->deferred_lock);
+    for (size_t i = 0; i < buffer->deferred_count && result == 0; i++) {
+        DeferredPage *deferred = &buffer->deferred[i];
+        result = visit(context, deferred->page_id, deferred->page, deferred->base);
+    }
+    pthread_mutex_unlock(&buffer->deferred_lock);
+    return result;
+}
+
+static int commitFrame(BufferPool *buffer, BufferFrame *frame, void *context) {
+    (void)buffer;
+    MagBase *db = context;
+    memcpy(frame->base, frame->page, db->page_size);
+    return 0;
+}
+
+int markPagesCommitted(BufferPool *buffer, MagBase *db) {
+    if (!buffer || !db || !buffer->no_steal) {
+        return -1;
+    }
+
+    visitFrames(buffer, FRAME_PENDING, 0, FRAME_PENDING, commitFrame, db);
+
+    // Deferred pages are logged now, write them out instead of keeping them around
+    int result = 0;
+    pthread_mutex_lock(&buffer->deferred_lock);
+    for (size_t i = 0; i < buffer->deferred_count; i++) {
+        DeferredPage *deferred = &buffer->deferred[i];
+        if (writePage(buffer, fileno(db->file_pointer), deferred->page_id, deferred->page, db->page_size,
+                      deferred->compress) != 0) {
+            fprintf(stderr, "Failed to write page %zu\n", deferred->page_id);
+            result = -1;
+        }
+        free(deferred->page);
+        free(deferred->base);
+    }
+    buffer->deferred_count = 0;
+    pthread_mutex_unlock(&buffer->deferred_lock);
+    return result;
+}
+
+bool hasPendingPages(BufferPool *buffer) {
+    if (!buffer || !buffer->no_steal) {
+        return false;
+    }
+
+    for (int p = 0; p < BUFFER_PARTITIONS; p++) {
+        BufferPartition *partition = &buffer->partitions[p];
+        pthread_mutex_lock(&partition->lock);
+        for (int f = partition->head; f >= 0; f = buffer->frames[f].next) {
+            if (buffer->frames[f].flags & FRAME_PENDING) {
+                pthread_mutex_unlock(&partition->lock);
+                return true;
             }
-            buffer->dirty_flags[i] = 0;
         }
+        pthread_mutex_unlock(&partition->lock);
     }
 
-    fflush(db->file_pointer);
+    pthread_mutex_lock(&buffer->deferred_lock);
+    bool deferred = buffer->deferred_count > 0;
+    pthread_mutex_unlock(&buffer->deferred_lock);
+    return deferred;
+}
+
+static int discardFrame(BufferPool *buffer, BufferFrame *frame, void *context) {
+    (void)context;
+    memcpy(frame->page, frame->base, buffer->page_size);
     return 0;
 }
+
+void discardPendingPages(BufferPool *buffer) {
+    if (!buffer || !buffer->no_steal) {
+        return;
+    }
+
+    // Restoring the committed image keeps a later flush from writing the abandoned change
+    visitFrames(buffer, FRAME_PENDING, 0, FRAME_PENDING, discardFrame, NULL);
+
+    pthread_mutex_lock(&buffer->deferred_lock);
+    for (size_t i = 0; i < buffer->deferred_count; i++) {
+        free(buffer->deferred[i].page);
+        free(buffer->deferred[i].base);
+    }
+    buffer->deferred_count = 0;
+    pthread_mutex_unlock(&buffer->deferred_lock);
+}
+
+int dropCachedPages(BufferPool *buffer) {
+    if (!buffer || hasPendingPages(buffer)) {
+        return -1;
+    }
+
+    releaseSessionWindow(buffer);
+    releaseWindow(buffer, &buffer->window, false);
+
+    // Unlinked frames keep their page buffers for the next pages they are claimed for
+    int status = 0;
+    for (int p = 0; p < BUFFER_PARTITIONS; p++) {
+        BufferPartition *partition = &buffer->partitions[p];
+        pthread_mutex_lock(&partition->lock);
+        int f = partition->head;
+        while (f >= 0) {
+            int next = buffer->frames[f].next;
+            if (buffer->frames[f].pins > 0) {
+                status = -1;
+            } else {
+                unlinkFrame(buffer, partition, f);
+            }
+            f = next;
+        }
+        pthread_mutex_unlock(&partition->lock);
+    }
+    return status;
+}
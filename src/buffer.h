@@ -7,19 +7,91 @@
 #include "db-init.h"
 #include <stdio.h>
 
-BufferPool *createBufferPool();
+// How a thread that entered a pool uses it
+typedef enum {
+    POOL_READ,  // Pages are copied out under a shared latch, any number of readers run at once
+    POOL_WRITE, // Pages are handed out in place and held under an exclusive latch, one writer at a time
+} PoolAccess;
+
+// Create a pool of BUFFER_SIZE frames for pages of page_size bytes
+BufferPool *createBufferPool(size_t page_size);
 int freeBufferPool(BufferPool *buffer);
-int flushPage(BufferPool *buffer, MagBase *db, int pageIndex);
-int addToBuffer(BufferPool *buffer, size_t pageId, char *pageData, MagBase *db);
+
+// Enter a pool shared between threads, until leaveBufferPool. A thread is in one pool at a time
+// Threads that do not enter use the pool one at a time, like a pool that is never shared
+// Returns 0 on success, -1 if the thread is already in a pool
+int enterBufferPool(BufferPool *buffer, PoolAccess access);
+
+// Leave the pool, the pages the thread was handed are released
+void leaveBufferPool(BufferPool *buffer);
+
+// Returns true unless the calling thread entered the pool in POOL_READ
+bool isPoolWriter(BufferPool *buffer);
+
+// Release the pages the thread was handed without leaving the pool, before it takes a lock that
+// comes ahead of page latches (see MagBase.file_lock)
+void releasePageWindow(BufferPool *buffer);
 
 // Read a page from buffer (or disk if not cached)
-// Returns pointer to page data in buffer, or NULL on error
+// Returns pointer to page data in buffer, or NULL on error or if the page fails its checksum
+// The pointer is only valid until the second read after it. A POOL_READ thread gets a private
+// copy, which it must not change
 char *readPageFromBuffer(BufferPool *buffer, size_t pageId, FILE *file_pointer, size_t page_size);
 
+// readPageFromBuffer for recovery, with a whole image of the page from the log. A copy in the
+// file that fails its checksum, or has none, was possibly torn and is replaced by the image
+// (length bytes, the rest cleared) without an error
+// Returns pointer to page data like readPageFromBuffer, or NULL on error or from a POOL_READ thread
+char *readPageOrImage(BufferPool *buffer, size_t pageId, FILE *file_pointer, size_t page_size, const char *image,
+                      size_t length);
+
+// Thread safe read of the first length bytes of a page into out
+// Cached pages are copied from the pool, others are read from fd with pread without being cached
+// Returns 0 on success, -1 on error or if the page read fails its checksum
+int copyPageFromBuffer(BufferPool *buffer, size_t pageId, int fd, size_t page_size, char *out, size_t length);
+
+// Hint the kernel to read the given pages ahead, consecutive page numbers become one request
+void prefetchPages(int fd, const uint64_t *pages, uint64_t count, size_t page_size);
+
 // Mark a page as dirty (modified) in the buffer
-// Returns 0 on success, -1 on error
+// Returns 0 on success, -1 on error or from a POOL_READ thread
 int markPageDirty(BufferPool *buffer, size_t pageId);
 
+// Choose whether a page is written as a compressed image from now on, for the pages of
+// compressed tables. A page read from the file compressed starts out compressed
+// Returns 0 on success, -1 if the page is not in the pool or from a POOL_READ thread
+int markPageCompressed(BufferPool *buffer, size_t pageId, bool compress);
+
 // Flush all dirty pages in the buffer to disk
 // Returns 0 on success, -1 on error
 int flushAllDirtyPages(BufferPool *buffer, MagBase *db);
+
+// Switch the pool to no-steal: changed pages are only written to the file once committed,
+// uncommitted pages that get evicted are kept in memory. Used when the database has a WAL
+// Returns 0 on success, -1 on error
+int enableNoSteal(BufferPool *buffer);
+
+// Seal every page written to the file with a CRC32C in its trailer and check it on every read,
+// a page that fails is reported and not handed out. Used for files from 1.3 on
+void enablePageChecksums(BufferPool *buffer);
+
+// Call visit with every uncommitted page and its committed image, the page is latched
+// exclusively during the call
+// Returns 0 on success, the first nonzero value visit returned otherwise
+int visitPendingPages(BufferPool *buffer, int (*visit)(void *context, size_t page_id, char *page, const char *base),
+                      void *context);
+
+// After the WAL commit, make the current pages the new diff base and write deferred pages out
+// Returns 0 on success, -1 on error
+int markPagesCommitted(BufferPool *buffer, MagBase *db);
+
+// Returns true if a page holds a change that is not committed yet
+bool hasPendingPages(BufferPool *buffer);
+
+// Throw away every uncommitted change, for commands that fail half way
+void discardPendingPages(BufferPool *buffer);
+
+// Forget every cached page, dirty ones included, after another process changed the file. No
+// page may be pending or held by another thread
+// Returns 0 on success, -1 if a page is still pending or pinned
+int dropCachedPages(BufferPool *buffer);
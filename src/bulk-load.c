@@ -0,0 +1,226 @@
+//     Keagan Anderson
+//        MagBase
+//       10/19/2026
+//
+//     Bulk loading: rows are packed into fresh pages outside the buffer pool and written in
+//     runs of contiguous pages, the table only sees them once the load is finished
+
+#include "bulk-load.h"
+#include "buffer.h"
+#include "checksum.h"
+#include "dictionary.h"
+#include "globals.h"
+#include "page-compress.h"
+#include "page-directory.h"
+#include "schema.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static char *runPage(BulkLoader *loader, uint32_t index) { return loader->run + (size_t)index * loader->db->page_size; }
+
+// Take the page numbers of a whole run from the end of the file. The directory may allocate
+// pages of its own between runs, so runs are not always back to back
+static uint64_t reserveRun(BulkLoader *loader) {
+    uint64_t first = loader->db->header->page_count;
+    loader->db->header->page_count += BULK_LOAD_RUN_PAGES;
+    return first;
+}
+
+static void startRun(BulkLoader *loader, uint64_t first) {
+    loader->run_first = first;
+    loader->run_count = 1;
+    memset(loader->run, 0, (size_t)BULK_LOAD_RUN_PAGES * loader->db->page_size);
+    ((PageHeader *)runPage(loader, 0))->free_space_offset = sizeof(PageHeader);
+    startPageZone(&loader->zones[0], first);
+}
+
+// Write the used pages of the run with one pwrite, a page at a time for compressed tables, and
+// enter them in the table's directory and zone map
+static int writeRun(BulkLoader *loader) {
+    MagBase *db = loader->db;
+    size_t length = (size_t)loader->run_count * db->page_size;
+    off_t offset = (off_t)(loader->run_first * db->page_size);
+
+    if (db->buffer_pool->checksums) {
+        for (uint32_t p = 0; p < loader->run_count; p++) {
+            sealPage(runPage(loader, p), db->page_size);
+        }
+    }
+    if (loader->schema->flags & TABLE_COMPRESSED) {
+        // Every page gets its own image and hole, they are written one at a time
+        for (uint32_t p = 0; p < loader->run_count; p++) {
+            if (storePage(loader->fd, loader->run_first + p, runPage(loader, p), db->page_size, true) != 0) {
+                fprintf(stderr, "Failed to write bulk loaded pages\n");
+                return -1;
+            }
+        }
+    } else {
+        for (size_t done = 0; done < length;) {
+            ssize_t written = pwrite(loader->fd, loader->run + done, length - done, offset + (off_t)done);
+            if (written <= 0) {
+                fprintf(stderr, "Failed to write bulk loaded pages\n");
+                return -1;
+            }
+            done += (size_t)written;
+        }
+    }
+
+    for (uint32_t p = 0; p < loader->run_count; p++) {
+        if (appendTablePage(db, loader->schema, loader->run_first + p) != 0 ||
+            appendPageZone(db, loader->schema->table_id, &loader->zones[p]) != 0) {
+            return -1;
+        }
+    }
+    loader->pages_written += loader->run_count;
+    return 0;
+}
+
+BulkLoader *openBulkLoader(MagBase *db, uint16_t table_id, uint32_t fill_percent) {
+    if (!db || fill_percent == 0 || fill_percent > 100) {
+        return NULL;
+    }
+
+    BulkLoader *loader = calloc(1, sizeof(BulkLoader));
+    if (!loader) {
+        return NULL;
+    }
+    loader->db = db;
+    loader->schema = readTableSchema(db, table_id);
+    loader->codec = getRowCodec(db, table_id);
+    loader->run = malloc((size_t)BULK_LOAD_RUN_PAGES * db->page_size);
+    loader->zones = malloc(BULK_LOAD_RUN_PAGES * sizeof(PageZone));
+    if (!loader->schema || !loader->codec || !loader->run || !loader->zones) {
+        abortBulkLoad(loader);
+        return NULL;
+    }
+
+    // Pages evicted from the pool sit in the stdio buffer, the pwrites below go around it
+    fflush(db->file_pointer);
+    loader->fd = fileno(db->file_pointer);
+    loader->previous_tail = loader->schema->root_page ? lastTablePage(db, loader->schema) : 0;
+    if (loader->schema->root_page && loader->previous_tail == 0) {
+        abortBulkLoad(loader);
+        return NULL;
+    }
+    loader->fill_limit = sizeof(PageHeader) + (db->usable_page_size - sizeof(PageHeader)) * fill_percent / 100;
+    return loader;
+}
+
+uint64_t bulkLoadRecord(BulkLoader *loader, Record *record) {
+    if (!loader || !record) {
+        return 0;
+    }
+
+    // The id is part of the row's size in compact rows
+    record->record_id = allocateRecordId(loader->db, loader->schema->table_id);
+    if (record->record_id == 0) {
+        return 0;
+    }
+    if (addDictionaryValues(loader->db, loader->codec, record) != 0) {
+        return 0;
+    }
+    size_t record_size = getRowSize(loader->db, loader->codec, record);
+    if (sizeof(PageHeader) + record_size > loader->db->usable_page_size) {
+        fprintf(stderr, "Record of %zu bytes does not fit in a page\n", record_size);
+        return 0;
+    }
+
+    if (loader->first_page == 0) {
+        startRun(loader, reserveRun(loader));
+        loader->first_page = loader->run_first;
+    }
+
+    char *page = runPage(loader, loader->run_count - 1);
+    PageHeader *page_header = (PageHeader *)page;
+
+    // A page always takes at least one row, whatever the fill factor
+    if (page_header->slot_count > 0 && page_header->free_space_offset + record_size > loader->fill_limit) {
+        if (loader->run_count < BULK_LOAD_RUN_PAGES) {
+            page_header->next_page = loader->run_first + loader->run_count;
+            loader->run_count++;
+        } else {
+            // Reserve the next run first so the full run's last page can point at it
+            uint64_t next_first = reserveRun(loader);
+            page_header->next_page = next_first;
+            if (writeRun(loader) != 0) {
+                return 0;
+            }
+            startRun(loader, next_first);
+        }
+        page = runPage(loader, loader->run_count - 1);
+        page_header = (PageHeader *)page;
+        page_header->free_space_offset = sizeof(PageHeader);
+        startPageZone(&loader->zones[loader->run_count - 1], loader->run_first + loader->run_count - 1);
+    }
+
+    if (serializeRow(loader->db, loader->codec, (uint8_t *)page + page_header->free_space_offset, record) != 0) {
+        return 0;
+    }
+    addZoneRow(&loader->zones[loader->run_count - 1], loader->schema->column_count, record);
+    page_header->slot_count++;
+    page_header->free_space_offset += (uint16_t)record_size;
+    loader->rows++;
+    return record->record_id;
+}
+
+int finishBulkLoad(BulkLoader *loader) {
+    if (!loader) {
+        return -1;
+    }
+    if (loader->first_page == 0) {
+        abortBulkLoad(loader);
+        return 0;
+    }
+
+    MagBase *db = loader->db;
+    TableSchemaRecord *schema = loader->schema;
+
+    // Hand back the unused end of the last run if nothing was allocated after it
+    if (db->header->page_count == loader->run_first + BULK_LOAD_RUN_PAGES) {
+        db->header->page_count = loader->run_first + loader->run_count;
+    }
+    uint64_t tail = loader->previous_tail;
+    int status = writeRun(loader);
+
+    // The new pages must be on disk before the commit below makes them part of the table,
+    // unless syncs are off
+    if (status == 0 && (fflush(db->file_pointer) != 0 || (db->sync_mode != SYNC_OFF && fdatasync(loader->fd) != 0))) {
+        fprintf(stderr, "Failed to sync bulk loaded pages\n");
+        status = -1;
+    }
+
+    if (status == 0) {
+        if (tail == 0) {
+            schema->root_page = (uint32_t)loader->first_page;
+        } else {
+            char *page_buffer = readPageFromBuffer(db->buffer_pool, tail, db->file_pointer, db->page_size);
+            if (!page_buffer) {
+                status = -1;
+            } else {
+                ((PageHeader *)page_buffer)->next_page = loader->first_page;
+                markPageDirty(db->buffer_pool, tail);
+            }
+        }
+    }
+    if (status == 0 && (updateTableSchema(db, schema) != 0 || commitDatabase(db) != 0)) {
+        status = -1;
+    }
+
+    free(loader->run);
+    free(loader->zones);
+    free(loader->schema);
+    free(loader);
+    return status;
+}
+
+void abortBulkLoad(BulkLoader *loader) {
+    if (!loader) {
+        return;
+    }
+    free(loader->run);
+    free(loader->zones);
+    free(loader->schema);
+    free(loader);
+}
@@ -0,0 +1,47 @@
+//     Keagan Anderson
+//        MagBase
+//       10/19/2026
+//
+//     Bulk loading: rows are packed into fresh pages outside the buffer pool and written in
+//     runs of contiguous pages, the table only sees them once the load is finished
+
+#pragma once
+
+#include "db-init.h"
+#include "records.h"
+#include "row-codec.h"
+#include "structs/schemaStruct.h"
+#include "zone-map.h"
+#include <stdint.h>
+
+typedef struct {
+    MagBase *db;
+    TableSchemaRecord *schema;          // Owned, saved once when the load is finished
+    const RowCodec *codec;              // Codec plan of the table, owned by the catalog
+    int fd;
+    size_t fill_limit;                  // A page is closed once a row would end past this offset
+    char *run;                          // BULK_LOAD_RUN_PAGES pages being filled
+    uint64_t run_first;                 // Page number of the first page of the run
+    uint32_t run_count;                 // Pages of the run in use, the last one is being filled
+    PageZone *zones;                    // Zone map entries of the run's pages
+    uint64_t first_page;                // First page of the load, 0 until a row is added
+    uint64_t previous_tail;             // Last page of the table before the load, 0 if it was empty
+    uint64_t rows;
+    uint64_t pages_written;
+} BulkLoader;
+
+// Start a load into a table, pages are filled to fill_percent (1-100) of their usable space
+// Returns NULL if the table does not exist or on error
+BulkLoader *openBulkLoader(MagBase *db, uint16_t table_id, uint32_t fill_percent);
+
+// Pack a record into the current page, its record_id is assigned here
+// Returns the record_id, or 0 on error
+uint64_t bulkLoadRecord(BulkLoader *loader, Record *record);
+
+// Write the last run, sync the new pages, then link them to the table, save the schema and
+// header and commit. Frees the loader either way
+// Returns 0 on success, -1 on error
+int finishBulkLoad(BulkLoader *loader);
+
+// Drop a load, nothing it wrote is reachable from the table
+void abortBulkLoad(BulkLoader *loader);
@@ -0,0 +1,135 @@
+//     Keagan Anderson
+//        MagBase
+//       10/19/2026
+//
+//     In-memory catalog of the table schemas, hashed by table id and by table name
+
+#include "catalog.h"
+#include "dictionary.h"
+#include <stdlib.h>
+#include <string.h>
+
+static uint32_t hashId(uint16_t table_id) { return (uint32_t)table_id * 2654435761u; }
+
+// FNV-1a
+static uint32_t hashName(const char *name) {
+    uint32_t hash = 2166136261u;
+    for (const unsigned char *c = (const unsigned char *)name; *c; c++) {
+        hash = (hash ^ *c) * 16777619u;
+    }
+    return hash;
+}
+
+Catalog *createCatalog(void) { return calloc(1, sizeof(Catalog)); }
+
+int addCatalogEntry(Catalog *catalog, const TableSchemaRecord *schema, uint64_t page_num, uint16_t offset) {
+    if (!catalog || !schema) {
+        return -1;
+    }
+
+    if (catalog->count == catalog->capacity) {
+        uint32_t capacity = catalog->capacity ? catalog->capacity * 2 : 16;
+        CatalogEntry *entries = realloc(catalog->entries, capacity * sizeof(CatalogEntry));
+        if (!entries) {
+            return -1;
+        }
+        catalog->entries = entries;
+        catalog->capacity = capacity;
+    }
+
+    CatalogEntry *entry = &catalog->entries[catalog->count++];
+    entry->schema = *schema;
+    buildRowCodec(&entry->codec, schema);
+    entry->page_num = page_num;
+    entry->offset = offset;
+    entry->next_record_id = schema->next_record_id;
+    entry->free_page = 0;
+    return 0;
+}
+
+int buildCatalogIndexes(Catalog *catalog) {
+    if (!catalog) {
+        return -1;
+    }
+
+    // At most half full so probes stay short
+    uint32_t slots = 16;
+    while (slots < catalog->count * 2) {
+        slots *= 2;
+    }
+
+    free(catalog->by_id);
+    free(catalog->by_name);
+    catalog->by_id = calloc(slots, sizeof(uint32_t));
+    catalog->by_name = calloc(slots, sizeof(uint32_t));
+    if (!catalog->by_id || !catalog->by_name) {
+        return -1;
+    }
+    catalog->slot_mask = slots - 1;
+
+    for (uint32_t i = 0; i < catalog->count; i++) {
+        TableSchemaRecord *schema = &catalog->entries[i].schema;
+
+        if (!findCatalogEntry(catalog, schema->table_id)) {
+            uint32_t slot = hashId(schema->table_id) & catalog->slot_mask;
+            while (catalog->by_id[slot] != 0) {
+                slot = (slot + 1) & catalog->slot_mask;
+            }
+            catalog->by_id[slot] = i + 1;
+        }
+
+        if (!findCatalogEntryByName(catalog, schema->table_name)) {
+            uint32_t slot = hashName(schema->table_name) & catalog->slot_mask;
+            while (catalog->by_name[slot] != 0) {
+                slot = (slot + 1) & catalog->slot_mask;
+            }
+            catalog->by_name[slot] = i + 1;
+        }
+    }
+    return 0;
+}
+
+CatalogEntry *findCatalogEntry(Catalog *catalog, uint16_t table_id) {
+    if (!catalog || !catalog->by_id) {
+        return NULL;
+    }
+
+    for (uint32_t slot = hashId(table_id) & catalog->slot_mask; catalog->by_id[slot] != 0;
+         slot = (slot + 1) & catalog->slot_mask) {
+        CatalogEntry *entry = &catalog->entries[catalog->by_id[slot] - 1];
+        if (entry->schema.table_id == table_id) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+CatalogEntry *findCatalogEntryByName(Catalog *catalog, const char *name) {
+    if (!catalog || !catalog->by_name || !name) {
+        return NULL;
+    }
+
+    for (uint32_t slot = hashName(name) & catalog->slot_mask; catalog->by_name[slot] != 0;
+         slot = (slot + 1) & catalog->slot_mask) {
+        CatalogEntry *entry = &catalog->entries[catalog->by_name[slot] - 1];
+        if (!strcmp(entry->schema.table_name, name)) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+void freeCatalog(Catalog *catalog) {
+    if (!catalog) {
+        return;
+    }
+    for (uint32_t i = 0; i < catalog->count; i++) {
+        for (uint16_t col = 0; col < MAX_COLUMNS; col++) {
+            freeDictionary(catalog->entries[i].codec.dictionaries[col]);
+        }
+    }
+    free(catalog->entries);
+    free(catalog->by_id);
+    free(catalog->by_name);
+    free(catalog);
+}
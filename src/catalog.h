@@ -0,0 +1,52 @@
+//     Keagan Anderson
+//        MagBase
+//       10/19/2026
+//
+//     In-memory catalog of the table schemas, hashed by table id and by table name
+
+#pragma once
+
+#include "row-codec.h"
+#include "structs/schemaStruct.h"
+#include <stdint.h>
+
+// A deserialized schema and where its record lives in the schema pages
+typedef struct {
+    TableSchemaRecord schema;
+    RowCodec codec;                     // Built from schema when the entry is added
+    uint64_t page_num;                  // Schema page holding the record
+    uint16_t offset;                    // Offset of the record in that page
+    uint64_t next_record_id;            // Next id handed out, schema.next_record_id is the saved
+                                        // high-water mark ids are reserved up to
+    uint64_t free_page;                 // First page before the last one that may have room for
+                                        // rows, 0 if none is known. Only kept in memory
+} CatalogEntry;
+
+// Entries are only added while the catalog is loaded, DDL retires the whole catalog so the
+// entries never move once the indexes are built
+typedef struct Catalog {
+    CatalogEntry *entries;              // In schema page order
+    uint32_t count;
+    uint32_t capacity;
+    uint32_t *by_id;                    // Open addressing, entry index + 1, 0 is an empty slot
+    uint32_t *by_name;
+    uint32_t slot_mask;                 // Slots per index minus one, a power of two minus one
+    struct Catalog *retired;            // Next older retired catalog
+} Catalog;
+
+// Returns NULL on error, caller must free it with freeCatalog
+Catalog *createCatalog(void);
+
+// Add a schema read from the schema pages, before buildCatalogIndexes
+// Returns 0 on success, -1 on error
+int addCatalogEntry(Catalog *catalog, const TableSchemaRecord *schema, uint64_t page_num, uint16_t offset);
+
+// Hash every entry by id and by name, the first table of a name wins
+// Returns 0 on success, -1 on error
+int buildCatalogIndexes(Catalog *catalog);
+
+// Returns the entry, or NULL if there is no such table
+CatalogEntry *findCatalogEntry(Catalog *catalog, uint16_t table_id);
+CatalogEntry *findCatalogEntryByName(Catalog *catalog, const char *name);
+
+void freeCatalog(Catalog *catalog);
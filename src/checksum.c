@@ -0,0 +1,163 @@
+//     Keagan Anderson
+//        MagBase
+//       10/19/2026
+//
+//     CRC32C page checksums (see checksum.h). The lookup table is the portable path, x86 CPUs
+//     with SSE4.2 hash 8 bytes per instruction instead
+
+#include "checksum.h"
+#include "db-init.h"
+#include <pthread.h>
+#include <string.h>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <nmmintrin.h>
+#define CRC32C_HAS_SSE42 1
+#endif
+
+#define CRC32C_POLYNOMIAL 0x82F63B78u // Castagnoli polynomial, bit reversed
+#define CRC32C_STRIPE 256             // Bytes of each of the three streams the SSE4.2 path interleaves
+
+// The checksum covers the page up to its checksum field, which is the last field of the trailer
+#define CHECKSUM_OFFSET(page_size) ((page_size) - sizeof(PageTrailer) + offsetof(PageTrailer, checksum))
+
+// Slicing by 8: table[k][b] is the CRC of byte b followed by k zero bytes
+static uint32_t crc_table[8][256];
+// shift_table[k][b] is the CRC state b << 8k advanced over CRC32C_STRIPE zero bytes
+static uint32_t shift_table[4][256];
+static uint32_t (*crc_function)(uint32_t crc, const uint8_t *bytes, size_t length);
+static pthread_once_t crc_once = PTHREAD_ONCE_INIT;
+
+static uint32_t crc32cTable(uint32_t crc, const uint8_t *bytes, size_t length) {
+    while (length > 0 && ((uintptr_t)bytes & 7) != 0) {
+        crc = crc_table[0][(crc ^ *bytes++) & 0xFF] ^ (crc >> 8);
+        length--;
+    }
+    while (length >= 8) {
+        uint64_t word;
+        memcpy(&word, bytes, sizeof(word));
+        word ^= crc;
+        crc = crc_table[7][word & 0xFF] ^ crc_table[6][(word >> 8) & 0xFF] ^ crc_table[5][(word >> 16) & 0xFF] ^
+              crc_table[4][(word >> 24) & 0xFF] ^ crc_table[3][(word >> 32) & 0xFF] ^
+              crc_table[2][(word >> 40) & 0xFF] ^ crc_table[1][(word >> 48) & 0xFF] ^ crc_table[0][word >> 56];
+        bytes += 8;
+        length -= 8;
+    }
+    while (length > 0) {
+        crc = crc_table[0][(crc ^ *bytes++) & 0xFF] ^ (crc >> 8);
+        length--;
+    }
+    return crc;
+}
+
+// Advance a CRC state over CRC32C_STRIPE zero bytes
+static uint32_t shiftStripe(uint32_t crc) {
+    return shift_table[0][crc & 0xFF] ^ shift_table[1][(crc >> 8) & 0xFF] ^ shift_table[2][(crc >> 16) & 0xFF] ^
+           shift_table[3][crc >> 24];
+}
+
+#ifdef CRC32C_HAS_SSE42
+// The crc32 instruction takes 3 cycles but a new one can start every cycle, so three stripes
+// are hashed side by side and joined with shiftStripe: crc(A B) = shift(crc(A)) ^ crc(0, B)
+__attribute__((target("sse4.2"))) static uint32_t crc32cHardware(uint32_t crc, const uint8_t *bytes,
+                                                                 size_t length) {
+    while (length > 0 && ((uintptr_t)bytes & 7) != 0) {
+        crc = _mm_crc32_u8(crc, *bytes++);
+        length--;
+    }
+    while (length >= 3 * CRC32C_STRIPE) {
+        uint64_t crc0 = crc, crc1 = 0, crc2 = 0;
+        for (size_t i = 0; i < CRC32C_STRIPE; i += 8) {
+            uint64_t word0, word1, word2;
+            memcpy(&word0, bytes + i, sizeof(word0));
+            memcpy(&word1, bytes + CRC32C_STRIPE + i, sizeof(word1));
+            memcpy(&word2, bytes + 2 * CRC32C_STRIPE + i, sizeof(word2));
+            crc0 = _mm_crc32_u64(crc0, word0);
+            crc1 = _mm_crc32_u64(crc1, word1);
+            crc2 = _mm_crc32_u64(crc2, word2);
+        }
+        crc = shiftStripe(shiftStripe((uint32_t)crc0) ^ (uint32_t)crc1) ^ (uint32_t)crc2;
+        bytes += 3 * CRC32C_STRIPE;
+        length -= 3 * CRC32C_STRIPE;
+    }
+    uint64_t wide = crc;
+    while (length >= 8) {
+        uint64_t word;
+        memcpy(&word, bytes, sizeof(word));
+        wide = _mm_crc32_u64(wide, word);
+        bytes += 8;
+        length -= 8;
+    }
+    crc = (uint32_t)wide;
+    while (length > 0) {
+        crc = _mm_crc32_u8(crc, *bytes++);
+        length--;
+    }
+    return crc;
+}
+#endif
+
+static void initCrc32c(void) {
+    for (uint32_t b = 0; b < 256; b++) {
+        uint32_t crc = b;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (crc & 1 ? CRC32C_POLYNOMIAL : 0);
+        }
+        crc_table[0][b] = crc;
+    }
+    for (uint32_t b = 0; b < 256; b++) {
+        for (int k = 1; k < 8; k++) {
+            crc_table[k][b] = crc_table[0][crc_table[k - 1][b] & 0xFF] ^ (crc_table[k - 1][b] >> 8);
+        }
+    }
+
+    for (int k = 0; k < 4; k++) {
+        for (uint32_t b = 0; b < 256; b++) {
+            uint32_t crc = b << (8 * k);
+            for (int zero = 0; zero < CRC32C_STRIPE; zero++) {
+                crc = crc_table[0][crc & 0xFF] ^ (crc >> 8);
+            }
+            shift_table[k][b] = crc;
+        }
+    }
+
+    crc_function = crc32cTable;
+#ifdef CRC32C_HAS_SSE42
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse4.2")) {
+        crc_function = crc32cHardware;
+    }
+#endif
+}
+
+uint32_t crc32c(uint32_t crc, const void *data, size_t length) {
+    pthread_once(&crc_once, initCrc32c);
+    return ~crc_function(~crc, data, length);
+}
+
+bool crc32cAccelerated(void) {
+    pthread_once(&crc_once, initCrc32c);
+    return crc_function != crc32cTable;
+}
+
+void sealPage(char *page, size_t page_size) {
+    uint32_t checksum = crc32c(0, page, CHECKSUM_OFFSET(page_size));
+    memcpy(page + CHECKSUM_OFFSET(page_size), &checksum, sizeof(checksum));
+}
+
+bool pageChecksumValid(const char *page, size_t page_size) {
+    uint32_t stored;
+    memcpy(&stored, page + CHECKSUM_OFFSET(page_size), sizeof(stored));
+    if (stored == crc32c(0, page, CHECKSUM_OFFSET(page_size))) {
+        return true;
+    }
+    if (stored != 0) {
+        return false;
+    }
+    for (size_t i = 0; i < page_size; i++) {
+        if (page[i] != 0) {
+            return false;
+        }
+    }
+    return true;
+}
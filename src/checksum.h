@@ -0,0 +1,24 @@
+//     Keagan Anderson
+//        MagBase
+//       10/19/2026
+//
+//     CRC32C (Castagnoli) page checksums, with the SSE4.2 crc32 instruction where the CPU has it
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Continue a CRC32C over length bytes, start with crc = 0
+uint32_t crc32c(uint32_t crc, const void *data, size_t length);
+
+// Returns true if crc32c uses the SSE4.2 instruction instead of the lookup table
+bool crc32cAccelerated(void);
+
+// Store the checksum of a page in its trailer, right before the page is written to the file
+void sealPage(char *page, size_t page_size);
+
+// Returns true if the trailer of a page read from the file matches its contents. A page of
+// zeros was never written (reserved past the end of the file) and passes as well
+bool pageChecksumValid(const char *page, size_t page_size);
@@ -0,0 +1,366 @@
+//     Keagan Anderson
+//        MagBase
+//       10/19/2026
+//
+//     Client side of magbased (see magbase-client.h)
+
+#include "globals.h"
+#include "magbase-client.h"
+#include "protocol.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// The server's frames are bounded by what one scan row or stats answer can hold
+#define CLIENT_MAX_FRAME SERVER_MAX_FRAME
+
+struct MagbaseClient {
+    int fd;
+    WireBuffer out;
+    WireBuffer in;
+    size_t consumed;          // Bytes of in holding the last answer, dropped by the next read
+    uint32_t next_request;
+    bool broken;              // The connection failed, every call fails from now on
+    char column_names[MAGBASE_MAX_COLUMNS][MAGBASE_MAX_NAME]; // Of the last stats answer
+};
+
+MagbaseClient *magbaseConnect(const char *socket_path) {
+    struct sockaddr_un address = {.sun_family = AF_UNIX};
+    if (!socket_path || strlen(socket_path) >= sizeof(address.sun_path)) {
+        return NULL;
+    }
+    strcpy(address.sun_path, socket_path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return NULL;
+    }
+    if (connect(fd, (struct sockaddr *)&address, sizeof(address)) != 0) {
+        close(fd);
+        return NULL;
+    }
+
+    MagbaseClient *client = calloc(1, sizeof(MagbaseClient));
+    if (!client) {
+        close(fd);
+        return NULL;
+    }
+    client->fd = fd;
+    client->next_request = 1;
+    return client;
+}
+
+void magbaseDisconnect(MagbaseClient *client) {
+    if (!client) {
+        return;
+    }
+    close(client->fd);
+    freeWire(&client->out);
+    freeWire(&client->in);
+    free(client);
+}
+
+// Start a request frame in the out buffer
+// Returns the offset of the frame for endFrame
+static size_t beginRequest(MagbaseClient *client, uint8_t opcode) {
+    return beginFrame(&client->out, client->next_request++, opcode);
+}
+
+// Write every request built so far
+// Returns 0 on success, -1 if the connection failed
+static int sendRequests(MagbaseClient *client) {
+    size_t sent = 0;
+    while (sent < client->out.length) {
+        ssize_t written = send(client->fd, client->out.data + sent, client->out.length - sent, MSG_NOSIGNAL);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            client->broken = true;
+            return -1;
+        }
+        sent += (size_t)written;
+    }
+    client->out.length = 0;
+    return 0;
+}
+
+// Wait for the next answer, its payload stays in the in buffer until the next call
+// Returns 0 with reader and status set, or -1 if the connection failed
+static int receiveAnswer(MagbaseClient *client, WireReader *reader, uint8_t *status) {
+    consumeWire(&client->in, client->consumed);
+    client->consumed = 0;
+
+    while (1) {
+        long frame_length = completeFrame(client->in.data, client->in.length, CLIENT_MAX_FRAME);
+        if (frame_length < 0) {
+            client->broken = true;
+            return -1;
+        }
+        if (frame_length > 0) {
+            *reader = frameReader(client->in.data, (size_t)frame_length, NULL, status);
+            client->consumed = (size_t)frame_length;
+            return 0;
+        }
+
+        if (reserveWire(&client->in, 64 * 1024) != 0) {
+            client->broken = true;
+            return -1;
+        }
+        ssize_t received = recv(client->fd, client->in.data + client->in.length,
+                                client->in.capacity - client->in.length, 0);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received <= 0) {
+            client->broken = true;
+            return -1;
+        }
+        client->in.length += (size_t)received;
+    }
+}
+
+// Send the request built in the out buffer and wait for its answer
+// Returns 0 with reader and status set, or -1 if the connection failed
+static int roundTrip(MagbaseClient *client, WireReader *reader, uint8_t *status) {
+    if (client->broken || sendRequests(client) != 0) {
+        client->out.length = 0;
+        return -1;
+    }
+    return receiveAnswer(client, reader, status);
+}
+
+int magbaseClientPing(MagbaseClient *client) {
+    if (!client) {
+        return -1;
+    }
+    WireReader reader;
+    uint8_t status;
+    endFrame(&client->out, beginRequest(client, OP_PING));
+    return roundTrip(client, &reader, &status) == 0 && status == STATUS_OK ? 0 : -1;
+}
+
+int magbaseClientCreateTable(MagbaseClient *client, const char *name, const MagbaseColumn *columns,
+                             uint16_t column_count) {
+    if (!client || !name || !columns) {
+        return -1;
+    }
+    size_t frame = beginRequest(client, OP_CREATE_TABLE);
+    putString(&client->out, name);
+    putColumns(&client->out, columns, column_count);
+    endFrame(&client->out, frame);
+
+    WireReader reader;
+    uint8_t status;
+    if (roundTrip(client, &reader, &status) != 0 || status != STATUS_OK) {
+        return -1;
+    }
+    uint16_t table_id = getU16(&reader);
+    return reader.failed ? -1 : table_id;
+}
+
+int magbaseClientDropTable(MagbaseClient *client, uint16_t table_id) {
+    if (!client) {
+        return -1;
+    }
+    size_t frame = beginRequest(client, OP_DROP_TABLE);
+    putU16(&client->out, table_id);
+    endFrame(&client->out, frame);
+
+    WireReader reader;
+    uint8_t status;
+    return roundTrip(client, &reader, &status) == 0 && status == STATUS_OK ? 0 : -1;
+}
+
+int magbaseClientFindTable(MagbaseClient *client, const char *name) {
+    if (!client || !name) {
+        return -1;
+    }
+    size_t frame = beginRequest(client, OP_FIND_TABLE);
+    putString(&client->out, name);
+    endFrame(&client->out, frame);
+
+    WireReader reader;
+    uint8_t status;
+    if (roundTrip(client, &reader, &status) != 0 || status != STATUS_OK) {
+        return -1;
+    }
+    uint16_t table_id = getU16(&reader);
+    return reader.failed ? -1 : table_id;
+}
+
+int magbaseClientTableStats(MagbaseClient *client, uint16_t table_id, MagbaseTableStats *stats) {
+    if (!client || !stats) {
+        return -1;
+    }
+    size_t frame = beginRequest(client, OP_TABLE_STATS);
+    putU16(&client->out, table_id);
+    endFrame(&client->out, frame);
+
+    WireReader reader;
+    uint8_t status;
+    if (roundTrip(client, &reader, &status) != 0 || status != STATUS_OK) {
+        return -1;
+    }
+
+    memset(stats, 0, sizeof(MagbaseTableStats));
+    stats->table_id = table_id;
+    const char *name = getString(&reader);
+    if (name) {
+        strncpy(stats->name, name, MAGBASE_MAX_NAME - 1);
+    }
+    getColumns(&reader, stats->columns, &stats->column_count, MAGBASE_MAX_COLUMNS);
+    stats->row_count = getU64(&reader);
+    stats->page_count = getU64(&reader);
+    if (reader.failed) {
+        return -1;
+    }
+
+    // The names would go with the answer, they are kept until the next stats call instead
+    for (uint16_t col = 0; col < stats->column_count; col++) {
+        snprintf(client->column_names[col], MAGBASE_MAX_NAME, "%s", stats->columns[col].name);
+        stats->columns[col].name = client->column_names[col];
+    }
+    return 0;
+}
+
+uint64_t magbaseClientInsert(MagbaseClient *client, uint16_t table_id, const MagbaseValue *values,
+                             uint16_t value_count) {
+    uint64_t record_id = 0;
+    int64_t inserted = magbaseClientInsertMany(client, table_id, values, value_count, 1, &record_id);
+    return inserted == 1 ? record_id : 0;
+}
+
+int64_t magbaseClientInsertMany(MagbaseClient *client, uint16_t table_id, const MagbaseValue *rows,
+                                uint16_t value_count, uint64_t row_count, uint64_t *record_ids) {
+    if (!client || (!rows && row_count > 0)) {
+        return -1;
+    }
+
+    int64_t inserted = 0;
+    for (uint64_t first = 0; first < row_count; first += CLIENT_PIPELINE_DEPTH) {
+        uint64_t window = row_count - first < CLIENT_PIPELINE_DEPTH ? row_count - first : CLIENT_PIPELINE_DEPTH;
+
+        // Send the whole window, then read its answers, which come back in order
+        for (uint64_t row = first; row < first + window; row++) {
+            size_t frame = beginRequest(client, OP_INSERT);
+            putU16(&client->out, table_id);
+            putValues(&client->out, rows + row * value_count, value_count);
+            endFrame(&client->out, frame);
+        }
+        if (client->broken || sendRequests(client) != 0) {
+            client->out.length = 0;
+            return -1;
+        }
+
+        for (uint64_t row = first; row < first + window; row++) {
+            WireReader reader;
+            uint8_t status;
+            if (receiveAnswer(client, &reader, &status) != 0) {
+                return -1;
+            }
+            uint64_t record_id = status == STATUS_OK ? getU64(&reader) : 0;
+            if (reader.failed) {
+                record_id = 0;
+            }
+            if (record_ids) {
+                record_ids[row] = record_id;
+            }
+            if (record_id != 0) {
+                inserted++;
+            }
+        }
+    }
+    return inserted;
+}
+
+int magbaseClientRead(MagbaseClient *client, uint16_t table_id, uint64_t record_id, MagbaseValue *values,
+                      uint16_t value_count) {
+    if (!client || !values) {
+        return -1;
+    }
+    size_t frame = beginRequest(client, OP_READ);
+    putU16(&client->out, table_id);
+    putU64(&client->out, record_id);
+    endFrame(&client->out, frame);
+
+    WireReader reader;
+    uint8_t status;
+    uint16_t count;
+    if (roundTrip(client, &reader, &status) != 0 || status != STATUS_OK) {
+        return -1;
+    }
+    return getValues(&reader, values, &count, value_count);
+}
+
+int magbaseClientUpdate(MagbaseClient *client, uint16_t table_id, uint64_t record_id,
+                        const MagbaseValue *values, uint16_t value_count) {
+    if (!client || !values) {
+        return -1;
+    }
+    size_t frame = beginRequest(client, OP_UPDATE);
+    putU16(&client->out, table_id);
+    putU64(&client->out, record_id);
+    putValues(&client->out, values, value_count);
+    endFrame(&client->out, frame);
+
+    WireReader reader;
+    uint8_t status;
+    return roundTrip(client, &reader, &status) == 0 && status == STATUS_OK ? 0 : -1;
+}
+
+int magbaseClientDelete(MagbaseClient *client, uint16_t table_id, uint64_t record_id) {
+    if (!client) {
+        return -1;
+    }
+    size_t frame = beginRequest(client, OP_DELETE);
+    putU16(&client->out, table_id);
+    putU64(&client->out, record_id);
+    endFrame(&client->out, frame);
+
+    WireReader reader;
+    uint8_t status;
+    return roundTrip(client, &reader, &status) == 0 && status == STATUS_OK ? 0 : -1;
+}
+
+int64_t magbaseClientScan(MagbaseClient *client, uint16_t table_id, const char *const *where, int where_count,
+                          MagbaseRowFunction row, void *context) {
+    if (!client || where_count < 0 || where_count > WIRE_MAX_CONDITIONS || (where_count > 0 && !where)) {
+        return -1;
+    }
+    size_t frame = beginRequest(client, OP_SCAN);
+    putU16(&client->out, table_id);
+    putU16(&client->out, (uint16_t)where_count);
+    for (int i = 0; i < where_count; i++) {
+        putString(&client->out, where[i]);
+    }
+    endFrame(&client->out, frame);
+
+    WireReader reader;
+    uint8_t status;
+    if (roundTrip(client, &reader, &status) != 0) {
+        return -1;
+    }
+
+    // Rows stream in until the closing answer
+    MagbaseValue values[MAGBASE_MAX_COLUMNS];
+    uint16_t count;
+    while (status == STATUS_ROW) {
+        uint64_t record_id = getU64(&reader);
+        if (getValues(&reader, values, &count, MAGBASE_MAX_COLUMNS) == 0 && row) {
+            row(context, record_id, values, count);
+        }
+        if (receiveAnswer(client, &reader, &status) != 0) {
+            return -1;
+        }
+    }
+    if (status != STATUS_OK) {
+        return -1;
+    }
+    uint64_t rows = getU64(&reader);
+    return reader.failed ? -1 : (int64_t)rows;
+}
@@ -0,0 +1,998 @@
+//     Keagan Anderson
+//        MagBase
+//       10/19/2026
+//
+//     The database commands, run against an already open database by the command line flags
+//     and by sessions
+
+#include "checksum.h"
+#include "commands.h"
+#include "file-lock.h"
+#include "filter.h"
+#include "globals.h"
+#include "import.h"
+#include "join.h"
+#include "page-compress.h"
+#include "parallel-scan.h"
+#include "planner.h"
+#include "records.h"
+#include "schema.h"
+#include "sort.h"
+#include "stats.h"
+#include "thread-pool.h"
+#include "structs/schemaStruct.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+typedef struct {
+    const char *name;
+    int min_args;             // Arguments after the database path
+    const char *arguments;
+    int (*run)(Session *session, int argc, char **argv);
+    bool writes;              // Takes the writer lock of the file, the others read under the header lock
+} Command;
+
+// Print one value, without a newline
+static void printFieldValue(RecordField *field) {
+    if (field->is_null) {
+        printf("NULL");
+        return;
+    }
+    switch (field->type) {
+        case COL_INT:
+            printf("%d", field->value.int_val);
+            break;
+        case COL_BOOL:
+            printf("%s", field->value.bool_val ? "true" : "false");
+            break;
+        case COL_TEXT:
+            printf("%s", field->value.text_val);
+            break;
+    }
+}
+
+// Print the values of a record separated by pipes, without a newline
+static void printRecordValues(Record *record) {
+    for (uint16_t col = 0; col < record->field_count; col++) {
+        printFieldValue(&record->fields[col]);
+        if (col < record->field_count - 1) printf(" | ");
+    }
+}
+
+// Record what a plan node actually produced, for -explain
+static void setActualRows(PlanNode *node, uint64_t rows) {
+    node->actual_rows = rows;
+    node->has_actual = 1;
+}
+
+// Print one record in the pipe-delimited -list-records format
+static void printRecordRow(Record *record) {
+    printf("  [ID %lu] ", record->record_id);
+    printRecordValues(record);
+    printf("\n");
+}
+
+// Fill the fields of a record from text values, NULL is a NULL value
+static void parseFieldValues(TableSchemaRecord *schema, Record *record, int count, char **values) {
+    for (uint16_t col = 0; col < schema->column_count && col < count; col++) {
+        char *value = values[col];
+
+        // Handle NULL values
+        if (!strcmp(value, "NULL")) {
+            record->fields[col].is_null = 1;
+            continue;
+        }
+
+        record->fields[col].is_null = 0;
+        record->fields[col].type = schema->columns[col].type;
+
+        switch (schema->columns[col].type) {
+            case COL_INT:
+                record->fields[col].value.int_val = atoi(value);
+                break;
+            case COL_BOOL:
+                record->fields[col].value.bool_val = (!strcmp(value, "true") || !strcmp(value, "1")) ? 1 : 0;
+                break;
+            case COL_TEXT:
+                strncpy(record->fields[col].value.text_val, value, MAX_RECORD_VALUE_SIZE - 1);
+                break;
+        }
+    }
+}
+
+// Commit a write unless a transaction is open, then COMMIT saves it with the rest
+static int finishWrite(Session *session) {
+    if (session->in_transaction) {
+        return 0;
+    }
+    return commitDatabase(session->db);
+}
+
+// A write that failed may have changed pages half way, its transaction is rolled back
+static int abortWrite(Session *session) {
+    rollbackDatabase(session->db);
+    if (session->in_transaction) {
+        session->in_transaction = false;
+        fprintf(stderr, "Transaction rolled back\n");
+    }
+    return -1;
+}
+
+static int createTableCommand(Session *session, int argc, char **argv) {
+    char *table_name = argv[0];
+    uint16_t num_columns = (uint16_t)atoi(argv[1]);
+
+    if (num_columns == 0 || num_columns > MAX_COLUMNS) {
+        fprintf(stderr, "Invalid number of columns\n");
+        return -1;
+    }
+    if (argc - 2 < num_columns) {
+        fprintf(stderr, "Not enough column definitions\n");
+        return -1;
+    }
+
+    TableSchemaRecord *schema = calloc(1, sizeof(TableSchemaRecord));
+    if (!schema) {
+        return -1;
+    }
+
+    schema->table_id = 0;  // Will be assigned by writeTableSchema
+    schema->column_count = num_columns;
+    schema->root_page = 0;  // Will be assigned later
+    schema->next_record_id = 1;  // Start record IDs from 1
+    schema->name_len = (uint16_t)strlen(table_name);
+    strncpy(schema->table_name, table_name, MAX_TABLE_NAME - 1);
+
+    // Parse columns
+    for (uint16_t col = 0; col < num_columns; col++) {
+        char *col_def = argv[2 + col];
+        char *col_name = strtok(col_def, ":");
+        char *col_type = strtok(NULL, ":");
+        char *col_nullable = strtok(NULL, ":");
+        char *col_encoding = strtok(NULL, ":");
+
+        if (!col_name || !col_type) {
+            fprintf(stderr, "Invalid column format. Use: col_name:type:nullable[:dict] (types: int, text, bool)\n");
+            free(schema);
+            return -1;
+        }
+
+        schema->columns[col].name_len = (uint16_t)strlen(col_name);
+        strncpy(schema->columns[col].name, col_name, MAX_COLUMN_NAME - 1);
+
+        if (!strcmp(col_type, "int")) {
+            schema->columns[col].type = COL_INT;
+        } else if (!strcmp(col_type, "text")) {
+            schema->columns[col].type = COL_TEXT;
+        } else if (!strcmp(col_type, "bool")) {
+            schema->columns[col].type = COL_BOOL;
+        } else {
+            fprintf(stderr, "Unknown column type: %s\n", col_type);
+            free(schema);
+            return -1;
+        }
+
+        schema->columns[col].nullable = (col_nullable && !strcmp(col_nullable, "1")) ? 1 : 0;
+
+        if (col_encoding) {
+            if (strcmp(col_encoding, "dict") != 0 || schema->columns[col].type != COL_TEXT) {
+                fprintf(stderr, "Only text columns can be stored as dict: %s\n", col_name);
+                free(schema);
+                return -1;
+            }
+            if (!hasDictionaries(session->db)) {
+                fprintf(stderr, "Database version %d.%d.%d has no dictionary columns\n",
+                        session->db->header->version.major, session->db->header->version.minor,
+                        session->db->header->version.patch);
+                free(schema);
+                return -1;
+            }
+            schema->dictionary_columns |= (uint16_t)(1u << col);
+        }
+    }
+
+    int table_id = writeTableSchema(session->db, schema);
+    free(schema);
+    if (table_id <= 0 || finishWrite(session) != 0) {
+        fprintf(stderr, "Failed to create table\n");
+        return abortWrite(session);
+    }
+
+    printf("Table '%s' created with ID %d\n", table_name, table_id);
+    return 0;
+}
+
+static int listTablesCommand(Session *session, int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+
+    uint16_t num_tables = 0;
+    TableSchemaRecord **schemas = readAllTableSchemas(session->db, &num_tables);
+
+    if (num_tables == 0) {
+        printf("No tables found\n");
+        return 0;
+    }
+
+    printf("Tables in database:\n");
+    for (uint16_t i = 0; i < num_tables; i++) {
+        printf("  [ID %d] %s (%d columns)%s\n", schemas[i]->table_id, schemas[i]->table_name,
+               schemas[i]->column_count, (schemas[i]->flags & TABLE_COMPRESSED) ? " [compressed]" : "");
+        for (uint16_t col = 0; col < schemas[i]->column_count; col++) {
+            const char *type_str = "unknown";
+            switch (schemas[i]->columns[col].type) {
+                case COL_INT:
+                    type_str = "int";
+                    break;
+                case COL_TEXT:
+                    type_str = "text";
+                    break;
+                case COL_BOOL:
+                    type_str = "bool";
+                    break;
+            }
+            printf("    - %s (%s)%s%s\n", schemas[i]->columns[col].name, type_str,
+                   schemas[i]->columns[col].nullable ? " [nullable]" : "",
+                   (schemas[i]->dictionary_columns & (1u << col)) ? " [dict]" : "");
+        }
+        free(schemas[i]);
+    }
+    free(schemas);
+    return 0;
+}
+
+static int deleteTableCommand(Session *session, int argc, char **argv) {
+    (void)argc;
+    uint16_t table_id = (uint16_t)atoi(argv[0]);
+
+    if (deleteTableSchema(session->db, table_id) != 0) {
+        fprintf(stderr, "Failed to delete table\n");
+        return -1;
+    }
+    if (finishWrite(session) != 0) {
+        fprintf(stderr, "Failed to delete table\n");
+        return abortWrite(session);
+    }
+
+    printf("Table with ID %d deleted\n", table_id);
+    return 0;
+}
+
+static int insertRecordCommand(Session *session, int argc, char **argv) {
+    uint16_t table_id = (uint16_t)atoi(argv[0]);
+
+    TableSchemaRecord *schema = getTableSchema(session->db, table_id);
+    if (!schema) {
+        fprintf(stderr, "Table not found\n");
+        return -1;
+    }
+
+    Record *record = createRecord(table_id, schema->column_count);
+    if (!record) {
+        return -1;
+    }
+    parseFieldValues(schema, record, argc - 1, argv + 1);
+
+    uint64_t record_id = insertRecord(session->db, record);
+    freeRecord(record);
+    if (record_id == 0 || finishWrite(session) != 0) {
+        fprintf(stderr, "Failed to insert record\n");
+        return abortWrite(session);
+    }
+
+    printf("Record inserted with ID %lu\n", record_id);
+    return 0;
+}
+
+static int importCommand(Session *session, int argc, char **argv) {
+    uint16_t table_id = (uint16_t)atoi(argv[0]);
+    const char *source = argv[1];
+
+    ImportOptions options = {0};
+    options.fill_percent = BULK_LOAD_FILL_PERCENT;
+    size_t source_length = strlen(source);
+    options.delimiter = source_length > 4 && !strcmp(&source[source_length - 4], ".tsv") ? '\t' : ',';
+    for (int i = 2; i < argc && argv[i][0] == '-'; i++) {
+        if (!strcmp(argv[i], "-skip-header")) {
+            options.skip_header = 1;
+        } else if (!strcmp(argv[i], "-delimiter") && i + 1 < argc) {
+            const char *delimiter = argv[++i];
+            options.delimiter = !strcmp(delimiter, "tab") || !strcmp(delimiter, "\\t") ? '\t' : delimiter[0];
+        } else if (!strcmp(argv[i], "-fill") && i + 1 < argc) {
+            options.fill_percent = (uint32_t)atoi(argv[++i]);
+        } else {
+            break;
+        }
+    }
+    if (options.delimiter == '\0' || options.delimiter == '"' || options.delimiter == '\n') {
+        fprintf(stderr, "Invalid delimiter\n");
+        return -1;
+    }
+    if (options.fill_percent == 0 || options.fill_percent > 100) {
+        fprintf(stderr, "-fill takes a percentage from 1 to 100\n");
+        return -1;
+    }
+
+    if (!session->command_line && !strcmp(source, "-")) {
+        fprintf(stderr, "A session reads its commands from stdin, import from a file\n");
+        return -1;
+    }
+    // The bulk loader commits on its own, it cannot be part of a larger transaction
+    if (session->in_transaction) {
+        fprintf(stderr, "import commits on its own, run it outside BEGIN/COMMIT\n");
+        return -1;
+    }
+
+    TableSchemaRecord *schema = getTableSchema(session->db, table_id);
+    if (!schema) {
+        fprintf(stderr, "Table not found\n");
+        return -1;
+    }
+    char table_name[MAX_TABLE_NAME];
+    memcpy(table_name, schema->table_name, MAX_TABLE_NAME);
+
+    FILE *input = strcmp(source, "-") ? fopen(source, "rb") : stdin;
+    if (!input) {
+        fprintf(stderr, "Failed to open %s\n", source);
+        return -1;
+    }
+
+    ImportResult result;
+    int status = importRows(session->db, table_id, input, &options, &result);
+    if (status == 0) {
+        printf("Imported %lu rows into %s (%lu pages)\n", (unsigned long)result.rows_imported,
+               table_name, (unsigned long)result.pages_written);
+    } else if (result.bad_line > 0) {
+        fprintf(stderr, "Import stopped at line %lu, %lu rows imported\n", (unsigned long)result.bad_line,
+                (unsigned long)result.rows_imported);
+    } else {
+        fprintf(stderr, "Failed to import into table %u\n", table_id);
+    }
+
+    if (input != stdin) {
+        fclose(input);
+    }
+    // The rows before a bad line are already committed, only a failed load leaves changes behind
+    if (status != 0 && result.rows_imported == 0) {
+        return abortWrite(session);
+    }
+    return status;
+}
+
+static int readRecordCommand(Session *session, int argc, char **argv) {
+    (void)argc;
+    uint16_t table_id = (uint16_t)atoi(argv[0]);
+    uint64_t record_id = (uint64_t)atoll(argv[1]);
+
+    TableSchemaRecord *schema = getTableSchema(session->db, table_id);
+    if (!schema) {
+        fprintf(stderr, "Table not found\n");
+        return -1;
+    }
+
+    Record *record = readRecord(session->db, table_id, record_id);
+    if (!record) {
+        fprintf(stderr, "Record not found\n");
+        return -1;
+    }
+
+    printf("Record ID %lu:\n", record->record_id);
+    for (uint16_t col = 0; col < record->field_count; col++) {
+        printf("  %s: ", schema->columns[col].name);
+        printFieldValue(&record->fields[col]);
+        printf("\n");
+    }
+    freeRecord(record);
+    return 0;
+}
+
+static int listRecordsCommand(Session *session, int argc, char **argv) {
+    MagBase *db = session->db;
+    uint16_t table_id = (uint16_t)atoi(argv[0]);
+
+    TableSchemaRecord *schema = getTableSchema(db, table_id);
+    if (!schema) {
+        fprintf(stderr, "Table not found\n");
+        return -1;
+    }
+
+    SortSpec spec;
+    initSortSpec(&spec);
+    Filter filter = {0};
+    spec.filter = &filter;
+
+    // Optional WHERE / ORDER BY / LIMIT modifiers
+    for (int i = 1; i + 1 < argc && argv[i][0] == '-'; i += 2) {
+        if (!strcmp(argv[i], "-where")) {
+            if (parsePredicate(schema, argv[i + 1], &filter) != 0) {
+                return -1;
+            }
+        } else if (!strcmp(argv[i], "-order-by")) {
+            if (parseSortKeys(schema, argv[i + 1], &spec) != 0) {
+                fprintf(stderr, "Invalid ORDER BY list: %s\n", argv[i + 1]);
+                return -1;
+            }
+        } else if (!strcmp(argv[i], "-limit")) {
+            spec.limit = (uint64_t)atoll(argv[i + 1]);
+        } else if (!strcmp(argv[i], "-sort-mem")) {
+            spec.memory_budget = (size_t)atoll(argv[i + 1]);
+        } else {
+            break;
+        }
+    }
+
+    PlanNode *plan = session->explain ? planSelect(db, table_id, &spec) : NULL;
+
+    // Rows are streamed so tables larger than memory can be listed
+    Record *record = createRecord(table_id, schema->column_count);
+    RecordScan *scan = NULL;
+    SortedScan *sorted = NULL;
+    if (spec.key_count > 0) {
+        sorted = openSortedScan(db, table_id, &spec);
+    } else {
+        scan = openFilteredScan(db, table_id, &filter);
+    }
+    if (!record || (!sorted && !scan)) {
+        fprintf(stderr, "Failed to read records\n");
+        freePlan(plan);
+        closeSortedScan(sorted);
+        closeRecordScan(scan);
+        freeRecord(record);
+        return -1;
+    }
+
+    uint64_t num_records = 0;
+    while (spec.limit == 0 || num_records < spec.limit) {
+        int result = sorted ? nextSortedRecord(sorted, record) : nextRecord(scan, record);
+        if (result != 1) {
+            if (result < 0) {
+                fprintf(stderr, "Failed to read records\n");
+            }
+            break;
+        }
+
+        if (!session->explain) {
+            if (num_records == 0) {
+                printf("Records in table %d:\n", table_id);
+            }
+            printRecordRow(record);
+        }
+        num_records++;
+    }
+
+    if (plan) {
+        // Walk down the Limit -> Sort -> Seq Scan chain planSelect built
+        PlanNode *node = plan;
+        if (node->type == PLAN_LIMIT) {
+            setActualRows(node, num_records);
+            node = node->children[0];
+        }
+        if (node->type != PLAN_SEQ_SCAN) {
+            setActualRows(node, sorted->emitted);
+            node->actual_runs = sorted->spilled_runs;
+            node = node->children[0];
+        }
+        setActualRows(node, sorted ? sorted->input_rows : scan->rows_matched);
+        printPlan(plan);
+        if (scan) {
+            printf("Pages skipped by zone map: %lu\n", (unsigned long)scan->pages_skipped);
+        }
+        freePlan(plan);
+    } else if (num_records == 0) {
+        printf("No records found\n");
+    }
+
+    closeSortedScan(sorted);
+    closeRecordScan(scan);
+    freeRecord(record);
+    return 0;
+}
+
+static int joinCommand(Session *session, int argc, char **argv) {
+    MagBase *db = session->db;
+    uint16_t left_table = (uint16_t)atoi(argv[0]);
+    char *left_col = argv[1];
+    uint16_t right_table = (uint16_t)atoi(argv[2]);
+    char *right_col = argv[3];
+
+    TableSchemaRecord *left_schema = getTableSchema(db, left_table);
+    TableSchemaRecord *right_schema = getTableSchema(db, right_table);
+    if (!left_schema || !right_schema) {
+        fprintf(stderr, "Table not found\n");
+        return -1;
+    }
+
+    JoinSpec spec;
+    initJoinSpec(&spec);
+    spec.left_table = left_table;
+    spec.right_table = right_table;
+    int left_index = findColumn(left_schema, left_col);
+    int right_index = findColumn(right_schema, right_col);
+    if (left_index < 0 || right_index < 0) {
+        fprintf(stderr, "Unknown join column: %s\n", left_index < 0 ? left_col : right_col);
+        return -1;
+    }
+    spec.left_column = (uint16_t)left_index;
+    spec.right_column = (uint16_t)right_index;
+
+    Filter left_filter = {0};
+    Filter right_filter = {0};
+    spec.left_filter = &left_filter;
+    spec.right_filter = &right_filter;
+
+    uint64_t limit = 0;
+    for (int i = 4; i + 1 < argc && argv[i][0] == '-'; i += 2) {
+        if (!strcmp(argv[i], "-where-left") || !strcmp(argv[i], "-where-right")) {
+            int left_side = !strcmp(argv[i], "-where-left");
+            if (parsePredicate(left_side ? left_schema : right_schema, argv[i + 1],
+                               left_side ? &left_filter : &right_filter) != 0) {
+                return -1;
+            }
+        } else if (!strcmp(argv[i], "-join-mem")) {
+            spec.memory_budget = (size_t)atoll(argv[i + 1]);
+        } else if (!strcmp(argv[i], "-limit")) {
+            limit = (uint64_t)atoll(argv[i + 1]);
+        } else {
+            break;
+        }
+    }
+
+    // The planner picks the build side from the statistics
+    PlanNode *plan = planJoin(db, &spec, limit);
+    HashJoin *join = openHashJoin(db, &spec);
+    if (!join) {
+        fprintf(stderr, "Failed to join tables\n");
+        freePlan(plan);
+        return -1;
+    }
+
+    if (!session->explain) {
+        printf("Join of %s.%s = %s.%s:\n", left_schema->table_name, left_col,
+               right_schema->table_name, right_col);
+    }
+
+    uint64_t num_rows = 0;
+    Record *left = NULL;
+    Record *right = NULL;
+    int result = 1;
+    while ((limit == 0 || num_rows < limit) && (result = nextJoinedRow(join, &left, &right)) == 1) {
+        if (!session->explain) {
+            printf("  [ID %lu, ID %lu] ", left->record_id, right->record_id);
+            printRecordValues(left);
+            printf(" || ");
+            printRecordValues(right);
+            printf("\n");
+        }
+        num_rows++;
+    }
+
+    if (result < 0) {
+        fprintf(stderr, "Failed to join tables\n");
+        freePlan(plan);
+        closeHashJoin(join);
+        return -1;
+    }
+
+    if (session->explain && plan) {
+        PlanNode *node = plan;
+        if (node->type == PLAN_LIMIT) {
+            setActualRows(node, num_rows);
+            node = node->children[0];
+        }
+        setActualRows(node, num_rows);
+        node->actual_runs = join->partition_count;
+        setActualRows(node->children[0], join->build_input_rows);
+        setActualRows(node->children[1], join->probe_input_rows);
+        printPlan(plan);
+    } else if (num_rows == 0) {
+        printf("No matching records\n");
+    }
+
+    freePlan(plan);
+    closeHashJoin(join);
+    return 0;
+}
+
+static int analyzeCommand(Session *session, int argc, char **argv) {
+    (void)argc;
+    uint16_t table_id = (uint16_t)atoi(argv[0]);
+
+    TableSchemaRecord *cached = getTableSchema(session->db, table_id);
+    if (!cached) {
+        fprintf(stderr, "Table not found\n");
+        return -1;
+    }
+    TableSchemaRecord table = *cached;
+    TableSchemaRecord *schema = &table;
+
+    TableStats stats;
+    if (analyzeTable(session->db, table_id, &stats) != 0 || finishWrite(session) != 0) {
+        fprintf(stderr, "Failed to analyze table\n");
+        return abortWrite(session);
+    }
+
+    printf("Analyzed %s: %lu rows in %lu pages\n", schema->table_name,
+           (unsigned long)stats.row_count, (unsigned long)stats.page_count);
+    for (uint16_t col = 0; col < stats.column_count; col++) {
+        ColumnStats *column = &stats.columns[col];
+        double null_fraction = stats.row_count ? (double)column->null_count / (double)stats.row_count : 0.0;
+        printf("  %s: nulls %.1f%%, ~%lu distinct", schema->columns[col].name, null_fraction * 100.0,
+               (unsigned long)column->distinct_count);
+        if (column->bucket_count > 0) {
+            char low[64], high[64];
+            formatStatsKey(schema->columns[col].type, column->min_key, low, sizeof(low));
+            formatStatsKey(schema->columns[col].type, column->max_key, high, sizeof(high));
+            printf(", min %s, max %s, %u histogram buckets", low, high, column->bucket_count);
+        }
+        printf("\n");
+    }
+    return 0;
+}
+
+static int aggregateCommand(Session *session, int argc, char **argv) {
+    MagBase *db = session->db;
+    uint16_t table_id = (uint16_t)atoi(argv[0]);
+    const char *aggregate_list = argv[1];
+
+    TableSchemaRecord *schema = getTableSchema(db, table_id);
+    if (!schema) {
+        fprintf(stderr, "Table not found\n");
+        return -1;
+    }
+
+    AggregateSpec spec = {0};
+    if (parseAggregates(schema, aggregate_list, &spec) != 0) {
+        fprintf(stderr, "Invalid aggregate list: %s\n", aggregate_list);
+        return -1;
+    }
+
+    Filter filter = {0};
+    uint32_t thread_count = 0;
+    for (int i = 2; i + 1 < argc && argv[i][0] == '-'; i += 2) {
+        if (!strcmp(argv[i], "-where")) {
+            if (parsePredicate(schema, argv[i + 1], &filter) != 0) {
+                return -1;
+            }
+        } else if (!strcmp(argv[i], "-threads")) {
+            thread_count = (uint32_t)atoi(argv[i + 1]);
+        } else {
+            break;
+        }
+    }
+
+    ThreadPool *pool = createThreadPool(thread_count);
+    ScanResult result;
+    if (!pool || parallelScan(db, table_id, &filter, &spec, pool, &result) != 0) {
+        fprintf(stderr, "Failed to scan table\n");
+        freeThreadPool(pool);
+        return -1;
+    }
+
+    if (session->explain) {
+        PlanNode *plan = planAggregate(db, table_id, &filter, &spec, pool->thread_count);
+        if (plan) {
+            setActualRows(plan, 1);
+            setActualRows(plan->children[0], result.rows_matched);
+            printPlan(plan);
+            freePlan(plan);
+        }
+        printf("Workers: %u, morsels: %lu, steals: %lu, pages: %lu, skipped by zone map: %lu\n", result.threads,
+               (unsigned long)result.morsels, (unsigned long)result.steals,
+               (unsigned long)result.pages_scanned, (unsigned long)result.pages_skipped);
+    } else {
+        for (uint16_t a = 0; a < spec.count; a++) {
+            Aggregate *aggregate = &spec.aggregates[a];
+            AggregateState *state = &result.states[a];
+            char name[64];
+            formatAggregate(schema, aggregate, name, sizeof(name));
+            printf("%s = ", name);
+
+            if (aggregate->op == AGG_COUNT) {
+                printf("%lu", (unsigned long)state->count);
+            } else if (state->count == 0) {
+                printf("NULL");
+            } else if (aggregate->op == AGG_SUM) {
+                printf("%lld", (long long)state->sum);
+            } else if (aggregate->op == AGG_AVG) {
+                printf("%.4f", (double)state->sum / (double)state->count);
+            } else {
+                printFieldValue(aggregate->op == AGG_MIN ? &state->min : &state->max);
+            }
+            printf("\n");
+        }
+    }
+
+    freeThreadPool(pool);
+    return 0;
+}
+
+static int updateRecordCommand(Session *session, int argc, char **argv) {
+    uint16_t table_id = (uint16_t)atoi(argv[0]);
+    uint64_t record_id = (uint64_t)atoll(argv[1]);
+
+    TableSchemaRecord *schema = getTableSchema(session->db, table_id);
+    if (!schema) {
+        fprintf(stderr, "Table not found\n");
+        return -1;
+    }
+
+    Record *record = readRecord(session->db, table_id, record_id);
+    if (!record) {
+        fprintf(stderr, "Record not found\n");
+        return -1;
+    }
+
+    // Update fields
+    parseFieldValues(schema, record, argc - 2, argv + 2);
+
+    int result = updateRecord(session->db, record);
+    freeRecord(record);
+    if (result != 0) {
+        fprintf(stderr, "Failed to update record\n");
+        return -1;
+    }
+    if (finishWrite(session) != 0) {
+        fprintf(stderr, "Failed to update record\n");
+        return abortWrite(session);
+    }
+
+    printf("Record updated\n");
+    return 0;
+}
+
+static int deleteRecordCommand(Session *session, int argc, char **argv) {
+    (void)argc;
+    uint16_t table_id = (uint16_t)atoi(argv[0]);
+    uint64_t record_id = (uint64_t)atoll(argv[1]);
+
+    if (deleteRecord(session->db, table_id, record_id) != 0) {
+        fprintf(stderr, "Record not found\n");
+        return -1;
+    }
+    if (finishWrite(session) != 0) {
+        fprintf(stderr, "Failed to delete record\n");
+        return abortWrite(session);
+    }
+
+    printf("Record deleted\n");
+    return 0;
+}
+
+static int vacuumCommand(Session *session, int argc, char **argv) {
+    (void)argc;
+    uint16_t table_id = (uint16_t)atoi(argv[0]);
+
+    uint64_t removed = 0;
+    if (vacuumTable(session->db, table_id, &removed) != 0) {
+        fprintf(stderr, "Failed to vacuum table\n");
+        return abortWrite(session);
+    }
+    if (finishWrite(session) != 0) {
+        fprintf(stderr, "Failed to vacuum table\n");
+        return abortWrite(session);
+    }
+
+    printf("Removed %lu row versions\n", (unsigned long)removed);
+    return 0;
+}
+
+static int compressCommand(Session *session, int argc, char **argv) {
+    (void)argc;
+    MagBase *db = session->db;
+    uint16_t table_id = (uint16_t)atoi(argv[0]);
+    bool compressed = !strcmp(argv[1], "on");
+    if (!compressed && strcmp(argv[1], "off") != 0) {
+        fprintf(stderr, "Compression must be on or off\n");
+        return -1;
+    }
+    // How a page is stored is not part of its image, a rollback could not put it back
+    if (session->in_transaction) {
+        fprintf(stderr, "compress cannot run inside a transaction\n");
+        return -1;
+    }
+    if (!hasTableFlags(db)) {
+        fprintf(stderr, "Database version %d.%d.%d has no page compression\n", db->header->version.major,
+                db->header->version.minor, db->header->version.patch);
+        return -1;
+    }
+
+    uint64_t pages = 0;
+    if (setTableCompression(db, table_id, compressed, &pages) != 0) {
+        fprintf(stderr, "Failed to set table compression\n");
+        return abortWrite(session);
+    }
+    if (finishWrite(session) != 0) {
+        fprintf(stderr, "Failed to set table compression\n");
+        return abortWrite(session);
+    }
+
+    printf("Compression %s for %lu pages\n", compressed ? "on" : "off", (unsigned long)pages);
+    return 0;
+}
+
+// Shared by the workers of -verify, each morsel is SCAN_MORSEL_PAGES pages read with one pread
+typedef struct {
+    int fd;
+    size_t page_size;
+    uint64_t page_count;
+    char *buffers;            // SCAN_MORSEL_PAGES pages per worker
+    uint8_t *failed;          // Per page, set if it failed its checksum or could not be read
+} VerifyScan;
+
+static void verifyMorsel(void *context, uint32_t worker, uint64_t morsel) {
+    VerifyScan *scan = context;
+    char *buffer = scan->buffers + (size_t)worker * SCAN_MORSEL_PAGES * scan->page_size;
+
+    // Page 0 holds the file header, it has no trailer
+    uint64_t first = morsel * SCAN_MORSEL_PAGES > 0 ? morsel * SCAN_MORSEL_PAGES : 1;
+    uint64_t last = (morsel + 1) * SCAN_MORSEL_PAGES < scan->page_count ? (morsel + 1) * SCAN_MORSEL_PAGES
+                                                                          : scan->page_count;
+    if (first >= last) {
+        return;
+    }
+
+    size_t length = (size_t)(last - first) * scan->page_size;
+    ssize_t bytes_read = pread(scan->fd, buffer, length, (off_t)(first * scan->page_size));
+    if (bytes_read < 0) {
+        memset(scan->failed + first, 1, last - first);
+        return;
+    }
+    if ((size_t)bytes_read < length) {
+        memset(buffer + bytes_read, 0, length - (size_t)bytes_read);
+    }
+
+    // A compressed page is checked once it is expanded, its image has a checksum of its own
+    for (uint64_t p = first; p < last; p++) {
+        char *page = buffer + (size_t)(p - first) * scan->page_size;
+        if (expandPage(page, scan->page_size) < 0 || !pageChecksumValid(page, scan->page_size)) {
+            scan->failed[p] = 1;
+        }
+    }
+}
+
+static int verifyCommand(Session *session, int argc, char **argv) {
+    MagBase *db = session->db;
+    if (!db->buffer_pool->checksums) {
+        fprintf(stderr, "Database version %d.%d.%d has no page checksums\n", db->header->version.major,
+                db->header->version.minor, db->header->version.patch);
+        return -1;
+    }
+
+    uint32_t thread_count = 0;
+    for (int i = 0; i + 1 < argc; i += 2) {
+        if (!strcmp(argv[i], "-threads")) {
+            thread_count = (uint32_t)atoi(argv[i + 1]);
+        }
+    }
+
+    // Every page in the file is checked, reading around the pool so the cache stays as it is
+    fflush(db->file_pointer);
+    struct stat file_stat;
+    if (fstat(fileno(db->file_pointer), &file_stat) != 0) {
+        fprintf(stderr, "Failed to read the database file size\n");
+        return -1;
+    }
+    VerifyScan scan = {
+        .fd = fileno(db->file_pointer),
+        .page_size = db->page_size,
+        .page_count = ((uint64_t)file_stat.st_size + db->page_size - 1) / db->page_size,
+    };
+
+    ThreadPool *pool = createThreadPool(thread_count);
+    if (pool) {
+        scan.buffers = malloc((size_t)pool->thread_count * SCAN_MORSEL_PAGES * scan.page_size);
+        scan.failed = calloc(scan.page_count ? scan.page_count : 1, 1);
+    }
+    uint64_t morsels = (scan.page_count + SCAN_MORSEL_PAGES - 1) / SCAN_MORSEL_PAGES;
+    if (!pool || !scan.buffers || !scan.failed || runMorsels(pool, morsels, verifyMorsel, &scan, NULL) != 0) {
+        fprintf(stderr, "Failed to verify database\n");
+        free(scan.buffers);
+        free(scan.failed);
+        freeThreadPool(pool);
+        return -1;
+    }
+
+    uint64_t failed = 0;
+    for (uint64_t p = 0; p < scan.page_count; p++) {
+        if (scan.failed[p]) {
+            printf("Page %lu failed its checksum\n", (unsigned long)p);
+            failed++;
+        }
+    }
+    uint64_t checked = scan.page_count > 0 ? scan.page_count - 1 : 0;
+    printf("Verified %lu pages on %u threads (%s): %lu failed\n", (unsigned long)checked, pool->thread_count,
+           crc32cAccelerated() ? "crc32c sse4.2" : "crc32c table", (unsigned long)failed);
+
+    free(scan.buffers);
+    free(scan.failed);
+    freeThreadPool(pool);
+    return failed == 0 ? 0 : -1;
+}
+
+static const Command commands[] = {
+    {"create-table", 3, "<table_name> <num_columns> [col_name:type:nullable[:dict] ...]", createTableCommand, true},
+    {"list-tables", 0, "", listTablesCommand, false},
+    {"delete-table", 1, "<table_id>", deleteTableCommand, true},
+    {"insert-record", 1, "<table_id> [field_value ...]", insertRecordCommand, true},
+    {"import", 2, "<table_id> <file|-> [-delimiter c] [-skip-header] [-fill percent]", importCommand, true},
+    {"read-record", 2, "<table_id> <record_id>", readRecordCommand, false},
+    {"list-records", 1,
+     "<table_id> [-where col<op>value]... [-order-by col[:asc|desc],...] [-limit k] [-sort-mem bytes]",
+     listRecordsCommand, false},
+    {"join", 4,
+     "<left_table_id> <left_col> <right_table_id> <right_col> [-where-left col<op>value]... "
+     "[-where-right col<op>value]... [-join-mem bytes] [-limit k]",
+     joinCommand, false},
+    {"analyze", 1, "<table_id>", analyzeCommand, true},
+    {"aggregate", 2, "<table_id> <fn[:col],...> [-where col<op>value]... [-threads n]", aggregateCommand, false},
+    {"update-record", 2, "<table_id> <record_id> [field_value ...]", updateRecordCommand, true},
+    {"delete-record", 2, "<table_id> <record_id>", deleteRecordCommand, true},
+    {"vacuum", 1, "<table_id>", vacuumCommand, true},
+    {"compress", 2, "<table_id> <on|off>", compressCommand, true},
+    {"verify", 0, "[-threads n]", verifyCommand, false},
+};
+
+static const Command *findCommand(const char *name) {
+    for (size_t c = 0; c < sizeof(commands) / sizeof(commands[0]); c++) {
+        if (!strcmp(commands[c].name, name)) {
+            return &commands[c];
+        }
+    }
+    return NULL;
+}
+
+static void printUsage(Session *session, const Command *command, FILE *out) {
+    const char *space = command->arguments[0] ? " " : "";
+    if (session->command_line) {
+        fprintf(out, "-%s <db_path>%s%s\n", command->name, space, command->arguments);
+    } else {
+        fprintf(out, "%s%s%s\n", command->name, space, command->arguments);
+    }
+}
+
+bool isCommand(const char *name) { return name && findCommand(name) != NULL; }
+
+int runCommand(Session *session, const char *name, int argc, char **argv) {
+    if (!session || !session->db || !name) {
+        return -1;
+    }
+
+    const Command *command = findCommand(name);
+    if (!command) {
+        fprintf(stderr, "Unknown command: %s\n", name);
+        return -1;
+    }
+    if (argc < command->min_args) {
+        fprintf(stderr, "Usage: ");
+        printUsage(session, command, stderr);
+        return -1;
+    }
+
+    // Other processes may have the file open. A transaction keeps the writer lock until it ends
+    if (!command->writes) {
+        if (lockFileReader(session->db) != 0) {
+            return -1;
+        }
+        int result = command->run(session, argc, argv);
+        unlockFileReader(session->db);
+        return result;
+    }
+    if (lockFileWriter(session->db) != 0) {
+        return -1;
+    }
+    int result = command->run(session, argc, argv);
+    if (!session->in_transaction && unlockFileWriter(session->db) != 0) {
+        result = -1;
+    }
+    return result;
+}
+
+void printCommands(Session *session) {
+    for (size_t c = 0; c < sizeof(commands) / sizeof(commands[0]); c++) {
+        printf("  ");
+        printUsage(session, &commands[c], stdout);
+    }
+}
@@ -0,0 +1,30 @@
+//     Keagan Anderson
+//        MagBase
+//       10/19/2026
+//
+//     The database commands, run against an already open database by the command line flags
+//     and by sessions
+
+#pragma once
+
+#include "db-init.h"
+#include <stdbool.h>
+
+typedef struct {
+    MagBase *db;
+    bool in_transaction;      // Between BEGIN and COMMIT, writes wait for COMMIT instead of committing
+    bool explain;             // The next query prints its plan instead of its rows
+    bool command_line;        // Usage messages show the -flag <db_path> form
+} Session;
+
+// Returns true if name (without the leading -) is a database command
+bool isCommand(const char *name);
+
+// Run one command, argv holds its arguments after the database path
+// Outside a transaction a write is committed before it returns. A write that fails half way
+// rolls back the open transaction
+// Returns 0 on success, -1 on error
+int runCommand(Session *session, const char *name, int argc, char **argv);
+
+// Print every command with its arguments, in the form the session takes them
+void printCommands(Session *session);
@@ -3,13 +3,22 @@
 //       01/08/2026
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 #include "buffer.h"
+#include "catalog.h"
 #include "db-init.h"
+#include "file-lock.h"
 #include "globals.h"
+#include "schema.h"
+#include "wal.h"
+
+Version version = {DB_VERSION_MAJOR, DB_VERSION_MINOR, DB_VERSION_PATCH};
 
 char *getHelpContent(void) {
     FILE *filePtr;
@@ -55,43 +64,41 @@ bool checkIfFileExists(char *path) {
     return true;
 }
 
-Header *createHeader(Header *newHeader) {
+bool validPageSize(uint32_t page_size) {
+    return page_size >= MIN_PAGE_SIZE && page_size <= MAX_PAGE_SIZE && (page_size & (page_size - 1)) == 0;
+}
+
+Header *createHeader(Header *newHeader, uint32_t page_size) {
     memcpy(newHeader->magic, MAGIC, MAGIC_LENGTH);
     newHeader->version = version;
     newHeader->page_count = 2;
-    newHeader->page_size = PAGE_SIZE;
+    newHeader->page_size = page_size;
     newHeader->schema_root = 1;
     newHeader->free_list_head = 2;
+    newHeader->stats_root = 0;
+    newHeader->checkpoint_lsn = 0;
+    newHeader->next_txn_id = 1;
+    newHeader->change_counter = 0;
+    memset(newHeader->id_hints, 0, sizeof(newHeader->id_hints));
 
     return (newHeader);
 }
 
 int writeHeader(MagBase *magBase) {
-    fseek(magBase->file_pointer, 0, SEEK_SET);
-    fwrite(magBase->header, sizeof(Header), 1, magBase->file_pointer);
-    fflush(magBase->file_pointer);
+    // Pages go through pwrite as well, so nothing sits in the FILE buffer
+    if (pwrite(fileno(magBase->file_pointer), magBase->header, sizeof(Header), 0) != (ssize_t)sizeof(Header)) {
+        return -1;
+    }
     return 0;
 }
 
-char *appendFileExt(char *path) {
-    // DEPRECATED: Use local buffer handling in caller instead
-    // This function is kept for backwards compatibility with -p command
-    static char buffer[512];  // Large enough for most paths
-    static int buffer_index = 0;
-    
-    // Rotate through multiple buffers to avoid overwriting
-    int index = buffer_index;
-    buffer_index = (buffer_index + 1) % 4;
-    
-    char *result = &buffer[index * 128];
-    
-    strncpy(result, path, 123);
-    result[123] = '\0';
-    
-    if (strlen(result) < 4 || strcmp(&result[strlen(result) - 4], ".mab") != 0) {
-        strcat(result, ".mab");
+char *appendFileExt(const char *path, char *out, size_t size) {
+    snprintf(out, size, "%s", path);
+    size_t length = strlen(out);
+    if ((length < 4 || strcmp(&out[length - 4], ".mab") != 0) && length + 4 < size) {
+        strcat(out, ".mab");
     }
-    return result;
+    return out;
 }
 
 int createSchemaPage() { return 0; }
@@ -121,28 +128,338 @@ int createDatabase(char *path) {
     return 0;
 }
 
+MagBase *openMagBase(char *path) {
+    FILE *dbFile = fopen(path, "r+b");
+    if (!dbFile) {
+        fprintf(stderr, "Failed to open database file\n");
+        return NULL;
+    }
+
+    Header *header = malloc(sizeof(Header));
+    if (!header || fread(header, sizeof(Header), 1, dbFile) != 1) {
+        fprintf(stderr, "Failed to read database header\n");
+        free(header);
+        fclose(dbFile);
+        return NULL;
+    }
+    fclose(dbFile);
+
+    if (memcmp(header->magic, MAGIC, MAGIC_LENGTH) != 0) {
+        fprintf(stderr, "This is not a valid MagDB\n");
+        free(header);
+        return NULL;
+    }
+
+    MagBase *db = createMagBase(header, path, false);
+    if (!db) {
+        free(header);
+    }
+    return db;
+}
+
 MagBase *createMagBase(Header *header, char path[], bool newFile) {
     MagBase *magBase = malloc(sizeof(MagBase));
     magBase->filePath = path;
+    // Read access as well, for the shared locks and the header checks of other processes
     if (newFile) {
-        magBase->file_pointer = fopen(path, "wb");
+        magBase->file_pointer = fopen(path, "w+b");
     } else {
         magBase->file_pointer = fopen(path, "r+b");
     }
-    magBase->buffer_pool = createBufferPool();
+    if (!magBase->file_pointer) {
+        fprintf(stderr, "Failed to open database file\n");
+        free(magBase);
+        return NULL;
+    }
+    // Files older than 1.2 have no trailer to keep page offsets below 64K
+    bool has_trailer = header->version.major > 1 || (header->version.major == 1 && header->version.minor >= 2);
+    if (!validPageSize(header->page_size) || (!has_trailer && header->page_size != PAGE_SIZE)) {
+        fprintf(stderr, "Unsupported page size %u\n", header->page_size);
+        fclose(magBase->file_pointer);
+        free(magBase);
+        return NULL;
+    }
+    magBase->buffer_pool = createBufferPool(header->page_size);
     magBase->header = header;
-    magBase->page_size = PAGE_SIZE;
+    magBase->page_size = header->page_size;
+    magBase->usable_page_size = header->page_size;
+    magBase->trailer_size = 0;
+    magBase->wal = NULL;
+    magBase->catalog = NULL;
+    pthread_mutex_init(&magBase->catalog_lock, NULL);
+    magBase->retired_catalogs = NULL;
+    magBase->committed_header = *header;
+    magBase->sync_mode = SYNC_FULL;
+    magBase->version_size = 0;
+    magBase->compact_rows = false;
+    magBase->writing_txn = 0;
+    magBase->compact_pages = true;
+
+    // Another process may be writing the file, the header is read again under the lock
+    if (lockFileOpen(magBase) != 0 ||
+        (!newFile && pread(fileno(magBase->file_pointer), header, sizeof(Header), 0) != (ssize_t)sizeof(Header))) {
+        fprintf(stderr, "Failed to lock database file\n");
+        fclose(magBase->file_pointer);
+        freeBufferPool(magBase->buffer_pool);
+        pthread_mutex_destroy(&magBase->file_lock);
+        free(magBase);
+        return NULL;
+    }
+    magBase->committed_header = *header;
+
+    // Files from 1.4 on keep row versions, readers see the rows committed when they started
+    if (header->version.major > 1 || (header->version.major == 1 && header->version.minor >= 4)) {
+        magBase->version_size = sizeof(RowVersion);
+    }
+
+    // Rows of 1.5 files leave out what the schema knows, see serializeRow
+    if (header->version.major > 1 || (header->version.major == 1 && header->version.minor >= 5)) {
+        magBase->compact_rows = true;
+    }
+
+    // Files from 1.2 on are written through the write-ahead log and carry page trailers
+    if (has_trailer) {
+        // 1.2 trailers stop after the lsn, from 1.3 on every page also carries a checksum
+        if (header->version.major == 1 && header->version.minor == 2) {
+            magBase->trailer_size = offsetof(PageTrailer, reserved);
+        } else {
+            magBase->trailer_size = sizeof(PageTrailer);
+            enablePageChecksums(magBase->buffer_pool);
+        }
+        magBase->usable_page_size = magBase->page_size - magBase->trailer_size;
+
+        // Recovery may write pages, readers of other processes wait for it. A process that did
+        // not get the writer lock finds the log empty
+        bool shared = magBase->file_writer && fileShared(magBase);
+        if (!shared || lockFileHeader(magBase) == 0) {
+            magBase->wal = openWal(magBase, newFile);
+            if (shared) {
+                unlockFileHeader(magBase);
+            }
+        }
+        if (!magBase->wal || enableNoSteal(magBase->buffer_pool) != 0) {
+            closeWal(magBase->wal);
+            fclose(magBase->file_pointer);
+            freeBufferPool(magBase->buffer_pool);
+            pthread_mutex_destroy(&magBase->file_lock);
+            free(magBase);
+            return NULL;
+        }
+    }
+    magBase->next_txn = header->next_txn_id;
+
+    // What recovery redid is written to the file if other processes read it
+    if (unlockFileOpen(magBase) != 0) {
+        fprintf(stderr, "Failed to write the recovered pages to %s\n", path);
+    }
     return magBase;
 }
 
+// Log the pending pages and the header, then hand the pages to the pool as committed. A
+// checkpoint follows when checkpoint is set or the log grew large. *commit_lsn gets what
+// walAwait has to wait for, 0 when nothing was logged. The caller holds lockFileHeader
+// Returns 0 on success, -1 on error
+static int commitLog(MagBase *magBase, bool checkpoint, uint64_t *commit_lsn) {
+    // The database file grew, its directory entry has to reach the disk as well
+    bool grew = magBase->header->page_count > magBase->committed_header.page_count;
+
+    Wal *wal = magBase->wal;
+    uint64_t txn_id = walBegin(wal);
+    int logged = walLogPendingPages(wal, magBase, txn_id);
+    if (logged < 0) {
+        return -1;
+    }
+
+    int header_changed = memcmp(magBase->header, &magBase->committed_header, sizeof(Header)) != 0;
+    if (logged == 0 && !header_changed) {
+        // Pages written back to what they were are committed as they are
+        magBase->writing_txn = 0;
+        return markPagesCommitted(magBase->buffer_pool, magBase);
+    }
+    if (header_changed && walLogHeader(wal, txn_id, magBase->header, &magBase->committed_header) != 0) {
+        return -1;
+    }
+    if (walCommit(wal, txn_id, commit_lsn) != 0) {
+        return -1;
+    }
+
+    // The rows of the transaction are durable, snapshots taken from now on see them
+    magBase->writing_txn = 0;
+    magBase->committed_header = *magBase->header;
+    if (markPagesCommitted(magBase->buffer_pool, magBase) != 0) {
+        return -1;
+    }
+    if (magBase->sync_mode == SYNC_FULL_DIR && grew && syncDirectory(magBase) != 0) {
+        return -1;
+    }
+    if (checkpoint || walSize(wal) >= WAL_CHECKPOINT_BYTES) {
+        return walCheckpoint(wal, magBase);
+    }
+    return 0;
+}
+
+int writeCommit(MagBase *magBase, uint64_t *commit_lsn) {
+    *commit_lsn = 0;
+    if (!magBase->wal) {
+        // The writer holds the header lock exclusively, see lockFileWriter
+        bool grew = magBase->header->page_count > magBase->committed_header.page_count;
+        flushAllDirtyPages(magBase->buffer_pool, magBase);
+        magBase->header->change_counter++;
+        writeHeader(magBase);
+        pthread_mutex_lock(&magBase->file_lock);
+        magBase->committed_header = *magBase->header;
+        pthread_mutex_unlock(&magBase->file_lock);
+        if (magBase->sync_mode >= SYNC_FULL && fdatasync(fileno(magBase->file_pointer)) != 0) {
+            return -1;
+        }
+        return magBase->sync_mode == SYNC_FULL_DIR && grew ? syncDirectory(magBase) : 0;
+    }
+
+    // Pages only reach the file under the exclusive header lock, a process opening the file
+    // meanwhile waits and finds the commit in the log. Readers of other processes only look at
+    // the file, while there are any every commit writes its pages there. It fails if their
+    // reads do not let it within LOCK_TIMEOUT_MS
+    if (lockFileHeader(magBase) != 0) {
+        return -1;
+    }
+    int result = commitLog(magBase, fileShared(magBase), commit_lsn);
+    unlockFileHeader(magBase);
+    return result;
+}
+
+int awaitCommit(MagBase *magBase, uint64_t commit_lsn) {
+    if (!magBase->wal || commit_lsn == 0) {
+        return 0;
+    }
+    return walAwait(magBase->wal, commit_lsn);
+}
+
+int commitDatabase(MagBase *magBase) {
+    uint64_t commit_lsn;
+    if (writeCommit(magBase, &commit_lsn) != 0) {
+        return -1;
+    }
+    return awaitCommit(magBase, commit_lsn);
+}
+
+int rollbackDatabase(MagBase *magBase) {
+    // Cached schemas may hold some of the abandoned changes
+    invalidateCatalog(magBase);
+    if (!magBase->wal) {
+        return -1;
+    }
+
+    discardPendingPages(magBase->buffer_pool);
+    pthread_mutex_lock(&magBase->file_lock);
+    *magBase->header = magBase->committed_header;
+    pthread_mutex_unlock(&magBase->file_lock);
+    // Its id is not handed out again, snapshots taken meanwhile may still name it
+    magBase->writing_txn = 0;
+    return 0;
+}
+
+uint64_t writerTxn(MagBase *magBase) {
+    uint64_t txn = magBase->writing_txn;
+    if (txn == 0) {
+        // Published before next_txn moves past it, so a snapshot that sees the new next_txn
+        // also sees the transaction running
+        txn = magBase->next_txn;
+        magBase->writing_txn = txn;
+        magBase->next_txn = txn + 1;
+    }
+    magBase->header->next_txn_id = txn + 1;
+    return txn;
+}
+
+static const char *sync_mode_names[] = {"off", "normal", "full", "full+dir"};
+
+int setSyncMode(MagBase *magBase, SyncMode mode) {
+    magBase->sync_mode = mode;
+    if (magBase->wal) {
+        magBase->wal->sync_mode = mode;
+        // Commits leave the log unsynced, it is synced before a page that depends on it is written
+        magBase->buffer_pool->wal = mode == SYNC_NORMAL ? magBase->wal : NULL;
+    }
+
+    // The file and its log may have just been created
+    return mode == SYNC_FULL_DIR ? syncDirectory(magBase) : 0;
+}
+
+int parseSyncMode(const char *name, SyncMode *mode) {
+    for (int m = SYNC_OFF; m <= SYNC_FULL_DIR; m++) {
+        if (!strcmp(name, sync_mode_names[m])) {
+            *mode = (SyncMode)m;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+const char *syncModeName(SyncMode mode) { return sync_mode_names[mode]; }
+
+int syncDirectory(MagBase *magBase) {
+    char directory[512];
+    snprintf(directory, sizeof(directory), "%s", magBase->filePath);
+    char *slash = strrchr(directory, '/');
+    if (!slash) {
+        strcpy(directory, ".");
+    } else if (slash == directory) {
+        directory[1] = '\0';
+    } else {
+        *slash = '\0';
+    }
+
+    int fd = open(directory, O_RDONLY);
+    if (fd < 0) {
+        return -1;
+    }
+    int result = fsync(fd);
+    close(fd);
+    return result == 0 ? 0 : -1;
+}
+
+PageTrailer *pageTrailer(MagBase *magBase, char *page_buffer) {
+    return (PageTrailer *)(page_buffer + magBase->page_size - magBase->trailer_size);
+}
+
 int freeDatabase(MagBase *magBase) {
-    // Flush all dirty pages before closing
-    flushAllDirtyPages(magBase->buffer_pool, magBase);
+    // While another process writes, it has already written what this one committed to the
+    // file and the cached pages may be older than it
+    bool locked = tryFileWriter(magBase) == 0;
+    if (magBase->wal) {
+        // Only committed changes may reach the file, the rest of the command is abandoned. While
+        // another process has the file open, unlockFileWriter checkpoints instead
+        discardPendingPages(magBase->buffer_pool);
+        *magBase->header = magBase->committed_header;
+        if (locked && !fileShared(magBase)) {
+            flushAllDirtyPages(magBase->buffer_pool, magBase);
+            writeHeader(magBase);
+        }
+    } else if (locked) {
+        // Flush all dirty pages before closing
+        flushAllDirtyPages(magBase->buffer_pool, magBase);
+        magBase->header->change_counter++;
+        writeHeader(magBase);
+        if (magBase->sync_mode == SYNC_NORMAL) {
+            fdatasync(fileno(magBase->file_pointer));
+        }
+    }
+    unlockFileWriter(magBase);
+    closeWal(magBase->wal);
 
+    invalidateCatalog(magBase);
+    while (magBase->retired_catalogs) {
+        Catalog *retired = magBase->retired_catalogs;
+        magBase->retired_catalogs = retired->retired;
+        freeCatalog(retired);
+    }
+    pthread_mutex_destroy(&magBase->catalog_lock);
     free(magBase->header);
+    // Closing the file gives up every lock the process holds on it
     fclose(magBase->file_pointer);
+    pthread_mutex_destroy(&magBase->file_lock);
     // free(magBase->filePath); // Not needed unless I decide to heap allocate the filepath
-    free(magBase->buffer_pool);
+    freeBufferPool(magBase->buffer_pool);
 
     free(magBase);
     return 0;
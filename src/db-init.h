@@ -6,6 +6,7 @@
 
 #include "globals.h"
 #include "structs/bufferStruct.h"
+#include <pthread.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
@@ -20,33 +21,145 @@ typedef struct {
     uint8_t patch;
 } Version;
 
+// Next record id of a table that handed ids out since its schema saved them, see allocateRecordId
+typedef struct {
+    uint16_t table_id;        // 0 for an unused slot
+    uint16_t reserved;
+    uint32_t ids_left;        // Ids of the reserved range not handed out yet, the next is high_water - ids_left
+    uint64_t high_water;      // The table's saved next_record_id when the slot was set
+} RecordIdHint;
+
 typedef struct {
     char magic[MAGIC_LENGTH]; // The signature to confirm the file is a magdb file
     Version version;          // the version num, duh
-    uint32_t page_size;       // size of a page (currently 4096)
+    uint32_t page_size;       // size of a page, chosen when the file is created (see validPageSize)
     uint64_t page_count;      // total pages
     uint64_t schema_root;     // page number of the schema table
     uint64_t free_list_head;  // first free page
+    uint64_t stats_root;      // first table statistics page, 0 until a table is analyzed
+    uint64_t checkpoint_lsn;  // every WAL record below this LSN is in the file
+    uint64_t next_txn_id;     // Id of the next transaction that writes rows (1.4 on)
+    uint64_t change_counter;  // Moves whenever pages reach the file, other processes then drop what they cached
+    RecordIdHint id_hints[RECORD_ID_HINTS]; // Tables that handed out record ids last, most recent first
 } Header;
 
+// Last bytes of every database page in files from 1.2 on, 1.2 files only have the lsn
+typedef struct {
+    uint64_t lsn;             // LSN of the last WAL record applied to the page
+    uint32_t reserved;
+    uint32_t checksum;        // CRC32C of the page before this field, set when the page is written (1.3 on)
+} PageTrailer;
+
+// How hard a commit works to survive a power loss, chosen per open with setSyncMode
+typedef enum {
+    SYNC_OFF,      // Never sync, a crash of the machine may lose or corrupt anything since the last close
+    SYNC_NORMAL,   // Sync the log only before pages reach the file and at checkpoints, the newest commits may be lost
+    SYNC_FULL,     // Sync the log on every commit (the default)
+    SYNC_FULL_DIR, // SYNC_FULL, and sync the directory whenever the database file grows
+} SyncMode;
+
+struct Wal;
+struct Catalog;
+
 typedef struct {
     char *filePath;
     FILE *file_pointer;
     Header *header;
     BufferPool *buffer_pool;
     size_t page_size;
+    size_t usable_page_size;  // page_size without the PageTrailer, what page layouts may fill
+    size_t trailer_size;      // Bytes of PageTrailer the file's pages carry, 0 before 1.2
+    struct Wal *wal;          // NULL for files older than 1.2, which are written in place
+    Header committed_header;  // Header as of the last commit, to log only real changes. Changed under file_lock
+    struct Catalog *_Atomic catalog;  // Table schemas by id and name, NULL until first needed
+    pthread_mutex_t catalog_lock;     // Held while the catalog loads, readers may need it at once
+    struct Catalog *retired_catalogs; // Dropped by DDL, kept until close since names point into them
+    SyncMode sync_mode;
+    size_t version_size;              // Bytes of RowVersion before every row, 0 before 1.4
+    bool compact_rows;                // Rows are encoded without per field types, from 1.5 on
+    _Atomic uint64_t next_txn;        // header->next_txn_id, which snapshots read while the writer runs
+    _Atomic uint64_t writing_txn;     // Transaction whose rows are not committed yet, 0 if none
+    bool compact_pages;               // Appends may compact a full page, no reader is in its table meanwhile
+    // Guards the fcntl locks of the process, committed_header and the fields below. Locks are
+    // taken in one order: the lock manager's, file_lock, the page latches of a thread's window,
+    // then catalog_lock and the locks inside the pool and the log, which are held without
+    // taking another. A thread lets go of its window before it takes file_lock
+    pthread_mutex_t file_lock;
+    int file_readers;                 // Reads of the process under the shared header lock
+    bool file_writer;                 // The process holds the writer lock of the file
+    short header_lock;                // What the process holds of the header lock, F_UNLCK, F_RDLCK or F_WRLCK
 } MagBase;
 
 typedef struct {
     uint16_t slot_count;
     uint16_t free_space_offset;
+    uint16_t dead_count;      // Rows with a deleted_txn, vacuum removes them (1.4 on)
+    uint16_t dead_bytes;      // Bytes those rows take up, what compacting the page could free (1.4 on)
     uint64_t next_page;
 } PageHeader;
 
+// Every offset of a page fits PageHeader: pages larger than 4096 bytes only exist in files
+// with trailers, which page layouts never fill
+_Static_assert(MAX_PAGE_SIZE - sizeof(PageTrailer) <= UINT16_MAX, "page offsets must fit 16 bits");
+
+// Leads every row of a data page in files from 1.4 on. A row is never changed in place: an
+// update marks the old version deleted and appends the new one, so a snapshot keeps its rows
+typedef struct {
+    uint64_t created_txn;     // Transaction that wrote the row
+    uint64_t deleted_txn;     // Transaction that deleted or replaced it, 0 while it is live
+} RowVersion;
+
 int freeDatabase(MagBase *magBase);
 MagBase *createMagBase(Header *header, char path[], bool newFile);
+
+// Open an existing database file, path must outlive the database
+// Returns NULL if the file cannot be opened or is not a MagBase database
+MagBase *openMagBase(char *path);
 int writeHeader(MagBase *magBase);
-Header *createHeader(Header *newHeader);
-char *appendFileExt(char *path);
+
+// Make the changes of the current command durable. With a WAL this logs the changed pages and
+// the header and syncs the log once, the pages themselves are written to the file later
+// Returns 0 on success, -1 on error
+int commitDatabase(MagBase *magBase);
+
+// commitDatabase in two steps, so a writer can let the next one in before its sync. writeCommit
+// logs the changes, and from then on snapshots see them, *commit_lsn gets what awaitCommit
+// waits for. awaitCommit needs none of the writer's locks, committers waiting at once share
+// one sync of the log
+// Returns 0 on success, -1 on error
+int writeCommit(MagBase *magBase, uint64_t *commit_lsn);
+int awaitCommit(MagBase *magBase, uint64_t commit_lsn);
+
+// Throw away every change since the last commit
+// Returns 0 on success, -1 for files older than 1.2, which are written in place and cannot roll back
+int rollbackDatabase(MagBase *magBase);
+
+// The transaction the rows written until the next commit or rollback are stamped with,
+// started by the first call after one (1.4 files)
+uint64_t writerTxn(MagBase *magBase);
+
+// Choose how commits and checkpoints sync, right after the database is opened
+// Returns 0 on success, -1 if syncing the directory fails (SYNC_FULL_DIR)
+int setSyncMode(MagBase *magBase, SyncMode mode);
+
+// Parse off, normal, full or full+dir
+// Returns 0 on success, -1 for an unknown name
+int parseSyncMode(const char *name, SyncMode *mode);
+const char *syncModeName(SyncMode mode);
+
+// fsync the directory holding the database, so new and grown files are found after a crash
+// Returns 0 on success, -1 on error
+int syncDirectory(MagBase *magBase);
+
+// Returns the trailer of a page, only meaningful when the file has trailers (see createMagBase)
+PageTrailer *pageTrailer(MagBase *magBase, char *page_buffer);
+// Fill in the header of a new file with pages of page_size bytes, see validPageSize
+Header *createHeader(Header *newHeader, uint32_t page_size);
+
+// Returns true if page_size is a power of two from MIN_PAGE_SIZE to MAX_PAGE_SIZE
+bool validPageSize(uint32_t page_size);
+// Copy path into out (size bytes) with ".mab" added when it does not end in it
+// Returns out
+char *appendFileExt(const char *path, char *out, size_t size);
 
 extern Version version;
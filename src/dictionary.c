@@ -0,0 +1,290 @@
+//     Keagan Anderson
+//        MagBase
+//       10/19/2026
+//
+//     Dictionary columns (see dictionary.h)
+
+#include "dictionary.h"
+#include "buffer.h"
+#include "row-codec.h"
+#include "schema.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// FNV-1a
+static uint32_t hashText(const char *text, size_t length) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ (unsigned char)text[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static Dictionary *createDictionary(void) {
+    Dictionary *dictionary = calloc(1, sizeof(Dictionary));
+    if (dictionary) {
+        pthread_mutex_init(&dictionary->lock, NULL);
+    }
+    return dictionary;
+}
+
+void freeDictionary(Dictionary *dictionary) {
+    if (!dictionary) {
+        return;
+    }
+
+    for (uint32_t code = 0; code < dictionary->count; code++) {
+        free(dictionary->chunks[code / DICTIONARY_CHUNK_CODES][code % DICTIONARY_CHUNK_CODES].text);
+    }
+    for (size_t c = 0; c < sizeof(dictionary->chunks) / sizeof(dictionary->chunks[0]); c++) {
+        free(dictionary->chunks[c]);
+    }
+    free(dictionary->slots);
+    pthread_mutex_destroy(&dictionary->lock);
+    free(dictionary);
+}
+
+const DictionaryValue *dictionaryValue(const Dictionary *dictionary, uint32_t code) {
+    if (code >= dictionary->count) {
+        return NULL;
+    }
+    return &dictionary->chunks[code / DICTIONARY_CHUNK_CODES][code % DICTIONARY_CHUNK_CODES];
+}
+
+// The caller holds the dictionary lock
+static int32_t lookupCode(Dictionary *dictionary, const char *text, size_t length) {
+    if (!dictionary->slots) {
+        return -1;
+    }
+
+    for (uint32_t slot = hashText(text, length) & dictionary->slot_mask; dictionary->slots[slot] != 0;
+         slot = (slot + 1) & dictionary->slot_mask) {
+        const DictionaryValue *value = dictionaryValue(dictionary, dictionary->slots[slot] - 1);
+        if (value->length == length && !memcmp(value->text, text, length)) {
+            return (int32_t)(dictionary->slots[slot] - 1);
+        }
+    }
+    return -1;
+}
+
+int32_t findDictionaryCode(Dictionary *dictionary, const char *text) {
+    pthread_mutex_lock(&dictionary->lock);
+    int32_t code = lookupCode(dictionary, text, strnlen(text, MAX_RECORD_VALUE_SIZE - 1));
+    pthread_mutex_unlock(&dictionary->lock);
+    return code;
+}
+
+// Hash every code again into slots twice as many as before
+static int growSlots(Dictionary *dictionary) {
+    uint32_t slots = dictionary->slots ? (dictionary->slot_mask + 1) * 2 : 64;
+    uint32_t *grown = calloc(slots, sizeof(uint32_t));
+    if (!grown) {
+        return -1;
+    }
+
+    for (uint32_t code = 0; code < dictionary->count; code++) {
+        const DictionaryValue *value = dictionaryValue(dictionary, code);
+        uint32_t slot = hashText(value->text, value->length) & (slots - 1);
+        while (grown[slot] != 0) {
+            slot = (slot + 1) & (slots - 1);
+        }
+        grown[slot] = code + 1;
+    }
+    free(dictionary->slots);
+    dictionary->slots = grown;
+    dictionary->slot_mask = slots - 1;
+    return 0;
+}
+
+// Hand out the next code for text, the caller holds the dictionary lock. The value is in place
+// before count moves past it
+// Returns the code, or -1 on error
+static int32_t appendValue(Dictionary *dictionary, const char *text, size_t length) {
+    uint32_t code = dictionary->count;
+    if (code >= DICTIONARY_MAX_CODES) {
+        return -1;
+    }
+
+    // At most half full so probes stay short
+    if ((code + 1) * 2 > (dictionary->slots ? dictionary->slot_mask + 1 : 0) && growSlots(dictionary) != 0) {
+        return -1;
+    }
+
+    DictionaryValue **chunk = &dictionary->chunks[code / DICTIONARY_CHUNK_CODES];
+    if (!*chunk && !(*chunk = calloc(DICTIONARY_CHUNK_CODES, sizeof(DictionaryValue)))) {
+        return -1;
+    }
+    DictionaryValue *value = &(*chunk)[code % DICTIONARY_CHUNK_CODES];
+    value->text = malloc(length + 1);
+    if (!value->text) {
+        return -1;
+    }
+    memcpy(value->text, text, length);
+    value->text[length] = '\0';
+    value->length = (uint16_t)length;
+
+    uint32_t slot = hashText(text, length) & dictionary->slot_mask;
+    while (dictionary->slots[slot] != 0) {
+        slot = (slot + 1) & dictionary->slot_mask;
+    }
+    dictionary->slots[slot] = code + 1;
+    dictionary->count = code + 1;
+    return (int32_t)code;
+}
+
+int loadDictionaries(MagBase *db, const TableSchemaRecord *schema, RowCodec *codec) {
+    for (uint16_t i = 0; i < codec->dictionary_count; i++) {
+        codec->dictionaries[codec->dictionary_columns[i]] = createDictionary();
+        if (!codec->dictionaries[codec->dictionary_columns[i]]) {
+            return -1;
+        }
+    }
+
+    uint64_t page_num = schema->dictionary_page;
+    while (page_num != 0) {
+        char *page_buffer = readPageFromBuffer(db->buffer_pool, page_num, db->file_pointer, db->page_size);
+        if (!page_buffer) {
+            return -1;
+        }
+
+        DictionaryPageHeader *header = (DictionaryPageHeader *)page_buffer;
+        size_t offset = sizeof(DictionaryPageHeader);
+        for (uint16_t e = 0; e < header->entry_count; e++) {
+            DictionaryEntry entry;
+            memcpy(&entry, page_buffer + offset, sizeof(DictionaryEntry));
+            const char *text = page_buffer + offset + sizeof(DictionaryEntry);
+            offset += sizeof(DictionaryEntry) + entry.length;
+
+            Dictionary *dictionary = entry.column < MAX_COLUMNS ? codec->dictionaries[entry.column] : NULL;
+            if (!dictionary || appendValue(dictionary, text, entry.length) < 0) {
+                fprintf(stderr, "Dictionary page %lu of table %u is damaged\n", (unsigned long)page_num,
+                        schema->table_id);
+                return -1;
+            }
+        }
+        page_num = header->next_dictionary_page;
+    }
+    return 0;
+}
+
+// Allocate and clear a dictionary page
+static uint64_t newDictionaryPage(MagBase *db) {
+    uint64_t page_num = db->header->page_count++;
+    char *page_buffer = readPageFromBuffer(db->buffer_pool, page_num, db->file_pointer, db->page_size);
+    if (!page_buffer) {
+        return 0;
+    }
+
+    memset(page_buffer, 0, db->usable_page_size);
+    DictionaryPageHeader *header = (DictionaryPageHeader *)page_buffer;
+    header->free_space_offset = sizeof(DictionaryPageHeader);
+    header->last_dictionary_page = page_num;
+    markPageDirty(db->buffer_pool, page_num);
+    return page_num;
+}
+
+// Write an entry to the end of the table's dictionary pages, starting the chain or a new page
+// when needed
+// Returns 0 on success, -1 on error
+static int writeEntry(MagBase *db, uint16_t table_id, uint8_t column, const char *text, size_t length) {
+    TableSchemaRecord *schema = getTableSchema(db, table_id);
+    if (!schema) {
+        return -1;
+    }
+
+    if (schema->dictionary_page == 0) {
+        uint64_t first = newDictionaryPage(db);
+        if (first == 0) {
+            return -1;
+        }
+        // Readers may be copying the cached schema
+        pthread_mutex_lock(&db->catalog_lock);
+        schema->dictionary_page = (uint32_t)first;
+        pthread_mutex_unlock(&db->catalog_lock);
+        if (updateTableSchema(db, schema) != 0) {
+            return -1;
+        }
+    }
+
+    // The page pointers are not held across reads, the pool may evict them
+    char *page_buffer = readPageFromBuffer(db->buffer_pool, schema->dictionary_page, db->file_pointer, db->page_size);
+    if (!page_buffer) {
+        return -1;
+    }
+    uint64_t tail = ((DictionaryPageHeader *)page_buffer)->last_dictionary_page;
+
+    page_buffer = readPageFromBuffer(db->buffer_pool, tail, db->file_pointer, db->page_size);
+    if (!page_buffer) {
+        return -1;
+    }
+    size_t entry_size = sizeof(DictionaryEntry) + length;
+    if (((DictionaryPageHeader *)page_buffer)->free_space_offset + entry_size > db->usable_page_size) {
+        // Tail is full, chain a new dictionary page
+        uint64_t new_tail = newDictionaryPage(db);
+        if (new_tail == 0) {
+            return -1;
+        }
+        page_buffer = readPageFromBuffer(db->buffer_pool, tail, db->file_pointer, db->page_size);
+        if (!page_buffer) {
+            return -1;
+        }
+        ((DictionaryPageHeader *)page_buffer)->next_dictionary_page = new_tail;
+        markPageDirty(db->buffer_pool, tail);
+
+        page_buffer = readPageFromBuffer(db->buffer_pool, schema->dictionary_page, db->file_pointer, db->page_size);
+        if (!page_buffer) {
+            return -1;
+        }
+        ((DictionaryPageHeader *)page_buffer)->last_dictionary_page = new_tail;
+        markPageDirty(db->buffer_pool, schema->dictionary_page);
+
+        tail = new_tail;
+        page_buffer = readPageFromBuffer(db->buffer_pool, tail, db->file_pointer, db->page_size);
+        if (!page_buffer) {
+            return -1;
+        }
+    }
+
+    DictionaryPageHeader *header = (DictionaryPageHeader *)page_buffer;
+    DictionaryEntry entry = {column, (uint8_t)length};
+    memcpy(page_buffer + header->free_space_offset, &entry, sizeof(DictionaryEntry));
+    memcpy(page_buffer + header->free_space_offset + sizeof(DictionaryEntry), text, length);
+    header->free_space_offset += (uint16_t)entry_size;
+    header->entry_count++;
+    markPageDirty(db->buffer_pool, tail);
+    return 0;
+}
+
+int addDictionaryValues(MagBase *db, const RowCodec *codec, Record *record) {
+    if (!db || !codec || !record) {
+        return -1;
+    }
+
+    for (uint16_t i = 0; i < codec->dictionary_count; i++) {
+        uint8_t column = codec->dictionary_columns[i];
+        Dictionary *dictionary = codec->dictionaries[column];
+        if (column >= record->field_count || record->fields[column].is_null) {
+            continue;
+        }
+
+        // Values are at most MAX_RECORD_VALUE_SIZE - 1 bytes, the entry length is a uint8
+        const char *text = record->fields[column].value.text_val;
+        size_t length = strnlen(text, MAX_RECORD_VALUE_SIZE - 1);
+
+        pthread_mutex_lock(&dictionary->lock);
+        int32_t code = lookupCode(dictionary, text, length);
+        if (code < 0 && dictionary->count >= DICTIONARY_MAX_CODES) {
+            pthread_mutex_unlock(&dictionary->lock);
+            fprintf(stderr, "Dictionary of column %u is full (%u values)\n", column, DICTIONARY_MAX_CODES);
+            return -1;
+        }
+        if (code < 0 && (writeEntry(db, codec->table_id, column, text, length) != 0 ||
+                         appendValue(dictionary, text, length) < 0)) {
+            pthread_mutex_unlock(&dictionary->lock);
+            return -1;
+        }
+        pthread_mutex_unlock(&dictionary->lock);
+    }
+    return 0;
+}
@@ -0,0 +1,69 @@
+//     Keagan Anderson
+//        MagBase
+//       10/19/2026
+//
+//     Dictionary columns: the distinct values of a text column kept once in the table's
+//     dictionary pages, rows hold a uint16 code instead of the text
+
+#pragma once
+
+#include "db-init.h"
+#include "records.h"
+#include "structs/schemaStruct.h"
+#include <pthread.h>
+#include <stdint.h>
+
+#define DICTIONARY_CHUNK_CODES 256 // Values per chunk, chunks never move so readers need no lock
+
+struct RowCodec;
+
+// Dictionary pages form a chain from TableSchemaRecord.dictionary_page, entries follow the header
+typedef struct {
+    uint16_t entry_count;               // Entries stored in this page
+    uint16_t free_space_offset;
+    uint64_t next_dictionary_page;      // 0 on the last page
+    uint64_t last_dictionary_page;      // Tail of the chain, only kept on the first page
+} DictionaryPageHeader;
+
+// A value in a dictionary page, its bytes follow. The codes of a column are handed out in
+// entry order, starting at 0
+typedef struct {
+    uint8_t column;
+    uint8_t length;
+} DictionaryEntry;
+
+typedef struct {
+    char *text;
+    uint16_t length;
+} DictionaryValue;
+
+// The values of one dictionary column. Readers turn codes into text without a lock, the writer
+// appends values and looks codes up through slots under lock
+typedef struct Dictionary {
+    _Atomic uint32_t count;             // Codes handed out, the values below it never change
+    DictionaryValue *chunks[(DICTIONARY_MAX_CODES + DICTIONARY_CHUNK_CODES - 1) / DICTIONARY_CHUNK_CODES];
+    pthread_mutex_t lock;               // Guards slots and appends
+    uint32_t *slots;                    // Open addressing by text, code + 1, 0 is an empty slot
+    uint32_t slot_mask;
+} Dictionary;
+
+// Create the dictionaries of the dictionary columns of a schema and fill them from the table's
+// dictionary pages. The codec points at them from then on
+// Returns 0 on success, -1 on error
+int loadDictionaries(MagBase *db, const TableSchemaRecord *schema, struct RowCodec *codec);
+
+void freeDictionary(Dictionary *dictionary);
+
+// Text of a code, NULL if the dictionary has no such code
+const DictionaryValue *dictionaryValue(const Dictionary *dictionary, uint32_t code);
+
+// Returns the code of text, or -1 if the dictionary does not have it
+int32_t findDictionaryCode(Dictionary *dictionary, const char *text);
+
+// Give every value of the record's dictionary columns a code before it is encoded with codec.
+// New values are appended to the table's dictionary pages, the caller commits them with the row.
+// The codes are in the dictionary at once, before the commit: readers only decode the codes of
+// rows they see, which are committed along with their values. A rollback forgets the codes by
+// invalidating the catalog, which owns the dictionaries, the next load reads the pages again
+// Returns 0 on success, -1 if a dictionary is full or on error
+int addDictionaryValues(MagBase *db, const struct RowCodec *codec, Record *record);
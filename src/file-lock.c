@@ -0,0 +1,370 @@
+//     Keagan Anderson
+//        MagBase
+//       10/19/2026
+//
+//     Locks between processes sharing a database file (see file-lock.h)
+
+#include "file-lock.h"
+#include "buffer.h"
+#include "globals.h"
+#include "schema.h"
+#include "wal.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+// Set or clear one lock byte without waiting. fcntl locks belong to the process, so two threads
+// changing the same byte would undo each other: the caller holds file_lock, except for the
+// writer byte which only the thread holding LOCK_WRITER touches
+// Returns 0 on success, -1 with errno set if another process holds a conflicting lock
+static int setLockByte(MagBase *db, int byte, short type) {
+    struct flock lock;
+    memset(&lock, 0, sizeof(lock));
+    lock.l_type = type;
+    lock.l_whence = SEEK_SET;
+    lock.l_start = (off_t)(FILE_LOCK_OFFSET + byte);
+    lock.l_len = 1;
+
+    int status;
+    do {
+        status = fcntl(fileno(db->file_pointer), F_SETLK, &lock);
+    } while (status != 0 && errno == EINTR);
+    return status == 0 ? 0 : -1;
+}
+
+// Sleep before trying a lock again, the pause doubles up to about 10ms
+// Returns 0, or -1 once LOCK_TIMEOUT_MS passed since start
+static int pauseBeforeRetry(MagBase *db, const struct timespec *start, struct timespec *pause) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    long waited_ms = (long)(now.tv_sec - start->tv_sec) * 1000 + (now.tv_nsec - start->tv_nsec) / 1000000;
+    if (waited_ms >= LOCK_TIMEOUT_MS) {
+        fprintf(stderr, "%s is locked by another process\n", db->filePath);
+        return -1;
+    }
+    nanosleep(pause, NULL);
+    if (pause->tv_nsec < 10000000) {
+        pause->tv_nsec *= 2;
+    }
+    return 0;
+}
+
+// Take a lock byte, retrying while another process holds it
+// Returns 0 on success, -1 if it is not granted within LOCK_TIMEOUT_MS or on error
+static int waitLockByte(MagBase *db, int byte, short type) {
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    struct timespec pause = {0, 100000};
+
+    while (setLockByte(db, byte, type) != 0) {
+        if ((errno != EAGAIN && errno != EACCES) || pauseBeforeRetry(db, &start, &pause) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Wait until no other process holds the pending byte
+// Returns 0 once it is free, -1 after LOCK_TIMEOUT_MS or on error
+static int waitPendingFree(MagBase *db) {
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    struct timespec pause = {0, 100000};
+
+    while (1) {
+        struct flock probe;
+        memset(&probe, 0, sizeof(probe));
+        probe.l_type = F_RDLCK;
+        probe.l_whence = SEEK_SET;
+        probe.l_start = (off_t)(FILE_LOCK_OFFSET + FILE_LOCK_PENDING);
+        probe.l_len = 1;
+        if (fcntl(fileno(db->file_pointer), F_GETLK, &probe) != 0) {
+            return -1;
+        }
+        if (probe.l_type == F_UNLCK) {
+            return 0;
+        }
+        if (pauseBeforeRetry(db, &start, &pause) != 0) {
+            return -1;
+        }
+    }
+}
+
+// Move the header lock of the process to type, the caller holds file_lock. A writer holds the
+// pending byte exclusively while it waits for the readers to leave, new readers queue behind
+// it instead of starving it
+// Returns 0 on success, -1 if it is not granted
+static int setHeaderLock(MagBase *db, short type) {
+    if (db->header_lock == type) {
+        return 0;
+    }
+
+    // Giving up some of the lock never waits
+    if (type == F_UNLCK || (type == F_RDLCK && db->header_lock == F_WRLCK)) {
+        if (setLockByte(db, FILE_LOCK_HEADER, type) != 0) {
+            return -1;
+        }
+        db->header_lock = type;
+        return 0;
+    }
+
+    // A reader only looks at the pending byte, which saves it two calls per read
+    int status;
+    if (type == F_RDLCK) {
+        status = waitPendingFree(db);
+    } else {
+        status = waitLockByte(db, FILE_LOCK_PENDING, F_WRLCK);
+    }
+    if (status == 0) {
+        status = waitLockByte(db, FILE_LOCK_HEADER, type);
+    }
+    if (type == F_WRLCK) {
+        setLockByte(db, FILE_LOCK_PENDING, F_UNLCK);
+    }
+    if (status == 0) {
+        db->header_lock = type;
+    }
+    return status;
+}
+
+// The header lock the process needs once a lockFileHeader ends or a reader or writer leaves:
+// exclusive for the writer of a file without a log, shared while reads run, none otherwise
+static int settleHeaderLock(MagBase *db) {
+    if (db->file_writer && !db->wal) {
+        return setHeaderLock(db, F_WRLCK);
+    }
+    return setHeaderLock(db, db->file_readers > 0 ? F_RDLCK : F_UNLCK);
+}
+
+// Drop what the process caches of the file if another process changed it since, the caller
+// holds file_lock and a lock that keeps others from changing it meanwhile
+// Returns 0 on success, -1 on error
+static int refreshFile(MagBase *db) {
+    Header disk;
+    ssize_t got = pread(fileno(db->file_pointer), &disk, sizeof(Header), 0);
+    // A file being created has no header yet, there is nothing to drop
+    if (got < (ssize_t)sizeof(Header) || disk.change_counter == db->committed_header.change_counter) {
+        return got < 0 ? -1 : 0;
+    }
+
+    if (dropCachedPages(db->buffer_pool) != 0) {
+        fprintf(stderr, "Another process changed %s while pages were held\n", db->filePath);
+        return -1;
+    }
+    invalidateCatalog(db);
+    *db->header = disk;
+    db->committed_header = disk;
+    db->next_txn = disk.next_txn_id;
+    db->writing_txn = 0;
+    return 0;
+}
+
+// Write the committed pages only in the log to the file, under the exclusive header lock
+// Returns 0 on success, -1 on error
+static int publishLog(MagBase *db) {
+    if (lockFileHeader(db) != 0) {
+        return -1;
+    }
+    int status = walCheckpoint(db->wal, db);
+    unlockFileHeader(db);
+    return status;
+}
+
+bool fileShared(MagBase *db) {
+    struct flock probe;
+    memset(&probe, 0, sizeof(probe));
+    probe.l_type = F_WRLCK;
+    probe.l_whence = SEEK_SET;
+    probe.l_start = (off_t)(FILE_LOCK_OFFSET + FILE_LOCK_PRESENT);
+    probe.l_len = 1;
+
+    // The process's own presence lock never conflicts, only other processes show up. When in
+    // doubt the file counts as shared, which only costs checkpoints
+    if (fcntl(fileno(db->file_pointer), F_GETLK, &probe) != 0) {
+        return true;
+    }
+    return probe.l_type != F_UNLCK;
+}
+
+int lockFileReader(MagBase *db) {
+    releasePageWindow(db->buffer_pool);
+    pthread_mutex_lock(&db->file_lock);
+    int status = 0;
+    if (db->header_lock == F_UNLCK) {
+        // While the process holds the writer lock no other process changes the file, what
+        // differs from the file is the writer's own commit
+        status = setHeaderLock(db, F_RDLCK);
+        if (status == 0 && !db->file_writer && refreshFile(db) != 0) {
+            setHeaderLock(db, F_UNLCK);
+            status = -1;
+        }
+    }
+    if (status == 0) {
+        db->file_readers++;
+    }
+    pthread_mutex_unlock(&db->file_lock);
+    return status;
+}
+
+void unlockFileReader(MagBase *db) {
+    releasePageWindow(db->buffer_pool);
+    pthread_mutex_lock(&db->file_lock);
+    if (db->file_readers > 0) {
+        db->file_readers--;
+        settleHeaderLock(db);
+    }
+    pthread_mutex_unlock(&db->file_lock);
+}
+
+// Finish taking the writer lock once the process holds its byte, the caller holds file_lock
+// Returns 0 on success, -1 on error, the byte is given back then
+static int claimWriter(MagBase *db) {
+    db->file_writer = true;
+    int status = settleHeaderLock(db);
+    if (status == 0) {
+        status = refreshFile(db);
+    }
+
+    // Another process wrote or emptied the log since. Records it holds were committed by a
+    // writer that died before it could write them to the file
+    if (status == 0 && db->wal && !walCurrent(db->wal)) {
+        bool shared = fileShared(db);
+        if (shared && setHeaderLock(db, F_WRLCK) != 0) {
+            status = -1;
+        } else {
+            status = walAdopt(db->wal, db);
+            // The redone commits may have changed schemas and handed out record ids
+            invalidateCatalog(db);
+            if (status == 0 && shared && walSize(db->wal) > 0) {
+                status = walCheckpoint(db->wal, db);
+            }
+            if (settleHeaderLock(db) != 0) {
+                status = -1;
+            }
+        }
+    }
+
+    if (status != 0) {
+        db->file_writer = false;
+        settleHeaderLock(db);
+        setLockByte(db, FILE_LOCK_WRITER, F_UNLCK);
+    }
+    return status;
+}
+
+int lockFileOpen(MagBase *db) {
+    pthread_mutex_init(&db->file_lock, NULL);
+    db->file_readers = 0;
+    db->file_writer = false;
+    db->header_lock = F_UNLCK;
+    if (setLockByte(db, FILE_LOCK_PRESENT, F_RDLCK) != 0) {
+        return -1;
+    }
+
+    char log_path[600];
+    snprintf(log_path, sizeof(log_path), "%s-wal", db->filePath);
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    struct timespec pause = {0, 100000};
+
+    while (1) {
+        if (setLockByte(db, FILE_LOCK_WRITER, F_WRLCK) == 0) {
+            pthread_mutex_lock(&db->file_lock);
+            int status = claimWriter(db);
+            pthread_mutex_unlock(&db->file_lock);
+            return status;
+        }
+
+        // Once its log is empty the writer has written every commit to the file, and the next
+        // ones wait for the header lock
+        if (lockFileReader(db) != 0) {
+            return -1;
+        }
+        struct stat info;
+        if (stat(log_path, &info) != 0 || (size_t)info.st_size <= sizeof(WalFileHeader)) {
+            return 0;
+        }
+        unlockFileReader(db);
+        if (pauseBeforeRetry(db, &start, &pause) != 0) {
+            return -1;
+        }
+    }
+}
+
+int unlockFileOpen(MagBase *db) {
+    if (db->file_writer) {
+        return unlockFileWriter(db);
+    }
+    unlockFileReader(db);
+    return 0;
+}
+
+int lockFileWriter(MagBase *db) {
+    if (db->file_writer) {
+        return 0;
+    }
+
+    // A writer of another process may hold it for a whole transaction, readers of this process
+    // keep going meanwhile
+    if (waitLockByte(db, FILE_LOCK_WRITER, F_WRLCK) != 0) {
+        return -1;
+    }
+    releasePageWindow(db->buffer_pool);
+    pthread_mutex_lock(&db->file_lock);
+    int status = claimWriter(db);
+    pthread_mutex_unlock(&db->file_lock);
+    return status;
+}
+
+int tryFileWriter(MagBase *db) {
+    if (db->file_writer) {
+        return 0;
+    }
+    if (setLockByte(db, FILE_LOCK_WRITER, F_WRLCK) != 0) {
+        return -1;
+    }
+    releasePageWindow(db->buffer_pool);
+    pthread_mutex_lock(&db->file_lock);
+    int status = claimWriter(db);
+    pthread_mutex_unlock(&db->file_lock);
+    return status;
+}
+
+int unlockFileWriter(MagBase *db) {
+    if (!db->file_writer) {
+        return 0;
+    }
+
+    // Readers of other processes only look at the file
+    int status = 0;
+    if (db->wal && walSize(db->wal) > 0 && fileShared(db)) {
+        status = publishLog(db);
+    }
+
+    releasePageWindow(db->buffer_pool);
+    pthread_mutex_lock(&db->file_lock);
+    db->file_writer = false;
+    settleHeaderLock(db);
+    setLockByte(db, FILE_LOCK_WRITER, F_UNLCK);
+    pthread_mutex_unlock(&db->file_lock);
+    return status;
+}
+
+int lockFileHeader(MagBase *db) {
+    releasePageWindow(db->buffer_pool);
+    pthread_mutex_lock(&db->file_lock);
+    int status = setHeaderLock(db, F_WRLCK);
+    if (status != 0) {
+        pthread_mutex_unlock(&db->file_lock);
+    }
+    return status;
+}
+
+void unlockFileHeader(MagBase *db) {
+    settleHeaderLock(db);
+    pthread_mutex_unlock(&db->file_lock);
+}
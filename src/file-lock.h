@@ -0,0 +1,65 @@
+//     Keagan Anderson
+//        MagBase
+//       10/19/2026
+//
+//     Locks between processes sharing a database file: fcntl byte-range locks on bytes far past
+//     the end of the file, and the change counter in the header that tells a process its
+//     cached pages are stale
+
+#pragma once
+
+#include "db-init.h"
+#include <stdbool.h>
+
+// Lock bytes, from FILE_LOCK_OFFSET on
+#define FILE_LOCK_PRESENT 0 // Shared by every process that has the file open
+#define FILE_LOCK_WRITER 1  // Exclusive for the process writing, from its first write until it commits
+#define FILE_LOCK_PENDING 2 // Exclusive while a process waits for the header, new readers queue behind it
+#define FILE_LOCK_HEADER 3  // Shared while a process reads the file, exclusive while one writes pages to it
+
+// Lock a file that was just opened: the presence lock, and the writer lock while the log is
+// recovered. When the writer of another process holds that, the process reads like
+// lockFileReader instead, once the writer has written every commit to the file
+// Returns 0 on success, -1 if neither is granted within LOCK_TIMEOUT_MS or on error
+int lockFileOpen(MagBase *db);
+
+// Give back what lockFileOpen took, what recovery redid is written to the file first if another
+// process has it open
+// Returns 0 on success, -1 if it could not be written
+int unlockFileOpen(MagBase *db);
+
+// Returns true if another process has the file open. Its readers look at the file, so commits
+// write their pages there at once instead of leaving them in the log
+bool fileShared(MagBase *db);
+
+// Start a read: the first reader of the process takes the header lock shared and, if another
+// process changed the file since, drops the cached pages, catalog and header. Not while the
+// process holds the writer lock, no other process can change the file then
+// Returns 0 on success, -1 on error
+int lockFileReader(MagBase *db);
+void unlockFileReader(MagBase *db);
+
+// Take the writer lock, waiting up to LOCK_TIMEOUT_MS for the writer of another process. It
+// refreshes like lockFileReader and takes over the log as the last writer left it. Files
+// without a log are written in place, their writer also holds the header lock exclusively
+// Does nothing if the process already holds it
+// Returns 0 on success, -1 if it is not granted or on error
+int lockFileWriter(MagBase *db);
+
+// Take the writer lock only if no other process holds it, for a close: another writer has
+// already written what this process committed
+// Returns 0 if the process holds it, -1 otherwise
+int tryFileWriter(MagBase *db);
+
+// Give the writer lock back, after the commit or rollback. Committed pages only in the log are
+// written to the file first if another process has it open
+// Returns 0 on success, -1 if they could not be written
+int unlockFileWriter(MagBase *db);
+
+// Hold the header lock exclusively while pages are written to the file, waiting out the
+// readers of other processes. The caller holds the writer lock. file_lock is held until
+// unlockFileHeader, the committed header changes under it and reads of the process start or
+// end after the pages are written
+// Returns 0 on success, -1 on error
+int lockFileHeader(MagBase *db);
+void unlockFileHeader(MagBase *db);
@@ -0,0 +1,197 @@
+//     Keagan Anderson
+//        MagBase
+//       10/19/2026
+//
+//     Row filters (WHERE col <op> value), ANDed together
+
+#include "filter.h"
+#include "dictionary.h"
+#include "schema.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *op_names[] = {"=", "!=", "<", "<=", ">", ">="};
+
+const char *predicateOpName(uint8_t op) {
+    return op <= PRED_GE ? op_names[op] : "?";
+}
+
+int parsePredicate(TableSchemaRecord *schema, const char *text, Filter *filter) {
+    if (!schema || !text || !filter || filter->count >= MAX_PREDICATES) {
+        return -1;
+    }
+
+    size_t name_len = strcspn(text, "=!<>");
+    if (name_len == 0 || name_len >= MAX_COLUMN_NAME || text[name_len] == '\0') {
+        fprintf(stderr, "Invalid predicate: %s (use col<op>value)\n", text);
+        return -1;
+    }
+
+    char name[MAX_COLUMN_NAME];
+    memcpy(name, text, name_len);
+    name[name_len] = '\0';
+
+    int column = findColumn(schema, name);
+    if (column < 0) {
+        fprintf(stderr, "Unknown column in predicate: %s\n", name);
+        return -1;
+    }
+
+    const char *op_text = text + name_len;
+    uint8_t op;
+    if (!strncmp(op_text, "!=", 2)) {
+        op = PRED_NE;
+    } else if (!strncmp(op_text, "<=", 2)) {
+        op = PRED_LE;
+    } else if (!strncmp(op_text, ">=", 2)) {
+        op = PRED_GE;
+    } else if (op_text[0] == '=') {
+        op = PRED_EQ;
+    } else if (op_text[0] == '<') {
+        op = PRED_LT;
+    } else if (op_text[0] == '>') {
+        op = PRED_GT;
+    } else {
+        fprintf(stderr, "Unknown operator in predicate: %s\n", text);
+        return -1;
+    }
+    const char *value = op_text + strlen(predicateOpName(op));
+
+    Predicate *predicate = &filter->predicates[filter->count];
+    memset(predicate, 0, sizeof(Predicate));
+    predicate->column = (uint16_t)column;
+    predicate->op = op;
+    predicate->value.type = schema->columns[column].type;
+
+    if (!strcmp(value, "NULL")) {
+        if (op != PRED_EQ && op != PRED_NE) {
+            fprintf(stderr, "NULL can only be compared with = or !=\n");
+            return -1;
+        }
+        predicate->value.is_null = 1;
+    } else {
+        char *end = NULL;
+        switch (schema->columns[column].type) {
+            case COL_INT:
+                predicate->value.value.int_val = (int32_t)strtol(value, &end, 10);
+                if (*value == '\0' || *end != '\0') {
+                    fprintf(stderr, "Expected an int in predicate: %s\n", text);
+                    return -1;
+                }
+                break;
+            case COL_BOOL:
+                predicate->value.value.bool_val = (!strcmp(value, "true") || !strcmp(value, "1")) ? 1 : 0;
+                break;
+            case COL_TEXT:
+                strncpy(predicate->value.value.text_val, value, MAX_RECORD_VALUE_SIZE - 1);
+                break;
+        }
+    }
+
+    filter->count++;
+    return 0;
+}
+
+// Returns 1 if the field satisfies the predicate, 0 otherwise
+static int fieldMatches(const Predicate *predicate, RecordField *field) {
+    if (predicate->value.is_null) {
+        return (predicate->op == PRED_EQ) == (field->is_null != 0);
+    }
+
+    // Comparisons against NULL are never true
+    if (field->is_null) {
+        return 0;
+    }
+
+    int cmp = compareFields(field, (RecordField *)&predicate->value);
+    switch (predicate->op) {
+        case PRED_EQ: return cmp == 0;
+        case PRED_NE: return cmp != 0;
+        case PRED_LT: return cmp < 0;
+        case PRED_LE: return cmp <= 0;
+        case PRED_GT: return cmp > 0;
+        case PRED_GE: return cmp >= 0;
+    }
+    return 0;
+}
+
+int recordMatchesFilter(const Filter *filter, Record *record) {
+    if (!filter) {
+        return 1;
+    }
+
+    for (uint16_t p = 0; p < filter->count; p++) {
+        const Predicate *predicate = &filter->predicates[p];
+        if (!fieldMatches(predicate, &record->fields[predicate->column])) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+void bindFilterCodes(Filter *filter, const RowCodec *codec) {
+    if (!filter || !codec) {
+        return;
+    }
+
+    // Codes are handed out in insert order, so only equality can be decided on them
+    for (uint16_t p = 0; p < filter->count; p++) {
+        Predicate *predicate = &filter->predicates[p];
+        Dictionary *dictionary = codec->dictionaries[predicate->column];
+        if (!dictionary || predicate->value.is_null || (predicate->op != PRED_EQ && predicate->op != PRED_NE)) {
+            continue;
+        }
+        predicate->coded = 1;
+        predicate->code = findDictionaryCode(dictionary, predicate->value.value.text_val);
+    }
+}
+
+int rowMatchesFilter(const Filter *filter, const RowCodec *codec, const uint8_t *row) {
+    if (!filter) {
+        return 1;
+    }
+
+    RecordField field;
+    for (uint16_t p = 0; p < filter->count; p++) {
+        const Predicate *predicate = &filter->predicates[p];
+        if (predicate->coded) {
+            // A NULL never matches, and neither does a value the dictionary lacks with =
+            int32_t code = decodeRowCode(codec, row, predicate->column);
+            if (code < 0 || (predicate->op == PRED_EQ) != (code == predicate->code)) {
+                return 0;
+            }
+            continue;
+        }
+
+        decodeRowField(codec, row, predicate->column, &field);
+        if (!fieldMatches(predicate, &field)) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+void formatPredicate(TableSchemaRecord *schema, const Predicate *predicate, char *out, size_t out_size) {
+    const char *name = schema ? schema->columns[predicate->column].name : "?";
+    const char *op = predicateOpName(predicate->op);
+
+    if (predicate->value.is_null) {
+        snprintf(out, out_size, "%s%sNULL", name, op);
+        return;
+    }
+
+    switch (predicate->value.type) {
+        case COL_INT:
+            snprintf(out, out_size, "%s%s%d", name, op, predicate->value.value.int_val);
+            break;
+        case COL_BOOL:
+            snprintf(out, out_size, "%s%s%s", name, op, predicate->value.value.bool_val ? "true" : "false");
+            break;
+        case COL_TEXT:
+            snprintf(out, out_size, "%s%s'%s'", name, op, predicate->value.value.text_val);
+            break;
+    }
+}
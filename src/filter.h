@@ -0,0 +1,52 @@
+//     Keagan Anderson
+//        MagBase
+//       10/19/2026
+//
+//     Row filters (WHERE col <op> value), ANDed together
+
+#pragma once
+
+#include "records.h"
+#include "row-codec.h"
+#include "structs/schemaStruct.h"
+#include <stdint.h>
+
+#define MAX_PREDICATES 16
+
+typedef enum { PRED_EQ, PRED_NE, PRED_LT, PRED_LE, PRED_GT, PRED_GE } PredicateOp;
+
+// column <op> value, a NULL value with = or != means IS NULL / IS NOT NULL
+typedef struct {
+    uint16_t column;
+    uint8_t op;                         // PredicateOp
+    uint8_t coded;                      // Set by bindFilterCodes, the column's code is compared with code
+    int32_t code;                       // Dictionary code of value, -1 if the dictionary does not have it
+    RecordField value;
+} Predicate;
+
+// Conjunction of predicates, an empty filter matches every row
+typedef struct Filter {
+    Predicate predicates[MAX_PREDICATES];
+    uint16_t count;
+} Filter;
+
+// Parse "col<op>value" (ops: = != < <= > >=) against a schema and append it to filter
+// Returns 0 on success, -1 on an unknown column, operator or a value of the wrong type
+int parsePredicate(TableSchemaRecord *schema, const char *text, Filter *filter);
+
+// Returns 1 if the record satisfies every predicate, 0 otherwise
+int recordMatchesFilter(const Filter *filter, Record *record);
+
+// Turn = and != on a dictionary column into a compare of codes, for rowMatchesFilter. Bind after
+// the snapshot of the scan is taken, the rows it sees only hold values the dictionary had then
+void bindFilterCodes(Filter *filter, const RowCodec *codec);
+
+// recordMatchesFilter on an encoded row (1.5 files), only the columns of the predicates are decoded
+// Returns 1 if the row satisfies every predicate, 0 otherwise
+int rowMatchesFilter(const Filter *filter, const RowCodec *codec, const uint8_t *row);
+
+// Operator as written in a predicate, for plans and errors
+const char *predicateOpName(uint8_t op);
+
+// Render a predicate as "col<op>value" into out
+void formatPredicate(TableSchemaRecord *schema, const Predicate *predicate, char *out, size_t out_size);
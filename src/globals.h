@@ -5,10 +5,50 @@
 #pragma once
 
 #define DB_VERSION_MAJOR 1
-#define DB_VERSION_MINOR 0
+#define DB_VERSION_MINOR 8
 #define DB_VERSION_PATCH 0
 
-#define PAGE_SIZE 4096
+#define PAGE_SIZE 4096           // Page size of a new database unless another one is chosen
+#define MIN_PAGE_SIZE 4096       // Page sizes a database may have, powers of two in between
+#define MAX_PAGE_SIZE 65536
+#define COMPRESS_BLOCK_SIZE 4096 // File system block, a page is stored compressed only when that frees one
 #define MAGIC "MAGDB.\0\0"
 #define MAGIC_LENGTH 8
-#define BUFFER_SIZE 10
+#define BUFFER_SIZE 256      // Frames of a buffer pool
+#define BUFFER_PARTITIONS 16 // Page table partitions of a buffer pool, each with its own lock (a power of two)
+
+#define SORT_MEMORY_BUDGET (4 * 1024 * 1024) // Bytes of rows a sort keeps in memory before spilling
+#define SORT_MERGE_FAN_IN 8                  // Runs merged at once, one buffer page each plus output
+#define JOIN_MEMORY_BUDGET (4 * 1024 * 1024) // Bytes of build rows a hash join keeps before partitioning
+#define JOIN_MAX_PARTITIONS 256              // Upper bound on grace hash join partitions
+
+#define STATS_HISTOGRAM_BUCKETS 16 // Equi-depth histogram buckets per column
+#define STATS_SAMPLE_SIZE 4096     // Reservoir sample per column the histogram is built from
+#define STATS_HLL_BITS 8           // HyperLogLog uses 2^bits registers for distinct counts
+
+#define SCAN_MORSEL_PAGES 16 // Pages a parallel scan worker takes at a time
+#define SCAN_MAX_THREADS 64  // Upper bound on parallel scan workers
+
+#define WAL_CHECKPOINT_BYTES (1024 * 1024) // Log size after which a commit writes the pages back and empties it
+#define WAL_DIFF_MERGE_GAP 16              // Equal bytes between two changes of a page below which one record covers both
+
+#define RECORD_ID_BATCH 1024 // Record ids reserved per schema write
+#define RECORD_ID_HINTS 4    // Tables whose next record id the header keeps
+#define DICTIONARY_MAX_CODES 65535 // Distinct values of a dictionary column, rows hold them as uint16 codes
+
+#define SESSION_MAX_WORDS 128 // Words a session command line may have
+
+#define LOCK_PARTITIONS 16   // Buckets of the table lock manager, each with its own mutex
+#define LOCK_TIMEOUT_MS 5000 // A lock not granted in this time fails the request, which breaks deadlocks
+#define VACUUM_WRITER_WAIT_MS 10 // Time a vacuum holding its table waits for the writer slot before letting readers back in
+#define FILE_LOCK_OFFSET (1LL << 40) // First lock byte of a database file, past any page it will have
+
+#define SERVER_WORKER_THREADS 4                 // Threads of magbased that serve requests
+#define SERVER_BACKLOG 128                      // Connections waiting to be accepted
+#define SERVER_MAX_FRAME (1024 * 1024)          // Longest request frame, a longer one closes the connection
+#define SERVER_OUTPUT_LIMIT (4 * 1024 * 1024)   // Unsent response bytes after which a client's requests wait
+#define CLIENT_PIPELINE_DEPTH 256               // Requests a client sends before reading their responses
+
+#define IMPORT_BUFFER_SIZE (1024 * 1024) // Bytes of input an import splits rows from, the longest row that loads
+#define BULK_LOAD_RUN_PAGES 64           // Pages a bulk load fills in memory and writes with one call
+#define BULK_LOAD_FILL_PERCENT 100       // Default page fill of a bulk load, records never grow in place
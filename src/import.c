@@ -0,0 +1,322 @@
+//     Keagan Anderson
+//        MagBase
+//       10/19/2026
+//
+//     Bulk loading of CSV/TSV text into a table: rows are split in place in a large read
+//     buffer and packed into new pages by the bulk loader
+
+#include "import.h"
+#include "bulk-load.h"
+#include "globals.h"
+#include "records.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+CsvReader *openCsvReader(FILE *file, char delimiter) {
+    if (!file) {
+        return NULL;
+    }
+
+    CsvReader *reader = calloc(1, sizeof(CsvReader));
+    if (!reader) {
+        return NULL;
+    }
+    reader->buffer = malloc(IMPORT_BUFFER_SIZE + 1);
+    if (!reader->buffer) {
+        free(reader);
+        return NULL;
+    }
+    reader->file = file;
+    reader->delimiter = delimiter;
+    reader->next_line = 1;
+    return reader;
+}
+
+void closeCsvReader(CsvReader *reader) {
+    if (!reader) {
+        return;
+    }
+    free(reader->buffer);
+    free(reader);
+}
+
+// Find the newline ending the row at reader->position, newlines inside quotes do not count
+// Returns 1 with *end on it, 0 if the buffer ends first
+static int findRowEnd(CsvReader *reader, size_t *end, uint64_t *newlines) {
+    char *data = reader->buffer;
+    size_t scan = reader->position;
+    int in_quotes = 0;
+    *newlines = 0;
+
+    while (scan < reader->length) {
+        char *newline = memchr(data + scan, '\n', reader->length - scan);
+        size_t stop = newline ? (size_t)(newline - data) : reader->length;
+
+        // Each quote flips the state, an escaped "" flips it twice
+        for (char *quote = memchr(data + scan, '"', stop - scan); quote;
+             quote = memchr(quote + 1, '"', stop - (size_t)(quote + 1 - data))) {
+            in_quotes = !in_quotes;
+        }
+
+        if (!newline) {
+            return 0;
+        }
+        if (!in_quotes) {
+            *end = stop;
+            return 1;
+        }
+        (*newlines)++;
+        scan = stop + 1;
+    }
+    return 0;
+}
+
+// Move the unread bytes to the front and fill the rest of the buffer
+static int refill(CsvReader *reader) {
+    size_t unread = reader->length - reader->position;
+    memmove(reader->buffer, reader->buffer + reader->position, unread);
+    reader->length = unread;
+    reader->position = 0;
+
+    size_t got = fread(reader->buffer + reader->length, 1, IMPORT_BUFFER_SIZE - reader->length, reader->file);
+    if (got == 0) {
+        if (ferror(reader->file)) {
+            return -1;
+        }
+        reader->eof = 1;
+    }
+    reader->length += got;
+    return 0;
+}
+
+// Split a row with quotes, unescaping in place (the output never runs ahead of the input)
+static int splitQuoted(CsvReader *reader, char *row, char *row_end) {
+    char *read = row;
+    char *write = row;
+
+    while (1) {
+        if (reader->field_count == MAX_COLUMNS) {
+            return -1;
+        }
+        reader->fields[reader->field_count++] = write;
+
+        if (read < row_end && *read == '"') {
+            read++;
+            while (read < row_end) {
+                if (*read == '"') {
+                    if (read + 1 < row_end && read[1] == '"') {
+                        *write++ = '"';
+                        read += 2;
+                        continue;
+                    }
+                    read++;
+                    break;
+                }
+                *write++ = *read++;
+            }
+        }
+        while (read < row_end && *read != reader->delimiter) {
+            *write++ = *read++;
+        }
+
+        *write++ = '\0';
+        if (read >= row_end) {
+            return 0;
+        }
+        read++;
+    }
+}
+
+int readCsvRow(CsvReader *reader) {
+    while (1) {
+        size_t end;
+        uint64_t newlines;
+        while (!findRowEnd(reader, &end, &newlines)) {
+            if (reader->eof) {
+                // Last row without a trailing newline
+                if (reader->position == reader->length) {
+                    return 0;
+                }
+                end = reader->length;
+                break;
+            }
+            if (reader->position == 0 && reader->length == IMPORT_BUFFER_SIZE) {
+                fprintf(stderr, "Line %lu: row is longer than the import buffer\n", (unsigned long)reader->next_line);
+                return -1;
+            }
+            if (refill(reader) != 0) {
+                fprintf(stderr, "Failed to read the import file\n");
+                return -1;
+            }
+        }
+
+        char *row = reader->buffer + reader->position;
+        char *row_end = reader->buffer + end;
+        reader->position = end < reader->length ? end + 1 : end;
+        reader->line = reader->next_line;
+        reader->next_line += newlines + 1;
+
+        if (row_end > row && row_end[-1] == '\r') {
+            row_end--;
+        }
+        if (row_end == row) {
+            continue;
+        }
+        *row_end = '\0';
+
+        reader->field_count = 0;
+        if (memchr(row, '"', (size_t)(row_end - row))) {
+            if (splitQuoted(reader, row, row_end) != 0) {
+                fprintf(stderr, "Line %lu: more than %d fields\n", (unsigned long)reader->line, MAX_COLUMNS);
+                return -1;
+            }
+            return 1;
+        }
+
+        // Common case, no quotes: cut at each delimiter
+        char *field = row;
+        while (1) {
+            if (reader->field_count == MAX_COLUMNS) {
+                fprintf(stderr, "Line %lu: more than %d fields\n", (unsigned long)reader->line, MAX_COLUMNS);
+                return -1;
+            }
+            reader->fields[reader->field_count++] = field;
+            char *delimiter = memchr(field, reader->delimiter, (size_t)(row_end - field));
+            if (!delimiter) {
+                break;
+            }
+            *delimiter = '\0';
+            field = delimiter + 1;
+        }
+        return 1;
+    }
+}
+
+// Convert one field of a row, an empty field or NULL is a NULL value
+static int parseField(CsvReader *reader, SchemaColumn *column, const char *text, RecordField *field) {
+    field->type = column->type;
+    field->is_null = text[0] == '\0' || !strcmp(text, "NULL");
+    if (field->is_null) {
+        if (!column->nullable) {
+            fprintf(stderr, "Line %lu: %s cannot be NULL\n", (unsigned long)reader->line, column->name);
+            return -1;
+        }
+        return 0;
+    }
+
+    switch (column->type) {
+        case COL_INT: {
+            char *end = NULL;
+            errno = 0;
+            long value = strtol(text, &end, 10);
+            if (*end != '\0' || errno != 0 || value < INT32_MIN || value > INT32_MAX) {
+                fprintf(stderr, "Line %lu: expected an int for %s, got %s\n", (unsigned long)reader->line,
+                        column->name, text);
+                return -1;
+            }
+            field->value.int_val = (int32_t)value;
+            break;
+        }
+        case COL_BOOL:
+            if (!strcmp(text, "true") || !strcmp(text, "1")) {
+                field->value.bool_val = 1;
+            } else if (!strcmp(text, "false") || !strcmp(text, "0")) {
+                field->value.bool_val = 0;
+            } else {
+                fprintf(stderr, "Line %lu: expected a bool for %s, got %s\n", (unsigned long)reader->line,
+                        column->name, text);
+                return -1;
+            }
+            break;
+        case COL_TEXT: {
+            size_t length = strlen(text);
+            if (length >= MAX_RECORD_VALUE_SIZE) {
+                fprintf(stderr, "Line %lu: %s is longer than %d bytes\n", (unsigned long)reader->line, column->name,
+                        MAX_RECORD_VALUE_SIZE - 1);
+                return -1;
+            }
+            memcpy(field->value.text_val, text, length + 1);
+            break;
+        }
+    }
+    return 0;
+}
+
+int importRows(MagBase *db, uint16_t table_id, FILE *file, const ImportOptions *options, ImportResult *result) {
+    if (!db || !file || !options || !result) {
+        return -1;
+    }
+    memset(result, 0, sizeof(ImportResult));
+
+    BulkLoader *loader = openBulkLoader(db, table_id, options->fill_percent);
+    if (!loader) {
+        return -1;
+    }
+    TableSchemaRecord *schema = loader->schema;
+    CsvReader *reader = openCsvReader(file, options->delimiter);
+    Record *record = createRecord(table_id, schema->column_count);
+    if (!reader || !record) {
+        closeCsvReader(reader);
+        freeRecord(record);
+        abortBulkLoad(loader);
+        return -1;
+    }
+
+    int status = 0;
+    int keep_rows = 1;
+    int row = 1;
+    if (options->skip_header) {
+        row = readCsvRow(reader);
+    }
+
+    while (row == 1 && (row = readCsvRow(reader)) == 1) {
+        if (reader->field_count != schema->column_count) {
+            fprintf(stderr, "Line %lu: expected %u fields, got %u\n", (unsigned long)reader->line,
+                    schema->column_count, reader->field_count);
+            status = -1;
+            break;
+        }
+
+        int parsed = 0;
+        for (uint16_t col = 0; col < schema->column_count && parsed == 0; col++) {
+            parsed = parseField(reader, &schema->columns[col], reader->fields[col], &record->fields[col]);
+        }
+        if (parsed != 0) {
+            status = -1;
+            break;
+        }
+
+        if (bulkLoadRecord(loader, record) == 0) {
+            fprintf(stderr, "Line %lu: failed to load the row\n", (unsigned long)reader->line);
+            status = -1;
+            keep_rows = 0;
+            break;
+        }
+    }
+    if (row < 0) {
+        status = -1;
+    }
+    if (status != 0) {
+        result->bad_line = reader->line;
+    }
+
+    // Rows before a bad one are complete, keep them
+    uint64_t rows = loader->rows;
+    if (keep_rows) {
+        uint64_t pages = loader->pages_written;
+        uint32_t run_count = loader->first_page ? loader->run_count : 0;
+        if (finishBulkLoad(loader) == 0) {
+            result->rows_imported = rows;
+            result->pages_written = pages + run_count;
+        } else {
+            status = -1;
+        }
+    } else {
+        abortBulkLoad(loader);
+    }
+
+    freeRecord(record);
+    closeCsvReader(reader);
+    return status;
+}
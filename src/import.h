@@ -0,0 +1,55 @@
+//     Keagan Anderson
+//        MagBase
+//       10/19/2026
+//
+//     Bulk loading of CSV/TSV text into a table: rows are split in place in a large read
+//     buffer and packed into new pages by the bulk loader
+
+#pragma once
+
+#include "db-init.h"
+#include "structs/schemaStruct.h"
+#include <stdint.h>
+#include <stdio.h>
+
+// Streaming reader of delimited rows. Fields point into the read buffer and are only valid
+// until the next readCsvRow
+typedef struct {
+    FILE *file;
+    char delimiter;
+    char *buffer;                       // IMPORT_BUFFER_SIZE bytes plus a terminator
+    size_t length;                      // Bytes of buffer holding file data
+    size_t position;                    // Start of the next row in buffer
+    int eof;
+    uint64_t line;                      // Line the current row starts on, from 1
+    uint64_t next_line;
+    char *fields[MAX_COLUMNS];
+    uint16_t field_count;
+} CsvReader;
+
+typedef struct {
+    char delimiter;                     // ',' or '\t'
+    int skip_header;                    // The first row names the columns
+    uint32_t fill_percent;              // How full the new pages are packed, 1-100
+} ImportOptions;
+
+typedef struct {
+    uint64_t rows_imported;             // Committed rows
+    uint64_t pages_written;
+    uint64_t bad_line;                  // Line of the row that stopped the import, 0 if none
+} ImportResult;
+
+// Returns NULL on error, caller must close it with closeCsvReader
+CsvReader *openCsvReader(FILE *file, char delimiter);
+
+// Read the next row into reader->fields. Fields may be quoted with ", "" inside quotes is a quote
+// and quoted fields may span lines
+// Returns 1 if a row was read, 0 at the end of the file, -1 on a read error or a row larger than the buffer
+int readCsvRow(CsvReader *reader);
+
+void closeCsvReader(CsvReader *reader);
+
+// Stream the rows of file into a table through a bulk load, committed once at the end. A row
+// that does not fit the schema stops the import, the rows before it are kept
+// Returns 0 on success, -1 on error
+int importRows(MagBase *db, uint16_t table_id, FILE *file, const ImportOptions *options, ImportResult *result);
@@ -0,0 +1,490 @@
+//     Keagan Anderson
+//        MagBase
+//       10/19/2026
+//
+//     In-engine equi-joins, hash join with a grace (partitioned) fallback
+
+#include "join.h"
+#include "globals.h"
+#include "schema.h"
+#include "filter.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Hash table bytes per build row on top of the record itself
+#define JOIN_ENTRY_OVERHEAD (sizeof(JoinEntry) + sizeof(int64_t))
+
+void initJoinSpec(JoinSpec *spec) {
+    memset(spec, 0, sizeof(JoinSpec));
+    spec->memory_budget = JOIN_MEMORY_BUDGET;
+}
+
+size_t joinBuildRowMemorySize(uint16_t field_count) {
+    return sizeof(Record) + field_count * sizeof(RecordField) + JOIN_ENTRY_OVERHEAD;
+}
+
+static int keysEqual(RecordField *a, RecordField *b) {
+    return compareFields(a, b) == 0;
+}
+
+// Times rows can be partitioned, a partition that is still over the budget after the last time
+// holds too many rows of one key
+#define JOIN_PARTITION_LEVELS 3
+
+// Partitions use the high bits of the hash, buckets the low ones, so a partition still spreads
+// over the whole table. Each level takes the next 8 bits, which fit JOIN_MAX_PARTITIONS
+static uint32_t partitionOf(uint64_t hash, uint8_t level, uint32_t fan_out) {
+    return (uint32_t)((hash >> (40 + 8 * level)) & (fan_out - 1));
+}
+
+// Partitions for rows of build_bytes, aiming for half the budget each to leave room for skew
+static uint32_t partitionFanOut(uint64_t build_bytes, size_t memory_budget) {
+    uint64_t wanted = (build_bytes * 2 + memory_budget - 1) / (memory_budget ? memory_budget : 1);
+    uint32_t fan_out = 2;
+    while (fan_out < wanted && fan_out < JOIN_MAX_PARTITIONS) {
+        fan_out <<= 1;
+    }
+    return fan_out;
+}
+
+static void clearHashTable(HashJoin *join) {
+    for (size_t i = 0; i < join->entry_count; i++) {
+        freeRecord(join->entries[i].record);
+    }
+    join->entry_count = 0;
+    for (size_t i = 0; i < join->bucket_count; i++) {
+        join->buckets[i] = -1;
+    }
+    join->match = -1;
+}
+
+// Size the bucket array for an expected number of build rows
+static int resizeBuckets(HashJoin *join, uint64_t expected_rows) {
+    size_t bucket_count = 16;
+    while (bucket_count < expected_rows && bucket_count < ((size_t)1 << 30)) {
+        bucket_count <<= 1;
+    }
+
+    int64_t *buckets = realloc(join->buckets, bucket_count * sizeof(int64_t));
+    if (!buckets) {
+        return -1;
+    }
+    join->buckets = buckets;
+    join->bucket_count = bucket_count;
+    for (size_t i = 0; i < bucket_count; i++) {
+        join->buckets[i] = -1;
+    }
+    return 0;
+}
+
+// Take ownership of a build row, rows with a NULL key are dropped
+static int insertBuildRow(HashJoin *join, Record *record) {
+    RecordField *key = &record->fields[join->build_column];
+    if (key->is_null) {
+        freeRecord(record);
+        return 0;
+    }
+
+    if (join->entry_count == join->entry_capacity) {
+        size_t new_capacity = join->entry_capacity ? join->entry_capacity * 2 : 256;
+        JoinEntry *grown = realloc(join->entries, new_capacity * sizeof(JoinEntry));
+        if (!grown) {
+            freeRecord(record);
+            return -1;
+        }
+        join->entries = grown;
+        join->entry_capacity = new_capacity;
+    }
+
+    uint64_t hash = hashRecordField(key);
+    size_t bucket = hash & (join->bucket_count - 1);
+    JoinEntry *entry = &join->entries[join->entry_count];
+    entry->hash = hash;
+    entry->record = record;
+    entry->next = join->buckets[bucket];
+    join->buckets[bucket] = (int64_t)join->entry_count;
+    join->entry_count++;
+    return 0;
+}
+
+// Add fan_out empty partitions of the given level after the last one, on both sides
+// Returns the index of the first, or -1 on error
+static int64_t addPartitions(HashJoin *join, uint32_t fan_out, uint8_t level) {
+    uint32_t count = join->partition_count + fan_out;
+    TempRun *build_runs = realloc(join->build_runs, count * sizeof(TempRun));
+    if (build_runs) {
+        join->build_runs = build_runs;
+    }
+    TempRun *probe_runs = realloc(join->probe_runs, count * sizeof(TempRun));
+    if (probe_runs) {
+        join->probe_runs = probe_runs;
+    }
+    uint8_t *levels = realloc(join->partition_levels, count * sizeof(uint8_t));
+    if (levels) {
+        join->partition_levels = levels;
+    }
+    if (!build_runs || !probe_runs || !levels) {
+        return -1;
+    }
+
+    uint32_t first = join->partition_count;
+    for (uint32_t p = first; p < count; p++) {
+        initTempRun(&join->build_runs[p]);
+        initTempRun(&join->probe_runs[p]);
+        join->partition_levels[p] = level;
+    }
+    join->partition_count = count;
+    return first;
+}
+
+// Scatter the rows a scan has left over the partition runs by key hash
+static int partitionRows(HashJoin *join, RecordScan *scan, uint16_t column, TempRun *runs, uint32_t fan_out) {
+    Record *record = createRecord(scan->schema->table_id, scan->schema->column_count);
+    if (!record) {
+        return -1;
+    }
+
+    int result;
+    while ((result = nextRecord(scan, record)) == 1) {
+        RecordField *key = &record->fields[column];
+        if (key->is_null) {
+            continue;
+        }
+        if (appendToTempRun(join->space, &runs[partitionOf(hashRecordField(key), 0, fan_out)], record) != 0) {
+            result = -1;
+            break;
+        }
+    }
+    freeRecord(record);
+    return result;
+}
+
+// The build rows outgrew the budget: move the hashed ones and the rest of the build scan to
+// partitions, then partition the probe table the same way
+static int startGraceJoin(HashJoin *join, RecordScan *build_scan) {
+    // Size the partitions for the share of the build table the filter kept so far
+    uint64_t expected_rows = join->build_rows;
+    if (build_scan->rows_scanned > 0 && build_scan->rows_matched < build_scan->rows_scanned) {
+        expected_rows = join->build_rows * build_scan->rows_matched / build_scan->rows_scanned;
+    }
+    uint32_t fan_out =
+        partitionFanOut(expected_rows * joinBuildRowMemorySize(join->build_fields), join->spec.memory_budget);
+
+    join->space = openTempSpace(join->db->page_size);
+    if (!join->space || addPartitions(join, fan_out, 0) < 0) {
+        return -1;
+    }
+
+    for (size_t i = 0; i < join->entry_count; i++) {
+        JoinEntry *entry = &join->entries[i];
+        TempRun *run = &join->build_runs[partitionOf(entry->hash, 0, fan_out)];
+        if (appendToTempRun(join->space, run, entry->record) != 0) {
+            return -1;
+        }
+    }
+    clearHashTable(join);
+
+    if (partitionRows(join, build_scan, join->build_column, join->build_runs, fan_out) < 0) {
+        return -1;
+    }
+
+    RecordScan *probe_scan = openFilteredScan(join->db, join->probe_table, join->probe_filter);
+    if (!probe_scan) {
+        return -1;
+    }
+    int result = partitionRows(join, probe_scan, join->probe_column, join->probe_runs, fan_out);
+    join->probe_input_rows = probe_scan->rows_matched;
+    closeRecordScan(probe_scan);
+    return result;
+}
+
+// Hash the build table in memory, switching to a grace join if its rows outgrow the budget
+static int buildFromTable(HashJoin *join) {
+    RecordScan *scan = openFilteredScan(join->db, join->build_table, join->build_filter);
+    if (!scan) {
+        return -1;
+    }
+
+    size_t row_bytes = joinBuildRowMemorySize(join->build_fields);
+    int result;
+    while (1) {
+        Record *record = createRecord(join->build_table, join->build_fields);
+        if (!record) {
+            result = -1;
+            break;
+        }
+        result = nextRecord(scan, record);
+        if (result != 1) {
+            freeRecord(record);
+            break;
+        }
+        if (insertBuildRow(join, record) != 0) {
+            result = -1;
+            break;
+        }
+        if (join->entry_count * row_bytes > join->spec.memory_budget) {
+            result = startGraceJoin(join, scan);
+            break;
+        }
+    }
+
+    join->build_input_rows = scan->rows_matched;
+    closeRecordScan(scan);
+    return result;
+}
+
+// Split a partition still over the budget using the next bits of the hash, its rows on both
+// sides move to partitions added after the last one
+// Returns 0 on success, -1 on error
+static int splitPartition(HashJoin *join, uint32_t partition) {
+    uint8_t level = join->partition_levels[partition] + 1;
+    if (level >= JOIN_PARTITION_LEVELS) {
+        fprintf(stderr, "Too many rows share a join key to join them within %zu bytes\n", join->spec.memory_budget);
+        return -1;
+    }
+    uint64_t build_bytes = join->build_runs[partition].record_count * joinBuildRowMemorySize(join->build_fields);
+    uint32_t fan_out = partitionFanOut(build_bytes, join->spec.memory_budget);
+    int64_t first = addPartitions(join, fan_out, level);
+    if (first < 0) {
+        return -1;
+    }
+
+    for (int side = 0; side < 2; side++) {
+        TempRun *runs = side == 0 ? join->build_runs : join->probe_runs;
+        uint16_t table_id = side == 0 ? join->build_table : join->probe_table;
+        uint16_t column = side == 0 ? join->build_column : join->probe_column;
+        Record *record = side == 0 ? createRecord(table_id, join->build_fields) : join->probe_record;
+        if (!record) {
+            return -1;
+        }
+
+        TempRunReader reader;
+        openTempRunReader(join->space, &runs[partition], &reader);
+        int result;
+        while ((result = nextTempRecord(&reader, record)) == 1) {
+            uint64_t hash = hashRecordField(&record->fields[column]);
+            if (appendToTempRun(join->space, &runs[first + partitionOf(hash, level, fan_out)], record) != 0) {
+                result = -1;
+                break;
+            }
+        }
+        if (side == 0) {
+            freeRecord(record);
+        }
+        if (result < 0) {
+            return -1;
+        }
+        releaseTempRun(join->space, &runs[partition]);
+    }
+    return 0;
+}
+
+// Hash one build partition and start reading the matching probe partition
+static int loadPartition(HashJoin *join) {
+    // A partition skew left over the budget is split and joined later, it is empty now
+    size_t row_bytes = joinBuildRowMemorySize(join->build_fields);
+    while (join->build_runs[join->partition].record_count * row_bytes > join->spec.memory_budget) {
+        if (splitPartition(join, join->partition) != 0) {
+            return -1;
+        }
+        join->partition++;
+    }
+
+    uint32_t partition = join->partition;
+    clearHashTable(join);
+    if (resizeBuckets(join, join->build_runs[partition].record_count) != 0) {
+        return -1;
+    }
+
+    TempRunReader reader;
+    openTempRunReader(join->space, &join->build_runs[partition], &reader);
+
+    int result;
+    while (1) {
+        Record *record = createRecord(join->build_table, join->build_fields);
+        if (!record) {
+            return -1;
+        }
+        result = nextTempRecord(&reader, record);
+        if (result != 1) {
+            freeRecord(record);
+            break;
+        }
+        if (insertBuildRow(join, record) != 0) {
+            return -1;
+        }
+    }
+    if (result < 0) {
+        return -1;
+    }
+
+    // The build partition now lives in memory, its pages can be reused
+    releaseTempRun(join->space, &join->build_runs[partition]);
+    openTempRunReader(join->space, &join->probe_runs[partition], &join->probe_reader);
+    return 0;
+}
+
+HashJoin *openHashJoin(MagBase *db, JoinSpec *spec) {
+    if (!db || !spec) {
+        return NULL;
+    }
+
+    TableSchemaRecord *left_schema = readTableSchema(db, spec->left_table);
+    TableSchemaRecord *right_schema = readTableSchema(db, spec->right_table);
+    if (!left_schema || !right_schema || spec->left_column >= left_schema->column_count ||
+        spec->right_column >= right_schema->column_count) {
+        fprintf(stderr, "Join table or column not found\n");
+        free(left_schema);
+        free(right_schema);
+        return NULL;
+    }
+
+    uint8_t left_type = left_schema->columns[spec->left_column].type;
+    uint8_t right_type = right_schema->columns[spec->right_column].type;
+    uint16_t left_fields = left_schema->column_count;
+    uint16_t right_fields = right_schema->column_count;
+    free(left_schema);
+    free(right_schema);
+
+    if (left_type != right_type || (left_type != COL_INT && left_type != COL_TEXT)) {
+        fprintf(stderr, "Join columns must both be int or both be text\n");
+        return NULL;
+    }
+
+    HashJoin *join = calloc(1, sizeof(HashJoin));
+    if (!join) {
+        return NULL;
+    }
+    join->db = db;
+    join->spec = *spec;
+    join->match = -1;
+
+    // Hash the smaller side
+    uint64_t left_rows = countRecords(db, spec->left_table, NULL);
+    uint64_t right_rows = countRecords(db, spec->right_table, NULL);
+    if (spec->build_side == JOIN_BUILD_AUTO) {
+        join->build_is_left = left_rows <= right_rows;
+    } else {
+        join->build_is_left = spec->build_side == JOIN_BUILD_LEFT;
+    }
+    join->build_filter = join->build_is_left ? spec->left_filter : spec->right_filter;
+    join->probe_filter = join->build_is_left ? spec->right_filter : spec->left_filter;
+    join->build_table = join->build_is_left ? spec->left_table : spec->right_table;
+    join->build_column = join->build_is_left ? spec->left_column : spec->right_column;
+    join->probe_table = join->build_is_left ? spec->right_table : spec->left_table;
+    join->probe_column = join->build_is_left ? spec->right_column : spec->left_column;
+    join->build_rows = join->build_is_left ? left_rows : right_rows;
+    join->probe_rows = join->build_is_left ? right_rows : left_rows;
+
+    join->build_fields = join->build_is_left ? left_fields : right_fields;
+    uint16_t probe_fields = join->build_is_left ? right_fields : left_fields;
+    join->probe_record = createRecord(join->probe_table, probe_fields);
+    if (!join->probe_record) {
+        closeHashJoin(join);
+        return NULL;
+    }
+
+    // Start hashing in memory, the filters may keep far fewer rows than the tables hold. The hash
+    // table never holds more rows than fit the budget
+    uint64_t expected_rows = spec->memory_budget / joinBuildRowMemorySize(join->build_fields) + 1;
+    if (resizeBuckets(join, join->build_rows < expected_rows ? join->build_rows : expected_rows) != 0 ||
+        buildFromTable(join) != 0) {
+        closeHashJoin(join);
+        return NULL;
+    }
+    if (join->space) {
+        if (loadPartition(join) != 0) {
+            closeHashJoin(join);
+            return NULL;
+        }
+        return join;
+    }
+
+    join->probe_scan = openFilteredScan(db, join->probe_table, join->probe_filter);
+    if (!join->probe_scan) {
+        closeHashJoin(join);
+        return NULL;
+    }
+    return join;
+}
+
+// Read the next probe row from the table scan or the current probe partition
+static int nextProbeRow(HashJoin *join) {
+    if (join->probe_scan) {
+        int result = nextRecord(join->probe_scan, join->probe_record);
+        join->probe_input_rows = join->probe_scan->rows_matched;
+        return result;
+    }
+    if (!join->space) {
+        return 0;
+    }
+
+    while (1) {
+        int result = nextTempRecord(&join->probe_reader, join->probe_record);
+        if (result != 0) {
+            return result;
+        }
+
+        // Partition done, move on to the next pair
+        releaseTempRun(join->space, &join->probe_runs[join->partition]);
+        if (++join->partition >= join->partition_count) {
+            return 0;
+        }
+        if (loadPartition(join) != 0) {
+            return -1;
+        }
+    }
+}
+
+int nextJoinedRow(HashJoin *join, Record **left, Record **right) {
+    if (!join || !left || !right) {
+        return -1;
+    }
+
+    while (1) {
+        RecordField *probe_key = &join->probe_record->fields[join->probe_column];
+
+        while (join->match >= 0) {
+            JoinEntry *entry = &join->entries[join->match];
+            join->match = entry->next;
+
+            if (entry->hash == join->probe_hash &&
+                keysEqual(&entry->record->fields[join->build_column], probe_key)) {
+                *left = join->build_is_left ? entry->record : join->probe_record;
+                *right = join->build_is_left ? join->probe_record : entry->record;
+                return 1;
+            }
+        }
+
+        int result = nextProbeRow(join);
+        if (result != 1) {
+            return result;
+        }
+
+        probe_key = &join->probe_record->fields[join->probe_column];
+        if (probe_key->is_null) {
+            continue;
+        }
+        join->probe_hash = hashRecordField(probe_key);
+        join->match = join->buckets[join->probe_hash & (join->bucket_count - 1)];
+    }
+}
+
+void closeHashJoin(HashJoin *join) {
+    if (!join) {
+        return;
+    }
+
+    for (size_t i = 0; i < join->entry_count; i++) {
+        freeRecord(join->entries[i].record);
+    }
+    free(join->entries);
+    free(join->buckets);
+    freeRecord(join->probe_record);
+    closeRecordScan(join->probe_scan);
+    closeTempSpace(join->space);
+    free(join->build_runs);
+    free(join->probe_runs);
+    free(join->partition_levels);
+    free(join);
+}
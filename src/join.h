@@ -0,0 +1,92 @@
+//     Keagan Anderson
+//        MagBase
+//       10/19/2026
+//
+//     In-engine equi-joins, hash join with a grace (partitioned) fallback
+
+#pragma once
+
+#include "db-init.h"
+#include "records.h"
+#include "temp-pages.h"
+#include <stdint.h>
+
+struct Filter;
+
+typedef enum { JOIN_BUILD_AUTO, JOIN_BUILD_LEFT, JOIN_BUILD_RIGHT } JoinBuildSide;
+
+// left_table.left_column = right_table.right_column
+typedef struct {
+    uint16_t left_table;
+    uint16_t left_column;
+    uint16_t right_table;
+    uint16_t right_column;
+    size_t memory_budget;               // Bytes of build rows held in memory before partitioning
+    uint8_t build_side;                 // JoinBuildSide, AUTO hashes the table with fewer rows
+    const struct Filter *left_filter;   // Applied while scanning each side, NULL for every row
+    const struct Filter *right_filter;
+} JoinSpec;
+
+// One build row in the hash table, chained by index
+typedef struct {
+    uint64_t hash;
+    Record *record;
+    int64_t next;                       // Next entry in the bucket, -1 ends the chain
+} JoinEntry;
+
+// Streaming join output
+typedef struct {
+    MagBase *db;
+    JoinSpec spec;
+    uint8_t build_is_left;              // 1 if the hash table holds rows of the left table
+    uint16_t build_table;
+    uint16_t build_column;
+    uint16_t build_fields;              // Column count of the build table
+    uint16_t probe_table;
+    uint16_t probe_column;
+    const struct Filter *build_filter;
+    const struct Filter *probe_filter;
+    uint64_t build_rows;                // Rows counted on each side when the join was opened
+    uint64_t probe_rows;
+    uint64_t build_input_rows;          // Rows that passed the filters, for reporting
+    uint64_t probe_input_rows;
+
+    JoinEntry *entries;                 // Hash table of the current build side (or partition)
+    size_t entry_count;
+    size_t entry_capacity;
+    int64_t *buckets;                   // Head entry per bucket, -1 for empty
+    size_t bucket_count;                // Power of two
+
+    Record *probe_record;               // Current probe row
+    uint64_t probe_hash;
+    int64_t match;                      // Next entry to test against probe_record
+
+    RecordScan *probe_scan;             // In memory join, streams the probe table
+    TempSpace *space;                   // Grace join, NULL when the build side fits in memory
+    TempRun *build_runs;
+    TempRun *probe_runs;
+    uint8_t *partition_levels;          // 0 for the partitions of the tables, splitting one adds 1
+    uint32_t partition_count;
+    uint32_t partition;                 // Partition being joined
+    TempRunReader probe_reader;
+} HashJoin;
+
+// Fill a spec with defaults, the tables and columns still have to be set
+void initJoinSpec(JoinSpec *spec);
+
+// Bytes one hashed build row of field_count columns costs against the memory budget
+size_t joinBuildRowMemorySize(uint16_t field_count);
+
+// Open a join. Unless spec->build_side says otherwise the smaller table (by row count) is hashed and the larger one streamed past it.
+// If the filtered build rows outgrow spec->memory_budget both sides are hash partitioned to temp
+// pages and the partitions are joined pairwise, a partition still over the budget is split
+// again. Only INT and TEXT keys of the same type are accepted, NULL keys never match
+// Returns NULL on error, caller must close it with closeHashJoin
+HashJoin *openHashJoin(MagBase *db, JoinSpec *spec);
+
+// Get the next matching pair, the records stay valid until the next call
+// Returns 1 if a pair was produced, 0 at the end, -1 on error
+int nextJoinedRow(HashJoin *join, Record **left, Record **right);
+
+// Free the join, its hash table and temporary pages
+void closeHashJoin(HashJoin *join);
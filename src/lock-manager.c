@@ -0,0 +1,300 @@
+//     Keagan Anderson
+//        MagBase
+//       10/19/2026
+//
+//     Table lock manager (see lock-manager.h)
+
+#include "lock-manager.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <time.h>
+
+LockManager *createLockManager(void) {
+    LockManager *locks = calloc(1, sizeof(LockManager));
+    if (!locks) {
+        return NULL;
+    }
+
+    // Waits are timed against the monotonic clock so a clock change cannot stretch them
+    pthread_condattr_t attributes;
+    pthread_condattr_init(&attributes);
+    pthread_condattr_setclock(&attributes, CLOCK_MONOTONIC);
+    for (int b = 0; b < LOCK_PARTITIONS; b++) {
+        pthread_mutex_init(&locks->buckets[b].lock, NULL);
+        pthread_cond_init(&locks->buckets[b].released, &attributes);
+    }
+    pthread_condattr_destroy(&attributes);
+    return locks;
+}
+
+void freeLockManager(LockManager *locks) {
+    if (!locks) {
+        return;
+    }
+    for (int b = 0; b < LOCK_PARTITIONS; b++) {
+        LockEntry *entry = locks->buckets[b].entries;
+        while (entry) {
+            LockEntry *next = entry->next;
+            free(entry->holders);
+            free(entry);
+            entry = next;
+        }
+        pthread_mutex_destroy(&locks->buckets[b].lock);
+        pthread_cond_destroy(&locks->buckets[b].released);
+    }
+    free(locks);
+}
+
+static LockBucket *bucketOf(LockManager *locks, uint32_t resource) {
+    return &locks->buckets[resource % LOCK_PARTITIONS];
+}
+
+// Find the entry of a resource, creating it when create is set. The caller holds the bucket lock
+// Entries stay until the manager is freed, there is one per table at most
+static LockEntry *findEntry(LockBucket *bucket, uint32_t resource, bool create) {
+    for (LockEntry *entry = bucket->entries; entry; entry = entry->next) {
+        if (entry->resource == resource) {
+            return entry;
+        }
+    }
+    if (!create) {
+        return NULL;
+    }
+
+    LockEntry *entry = calloc(1, sizeof(LockEntry));
+    if (!entry) {
+        return NULL;
+    }
+    entry->resource = resource;
+    entry->next = bucket->entries;
+    bucket->entries = entry;
+    return entry;
+}
+
+// The holder record of owner, added when create is set. The caller holds the bucket lock and
+// the pointer is only valid until it waits, other owners may grow the array meanwhile
+static LockHolder *findHolder(LockEntry *entry, const void *owner, bool create) {
+    for (uint32_t i = 0; i < entry->holder_count; i++) {
+        if (entry->holders[i].owner == owner) {
+            return &entry->holders[i];
+        }
+    }
+    if (!create) {
+        return NULL;
+    }
+
+    if (entry->holder_count == entry->holder_capacity) {
+        uint32_t capacity = entry->holder_capacity ? entry->holder_capacity * 2 : 4;
+        LockHolder *grown = realloc(entry->holders, capacity * sizeof(LockHolder));
+        if (!grown) {
+            return NULL;
+        }
+        entry->holders = grown;
+        entry->holder_capacity = capacity;
+    }
+    LockHolder *holder = &entry->holders[entry->holder_count++];
+    holder->owner = owner;
+    holder->parent = NULL;
+    holder->shared = 0;
+    holder->exclusive = 0;
+    return holder;
+}
+
+// Drop a holder that holds nothing anymore
+static void removeHolder(LockEntry *entry, LockHolder *holder) {
+    if (holder->exclusive == 0 && entry->exclusive_owner == holder->owner) {
+        entry->exclusive_owner = NULL;
+    }
+    if (holder->shared == 0 && holder->exclusive == 0) {
+        *holder = entry->holders[--entry->holder_count];
+    }
+}
+
+// Returns true if an owner other than owner holds the resource shared
+static bool sharedByOthers(LockEntry *entry, const void *owner) {
+    for (uint32_t i = 0; i < entry->holder_count; i++) {
+        if (entry->holders[i].owner != owner && entry->holders[i].shared > 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Returns true if owner holds the resource, or an owner it is the parent of holds it shared
+static bool heldBy(LockEntry *entry, const void *owner) {
+    for (uint32_t i = 0; i < entry->holder_count; i++) {
+        LockHolder *holder = &entry->holders[i];
+        if ((holder->owner == owner && (holder->shared > 0 || holder->exclusive > 0)) ||
+            (holder->parent == owner && holder->shared > 0)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static int lockResource(LockManager *locks, uint32_t resource, LockMode mode, const void *owner, const void *parent,
+                        long timeout_ms) {
+    if (!locks || !owner) {
+        return -1;
+    }
+
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += timeout_ms / 1000;
+    deadline.tv_nsec += (timeout_ms % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    LockBucket *bucket = bucketOf(locks, resource);
+    pthread_mutex_lock(&bucket->lock);
+    LockEntry *entry = findEntry(bucket, resource, true);
+    if (!entry) {
+        pthread_mutex_unlock(&bucket->lock);
+        return -1;
+    }
+
+    LockHolder *holder = findHolder(entry, owner, false);
+    int status = 0;
+    if (mode == LOCK_SHARED) {
+        // An owner that holds the resource already is never queued, it would wait for itself.
+        // Nobody else holds it exclusively then
+        bool holding = heldBy(entry, owner);
+        while (!holding && status == 0 && (entry->exclusive_owner || entry->waiting_exclusive > 0)) {
+            status = pthread_cond_timedwait(&bucket->released, &bucket->lock, &deadline);
+        }
+    } else if (!holder || holder->exclusive == 0) {
+        entry->waiting_exclusive++;
+        while (status == 0 && (entry->exclusive_owner || sharedByOthers(entry, owner))) {
+            status = pthread_cond_timedwait(&bucket->released, &bucket->lock, &deadline);
+        }
+        entry->waiting_exclusive--;
+        if (status == 0) {
+            entry->exclusive_owner = owner;
+        } else {
+            // Shared requests queued behind this one may go now
+            pthread_cond_broadcast(&bucket->released);
+        }
+    }
+
+    if (status == 0) {
+        holder = findHolder(entry, owner, true);
+        if (!holder) {
+            if (mode == LOCK_EXCLUSIVE && entry->exclusive_owner == owner) {
+                entry->exclusive_owner = NULL;
+            }
+            status = ENOMEM;
+        } else if (mode == LOCK_SHARED) {
+            holder->shared++;
+        } else {
+            holder->exclusive++;
+        }
+        if (holder && parent) {
+            holder->parent = parent;
+        }
+    }
+    pthread_mutex_unlock(&bucket->lock);
+    return status == 0 ? 0 : -1;
+}
+
+int acquireLock(LockManager *locks, uint32_t resource, LockMode mode, const void *owner) {
+    return lockResource(locks, resource, mode, owner, NULL, LOCK_TIMEOUT_MS);
+}
+
+int acquireLockWithin(LockManager *locks, uint32_t resource, LockMode mode, const void *owner, long timeout_ms) {
+    return lockResource(locks, resource, mode, owner, NULL, timeout_ms);
+}
+
+int acquireLockFor(LockManager *locks, uint32_t resource, LockMode mode, const void *owner, const void *parent) {
+    return lockResource(locks, resource, mode, owner, parent, LOCK_TIMEOUT_MS);
+}
+
+int tryAcquireLock(LockManager *locks, uint32_t resource, LockMode mode, const void *owner) {
+    if (!locks || !owner) {
+        return -1;
+    }
+
+    LockBucket *bucket = bucketOf(locks, resource);
+    pthread_mutex_lock(&bucket->lock);
+    LockEntry *entry = findEntry(bucket, resource, true);
+    bool granted = false;
+    if (entry) {
+        if (mode == LOCK_SHARED) {
+            granted = heldBy(entry, owner) || (!entry->exclusive_owner && entry->waiting_exclusive == 0);
+        } else {
+            granted = (!entry->exclusive_owner || entry->exclusive_owner == owner) && !sharedByOthers(entry, owner);
+        }
+    }
+
+    if (granted) {
+        LockHolder *holder = findHolder(entry, owner, true);
+        if (!holder) {
+            granted = false;
+        } else if (mode == LOCK_SHARED) {
+            holder->shared++;
+        } else {
+            entry->exclusive_owner = owner;
+            holder->exclusive++;
+        }
+    }
+    pthread_mutex_unlock(&bucket->lock);
+    return granted ? 0 : -1;
+}
+
+void releaseLock(LockManager *locks, uint32_t resource, LockMode mode, const void *owner) {
+    if (!locks) {
+        return;
+    }
+
+    LockBucket *bucket = bucketOf(locks, resource);
+    pthread_mutex_lock(&bucket->lock);
+    LockEntry *entry = findEntry(bucket, resource, false);
+    LockHolder *holder = entry ? findHolder(entry, owner, false) : NULL;
+    uint32_t *count = holder ? (mode == LOCK_SHARED ? &holder->shared : &holder->exclusive) : NULL;
+    if (count && *count > 0) {
+        (*count)--;
+        removeHolder(entry, holder);
+        pthread_cond_broadcast(&bucket->released);
+    }
+    pthread_mutex_unlock(&bucket->lock);
+}
+
+void releaseOwnerLocks(LockManager *locks, const void *owner) {
+    if (!locks) {
+        return;
+    }
+
+    for (int b = 0; b < LOCK_PARTITIONS; b++) {
+        LockBucket *bucket = &locks->buckets[b];
+        bool released = false;
+        pthread_mutex_lock(&bucket->lock);
+        for (LockEntry *entry = bucket->entries; entry; entry = entry->next) {
+            LockHolder *holder = findHolder(entry, owner, false);
+            if (holder) {
+                holder->shared = 0;
+                holder->exclusive = 0;
+                removeHolder(entry, holder);
+                released = true;
+            }
+        }
+        if (released) {
+            pthread_cond_broadcast(&bucket->released);
+        }
+        pthread_mutex_unlock(&bucket->lock);
+    }
+}
+
+bool holdsLock(LockManager *locks, uint32_t resource, LockMode mode, const void *owner) {
+    if (!locks) {
+        return false;
+    }
+
+    LockBucket *bucket = bucketOf(locks, resource);
+    pthread_mutex_lock(&bucket->lock);
+    LockEntry *entry = findEntry(bucket, resource, false);
+    LockHolder *holder = entry ? findHolder(entry, owner, false) : NULL;
+    bool held = holder && (holder->exclusive > 0 || (mode == LOCK_SHARED && holder->shared > 0));
+    pthread_mutex_unlock(&bucket->lock);
+    return held;
+}
@@ -0,0 +1,80 @@
+//     Keagan Anderson
+//        MagBase
+//       10/19/2026
+//
+//     Table lock manager: shared and exclusive locks on tables and a few whole database
+//     resources, held by owners (a thread, a cursor) until they release them
+
+#pragma once
+
+#include "globals.h"
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef enum { LOCK_SHARED, LOCK_EXCLUSIVE } LockMode;
+
+// Resources above the table ids
+#define LOCK_CATALOG 0x10000u // Shared by every call that looks tables up, exclusive for DDL and rollback
+#define LOCK_WRITER 0x10001u  // Exclusive for the one writer, a transaction keeps it until it ends
+
+// What one owner holds of a resource, both counts grow with every grant
+typedef struct {
+    const void *owner;
+    const void *parent;                 // Owner the locks were taken for (the thread of a cursor), NULL for none
+    uint32_t shared;
+    uint32_t exclusive;
+} LockHolder;
+
+typedef struct LockEntry {
+    uint32_t resource;
+    LockHolder *holders;
+    uint32_t holder_count;
+    uint32_t holder_capacity;
+    const void *exclusive_owner;        // NULL while nobody holds the resource exclusively
+    uint32_t waiting_exclusive;         // New shared requests queue behind these, so writers are not starved
+    struct LockEntry *next;
+} LockEntry;
+
+// Resources hash to a bucket, which guards its entries
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t released;
+    LockEntry *entries;
+} LockBucket;
+
+typedef struct LockManager {
+    LockBucket buckets[LOCK_PARTITIONS];
+} LockManager;
+
+// Returns NULL on error, caller must free it with freeLockManager
+LockManager *createLockManager(void);
+void freeLockManager(LockManager *locks);
+
+// Lock a resource for owner, waiting for conflicting holders. An owner may take a lock it
+// already holds again, and exclusive when it is the only shared holder. A shared request of an
+// owner is never queued while it, or an owner it is the parent of, holds the resource
+// Returns 0 once granted, -1 if it is not granted within LOCK_TIMEOUT_MS (a deadlock) or on error
+int acquireLock(LockManager *locks, uint32_t resource, LockMode mode, const void *owner);
+
+// acquireLock giving up after timeout_ms instead
+// Returns 0 once granted, -1 if it is not granted in time or on error
+int acquireLockWithin(LockManager *locks, uint32_t resource, LockMode mode, const void *owner, long timeout_ms);
+
+// acquireLock for an owner that parent opened, such as a cursor of a thread. Shared requests of
+// parent then pass the queue like those of owner, parent would otherwise wait for itself
+// Returns 0 once granted, -1 if it is not granted within LOCK_TIMEOUT_MS or on error
+int acquireLockFor(LockManager *locks, uint32_t resource, LockMode mode, const void *owner, const void *parent);
+
+// Lock a resource for owner only if that needs no wait
+// Returns 0 if granted, -1 if another owner holds a conflicting lock or on error
+int tryAcquireLock(LockManager *locks, uint32_t resource, LockMode mode, const void *owner);
+
+// Give back one grant of acquireLock or tryAcquireLock
+void releaseLock(LockManager *locks, uint32_t resource, LockMode mode, const void *owner);
+
+// Give back every lock owner holds, at the end of a transaction
+void releaseOwnerLocks(LockManager *locks, const void *owner);
+
+// Returns true if owner holds the resource in mode (exclusive also counts as shared)
+bool holdsLock(LockManager *locks, uint32_t resource, LockMode mode, const void *owner);
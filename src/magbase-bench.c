@@ -0,0 +1,254 @@
+//     Keagan Anderson
+//        MagBase
+//       10/19/2026
+//
+//     magbase-bench, measures write throughput and commit latency under every sync mode, and
+//     point read throughput from threads sharing one handle
+//     Usage: magbase-bench [-rows n] [-batch n] [-dir path] [-read-threads n]
+
+#include "magbase.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+static const char *mode_names[] = {"off", "normal", "full", "full+dir"};
+
+typedef struct {
+    double commits_per_second;  // Single row commits
+    double p50_us;
+    double p99_us;
+    double max_us;
+    double batch_rows_per_second; // Rows committed batch at a time
+} BenchResult;
+
+static double nowSeconds(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+static int compareDoubles(const void *a, const void *b) {
+    double left = *(const double *)a;
+    double right = *(const double *)b;
+    return (left > right) - (left < right);
+}
+
+static void removeDatabase(const char *path) {
+    char wal_path[600];
+    snprintf(wal_path, sizeof(wal_path), "%s-wal", path);
+    unlink(path);
+    unlink(wal_path);
+}
+
+// Insert rows one commit each, then the same number of rows batch at a time, into a fresh
+// database opened with the given mode
+// Returns 0 on success, -1 on error
+static int benchMode(const char *directory, MagbaseSyncMode mode, uint64_t rows, uint64_t batch,
+                     BenchResult *result) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s/magbase-bench-%d.mab", directory, (int)mode);
+    removeDatabase(path);
+
+    MagbaseOptions options = {.create_if_missing = true};
+    MagbaseDb *db = magbaseOpen(path, &options);
+    if (!db || magbaseSetSyncMode(db, mode) != 0) {
+        magbaseClose(db);
+        removeDatabase(path);
+        return -1;
+    }
+
+    MagbaseColumn columns[] = {{"id", MAGBASE_INT, false}, {"name", MAGBASE_TEXT, false}};
+    int table_id = magbaseCreateTable(db, "bench", columns, 2);
+    double *latencies = malloc(rows * sizeof(double));
+    int status = table_id < 0 || !latencies ? -1 : 0;
+
+    MagbaseValue values[2] = {{.type = MAGBASE_INT}, {.type = MAGBASE_TEXT}};
+    values[1].value.text_val = "a row of the sync benchmark";
+
+    double start = nowSeconds();
+    for (uint64_t row = 0; row < rows && status == 0; row++) {
+        values[0].value.int_val = (int32_t)row;
+        double before = nowSeconds();
+        if (magbaseInsert(db, (uint16_t)table_id, values, 2) == 0) {
+            status = -1;
+        }
+        latencies[row] = (nowSeconds() - before) * 1e6;
+    }
+    double elapsed = nowSeconds() - start;
+
+    if (status == 0) {
+        qsort(latencies, rows, sizeof(double), compareDoubles);
+        result->commits_per_second = (double)rows / elapsed;
+        result->p50_us = latencies[rows / 2];
+        result->p99_us = latencies[rows * 99 / 100];
+        result->max_us = latencies[rows - 1];
+    }
+
+    start = nowSeconds();
+    for (uint64_t row = 0; row < rows && status == 0; row += batch) {
+        if (magbaseBegin(db) != 0) {
+            status = -1;
+            break;
+        }
+        for (uint64_t in_batch = 0; in_batch < batch && row + in_batch < rows; in_batch++) {
+            values[0].value.int_val = (int32_t)(row + in_batch);
+            if (magbaseInsert(db, (uint16_t)table_id, values, 2) == 0) {
+                status = -1;
+                break;
+            }
+        }
+        if (status == 0 && magbaseCommit(db) != 0) {
+            status = -1;
+        }
+    }
+    if (status == 0) {
+        result->batch_rows_per_second = (double)rows / (nowSeconds() - start);
+    }
+
+    free(latencies);
+    if (magbaseClose(db) != 0) {
+        status = -1;
+    }
+    removeDatabase(path);
+    return status;
+}
+
+#define READS_PER_THREAD 200000
+
+typedef struct {
+    MagbaseDb *db;
+    uint16_t table_id;
+    uint64_t rows;
+    unsigned seed;
+    int status;
+} ReadWorker;
+
+static void *readRows(void *argument) {
+    ReadWorker *worker = argument;
+    MagbaseValue values[2];
+    for (int read = 0; read < READS_PER_THREAD && worker->status == 0; read++) {
+        uint64_t record_id = (uint64_t)rand_r(&worker->seed) % worker->rows + 1;
+        if (magbaseRead(worker->db, worker->table_id, record_id, values, 2) != 0) {
+            worker->status = -1;
+        }
+    }
+    return NULL;
+}
+
+// Read random rows of one table from 1, 2, 4 ... threads up to thread_count, all sharing a handle
+// Returns 0 on success, -1 on error
+static int benchReads(const char *directory, uint64_t rows, int thread_count) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s/magbase-bench-reads.mab", directory);
+    removeDatabase(path);
+
+    MagbaseOptions options = {.create_if_missing = true};
+    MagbaseDb *db = magbaseOpen(path, &options);
+    MagbaseColumn columns[] = {{"id", MAGBASE_INT, false}, {"name", MAGBASE_TEXT, false}};
+    int table_id = db ? magbaseCreateTable(db, "bench", columns, 2) : -1;
+    int status = table_id < 0 || magbaseBegin(db) != 0 ? -1 : 0;
+
+    MagbaseValue values[2] = {{.type = MAGBASE_INT}, {.type = MAGBASE_TEXT}};
+    values[1].value.text_val = "a row of the read benchmark";
+    for (uint64_t row = 0; row < rows && status == 0; row++) {
+        values[0].value.int_val = (int32_t)row;
+        if (magbaseInsert(db, (uint16_t)table_id, values, 2) == 0) {
+            status = -1;
+        }
+    }
+    if (status == 0 && magbaseCommit(db) != 0) {
+        status = -1;
+    }
+
+    ReadWorker *workers = calloc((size_t)thread_count, sizeof(ReadWorker));
+    pthread_t *threads = calloc((size_t)thread_count, sizeof(pthread_t));
+    if (!workers || !threads) {
+        status = -1;
+    }
+    if (status == 0) {
+        printf("\n%d point reads per thread over %lu rows\n\n", READS_PER_THREAD, (unsigned long)rows);
+        printf("%-9s %12s\n", "threads", "reads/s");
+    }
+
+    for (int threads_run = 1; status == 0; threads_run *= 2) {
+        threads_run = threads_run > thread_count ? thread_count : threads_run;
+        int started = 0;
+        double start = nowSeconds();
+        for (; started < threads_run; started++) {
+            workers[started] = (ReadWorker){db, (uint16_t)table_id, rows, (unsigned)started + 1, 0};
+            if (pthread_create(&threads[started], NULL, readRows, &workers[started]) != 0) {
+                status = -1;
+                break;
+            }
+        }
+        for (int t = 0; t < started; t++) {
+            pthread_join(threads[t], NULL);
+            status = workers[t].status != 0 ? -1 : status;
+        }
+        if (status == 0) {
+            printf("%-9d %12.0f\n", threads_run,
+                   (double)threads_run * READS_PER_THREAD / (nowSeconds() - start));
+        }
+        if (threads_run == thread_count) {
+            break;
+        }
+    }
+
+    free(workers);
+    free(threads);
+    if (magbaseClose(db) != 0) {
+        status = -1;
+    }
+    removeDatabase(path);
+    return status;
+}
+
+int main(int argc, char *argv[]) {
+    uint64_t rows = 2000;
+    uint64_t batch = 100;
+    const char *directory = ".";
+    int read_threads = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-rows") && i + 1 < argc) {
+            rows = strtoull(argv[++i], NULL, 10);
+        } else if (!strcmp(argv[i], "-batch") && i + 1 < argc) {
+            batch = strtoull(argv[++i], NULL, 10);
+        } else if (!strcmp(argv[i], "-dir") && i + 1 < argc) {
+            directory = argv[++i];
+        } else if (!strcmp(argv[i], "-read-threads") && i + 1 < argc) {
+            read_threads = atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "Usage: magbase-bench [-rows n] [-batch n] [-dir path] [-read-threads n]\n");
+            return 1;
+        }
+    }
+    if (rows == 0 || batch == 0 || read_threads < 0) {
+        fprintf(stderr, "-rows and -batch take a number above 0\n");
+        return 1;
+    }
+
+    // The disk under directory is what is measured, a tmpfs makes every mode look the same
+    printf("%lu single row commits, then %lu rows in transactions of %lu, in %s\n\n", (unsigned long)rows,
+           (unsigned long)rows, (unsigned long)batch, directory);
+    printf("%-9s %12s %10s %10s %10s %14s\n", "mode", "commits/s", "p50 us", "p99 us", "max us", "batch rows/s");
+
+    for (int mode = MAGBASE_SYNC_OFF; mode <= MAGBASE_SYNC_FULL_DIR; mode++) {
+        BenchResult result;
+        if (benchMode(directory, (MagbaseSyncMode)mode, rows, batch, &result) != 0) {
+            fprintf(stderr, "Benchmark of sync mode %s failed\n", mode_names[mode]);
+            return 1;
+        }
+        printf("%-9s %12.0f %10.1f %10.1f %10.1f %14.0f\n", mode_names[mode], result.commits_per_second,
+               result.p50_us, result.p99_us, result.max_us, result.batch_rows_per_second);
+    }
+
+    if (read_threads > 0 && benchReads(directory, rows, read_threads) != 0) {
+        fprintf(stderr, "Read benchmark failed\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,382 @@
+//     Keagan Anderson
+//        MagBase
+//       10/19/2026
+//
+//     magbase-client, runs one command against a database served by magbased
+//     Usage: magbase-client [-socket path] <db_path> <command> [arguments ...]
+
+#include "magbase-client.h"
+#include "globals.h"
+#include "protocol.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    const char *name;
+    int min_args;
+    const char *arguments;
+    int (*run)(MagbaseClient *client, int argc, char **argv);
+} ClientCommand;
+
+static void printValue(const MagbaseValue *value) {
+    if (value->is_null) {
+        printf("NULL");
+        return;
+    }
+    switch (value->type) {
+        case MAGBASE_INT:
+            printf("%d", value->value.int_val);
+            break;
+        case MAGBASE_BOOL:
+            printf("%s", value->value.bool_val ? "true" : "false");
+            break;
+        case MAGBASE_TEXT:
+            printf("%s", value->value.text_val);
+            break;
+    }
+}
+
+static void printRow(void *context, uint64_t record_id, const MagbaseValue *values, uint16_t value_count) {
+    (void)context;
+    printf("  [ID %lu] ", (unsigned long)record_id);
+    for (uint16_t col = 0; col < value_count; col++) {
+        printValue(&values[col]);
+        if (col < value_count - 1) printf(" | ");
+    }
+    printf("\n");
+}
+
+// Fill values from text the way the magbase command line reads them, NULL is a NULL value
+static void parseValues(MagbaseTableStats *stats, MagbaseValue *values, int count, char **text) {
+    memset(values, 0, sizeof(MagbaseValue) * stats->column_count);
+    for (uint16_t col = 0; col < stats->column_count; col++) {
+        values[col].type = stats->columns[col].type;
+        if (col >= count || !strcmp(text[col], "NULL")) {
+            values[col].is_null = true;
+            continue;
+        }
+        switch (values[col].type) {
+            case MAGBASE_INT:
+                values[col].value.int_val = atoi(text[col]);
+                break;
+            case MAGBASE_BOOL:
+                values[col].value.bool_val = !strcmp(text[col], "true") || !strcmp(text[col], "1");
+                break;
+            case MAGBASE_TEXT:
+                values[col].value.text_val = text[col];
+                break;
+        }
+    }
+}
+
+// Fetch the schema a command needs to read or print values
+static int loadTable(MagbaseClient *client, const char *table, MagbaseTableStats *stats) {
+    if (magbaseClientTableStats(client, (uint16_t)atoi(table), stats) != 0) {
+        fprintf(stderr, "Table not found\n");
+        return -1;
+    }
+    return 0;
+}
+
+static int pingCommand(MagbaseClient *client, int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+    if (magbaseClientPing(client) != 0) {
+        fprintf(stderr, "No answer from the server\n");
+        return -1;
+    }
+    printf("Server is up\n");
+    return 0;
+}
+
+static int createTableCommand(MagbaseClient *client, int argc, char **argv) {
+    uint16_t num_columns = (uint16_t)atoi(argv[1]);
+    if (num_columns == 0 || num_columns > MAGBASE_MAX_COLUMNS || argc - 2 < num_columns) {
+        fprintf(stderr, "Invalid number of columns\n");
+        return -1;
+    }
+
+    MagbaseColumn columns[MAGBASE_MAX_COLUMNS];
+    for (uint16_t col = 0; col < num_columns; col++) {
+        char *name = strtok(argv[2 + col], ":");
+        char *type = strtok(NULL, ":");
+        char *nullable = strtok(NULL, ":");
+        if (!name || !type) {
+            fprintf(stderr, "Invalid column format. Use: col_name:type:nullable (types: int, text, bool)\n");
+            return -1;
+        }
+        columns[col].name = name;
+        columns[col].nullable = nullable && !strcmp(nullable, "1");
+        if (!strcmp(type, "int")) {
+            columns[col].type = MAGBASE_INT;
+        } else if (!strcmp(type, "text")) {
+            columns[col].type = MAGBASE_TEXT;
+        } else if (!strcmp(type, "bool")) {
+            columns[col].type = MAGBASE_BOOL;
+        } else {
+            fprintf(stderr, "Unknown column type: %s\n", type);
+            return -1;
+        }
+    }
+
+    int table_id = magbaseClientCreateTable(client, argv[0], columns, num_columns);
+    if (table_id < 0) {
+        fprintf(stderr, "Failed to create table\n");
+        return -1;
+    }
+    printf("Table '%s' created with ID %d\n", argv[0], table_id);
+    return 0;
+}
+
+static int deleteTableCommand(MagbaseClient *client, int argc, char **argv) {
+    (void)argc;
+    if (magbaseClientDropTable(client, (uint16_t)atoi(argv[0])) != 0) {
+        fprintf(stderr, "Failed to delete table\n");
+        return -1;
+    }
+    printf("Table with ID %d deleted\n", atoi(argv[0]));
+    return 0;
+}
+
+static int findTableCommand(MagbaseClient *client, int argc, char **argv) {
+    (void)argc;
+    int table_id = magbaseClientFindTable(client, argv[0]);
+    if (table_id < 0) {
+        fprintf(stderr, "Table not found\n");
+        return -1;
+    }
+    printf("%d\n", table_id);
+    return 0;
+}
+
+static int statsCommand(MagbaseClient *client, int argc, char **argv) {
+    (void)argc;
+    MagbaseTableStats stats;
+    if (loadTable(client, argv[0], &stats) != 0) {
+        return -1;
+    }
+    printf("[ID %d] %s (%d columns), %lu rows in %lu pages\n", stats.table_id, stats.name, stats.column_count,
+           (unsigned long)stats.row_count, (unsigned long)stats.page_count);
+    return 0;
+}
+
+static int insertRecordCommand(MagbaseClient *client, int argc, char **argv) {
+    MagbaseTableStats stats;
+    MagbaseValue values[MAGBASE_MAX_COLUMNS];
+    if (loadTable(client, argv[0], &stats) != 0) {
+        return -1;
+    }
+    parseValues(&stats, values, argc - 1, argv + 1);
+
+    uint64_t record_id = magbaseClientInsert(client, stats.table_id, values, stats.column_count);
+    if (record_id == 0) {
+        fprintf(stderr, "Failed to insert record\n");
+        return -1;
+    }
+    printf("Record inserted with ID %lu\n", (unsigned long)record_id);
+    return 0;
+}
+
+// Split a line at tabs in place
+// Returns the number of fields
+static int splitTabs(char *line, char **fields, int max_fields) {
+    int count = 0;
+    line[strcspn(line, "\r\n")] = '\0';
+    while (count < max_fields) {
+        fields[count++] = line;
+        char *tab = strchr(line, '\t');
+        if (!tab) {
+            break;
+        }
+        *tab = '\0';
+        line = tab + 1;
+    }
+    return count;
+}
+
+static int insertRecordsCommand(MagbaseClient *client, int argc, char **argv) {
+    (void)argc;
+    MagbaseTableStats stats;
+    if (loadTable(client, argv[0], &stats) != 0) {
+        return -1;
+    }
+
+    // Lines are held until a window of rows is sent, the text values point into them
+    MagbaseValue *rows = malloc(sizeof(MagbaseValue) * stats.column_count * CLIENT_PIPELINE_DEPTH);
+    char **lines = calloc(CLIENT_PIPELINE_DEPTH, sizeof(char *));
+    size_t *capacities = calloc(CLIENT_PIPELINE_DEPTH, sizeof(size_t));
+    if (!rows || !lines || !capacities) {
+        free(rows);
+        free(lines);
+        free(capacities);
+        return -1;
+    }
+
+    uint64_t total = 0;
+    uint64_t failed = 0;
+    int result = 0;
+    while (result == 0) {
+        uint64_t count = 0;
+        while (count < CLIENT_PIPELINE_DEPTH && getline(&lines[count], &capacities[count], stdin) >= 0) {
+            char *fields[MAGBASE_MAX_COLUMNS];
+            int field_count = splitTabs(lines[count], fields, MAGBASE_MAX_COLUMNS);
+            parseValues(&stats, rows + count * stats.column_count, field_count, fields);
+            count++;
+        }
+        if (count == 0) {
+            break;
+        }
+
+        int64_t inserted = magbaseClientInsertMany(client, stats.table_id, rows, stats.column_count, count, NULL);
+        if (inserted < 0) {
+            fprintf(stderr, "Lost the connection to the server\n");
+            result = -1;
+            break;
+        }
+        total += (uint64_t)inserted;
+        failed += count - (uint64_t)inserted;
+    }
+
+    for (int i = 0; i < CLIENT_PIPELINE_DEPTH; i++) {
+        free(lines[i]);
+    }
+    free(lines);
+    free(capacities);
+    free(rows);
+
+    printf("%lu records inserted\n", (unsigned long)total);
+    if (failed > 0) {
+        fprintf(stderr, "%lu records failed\n", (unsigned long)failed);
+        result = -1;
+    }
+    return result;
+}
+
+static int readRecordCommand(MagbaseClient *client, int argc, char **argv) {
+    (void)argc;
+    MagbaseTableStats stats;
+    MagbaseValue values[MAGBASE_MAX_COLUMNS];
+    if (loadTable(client, argv[0], &stats) != 0) {
+        return -1;
+    }
+    uint64_t record_id = (uint64_t)atoll(argv[1]);
+    if (magbaseClientRead(client, stats.table_id, record_id, values, MAGBASE_MAX_COLUMNS) != 0) {
+        fprintf(stderr, "Record not found\n");
+        return -1;
+    }
+
+    printf("Record ID %lu:\n", (unsigned long)record_id);
+    for (uint16_t col = 0; col < stats.column_count; col++) {
+        printf("  %s: ", stats.columns[col].name);
+        printValue(&values[col]);
+        printf("\n");
+    }
+    return 0;
+}
+
+static int listRecordsCommand(MagbaseClient *client, int argc, char **argv) {
+    const char *where[WIRE_MAX_CONDITIONS];
+    int where_count = 0;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-where") && i + 1 < argc && where_count < WIRE_MAX_CONDITIONS) {
+            where[where_count++] = argv[++i];
+        } else {
+            fprintf(stderr, "Unknown option: %s\n", argv[i]);
+            return -1;
+        }
+    }
+
+    uint16_t table_id = (uint16_t)atoi(argv[0]);
+    printf("Records in table %d:\n", table_id);
+    if (magbaseClientScan(client, table_id, where, where_count, printRow, NULL) < 0) {
+        fprintf(stderr, "Failed to list records\n");
+        return -1;
+    }
+    return 0;
+}
+
+static int updateRecordCommand(MagbaseClient *client, int argc, char **argv) {
+    MagbaseTableStats stats;
+    MagbaseValue values[MAGBASE_MAX_COLUMNS];
+    if (loadTable(client, argv[0], &stats) != 0) {
+        return -1;
+    }
+    parseValues(&stats, values, argc - 2, argv + 2);
+
+    if (magbaseClientUpdate(client, stats.table_id, (uint64_t)atoll(argv[1]), values, stats.column_count) != 0) {
+        fprintf(stderr, "Failed to update record\n");
+        return -1;
+    }
+    printf("Record updated\n");
+    return 0;
+}
+
+static int deleteRecordCommand(MagbaseClient *client, int argc, char **argv) {
+    (void)argc;
+    if (magbaseClientDelete(client, (uint16_t)atoi(argv[0]), (uint64_t)atoll(argv[1])) != 0) {
+        fprintf(stderr, "Record not found\n");
+        return -1;
+    }
+    printf("Record deleted\n");
+    return 0;
+}
+
+static const ClientCommand commands[] = {
+    {"ping", 0, "", pingCommand},
+    {"create-table", 3, "<table_name> <num_columns> [col_name:type:nullable ...]", createTableCommand},
+    {"delete-table", 1, "<table_id>", deleteTableCommand},
+    {"find-table", 1, "<table_name>", findTableCommand},
+    {"stats", 1, "<table_id>", statsCommand},
+    {"insert-record", 1, "<table_id> [field_value ...]", insertRecordCommand},
+    {"insert-records", 1, "<table_id> < tab separated rows", insertRecordsCommand},
+    {"read-record", 2, "<table_id> <record_id>", readRecordCommand},
+    {"list-records", 1, "<table_id> [-where col<op>value]...", listRecordsCommand},
+    {"update-record", 2, "<table_id> <record_id> [field_value ...]", updateRecordCommand},
+    {"delete-record", 2, "<table_id> <record_id>", deleteRecordCommand},
+};
+
+static void printUsage(void) {
+    fprintf(stderr, "Usage: magbase-client [-socket path] <db_path> <command> [arguments ...]\n");
+    for (size_t c = 0; c < sizeof(commands) / sizeof(commands[0]); c++) {
+        fprintf(stderr, "  %s %s\n", commands[c].name, commands[c].arguments);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    char socket_path[256] = "";
+    int first = 1;
+    if (argc > 2 && !strcmp(argv[1], "-socket")) {
+        snprintf(socket_path, sizeof(socket_path), "%s", argv[2]);
+        first = 3;
+    }
+    if (argc - first < 2) {
+        printUsage();
+        return 1;
+    }
+    if (!socket_path[0] && defaultSocketPath(argv[first], socket_path, sizeof(socket_path)) != 0) {
+        fprintf(stderr, "Database path is too long\n");
+        return 1;
+    }
+
+    const ClientCommand *command = NULL;
+    for (size_t c = 0; c < sizeof(commands) / sizeof(commands[0]); c++) {
+        if (!strcmp(commands[c].name, argv[first + 1])) {
+            command = &commands[c];
+        }
+    }
+    int command_argc = argc - first - 2;
+    if (!command || command_argc < command->min_args) {
+        printUsage();
+        return 1;
+    }
+
+    MagbaseClient *client = magbaseConnect(socket_path);
+    if (!client) {
+        fprintf(stderr, "Failed to connect to %s, is magbased running?\n", socket_path);
+        return 1;
+    }
+    int status = command->run(client, command_argc, argv + first + 2);
+    magbaseDisconnect(client);
+    return status == 0 ? 0 : 1;
+}
@@ -0,0 +1,62 @@
+//     Keagan Anderson
+//        MagBase
+//       10/19/2026
+//
+//     Client side of magbased, part of libmagbase. The calls mirror magbase.h but run in the
+//     server, so many processes share its buffer pool and catalog
+
+#pragma once
+
+#include "magbase.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct MagbaseClient MagbaseClient;
+
+// Called for every row of a scan, text values are only valid during the call
+typedef void (*MagbaseRowFunction)(void *context, uint64_t record_id, const MagbaseValue *values,
+                                   uint16_t value_count);
+
+// Connect to magbased, for the default socket of a database use "<db_path>.mab-sock"
+// A client is used by one thread at a time
+// Returns NULL if nothing listens on socket_path
+MAGBASE_API MagbaseClient *magbaseConnect(const char *socket_path);
+
+MAGBASE_API void magbaseDisconnect(MagbaseClient *client);
+
+// Returns 0 if the server answers, -1 otherwise
+MAGBASE_API int magbaseClientPing(MagbaseClient *client);
+
+// Each call sends one request and waits for its answer, returning what the magbase.h call of
+// the same name returns. Text read back stays valid until the next call on the client, column
+// names from magbaseClientTableStats until its next call
+MAGBASE_API int magbaseClientCreateTable(MagbaseClient *client, const char *name, const MagbaseColumn *columns,
+                                         uint16_t column_count);
+MAGBASE_API int magbaseClientDropTable(MagbaseClient *client, uint16_t table_id);
+MAGBASE_API int magbaseClientFindTable(MagbaseClient *client, const char *name);
+MAGBASE_API int magbaseClientTableStats(MagbaseClient *client, uint16_t table_id, MagbaseTableStats *stats);
+MAGBASE_API uint64_t magbaseClientInsert(MagbaseClient *client, uint16_t table_id, const MagbaseValue *values,
+                                         uint16_t value_count);
+MAGBASE_API int magbaseClientRead(MagbaseClient *client, uint16_t table_id, uint64_t record_id,
+                                  MagbaseValue *values, uint16_t value_count);
+MAGBASE_API int magbaseClientUpdate(MagbaseClient *client, uint16_t table_id, uint64_t record_id,
+                                    const MagbaseValue *values, uint16_t value_count);
+MAGBASE_API int magbaseClientDelete(MagbaseClient *client, uint16_t table_id, uint64_t record_id);
+
+// Insert row_count rows of value_count values each (rows holds them one after another),
+// pipelining the requests so the round trips overlap. record_ids (optional) gets the id of each
+// row, 0 for a row that failed
+// Returns the number of rows inserted, or -1 if the connection failed
+MAGBASE_API int64_t magbaseClientInsertMany(MagbaseClient *client, uint16_t table_id, const MagbaseValue *rows,
+                                            uint16_t value_count, uint64_t row_count, uint64_t *record_ids);
+
+// Call row for every row of a table matching every "col<op>value" in where, see magbaseOpenCursor
+// Returns the number of rows, or -1 on error
+MAGBASE_API int64_t magbaseClientScan(MagbaseClient *client, uint16_t table_id, const char *const *where,
+                                      int where_count, MagbaseRowFunction row, void *context);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,694 @@
+//     Keagan Anderson
+//        MagBase
+//       10/19/2026
+//
+//     libmagbase, the public C API on top of the engine (see magbase.h)
+
+#include "magbase.h"
+#include "buffer.h"
+#include "db-init.h"
+#include "file-lock.h"
+#include "filter.h"
+#include "globals.h"
+#include "lock-manager.h"
+#include "records.h"
+#include "schema.h"
+#include "structs/schemaStruct.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define STRINGIFY_VALUE(x) #x
+#define STRINGIFY(x) STRINGIFY_VALUE(x)
+
+struct MagbaseDb {
+    MagBase *db;
+    char *path;               // Owned, the engine keeps a pointer to it
+    LockManager *locks;       // Table locks of the threads sharing the handle
+    _Atomic int open_cursors;
+};
+
+struct MagbaseCursor {
+    MagbaseDb *owner;
+    RecordScan *scan;
+    Filter filter;            // The scan keeps a pointer to it
+    Record *record;           // Last row read, the text values point into it
+    uint16_t table_id;
+    bool locked;              // Holds its table shared, unless the opening transaction had it exclusively
+    bool file_locked;         // Counts as a reader of the file, so other processes do not write it meanwhile
+};
+
+// Its address names the calling thread to the lock manager
+static _Thread_local char thread_owner;
+#define THREAD_OWNER ((const void *)&thread_owner)
+
+// The handle whose transaction the calling thread has open, NULL outside one
+static _Thread_local MagbaseDb *transaction_db;
+
+// Last row magbaseRead returned to a thread, the text values point into it. Freed with the thread
+static pthread_key_t row_key;
+static pthread_once_t row_key_once = PTHREAD_ONCE_INIT;
+
+static void freeRow(void *row) { freeRecord(row); }
+
+static void createRowKey(void) { pthread_key_create(&row_key, freeRow); }
+
+const char *magbaseVersion(void) {
+    return STRINGIFY(DB_VERSION_MAJOR) "." STRINGIFY(DB_VERSION_MINOR) "." STRINGIFY(DB_VERSION_PATCH);
+}
+
+// Create an empty database file, like -p without the prompt. A new file is opened write only,
+// so it is closed and opened again for use
+static MagBase *createEmptyDatabase(char *path, uint32_t page_size) {
+    if (!validPageSize(page_size)) {
+        fprintf(stderr, "Unsupported page size %u\n", page_size);
+        return NULL;
+    }
+    Header *header = malloc(sizeof(Header));
+    if (!header) {
+        return NULL;
+    }
+    createHeader(header, page_size);
+
+    MagBase *db = createMagBase(header, path, true);
+    if (!db) {
+        free(header);
+        return NULL;
+    }
+    int result = writeHeader(db);
+    freeDatabase(db);
+    return result == 0 ? openMagBase(path) : NULL;
+}
+
+MagbaseDb *magbaseOpen(const char *path, const MagbaseOptions *options) {
+    if (!path) {
+        return NULL;
+    }
+
+    MagbaseDb *handle = calloc(1, sizeof(MagbaseDb));
+    size_t length = strlen(path);
+    bool has_extension = length >= 4 && !strcmp(path + length - 4, ".mab");
+    if (!handle || !(handle->path = malloc(length + 5))) {
+        free(handle);
+        return NULL;
+    }
+    memcpy(handle->path, path, length + 1);
+    if (!has_extension) {
+        strcat(handle->path, ".mab");
+    }
+
+    if (options && options->create_if_missing && !checkIfFileExists(handle->path)) {
+        handle->db = createEmptyDatabase(handle->path, options->page_size ? options->page_size : PAGE_SIZE);
+    } else {
+        handle->db = openMagBase(handle->path);
+    }
+    handle->locks = handle->db ? createLockManager() : NULL;
+    if (!handle->locks) {
+        if (handle->db) {
+            freeDatabase(handle->db);
+        }
+        free(handle->path);
+        free(handle);
+        return NULL;
+    }
+    // Threads read while the writer appends, pages are only compacted under beginCompaction
+    handle->db->compact_pages = false;
+    return handle;
+}
+
+int magbaseClose(MagbaseDb *db) {
+    if (!db || db->open_cursors > 0) {
+        return -1;
+    }
+
+    // freeDatabase keeps only committed changes
+    if (transaction_db == db) {
+        transaction_db = NULL;
+    }
+    int result = freeDatabase(db->db);
+    freeLockManager(db->locks);
+    free(db->path);
+    free(db);
+    return result;
+}
+
+// Take what a call reading table_id needs (0 for a call that only looks tables up): the table
+// and the catalog shared, and the pool in POOL_READ. Tables are always locked before the
+// catalog, which is only held during a call, so a waiting call never holds what it waits for.
+// A thread in a transaction reads as the writer, so it sees the rows it has not committed yet.
+// Last the file is locked against writers of other processes
+// Returns 0 on success, -1 if a lock is not granted
+static int beginRead(MagbaseDb *db, uint16_t table_id) {
+    if (table_id != 0 && acquireLock(db->locks, table_id, LOCK_SHARED, THREAD_OWNER) != 0) {
+        return -1;
+    }
+    if (acquireLock(db->locks, LOCK_CATALOG, LOCK_SHARED, THREAD_OWNER) == 0) {
+        if (enterBufferPool(db->db->buffer_pool, transaction_db == db ? POOL_WRITE : POOL_READ) == 0) {
+            if (lockFileReader(db->db) == 0) {
+                return 0;
+            }
+            leaveBufferPool(db->db->buffer_pool);
+        }
+        releaseLock(db->locks, LOCK_CATALOG, LOCK_SHARED, THREAD_OWNER);
+    }
+    if (table_id != 0) {
+        releaseLock(db->locks, table_id, LOCK_SHARED, THREAD_OWNER);
+    }
+    return -1;
+}
+
+static void endRead(MagbaseDb *db, uint16_t table_id) {
+    unlockFileReader(db->db);
+    leaveBufferPool(db->db->buffer_pool);
+    releaseLock(db->locks, LOCK_CATALOG, LOCK_SHARED, THREAD_OWNER);
+    if (table_id != 0) {
+        releaseLock(db->locks, table_id, LOCK_SHARED, THREAD_OWNER);
+    }
+}
+
+// Take what a write to table_id needs (0 for none): the writer slot and the table exclusively,
+// both kept to the end of a transaction, the catalog in catalog_mode (exclusive for DDL) and the
+// pool in POOL_WRITE. Commits cover the whole database, so one writer runs at a time, and the
+// writer lock of the file keeps writers of other processes out as long as the writer slot
+// Returns 0 on success, -1 if a lock is not granted
+static int beginWrite(MagbaseDb *db, uint16_t table_id, LockMode catalog_mode) {
+    bool granted = acquireLock(db->locks, LOCK_WRITER, LOCK_EXCLUSIVE, THREAD_OWNER) == 0 &&
+                   (table_id == 0 || acquireLock(db->locks, table_id, LOCK_EXCLUSIVE, THREAD_OWNER) == 0);
+    if (granted && acquireLock(db->locks, LOCK_CATALOG, catalog_mode, THREAD_OWNER) == 0) {
+        if (enterBufferPool(db->db->buffer_pool, POOL_WRITE) == 0) {
+            if (lockFileWriter(db->db) == 0) {
+                return 0;
+            }
+            leaveBufferPool(db->db->buffer_pool);
+        }
+        releaseLock(db->locks, LOCK_CATALOG, catalog_mode, THREAD_OWNER);
+    }
+    if (transaction_db != db) {
+        releaseOwnerLocks(db->locks, THREAD_OWNER);
+    }
+    return -1;
+}
+
+static void endWrite(MagbaseDb *db, LockMode catalog_mode) {
+    if (transaction_db != db) {
+        unlockFileWriter(db->db);
+    }
+    leaveBufferPool(db->db->buffer_pool);
+    releaseLock(db->locks, LOCK_CATALOG, catalog_mode, THREAD_OWNER);
+    if (transaction_db != db) {
+        releaseOwnerLocks(db->locks, THREAD_OWNER);
+    }
+}
+
+// The table a row write locks. Rows of 1.4 files are versioned, readers skip the versions the
+// writer has not committed, so only older files lock the table against them
+static uint16_t rowWriteTable(MagbaseDb *db, uint16_t table_id) { return db->db->version_size > 0 ? 0 : table_id; }
+
+// Let an append to a table of a 1.4 file compact a full page, which moves its rows, when no
+// reader is in the table. The table is held exclusively until endCompaction, readers that come
+// meanwhile wait and then take snapshots that no longer need the removed rows
+static void beginCompaction(MagbaseDb *db, uint16_t table_id) {
+    db->db->compact_pages = db->db->version_size > 0 &&
+                            tryAcquireLock(db->locks, table_id, LOCK_EXCLUSIVE, THREAD_OWNER) == 0;
+}
+
+static void endCompaction(MagbaseDb *db, uint16_t table_id) {
+    if (db->db->compact_pages) {
+        releaseLock(db->locks, table_id, LOCK_EXCLUSIVE, THREAD_OWNER);
+        db->db->compact_pages = false;
+    }
+}
+
+int magbaseSetSyncMode(MagbaseDb *db, MagbaseSyncMode mode) {
+    if (!db || mode < MAGBASE_SYNC_OFF || mode > MAGBASE_SYNC_FULL_DIR) {
+        return -1;
+    }
+    if (beginWrite(db, 0, LOCK_SHARED) != 0) {
+        return -1;
+    }
+    int result = setSyncMode(db->db, (SyncMode)mode);
+    endWrite(db, LOCK_SHARED);
+    return result;
+}
+
+// Commit a write unless a transaction is open, like a session does. The log is only synced by
+// awaitWrite, after endWrite lets the next writer in, so writers that commit one after the
+// other while a sync runs share the next one
+static int finishWrite(MagbaseDb *db, uint64_t *commit_lsn) {
+    *commit_lsn = 0;
+    if (transaction_db == db) {
+        return 0;
+    }
+    return writeCommit(db->db, commit_lsn);
+}
+
+// Wait for a commit finishWrite logged to be durable
+// Returns 0 on success, -1 if the log could not be synced
+static int awaitWrite(MagbaseDb *db, uint64_t commit_lsn) { return awaitCommit(db->db, commit_lsn); }
+
+// A write that failed may have changed pages half way, its transaction is rolled back. The
+// rollback resets the header and the catalog readers look at, so they are waited out first
+static int abortWrite(MagbaseDb *db) {
+    leaveBufferPool(db->db->buffer_pool);
+    acquireLock(db->locks, LOCK_CATALOG, LOCK_EXCLUSIVE, THREAD_OWNER);
+    enterBufferPool(db->db->buffer_pool, POOL_WRITE);
+    rollbackDatabase(db->db);
+    if (transaction_db == db) {
+        transaction_db = NULL;
+    }
+    releaseLock(db->locks, LOCK_CATALOG, LOCK_EXCLUSIVE, THREAD_OWNER);
+    return -1;
+}
+
+int magbaseBegin(MagbaseDb *db) {
+    if (!db || transaction_db || !db->db->wal) {
+        return -1;
+    }
+    // Held until commit or rollback, other writers wait for it
+    if (acquireLock(db->locks, LOCK_WRITER, LOCK_EXCLUSIVE, THREAD_OWNER) != 0) {
+        return -1;
+    }
+    transaction_db = db;
+    return 0;
+}
+
+int magbaseCommit(MagbaseDb *db) {
+    if (!db || transaction_db != db || beginWrite(db, 0, LOCK_SHARED) != 0) {
+        return -1;
+    }
+    transaction_db = NULL;
+
+    int result = 0;
+    uint64_t commit_lsn;
+    if (finishWrite(db, &commit_lsn) != 0) {
+        result = abortWrite(db);
+    }
+    endWrite(db, LOCK_SHARED);
+    return result == 0 ? awaitWrite(db, commit_lsn) : -1;
+}
+
+int magbaseRollback(MagbaseDb *db) {
+    if (!db || transaction_db != db || beginWrite(db, 0, LOCK_EXCLUSIVE) != 0) {
+        return -1;
+    }
+    transaction_db = NULL;
+    int result = rollbackDatabase(db->db);
+    endWrite(db, LOCK_EXCLUSIVE);
+    return result;
+}
+
+// Build the schema of a new table
+// Returns NULL if a column is not valid
+static TableSchemaRecord *schemaFromColumns(const char *name, const MagbaseColumn *columns, uint16_t column_count) {
+    TableSchemaRecord *schema = calloc(1, sizeof(TableSchemaRecord));
+    if (!schema) {
+        return NULL;
+    }
+    schema->column_count = column_count;
+    schema->next_record_id = 1;
+    schema->name_len = (uint16_t)strlen(name);
+    strcpy(schema->table_name, name);
+
+    for (uint16_t col = 0; col < column_count; col++) {
+        const MagbaseColumn *column = &columns[col];
+        if (!column->name || strlen(column->name) >= MAX_COLUMN_NAME || column->type > MAGBASE_BOOL) {
+            free(schema);
+            return NULL;
+        }
+        schema->columns[col].type = column->type;
+        schema->columns[col].nullable = column->nullable ? 1 : 0;
+        schema->columns[col].name_len = (uint16_t)strlen(column->name);
+        strcpy(schema->columns[col].name, column->name);
+    }
+    return schema;
+}
+
+int magbaseCreateTable(MagbaseDb *db, const char *name, const MagbaseColumn *columns, uint16_t column_count) {
+    if (!db || !name || !columns || column_count == 0 || column_count > MAX_COLUMNS ||
+        strlen(name) >= MAX_TABLE_NAME) {
+        return -1;
+    }
+    TableSchemaRecord *schema = schemaFromColumns(name, columns, column_count);
+    if (!schema || beginWrite(db, 0, LOCK_EXCLUSIVE) != 0) {
+        free(schema);
+        return -1;
+    }
+
+    int table_id = -1;
+    uint64_t commit_lsn = 0;
+    if (!getTableSchemaByName(db->db, name)) {
+        table_id = writeTableSchema(db->db, schema);
+        // Until its transaction commits nobody else may use the table
+        if (table_id > 0 && acquireLock(db->locks, (uint16_t)table_id, LOCK_EXCLUSIVE, THREAD_OWNER) != 0) {
+            table_id = -1;
+        }
+        if (table_id <= 0 || finishWrite(db, &commit_lsn) != 0) {
+            table_id = abortWrite(db);
+        }
+    }
+    free(schema);
+    endWrite(db, LOCK_EXCLUSIVE);
+    return table_id > 0 && awaitWrite(db, commit_lsn) != 0 ? -1 : table_id;
+}
+
+int magbaseDropTable(MagbaseDb *db, uint16_t table_id) {
+    if (!db || table_id == 0 || beginWrite(db, table_id, LOCK_EXCLUSIVE) != 0) {
+        return -1;
+    }
+
+    int result = -1;
+    uint64_t commit_lsn = 0;
+    if (deleteTableSchema(db->db, table_id) == 0) {
+        result = finishWrite(db, &commit_lsn) == 0 ? 0 : abortWrite(db);
+    }
+    endWrite(db, LOCK_EXCLUSIVE);
+    return result == 0 ? awaitWrite(db, commit_lsn) : -1;
+}
+
+int magbaseFindTable(MagbaseDb *db, const char *name) {
+    if (!db || !name || beginRead(db, 0) != 0) {
+        return -1;
+    }
+    TableSchemaRecord *schema = getTableSchemaByName(db->db, name);
+    int table_id = schema ? schema->table_id : -1;
+    endRead(db, 0);
+    return table_id;
+}
+
+int magbaseTableStats(MagbaseDb *db, uint16_t table_id, MagbaseTableStats *stats) {
+    if (!db || !stats || table_id == 0 || beginRead(db, table_id) != 0) {
+        return -1;
+    }
+    TableSchemaRecord *schema = getTableSchema(db->db, table_id);
+    if (!schema) {
+        endRead(db, table_id);
+        return -1;
+    }
+
+    memset(stats, 0, sizeof(MagbaseTableStats));
+    stats->table_id = table_id;
+    strncpy(stats->name, schema->table_name, MAGBASE_MAX_NAME - 1);
+    stats->column_count = schema->column_count;
+    for (uint16_t col = 0; col < schema->column_count; col++) {
+        stats->columns[col].name = schema->columns[col].name;
+        stats->columns[col].type = schema->columns[col].type;
+        stats->columns[col].nullable = schema->columns[col].nullable != 0;
+    }
+    stats->row_count = countRecords(db->db, table_id, &stats->page_count);
+    endRead(db, table_id);
+    return 0;
+}
+
+// Build a record from public values, checking them against the schema
+// Returns the record, or NULL if a value does not fit its column
+static Record *recordFromValues(TableSchemaRecord *schema, const MagbaseValue *values, uint16_t value_count) {
+    if (!values || value_count != schema->column_count) {
+        return NULL;
+    }
+
+    Record *record = createRecord(schema->table_id, schema->column_count);
+    if (!record) {
+        return NULL;
+    }
+    for (uint16_t col = 0; col < value_count; col++) {
+        const MagbaseValue *value = &values[col];
+        RecordField *field = &record->fields[col];
+        field->type = schema->columns[col].type;
+
+        if (value->is_null) {
+            if (!schema->columns[col].nullable) {
+                freeRecord(record);
+                return NULL;
+            }
+            field->is_null = 1;
+            continue;
+        }
+        if (value->type != field->type) {
+            freeRecord(record);
+            return NULL;
+        }
+
+        field->is_null = 0;
+        switch (field->type) {
+            case COL_INT:
+                field->value.int_val = value->value.int_val;
+                break;
+            case COL_BOOL:
+                field->value.bool_val = value->value.bool_val ? 1 : 0;
+                break;
+            case COL_TEXT:
+                if (!value->value.text_val || strlen(value->value.text_val) >= MAX_RECORD_VALUE_SIZE) {
+                    freeRecord(record);
+                    return NULL;
+                }
+                strcpy(field->value.text_val, value->value.text_val);
+                break;
+        }
+    }
+    return record;
+}
+
+// Point public values at the fields of a record
+static void valuesFromRecord(TableSchemaRecord *schema, Record *record, MagbaseValue *values) {
+    for (uint16_t col = 0; col < record->field_count; col++) {
+        RecordField *field = &record->fields[col];
+        MagbaseValue *value = &values[col];
+        value->type = schema->columns[col].type;
+        value->is_null = field->is_null != 0;
+        if (value->is_null) {
+            continue;
+        }
+
+        switch (value->type) {
+            case COL_INT:
+                value->value.int_val = field->value.int_val;
+                break;
+            case COL_BOOL:
+                value->value.bool_val = field->value.bool_val != 0;
+                break;
+            case COL_TEXT:
+                value->value.text_val = field->value.text_val;
+                break;
+        }
+    }
+}
+
+uint64_t magbaseInsert(MagbaseDb *db, uint16_t table_id, const MagbaseValue *values, uint16_t value_count) {
+    if (!db || table_id == 0 || beginWrite(db, rowWriteTable(db, table_id), LOCK_SHARED) != 0) {
+        return 0;
+    }
+    TableSchemaRecord *schema = getTableSchema(db->db, table_id);
+    Record *record = schema ? recordFromValues(schema, values, value_count) : NULL;
+    if (!record) {
+        endWrite(db, LOCK_SHARED);
+        return 0;
+    }
+
+    beginCompaction(db, table_id);
+    uint64_t record_id = appendRecord(db->db, schema, record);
+    endCompaction(db, table_id);
+    freeRecord(record);
+    uint64_t commit_lsn;
+    if (record_id == 0 || finishWrite(db, &commit_lsn) != 0) {
+        abortWrite(db);
+        record_id = 0;
+    }
+    endWrite(db, LOCK_SHARED);
+    return record_id != 0 && awaitWrite(db, commit_lsn) == 0 ? record_id : 0;
+}
+
+int magbaseRead(MagbaseDb *db, uint16_t table_id, uint64_t record_id, MagbaseValue *values, uint16_t value_count) {
+    if (!db || !values || table_id == 0 || beginRead(db, table_id) != 0) {
+        return -1;
+    }
+    TableSchemaRecord *schema = getTableSchema(db->db, table_id);
+    Record *record = schema && value_count >= schema->column_count ? readRecord(db->db, table_id, record_id) : NULL;
+    if (!record) {
+        endRead(db, table_id);
+        return -1;
+    }
+
+    pthread_once(&row_key_once, createRowKey);
+    freeRecord(pthread_getspecific(row_key));
+    pthread_setspecific(row_key, record);
+    valuesFromRecord(schema, record, values);
+    endRead(db, table_id);
+    return 0;
+}
+
+int magbaseUpdate(MagbaseDb *db, uint16_t table_id, uint64_t record_id, const MagbaseValue *values,
+                  uint16_t value_count) {
+    if (!db || table_id == 0 || beginWrite(db, rowWriteTable(db, table_id), LOCK_SHARED) != 0) {
+        return -1;
+    }
+    TableSchemaRecord *schema = getTableSchema(db->db, table_id);
+    Record *record = schema ? recordFromValues(schema, values, value_count) : NULL;
+    if (!record) {
+        endWrite(db, LOCK_SHARED);
+        return -1;
+    }
+    record->record_id = record_id;
+
+    beginCompaction(db, table_id);
+    int result = updateRecord(db->db, record);
+    endCompaction(db, table_id);
+    freeRecord(record);
+    uint64_t commit_lsn = 0;
+    if (result == 0 && finishWrite(db, &commit_lsn) != 0) {
+        result = abortWrite(db);
+    }
+    endWrite(db, LOCK_SHARED);
+    return result == 0 ? awaitWrite(db, commit_lsn) : -1;
+}
+
+int magbaseDelete(MagbaseDb *db, uint16_t table_id, uint64_t record_id) {
+    if (!db || table_id == 0 || beginWrite(db, rowWriteTable(db, table_id), LOCK_SHARED) != 0) {
+        return -1;
+    }
+
+    int result = deleteRecord(db->db, table_id, record_id);
+    uint64_t commit_lsn = 0;
+    if (result == 0 && finishWrite(db, &commit_lsn) != 0) {
+        result = abortWrite(db);
+    }
+    endWrite(db, LOCK_SHARED);
+    return result == 0 ? awaitWrite(db, commit_lsn) : -1;
+}
+
+// Take what a vacuum of table_id needs: the table to itself since rows move, then a write. The
+// table comes first, so writers are not kept waiting behind the readers and cursors it waits
+// for, while new readers queue behind it so they cannot starve it. Holding the table it waits for
+// the writer slot only VACUUM_WRITER_WAIT_MS, a long transaction would keep readers out, and then
+// lets readers back in for as long before it tries again. A transaction already has the slot
+// Returns 0 on success, -1 if a lock is not granted within LOCK_TIMEOUT_MS
+static int beginVacuum(MagbaseDb *db, uint16_t table_id) {
+    if (transaction_db == db) {
+        return beginWrite(db, table_id, LOCK_SHARED);
+    }
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    while (acquireLock(db->locks, table_id, LOCK_EXCLUSIVE, THREAD_OWNER) == 0) {
+        if (acquireLockWithin(db->locks, LOCK_WRITER, LOCK_EXCLUSIVE, THREAD_OWNER, VACUUM_WRITER_WAIT_MS) == 0) {
+            // beginWrite takes the writer slot again, endWrite gives back both
+            return beginWrite(db, 0, LOCK_SHARED);
+        }
+        releaseLock(db->locks, table_id, LOCK_EXCLUSIVE, THREAD_OWNER);
+
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        if ((long)(now.tv_sec - start.tv_sec) * 1000 + (now.tv_nsec - start.tv_nsec) / 1000000 >= LOCK_TIMEOUT_MS) {
+            break;
+        }
+        struct timespec pause = {0, VACUUM_WRITER_WAIT_MS * 1000000L};
+        nanosleep(&pause, NULL);
+    }
+    return -1;
+}
+
+int magbaseVacuum(MagbaseDb *db, uint16_t table_id, uint64_t *removed) {
+    if (!db || !removed || table_id == 0 || beginVacuum(db, table_id) != 0) {
+        return -1;
+    }
+
+    int result = vacuumTable(db->db, table_id, removed);
+    uint64_t commit_lsn = 0;
+    if (result == 0 && finishWrite(db, &commit_lsn) != 0) {
+        result = abortWrite(db);
+    }
+    endWrite(db, LOCK_SHARED);
+    return result == 0 ? awaitWrite(db, commit_lsn) : -1;
+}
+
+MagbaseCursor *magbaseOpenCursor(MagbaseDb *db, uint16_t table_id, const char *const *where, int where_count) {
+    if (!db || table_id == 0 || where_count < 0 || (where_count > 0 && !where)) {
+        return NULL;
+    }
+    MagbaseCursor *cursor = calloc(1, sizeof(MagbaseCursor));
+    if (!cursor) {
+        return NULL;
+    }
+    cursor->owner = db;
+    cursor->table_id = table_id;
+
+    // The cursor keeps its table from being written until it is closed. A transaction that
+    // holds the table exclusively already keeps other writers out
+    if (!holdsLock(db->locks, table_id, LOCK_EXCLUSIVE, THREAD_OWNER)) {
+        if (acquireLockFor(db->locks, table_id, LOCK_SHARED, cursor, THREAD_OWNER) != 0) {
+            free(cursor);
+            return NULL;
+        }
+        cursor->locked = true;
+    }
+    if (beginRead(db, 0) != 0) {
+        magbaseCloseCursor(cursor);
+        return NULL;
+    }
+    // Taken after the catalog like every file lock, the read already holds it so it never waits
+    if (lockFileReader(db->db) != 0) {
+        endRead(db, 0);
+        magbaseCloseCursor(cursor);
+        return NULL;
+    }
+    cursor->file_locked = true;
+
+    TableSchemaRecord *schema = getTableSchema(db->db, table_id);
+    int status = schema ? 0 : -1;
+    for (int i = 0; i < where_count && status == 0; i++) {
+        status = parsePredicate(schema, where[i], &cursor->filter);
+    }
+    if (status == 0) {
+        cursor->record = createRecord(table_id, schema->column_count);
+        cursor->scan = openFilteredScan(db->db, table_id, &cursor->filter);
+    }
+    endRead(db, 0);
+
+    db->open_cursors++;
+    if (!cursor->record || !cursor->scan) {
+        magbaseCloseCursor(cursor);
+        return NULL;
+    }
+    return cursor;
+}
+
+int magbaseNext(MagbaseCursor *cursor, uint64_t *record_id, MagbaseValue *values, uint16_t value_count) {
+    if (!cursor || !values || value_count < cursor->scan->schema->column_count) {
+        return -1;
+    }
+
+    // The table lock of the cursor covers its pages, the catalog is not needed
+    BufferPool *pool = cursor->owner->db->buffer_pool;
+    if (enterBufferPool(pool, POOL_READ) != 0) {
+        return -1;
+    }
+    int result = nextRecord(cursor->scan, cursor->record);
+    leaveBufferPool(pool);
+    if (result != 1) {
+        return result;
+    }
+    if (record_id) {
+        *record_id = cursor->record->record_id;
+    }
+    valuesFromRecord(cursor->scan->schema, cursor->record, values);
+    return 1;
+}
+
+void magbaseCloseCursor(MagbaseCursor *cursor) {
+    if (!cursor) {
+        return;
+    }
+    if (cursor->file_locked) {
+        unlockFileReader(cursor->owner->db);
+    }
+    if (cursor->locked) {
+        releaseLock(cursor->owner->locks, cursor->table_id, LOCK_SHARED, cursor);
+    }
+    if (cursor->record || cursor->scan) {
+        cursor->owner->open_cursors--;
+    }
+    closeRecordScan(cursor->scan);
+    freeRecord(cursor->record);
+    free(cursor);
+}
@@ -0,0 +1,165 @@
+//     Keagan Anderson
+//        MagBase
+//       10/19/2026
+//
+//     libmagbase, the public C API for using MagBase in process. This is the only header a
+//     program linking the library includes. A struct or signature here only changes along with
+//     the SOVERSION of libmagbase.so, 2 since MagbaseOptions gained page_size
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(__GNUC__)
+#define MAGBASE_API __attribute__((visibility("default")))
+#else
+#define MAGBASE_API
+#endif
+
+#define MAGBASE_MAX_COLUMNS 16     // Columns a table may have
+#define MAGBASE_MAX_NAME 32        // Bytes of a table or column name, with the terminator
+#define MAGBASE_MAX_TEXT 256       // Bytes of a text value, with the terminator
+
+typedef struct MagbaseDb MagbaseDb;
+typedef struct MagbaseCursor MagbaseCursor;
+
+typedef enum { MAGBASE_INT, MAGBASE_TEXT, MAGBASE_BOOL } MagbaseType;
+
+// How hard a commit works to survive a power loss, see magbaseSetSyncMode
+typedef enum { MAGBASE_SYNC_OFF, MAGBASE_SYNC_NORMAL, MAGBASE_SYNC_FULL, MAGBASE_SYNC_FULL_DIR } MagbaseSyncMode;
+
+typedef struct {
+    bool create_if_missing;   // Create an empty database when the file does not exist
+    uint32_t page_size;       // Page size of a database it creates, a power of two from 4096 to 65536, 0 for 4096
+} MagbaseOptions;
+
+typedef struct {
+    const char *name;
+    uint8_t type;             // MagbaseType
+    bool nullable;
+} MagbaseColumn;
+
+// One column value of a row. Text read back from the database points into memory the library
+// owns, see magbaseRead and magbaseNext for how long it stays valid
+typedef struct {
+    uint8_t type;             // MagbaseType, must match the column unless is_null is set
+    bool is_null;
+    union {
+        int32_t int_val;
+        const char *text_val;
+        bool bool_val;
+    } value;
+} MagbaseValue;
+
+typedef struct {
+    uint16_t table_id;
+    char name[MAGBASE_MAX_NAME];
+    uint16_t column_count;
+    MagbaseColumn columns[MAGBASE_MAX_COLUMNS]; // Names point into the database, valid until it is closed
+    uint64_t row_count;
+    uint64_t page_count;
+} MagbaseTableStats;
+
+// Returns the library version as "major.minor.patch"
+MAGBASE_API const char *magbaseVersion(void);
+
+// Open a database, ".mab" is added to path when it does not end in it. options may be NULL
+// A handle may be shared by threads: reads run at once and writes wait for each other, in files
+// older than 1.4 also for the readers of their table. A lock not granted within 5 seconds fails
+// the call
+// Returns NULL if the file cannot be opened or created
+MAGBASE_API MagbaseDb *magbaseOpen(const char *path, const MagbaseOptions *options);
+
+// Close a database, a transaction still open is rolled back and every open cursor must be
+// closed first
+// Returns 0 on success, -1 on error
+MAGBASE_API int magbaseClose(MagbaseDb *db);
+
+// Choose the sync mode, right after magbaseOpen. FULL (the default) syncs the log before a
+// commit returns, threads committing at once share a sync. NORMAL only syncs it before pages reach the file and at checkpoints, a power loss may
+// lose the newest commits but never leaves half of one. OFF never syncs. FULL_DIR is FULL that
+// also syncs the directory when the file grows
+// Returns 0 on success, -1 on error
+MAGBASE_API int magbaseSetSyncMode(MagbaseDb *db, MagbaseSyncMode mode);
+
+// Outside a transaction every write commits on its own. Between begin and commit writes are
+// only saved by the commit, rollback drops them. A write that fails rolls back the transaction
+// A transaction belongs to the thread that began it and holds the tables it wrote until it
+// ends. Transactions need a 1.2 file, older files are written in place
+// Returns 0 on success, -1 on error
+MAGBASE_API int magbaseBegin(MagbaseDb *db);
+MAGBASE_API int magbaseCommit(MagbaseDb *db);
+MAGBASE_API int magbaseRollback(MagbaseDb *db);
+
+// Create a table
+// Returns the new table id, or -1 on error
+MAGBASE_API int magbaseCreateTable(MagbaseDb *db, const char *name, const MagbaseColumn *columns,
+                                   uint16_t column_count);
+
+// Drop a table
+// Returns 0 on success, -1 on error
+MAGBASE_API int magbaseDropTable(MagbaseDb *db, uint16_t table_id);
+
+// Returns the id of the table called name, or -1 if there is none
+MAGBASE_API int magbaseFindTable(MagbaseDb *db, const char *name);
+
+// Fill stats with the schema and size of a table
+// Returns 0 on success, -1 if the table does not exist
+MAGBASE_API int magbaseTableStats(MagbaseDb *db, uint16_t table_id, MagbaseTableStats *stats);
+
+// Insert a row, values holds one value per column
+// Returns the new record id, or 0 on error
+MAGBASE_API uint64_t magbaseInsert(MagbaseDb *db, uint16_t table_id, const MagbaseValue *values,
+                                   uint16_t value_count);
+
+// Read a row into values, which must hold one value per column. Text values stay valid until
+// the next magbaseRead of the calling thread
+// Returns 0 on success, -1 if the record does not exist
+MAGBASE_API int magbaseRead(MagbaseDb *db, uint16_t table_id, uint64_t record_id, MagbaseValue *values,
+                            uint16_t value_count);
+
+// Replace every value of a row. In a 1.4 file the new values are a new version of the row, kept
+// in the page of the old one when compacting it makes room, and readers see the old one until
+// the write commits. In older files a row is rewritten in place and may only grow into the free
+// space of its page
+// Returns 0 on success, -1 if the record does not exist, the new values do not fit or on error
+MAGBASE_API int magbaseUpdate(MagbaseDb *db, uint16_t table_id, uint64_t record_id,
+                              const MagbaseValue *values, uint16_t value_count);
+
+// Delete a row
+// Returns 0 on success, -1 if the record does not exist or on error
+MAGBASE_API int magbaseDelete(MagbaseDb *db, uint16_t table_id, uint64_t record_id);
+
+// Remove the row versions updates and deletes left behind in a 1.4 file and set removed to their
+// number. The file does not shrink, later inserts of the table fill the space before it grows
+// It waits for the readers and open cursors of the table to leave without keeping other writers
+// waiting, reads that start meanwhile wait for it unless their thread has a cursor of the table
+// open. A no-op for older files
+// Returns 0 on success, -1 on error
+MAGBASE_API int magbaseVacuum(MagbaseDb *db, uint16_t table_id, uint64_t *removed);
+
+// Open a cursor over the rows of a table matching every "col<op>value" in where (ops: = != <
+// <= > >=, NULL with = or != tests for NULL). where may be NULL when where_count is 0
+// In a 1.4 file the cursor reads the rows committed when it opened and writes go on meanwhile,
+// only vacuum waits for it. In older files writes to the table wait until it is closed
+// A cursor is used by one thread at a time
+// Returns NULL if the table does not exist or a condition does not parse
+MAGBASE_API MagbaseCursor *magbaseOpenCursor(MagbaseDb *db, uint16_t table_id, const char *const *where,
+                                             int where_count);
+
+// Read the next row of a cursor, record_id may be NULL. Text values stay valid until the next
+// call on the cursor
+// Returns 1 if a row was read, 0 at the end, -1 on error
+MAGBASE_API int magbaseNext(MagbaseCursor *cursor, uint64_t *record_id, MagbaseValue *values,
+                            uint16_t value_count);
+
+MAGBASE_API void magbaseCloseCursor(MagbaseCursor *cursor);
+
+#ifdef __cplusplus
+}
+#endif
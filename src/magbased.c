@@ -0,0 +1,47 @@
+//     Keagan Anderson
+//        MagBase
+//       10/19/2026
+//
+//     magbased, serves one database to local clients until SIGINT or SIGTERM
+//     Usage: magbased <db_path> [-socket path] [-threads n] [-sync mode]
+
+#include "db-init.h"
+#include "protocol.h"
+#include "server.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int main(int argc, char *argv[]) {
+    if (argc < 2 || argv[1][0] == '-') {
+        fprintf(stderr, "Usage: magbased <db_path> [-socket path] [-threads n] [-sync off|normal|full|full+dir]\n");
+        return 1;
+    }
+
+    const char *db_path = argv[1];
+    char socket_path[256];
+    if (defaultSocketPath(db_path, socket_path, sizeof(socket_path)) != 0) {
+        fprintf(stderr, "Database path is too long\n");
+        return 1;
+    }
+    uint32_t threads = 0;
+    SyncMode sync_mode = SYNC_FULL;
+
+    for (int i = 2; i < argc; i++) {
+        if (!strcmp(argv[i], "-socket") && i + 1 < argc) {
+            snprintf(socket_path, sizeof(socket_path), "%s", argv[++i]);
+        } else if (!strcmp(argv[i], "-threads") && i + 1 < argc) {
+            threads = (uint32_t)atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-sync") && i + 1 < argc) {
+            if (parseSyncMode(argv[++i], &sync_mode) != 0) {
+                fprintf(stderr, "Unknown sync mode: %s\n", argv[i]);
+                return 1;
+            }
+        } else {
+            fprintf(stderr, "Unknown option: %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    return runServer(db_path, socket_path, threads, (MagbaseSyncMode)sync_mode) == 0 ? 0 : 1;
+}
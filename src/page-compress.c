@@ -0,0 +1,234 @@
+//     Keagan Anderson
+//        MagBase
+//       10/19/2026
+//
+//     Page compression (see page-compress.h). The LZ77 data is a run of sequences, each a token
+//     byte (literal count in the high 4 bits, match length - LZ_MIN_MATCH in the low 4), extra
+//     length bytes when a field is 15, the literals, the match offset as a uint16 and extra
+//     match length bytes. The last sequence stops after its literals
+
+#define _GNU_SOURCE // fallocate
+
+#include "page-compress.h"
+#include "checksum.h"
+#include "globals.h"
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define LZ_MIN_MATCH 4
+#define LZ_MAX_OFFSET 65535
+#define LZ_HASH_BITS 12 // Positions the compressor remembers, by a hash of their next 4 bytes
+
+static uint32_t lzHash(const uint8_t *ptr) {
+    uint32_t value;
+    memcpy(&value, ptr, sizeof(value));
+    return (value * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+// Write what is left of a length after its 4 bit field, 255 per byte until a smaller byte ends it
+// Returns the position after it, NULL if it does not fit
+static uint8_t *putLength(uint8_t *ptr, const uint8_t *end, size_t length) {
+    while (length >= 255) {
+        if (ptr == end) {
+            return NULL;
+        }
+        *ptr++ = 255;
+        length -= 255;
+    }
+    if (ptr == end) {
+        return NULL;
+    }
+    *ptr++ = (uint8_t)length;
+    return ptr;
+}
+
+// Returns 0 and adds the extra length bytes to *length, -1 if the data ends first
+static int getLength(const uint8_t **ptr, const uint8_t *end, size_t *length) {
+    uint8_t byte;
+    do {
+        if (*ptr == end) {
+            return -1;
+        }
+        byte = *(*ptr)++;
+        *length += byte;
+    } while (byte == 255);
+    return 0;
+}
+
+// Write one sequence, match is 0 for the last one
+// Returns the position after it, NULL if it does not fit
+static uint8_t *putSequence(uint8_t *ptr, const uint8_t *end, const uint8_t *literals, size_t literal_count,
+                            size_t offset, size_t match) {
+    if (ptr == end) {
+        return NULL;
+    }
+    size_t match_code = match > 0 ? match - LZ_MIN_MATCH : 0;
+    uint8_t *token = ptr++;
+    *token = (uint8_t)((literal_count < 15 ? literal_count : 15) << 4 | (match_code < 15 ? match_code : 15));
+
+    if (literal_count >= 15 && !(ptr = putLength(ptr, end, literal_count - 15))) {
+        return NULL;
+    }
+    if ((size_t)(end - ptr) < literal_count) {
+        return NULL;
+    }
+    memcpy(ptr, literals, literal_count);
+    ptr += literal_count;
+    if (match == 0) {
+        return ptr;
+    }
+
+    if (end - ptr < 2) {
+        return NULL;
+    }
+    *ptr++ = (uint8_t)offset;
+    *ptr++ = (uint8_t)(offset >> 8);
+    if (match_code >= 15) {
+        ptr = putLength(ptr, end, match_code - 15);
+    }
+    return ptr;
+}
+
+size_t lzCompress(const uint8_t *in, size_t length, uint8_t *out, size_t capacity) {
+    uint32_t positions[1 << LZ_HASH_BITS];
+    memset(positions, 0, sizeof(positions));
+    uint8_t *ptr = out;
+    const uint8_t *end = out + capacity;
+
+    // Greedy: the first earlier position with the same 4 bytes is taken and extended
+    size_t anchor = 0;
+    size_t pos = 0;
+    while (pos + LZ_MIN_MATCH <= length) {
+        uint32_t hash = lzHash(in + pos);
+        size_t candidate = positions[hash];
+        positions[hash] = (uint32_t)pos;
+        if (candidate >= pos || pos - candidate > LZ_MAX_OFFSET || memcmp(in + candidate, in + pos, LZ_MIN_MATCH) != 0) {
+            pos++;
+            continue;
+        }
+
+        size_t match = LZ_MIN_MATCH;
+        while (pos + match < length && in[candidate + match] == in[pos + match]) {
+            match++;
+        }
+        if (!(ptr = putSequence(ptr, end, in + anchor, pos - anchor, pos - candidate, match))) {
+            return 0;
+        }
+        pos += match;
+        anchor = pos;
+    }
+
+    if (!(ptr = putSequence(ptr, end, in + anchor, length - anchor, 0, 0))) {
+        return 0;
+    }
+    return (size_t)(ptr - out);
+}
+
+size_t lzDecompress(const uint8_t *in, size_t length, uint8_t *out, size_t capacity) {
+    const uint8_t *ptr = in;
+    const uint8_t *end = in + length;
+    uint8_t *write = out;
+    const uint8_t *write_end = out + capacity;
+
+    while (ptr < end) {
+        uint8_t token = *ptr++;
+        size_t literal_count = token >> 4;
+        if (literal_count == 15 && getLength(&ptr, end, &literal_count) != 0) {
+            return 0;
+        }
+        if (literal_count > (size_t)(end - ptr) || literal_count > (size_t)(write_end - write)) {
+            return 0;
+        }
+        memcpy(write, ptr, literal_count);
+        write += literal_count;
+        ptr += literal_count;
+        if (ptr == end) {
+            break;
+        }
+
+        if (end - ptr < 2) {
+            return 0;
+        }
+        size_t offset = (size_t)ptr[0] | (size_t)ptr[1] << 8;
+        ptr += 2;
+        size_t match = token & 15;
+        if (match == 15 && getLength(&ptr, end, &match) != 0) {
+            return 0;
+        }
+        match += LZ_MIN_MATCH;
+        if (offset == 0 || offset > (size_t)(write - out) || match > (size_t)(write_end - write)) {
+            return 0;
+        }
+
+        // A match may overlap the bytes it produces, a run of one byte has offset 1
+        const uint8_t *from = write - offset;
+        if (offset >= match) {
+            memcpy(write, from, match);
+            write += match;
+        } else {
+            for (size_t i = 0; i < match; i++) {
+                *write++ = from[i];
+            }
+        }
+    }
+    return (size_t)(write - out);
+}
+
+int storePage(int fd, size_t page_id, const char *page, size_t page_size, bool compress) {
+    off_t offset = (off_t)(page_id * page_size);
+    char *image = compress && page_size > COMPRESS_BLOCK_SIZE ? malloc(page_size) : NULL;
+
+    // Only an image that leaves a whole block of the slot unused saves anything on disk
+    size_t used = 0;
+    if (image) {
+        size_t capacity = page_size - COMPRESS_BLOCK_SIZE - sizeof(PageImageHeader);
+        size_t length = lzCompress((const uint8_t *)page, page_size, (uint8_t *)image + sizeof(PageImageHeader), capacity);
+        if (length > 0) {
+            PageImageHeader header = {PAGE_IMAGE_MAGIC, (uint32_t)length, 0, 0};
+            header.checksum = crc32c(0, image + sizeof(PageImageHeader), length);
+            memcpy(image, &header, sizeof(header));
+            used = sizeof(PageImageHeader) + length;
+        }
+    }
+
+    const char *data = used > 0 ? image : page;
+    size_t length = used > 0 ? used : page_size;
+    for (size_t done = 0; done < length;) {
+        ssize_t written = pwrite(fd, data + done, length - done, offset + (off_t)done);
+        if (written <= 0) {
+            free(image);
+            return -1;
+        }
+        done += (size_t)written;
+    }
+    free(image);
+
+    // Readers only look at the image, punching the rest out of the file is what saves the space.
+    // File systems without holes keep the old bytes there
+#ifdef FALLOC_FL_PUNCH_HOLE
+    if (used > 0) {
+        fallocate(fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, offset + (off_t)used, (off_t)(page_size - used));
+    }
+#endif
+    return 0;
+}
+
+int expandPage(char *page, size_t page_size) {
+    PageImageHeader header;
+    memcpy(&header, page, sizeof(header));
+    if (header.magic != PAGE_IMAGE_MAGIC || header.length > page_size - sizeof(PageImageHeader) ||
+        crc32c(0, page + sizeof(PageImageHeader), header.length) != header.checksum) {
+        return 0;
+    }
+
+    uint8_t *data = malloc(header.length);
+    if (!data) {
+        return -1;
+    }
+    memcpy(data, page + sizeof(PageImageHeader), header.length);
+    size_t expanded = lzDecompress(data, header.length, (uint8_t *)page, page_size);
+    free(data);
+    return expanded == page_size ? 1 : -1;
+}
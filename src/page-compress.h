@@ -0,0 +1,43 @@
+//     Keagan Anderson
+//        MagBase
+//       10/19/2026
+//
+//     Page compression: a small LZ77 codec and the compressed image a page of a compressed
+//     table is stored as. The image sits at the start of the page's slot in the file and the
+//     rest of the slot is punched out, so every page keeps its place at page_num * page_size
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define PAGE_IMAGE_MAGIC 0x5a4c474du // "MGLZ"
+
+// Leads a compressed page image, the LZ77 data follows
+typedef struct {
+    uint32_t magic;           // PAGE_IMAGE_MAGIC
+    uint32_t length;          // Bytes of LZ77 data
+    uint32_t checksum;        // CRC32C of the LZ77 data, tells an image from a page that starts alike
+    uint32_t reserved;
+} PageImageHeader;
+
+// Compress length bytes of in into out, which holds capacity bytes. Matches are at most 65535
+// bytes back, inputs up to MAX_PAGE_SIZE find every one
+// Returns the compressed size, 0 if it does not fit in capacity
+size_t lzCompress(const uint8_t *in, size_t length, uint8_t *out, size_t capacity);
+
+// Decompress length bytes of lzCompress output into out, which holds capacity bytes
+// Returns the decompressed size, 0 if the data is malformed or does not fit
+size_t lzDecompress(const uint8_t *in, size_t length, uint8_t *out, size_t capacity);
+
+// Write a page, sealed already, to its slot in the file. With compress it is stored as a
+// compressed image when that frees at least COMPRESS_BLOCK_SIZE bytes of the slot
+// Returns 0 on success, -1 on error
+int storePage(int fd, size_t page_id, const char *page, size_t page_size, bool compress);
+
+// Turn the slot of a page as read from the file back into the page, in place. Bytes past the
+// end of the file must read as zeros
+// Returns 1 if it held a compressed image, 0 if the page was stored as is, -1 if the image is
+// damaged or memory runs out
+int expandPage(char *page, size_t page_size);
@@ -0,0 +1,267 @@
+//     Keagan Anderson
+//        MagBase
+//       10/19/2026
+//
+//     Per table page directories: the data pages of a table as a list of extents, so
+//     page N can be found without walking the next_page chain
+
+#include "page-directory.h"
+#include "buffer.h"
+#include "schema.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define EXTENTS_PER_PAGE(db) (((db)->usable_page_size - sizeof(DirectoryPageHeader)) / sizeof(PageExtent))
+
+static PageExtent *pageExtents(char *page_buffer) {
+    return (PageExtent *)(page_buffer + sizeof(DirectoryPageHeader));
+}
+
+// Allocate and clear a directory page
+static uint64_t newDirectoryPage(MagBase *db) {
+    uint64_t page_num = db->header->page_count++;
+    char *page_buffer = readPageFromBuffer(db->buffer_pool, page_num, db->file_pointer, db->page_size);
+    if (!page_buffer) {
+        return 0;
+    }
+
+    memset(page_buffer, 0, db->usable_page_size);
+    ((DirectoryPageHeader *)page_buffer)->last_directory_page = page_num;
+    markPageDirty(db->buffer_pool, page_num);
+    return page_num;
+}
+
+int appendTablePage(MagBase *db, TableSchemaRecord *schema, uint64_t page_num) {
+    if (!db || !schema || page_num == 0) {
+        return -1;
+    }
+    if (!hasPageDirectories(db)) {
+        return 0;
+    }
+
+    if (schema->directory_page == 0) {
+        uint64_t first = newDirectoryPage(db);
+        if (first == 0) {
+            return -1;
+        }
+        schema->directory_page = (uint32_t)first;
+    }
+
+    // The page pointers are not held across reads, the pool may evict them
+    char *page_buffer = readPageFromBuffer(db->buffer_pool, schema->directory_page, db->file_pointer, db->page_size);
+    if (!page_buffer) {
+        return -1;
+    }
+    DirectoryPageHeader *first_header = (DirectoryPageHeader *)page_buffer;
+    first_header->total_pages++;
+    uint64_t tail = first_header->last_directory_page;
+    markPageDirty(db->buffer_pool, schema->directory_page);
+
+    page_buffer = readPageFromBuffer(db->buffer_pool, tail, db->file_pointer, db->page_size);
+    if (!page_buffer) {
+        return -1;
+    }
+    DirectoryPageHeader *tail_header = (DirectoryPageHeader *)page_buffer;
+    PageExtent *extents = pageExtents(page_buffer);
+
+    // Pages allocated back to back grow the last extent
+    if (tail_header->extent_count > 0) {
+        PageExtent *last = &extents[tail_header->extent_count - 1];
+        if (last->first_page + last->page_count == page_num) {
+            last->page_count++;
+            markPageDirty(db->buffer_pool, tail);
+            return 0;
+        }
+    }
+
+    if (tail_header->extent_count < EXTENTS_PER_PAGE(db)) {
+        extents[tail_header->extent_count].first_page = page_num;
+        extents[tail_header->extent_count].page_count = 1;
+        tail_header->extent_count++;
+        markPageDirty(db->buffer_pool, tail);
+        return 0;
+    }
+
+    // Tail is full, chain a new directory page
+    uint64_t new_tail = newDirectoryPage(db);
+    if (new_tail == 0) {
+        return -1;
+    }
+    page_buffer = readPageFromBuffer(db->buffer_pool, new_tail, db->file_pointer, db->page_size);
+    if (!page_buffer) {
+        return -1;
+    }
+    pageExtents(page_buffer)[0].first_page = page_num;
+    pageExtents(page_buffer)[0].page_count = 1;
+    ((DirectoryPageHeader *)page_buffer)->extent_count = 1;
+    markPageDirty(db->buffer_pool, new_tail);
+
+    page_buffer = readPageFromBuffer(db->buffer_pool, tail, db->file_pointer, db->page_size);
+    if (!page_buffer) {
+        return -1;
+    }
+    ((DirectoryPageHeader *)page_buffer)->next_directory_page = new_tail;
+    markPageDirty(db->buffer_pool, tail);
+
+    page_buffer = readPageFromBuffer(db->buffer_pool, schema->directory_page, db->file_pointer, db->page_size);
+    if (!page_buffer) {
+        return -1;
+    }
+    ((DirectoryPageHeader *)page_buffer)->last_directory_page = new_tail;
+    markPageDirty(db->buffer_pool, schema->directory_page);
+    return 0;
+}
+
+// Files without a directory, follow next_page
+static int walkTableChain(MagBase *db, TableSchemaRecord *schema, uint64_t **pages, uint64_t *page_count) {
+    size_t capacity = 0;
+    uint64_t page_num = schema->root_page;
+
+    while (page_num != 0) {
+        char *page_buffer = readPageFromBuffer(db->buffer_pool, page_num, db->file_pointer, db->page_size);
+        if (!page_buffer) {
+            return -1;
+        }
+
+        if (*page_count == capacity) {
+            capacity = capacity ? capacity * 2 : 64;
+            uint64_t *grown = realloc(*pages, capacity * sizeof(uint64_t));
+            if (!grown) {
+                return -1;
+            }
+            *pages = grown;
+        }
+        (*pages)[(*page_count)++] = page_num;
+        page_num = ((PageHeader *)page_buffer)->next_page;
+    }
+    return 0;
+}
+
+int readTablePages(MagBase *db, TableSchemaRecord *schema, uint64_t **pages, uint64_t *page_count) {
+    if (!db || !schema || !pages || !page_count) {
+        return -1;
+    }
+    *pages = NULL;
+    *page_count = 0;
+
+    if (schema->directory_page == 0) {
+        if (walkTableChain(db, schema, pages, page_count) != 0) {
+            free(*pages);
+            *pages = NULL;
+            *page_count = 0;
+            return -1;
+        }
+        return 0;
+    }
+
+    char *page_buffer = readPageFromBuffer(db->buffer_pool, schema->directory_page, db->file_pointer, db->page_size);
+    if (!page_buffer) {
+        return -1;
+    }
+    uint64_t total = ((DirectoryPageHeader *)page_buffer)->total_pages;
+    if (total == 0) {
+        return 0;
+    }
+
+    *pages = malloc(total * sizeof(uint64_t));
+    if (!*pages) {
+        return -1;
+    }
+
+    uint64_t directory_page = schema->directory_page;
+    while (directory_page != 0) {
+        page_buffer = readPageFromBuffer(db->buffer_pool, directory_page, db->file_pointer, db->page_size);
+        if (!page_buffer) {
+            free(*pages);
+            *pages = NULL;
+            *page_count = 0;
+            return -1;
+        }
+
+        DirectoryPageHeader *directory_header = (DirectoryPageHeader *)page_buffer;
+        PageExtent *extents = pageExtents(page_buffer);
+        for (uint16_t e = 0; e < directory_header->extent_count; e++) {
+            for (uint64_t p = 0; p < extents[e].page_count && *page_count < total; p++) {
+                (*pages)[(*page_count)++] = extents[e].first_page + p;
+            }
+        }
+        directory_page = directory_header->next_directory_page;
+    }
+    return 0;
+}
+
+uint64_t getTablePage(MagBase *db, TableSchemaRecord *schema, uint64_t index) {
+    if (!db || !schema) {
+        return 0;
+    }
+
+    // Without a directory the chain is the only way
+    if (schema->directory_page == 0) {
+        uint64_t page_num = schema->root_page;
+        for (uint64_t i = 0; page_num != 0 && i < index; i++) {
+            char *page_buffer = readPageFromBuffer(db->buffer_pool, page_num, db->file_pointer, db->page_size);
+            if (!page_buffer) {
+                return 0;
+            }
+            page_num = ((PageHeader *)page_buffer)->next_page;
+        }
+        return page_num;
+    }
+
+    uint64_t directory_page = schema->directory_page;
+    while (directory_page != 0) {
+        char *page_buffer = readPageFromBuffer(db->buffer_pool, directory_page, db->file_pointer, db->page_size);
+        if (!page_buffer) {
+            return 0;
+        }
+
+        DirectoryPageHeader *directory_header = (DirectoryPageHeader *)page_buffer;
+        PageExtent *extents = pageExtents(page_buffer);
+        for (uint16_t e = 0; e < directory_header->extent_count; e++) {
+            if (index < extents[e].page_count) {
+                return extents[e].first_page + index;
+            }
+            index -= extents[e].page_count;
+        }
+        directory_page = directory_header->next_directory_page;
+    }
+    return 0;
+}
+
+uint64_t lastTablePage(MagBase *db, TableSchemaRecord *schema) {
+    if (!db || !schema || schema->root_page == 0) {
+        return 0;
+    }
+
+    if (schema->directory_page != 0) {
+        char *page_buffer =
+            readPageFromBuffer(db->buffer_pool, schema->directory_page, db->file_pointer, db->page_size);
+        if (!page_buffer) {
+            return 0;
+        }
+        uint64_t tail = ((DirectoryPageHeader *)page_buffer)->last_directory_page;
+
+        page_buffer = readPageFromBuffer(db->buffer_pool, tail, db->file_pointer, db->page_size);
+        if (!page_buffer) {
+            return 0;
+        }
+        DirectoryPageHeader *tail_header = (DirectoryPageHeader *)page_buffer;
+        if (tail_header->extent_count > 0) {
+            PageExtent *last = &pageExtents(page_buffer)[tail_header->extent_count - 1];
+            return last->first_page + last->page_count - 1;
+        }
+    }
+
+    uint64_t page_num = schema->root_page;
+    while (1) {
+        char *page_buffer = readPageFromBuffer(db->buffer_pool, page_num, db->file_pointer, db->page_size);
+        if (!page_buffer) {
+            return 0;
+        }
+        uint64_t next_page = ((PageHeader *)page_buffer)->next_page;
+        if (next_page == 0) {
+            return page_num;
+        }
+        page_num = next_page;
+    }
+}
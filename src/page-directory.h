@@ -0,0 +1,44 @@
+//     Keagan Anderson
+//        MagBase
+//       10/19/2026
+//
+//     Per table page directories: the data pages of a table as a list of extents, so
+//     page N can be found without walking the next_page chain
+
+#pragma once
+
+#include "db-init.h"
+#include "structs/schemaStruct.h"
+#include <stdint.h>
+
+// Run of consecutive page numbers, in chain order
+typedef struct {
+    uint64_t first_page;
+    uint64_t page_count;
+} PageExtent;
+
+// Directory pages form a chain from TableSchemaRecord.directory_page, extents follow the header
+typedef struct {
+    uint16_t extent_count;              // Extents stored in this page
+    uint64_t next_directory_page;       // 0 on the last page
+    uint64_t last_directory_page;       // Tail of the chain, only kept on the first page
+    uint64_t total_pages;               // Pages of the table, only kept on the first page
+} DirectoryPageHeader;
+
+// Record a page just linked onto the end of the table's chain. Allocates the first directory
+// page and sets schema->directory_page if needed, the caller persists the schema
+// Returns 0 on success (or when the file has no directories), -1 on error
+int appendTablePage(MagBase *db, TableSchemaRecord *schema, uint64_t page_num);
+
+// Every data page of a table in chain order, from the directory or by walking the chain in
+// files without one. *pages is NULL for an empty table, otherwise the caller frees it
+// Returns 0 on success, -1 on error
+int readTablePages(MagBase *db, TableSchemaRecord *schema, uint64_t **pages, uint64_t *page_count);
+
+// Page number of the index'th page (from 0) of a table
+// Returns 0 if the table has fewer pages
+uint64_t getTablePage(MagBase *db, TableSchemaRecord *schema, uint64_t index);
+
+// Last page of a table, where inserts go
+// Returns 0 if the table has no pages
+uint64_t lastTablePage(MagBase *db, TableSchemaRecord *schema);
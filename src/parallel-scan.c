@@ -0,0 +1,302 @@
+//     Keagan Anderson
+//        MagBase
+//       10/19/2026
+//
+//     Parallel table scans: pages are split into morsels, run on a thread pool and
+//     the per thread counts and aggregates are merged at the end
+
+#include "parallel-scan.h"
+#include "buffer.h"
+#include "filter.h"
+#include "globals.h"
+#include "page-directory.h"
+#include "schema.h"
+#include "zone-map.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *aggregate_names[] = {"count", "sum", "min", "max", "avg"};
+
+// Private state of one worker, merged into the result once the scan is done
+typedef struct {
+    char *page;                         // Private copy of the page being decoded
+    Record *record;
+    uint64_t rows_scanned;
+    uint64_t rows_matched;
+    uint64_t pages_scanned;
+    int failed;
+    AggregateState states[MAX_AGGREGATES];
+} ScanWorker;
+
+// Shared, read only while the workers run
+typedef struct {
+    MagBase *db;
+    int fd;
+    uint16_t field_count;
+    const RowCodec *codec;
+    const Filter *filter;               // Bound to the table's dictionaries, NULL for every row
+    const AggregateSpec *spec;
+    Snapshot snapshot;                  // Taken by the calling thread, the workers see what it sees
+    uint64_t *pages;                    // Page numbers of the table in chain order, less those the
+                                        // zone map rules out
+    uint64_t page_count;
+    ScanWorker **workers;
+} ParallelScan;
+
+int parseAggregates(TableSchemaRecord *schema, const char *text, AggregateSpec *spec) {
+    if (!schema || !text || !spec) {
+        return -1;
+    }
+
+    char list[512];
+    strncpy(list, text, sizeof(list) - 1);
+    list[sizeof(list) - 1] = '\0';
+
+    char *save_list = NULL;
+    for (char *item = strtok_r(list, ",", &save_list); item; item = strtok_r(NULL, ",", &save_list)) {
+        char *save_item = NULL;
+        char *name = strtok_r(item, ":", &save_item);
+        char *column_name = strtok_r(NULL, ":", &save_item);
+
+        if (!name || spec->count >= MAX_AGGREGATES) {
+            return -1;
+        }
+
+        int op = -1;
+        for (int i = 0; i <= AGG_AVG; i++) {
+            if (!strcmp(name, aggregate_names[i])) {
+                op = i;
+            }
+        }
+        if (op < 0) {
+            fprintf(stderr, "Unknown aggregate: %s (use count, sum, min, max or avg)\n", name);
+            return -1;
+        }
+
+        int column = AGGREGATE_ALL_ROWS;
+        if (column_name) {
+            column = findColumn(schema, column_name);
+            if (column < 0) {
+                fprintf(stderr, "Unknown column in aggregate: %s\n", column_name);
+                return -1;
+            }
+        } else if (op != AGG_COUNT) {
+            fprintf(stderr, "%s needs a column, e.g. %s:price\n", name, name);
+            return -1;
+        }
+
+        if ((op == AGG_SUM || op == AGG_AVG) && schema->columns[column].type != COL_INT) {
+            fprintf(stderr, "%s needs an int column\n", name);
+            return -1;
+        }
+
+        spec->aggregates[spec->count].op = (uint8_t)op;
+        spec->aggregates[spec->count].column = (uint16_t)column;
+        spec->count++;
+    }
+
+    return spec->count > 0 ? 0 : -1;
+}
+
+void formatAggregate(TableSchemaRecord *schema, const Aggregate *aggregate, char *out, size_t out_size) {
+    if (aggregate->column == AGGREGATE_ALL_ROWS) {
+        snprintf(out, out_size, "%s(*)", aggregate_names[aggregate->op]);
+    } else {
+        snprintf(out, out_size, "%s(%s)", aggregate_names[aggregate->op], schema->columns[aggregate->column].name);
+    }
+}
+
+// Fold one value into a running aggregate
+static void accumulate(AggregateState *state, const Aggregate *aggregate, RecordField *field) {
+    if (!field) {
+        state->count++;
+        return;
+    }
+    if (field->is_null) {
+        return;
+    }
+
+    switch (aggregate->op) {
+        case AGG_SUM:
+        case AGG_AVG:
+            state->sum += field->value.int_val;
+            break;
+        case AGG_MIN:
+            if (state->count == 0 || compareFields(field, &state->min) < 0) {
+                state->min = *field;
+            }
+            break;
+        case AGG_MAX:
+            if (state->count == 0 || compareFields(field, &state->max) > 0) {
+                state->max = *field;
+            }
+            break;
+    }
+    state->count++;
+}
+
+// Combine a worker's partial aggregate into the total
+static void mergeAggregate(AggregateState *total, const AggregateState *part, const Aggregate *aggregate) {
+    if (part->count == 0) {
+        return;
+    }
+
+    if (aggregate->op == AGG_MIN && (total->count == 0 || compareFields((RecordField *)&part->min, &total->min) < 0)) {
+        total->min = part->min;
+    }
+    if (aggregate->op == AGG_MAX && (total->count == 0 || compareFields((RecordField *)&part->max, &total->max) > 0)) {
+        total->max = part->max;
+    }
+    total->count += part->count;
+    total->sum += part->sum;
+}
+
+static void scanMorsel(void *context, uint32_t worker_index, uint64_t morsel) {
+    ParallelScan *scan = context;
+    ScanWorker *worker = scan->workers[worker_index];
+    if (worker->failed) {
+        return;
+    }
+
+    uint64_t first = morsel * SCAN_MORSEL_PAGES;
+    uint64_t last = first + SCAN_MORSEL_PAGES < scan->page_count ? first + SCAN_MORSEL_PAGES : scan->page_count;
+    Record *record = worker->record;
+
+    // Ask the kernel for the whole morsel now, the reads below then hit the page cache
+    prefetchPages(scan->fd, &scan->pages[first], last - first, scan->db->page_size);
+
+    for (uint64_t p = first; p < last; p++) {
+        if (copyPageFromBuffer(scan->db->buffer_pool, scan->pages[p], scan->fd, scan->db->page_size, worker->page,
+                               scan->db->page_size) != 0) {
+            worker->failed = 1;
+            return;
+        }
+        worker->pages_scanned++;
+
+        PageHeader *page_header = (PageHeader *)worker->page;
+        uint16_t offset = sizeof(PageHeader);
+        for (uint16_t slot = 0; slot < page_header->slot_count; slot++) {
+            uint8_t *row = (uint8_t *)worker->page + offset;
+            record->field_count = scan->field_count;
+            if (!rowVisible(scan->db, &scan->snapshot, row)) {
+                offset += (uint16_t)skipRow(scan->db, scan->codec, row, record);
+                continue;
+            }
+            worker->rows_scanned++;
+
+            // Encoded rows are filtered before they are decoded
+            if (scan->filter && scan->db->compact_rows &&
+                !rowMatchesFilter(scan->filter, scan->codec, row + scan->db->version_size)) {
+                offset += (uint16_t)skipRow(scan->db, scan->codec, row, record);
+                continue;
+            }
+            offset += (uint16_t)deserializeRow(scan->db, scan->codec, row, record);
+
+            if (scan->filter && !scan->db->compact_rows && !recordMatchesFilter(scan->filter, record)) {
+                continue;
+            }
+            worker->rows_matched++;
+
+            for (uint16_t a = 0; scan->spec && a < scan->spec->count; a++) {
+                const Aggregate *aggregate = &scan->spec->aggregates[a];
+                RecordField *field =
+                    aggregate->column == AGGREGATE_ALL_ROWS ? NULL : &record->fields[aggregate->column];
+                accumulate(&worker->states[a], aggregate, field);
+            }
+        }
+    }
+}
+
+int parallelScan(MagBase *db, uint16_t table_id, const Filter *filter, const AggregateSpec *spec,
+                 ThreadPool *pool, ScanResult *result) {
+    if (!db || !pool || !result) {
+        return -1;
+    }
+
+    TableSchemaRecord *schema = readTableSchema(db, table_id);
+    if (!schema) {
+        return -1;
+    }
+
+    memset(result, 0, sizeof(ScanResult));
+    result->threads = pool->thread_count;
+
+    ParallelScan scan;
+    memset(&scan, 0, sizeof(ParallelScan));
+    scan.db = db;
+    scan.fd = fileno(db->file_pointer);
+    scan.field_count = schema->column_count;
+    scan.codec = getRowCodec(db, table_id);
+    scan.spec = spec && spec->count > 0 ? spec : NULL;
+    scan.snapshot = takeSnapshot(db);
+    Filter bound;
+    if (filter && filter->count > 0) {
+        bound = *filter;
+        bindFilterCodes(&bound, scan.codec);
+        scan.filter = &bound;
+    }
+    scan.workers = calloc(pool->thread_count, sizeof(ScanWorker *));
+
+    // The directory gives every page up front, so morsels can be cut before any data page is read
+    int status = readTablePages(db, schema, &scan.pages, &scan.page_count) == 0 && scan.workers && scan.codec ? 0 : -1;
+
+    // Pages the zone map rules out are never handed to a worker
+    int64_t removed = 0;
+    if (status == 0 && scan.filter) {
+        removed = pruneTablePages(db, schema, scan.filter, scan.pages, &scan.page_count);
+    }
+    if (removed < 0) {
+        status = -1;
+    } else {
+        result->pages_skipped = (uint64_t)removed;
+    }
+
+    // Workers read the file with pread, pages written back by the reads above must land first
+    fflush(db->file_pointer);
+    for (uint32_t w = 0; status == 0 && w < pool->thread_count; w++) {
+        // Separate allocations keep the hot counters of different workers off the same cache line
+        ScanWorker *worker = calloc(1, sizeof(ScanWorker));
+        scan.workers[w] = worker;
+        if (!worker) {
+            status = -1;
+            break;
+        }
+        worker->page = malloc(db->page_size);
+        worker->record = createRecord(table_id, schema->column_count);
+        if (!worker->page || !worker->record) {
+            status = -1;
+        }
+    }
+
+    if (status == 0) {
+        result->morsels = (scan.page_count + SCAN_MORSEL_PAGES - 1) / SCAN_MORSEL_PAGES;
+        status = runMorsels(pool, result->morsels, scanMorsel, &scan, &result->steals);
+    }
+
+    for (uint32_t w = 0; scan.workers && w < pool->thread_count; w++) {
+        ScanWorker *worker = scan.workers[w];
+        if (!worker) {
+            continue;
+        }
+
+        if (worker->failed) {
+            status = -1;
+        }
+        result->rows_scanned += worker->rows_scanned;
+        result->rows_matched += worker->rows_matched;
+        result->pages_scanned += worker->pages_scanned;
+        for (uint16_t a = 0; scan.spec && a < scan.spec->count; a++) {
+            mergeAggregate(&result->states[a], &worker->states[a], &scan.spec->aggregates[a]);
+        }
+
+        free(worker->page);
+        freeRecord(worker->record);
+        free(worker);
+    }
+
+    free(scan.workers);
+    free(scan.pages);
+    free(schema);
+    return status;
+}
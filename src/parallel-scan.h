@@ -0,0 +1,66 @@
+//     Keagan Anderson
+//        MagBase
+//       10/19/2026
+//
+//     Parallel table scans: pages are split into morsels, run on a thread pool and
+//     the per thread counts and aggregates are merged at the end
+
+#pragma once
+
+#include "db-init.h"
+#include "records.h"
+#include "structs/schemaStruct.h"
+#include "thread-pool.h"
+#include <stdint.h>
+
+#define MAX_AGGREGATES 16
+
+// Column of a COUNT(*)
+#define AGGREGATE_ALL_ROWS UINT16_MAX
+
+typedef enum { AGG_COUNT, AGG_SUM, AGG_MIN, AGG_MAX, AGG_AVG } AggregateOp;
+
+typedef struct {
+    uint8_t op;                         // AggregateOp
+    uint16_t column;                    // AGGREGATE_ALL_ROWS for count(*)
+} Aggregate;
+
+typedef struct {
+    Aggregate aggregates[MAX_AGGREGATES];
+    uint16_t count;
+} AggregateSpec;
+
+// Running value of one aggregate, NULL values are skipped like in SQL
+typedef struct {
+    uint64_t count;                     // Rows (count(*)) or non NULL values seen
+    int64_t sum;
+    RecordField min;
+    RecordField max;
+} AggregateState;
+
+struct Filter;
+
+typedef struct {
+    uint64_t rows_scanned;
+    uint64_t rows_matched;
+    uint64_t pages_scanned;
+    uint64_t pages_skipped;             // Pages the zone map ruled out, never read
+    uint64_t morsels;
+    uint64_t steals;                    // Ranges of morsels moved between workers
+    uint32_t threads;
+    AggregateState states[MAX_AGGREGATES];
+} ScanResult;
+
+// Parse an aggregate list like "count,sum:price,max:name" against a schema and append it to spec
+// sum and avg need an int column, count:col counts the non NULL values of col
+// Returns 0 on success, -1 on an unknown function, column or a wrong column type
+int parseAggregates(TableSchemaRecord *schema, const char *text, AggregateSpec *spec);
+
+// Render an aggregate as "sum(price)" into out
+void formatAggregate(TableSchemaRecord *schema, const Aggregate *aggregate, char *out, size_t out_size);
+
+// Scan a table on every worker of pool, counting and aggregating the rows matching filter
+// (which may be NULL). spec may be NULL to only count
+// Returns 0 on success, -1 on error
+int parallelScan(MagBase *db, uint16_t table_id, const struct Filter *filter, const AggregateSpec *spec,
+                 ThreadPool *pool, ScanResult *result);
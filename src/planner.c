@@ -0,0 +1,428 @@
+//     Keagan Anderson
+//        MagBase
+//       10/19/2026
+//
+//     Cost based planning for -list-records, -join and -aggregate, printed by -explain
+
+#include "planner.h"
+#include "filter.h"
+#include "globals.h"
+#include "schema.h"
+#include "stats.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Cost units are sequential page reads
+#define SEQ_PAGE_COST 1.0
+#define CPU_TUPLE_COST 0.01               // Decoding and passing on one row
+#define CPU_OPERATOR_COST 0.0025          // One comparison or predicate
+#define SPILL_PAGE_COST 2.0               // Writing a temp page and reading it back
+#define HASH_BUILD_COST 0.02              // Copying a row into the hash table
+#define PARALLEL_SETUP_COST 10.0          // Waking the workers and merging their results
+
+// Used when a table was never analyzed
+#define DEFAULT_EQ_SELECTIVITY 0.005
+#define DEFAULT_RANGE_SELECTIVITY (1.0 / 3.0)
+#define DEFAULT_NULL_SELECTIVITY 0.005
+#define DEFAULT_DISTINCT 200.0
+#define DEFAULT_ROW_BYTES 64.0
+
+static const char *node_names[] = {"Seq Scan",  "Sort",      "External Sort", "Top-K Sort",      "Limit",
+                                    "Hash Join", "Grace Hash Join", "Aggregate", "Parallel Seq Scan"};
+
+// What the planner knows about one table
+typedef struct {
+    uint16_t table_id;
+    TableSchemaRecord *schema;
+    TableStats stats;
+    int has_stats;
+    double rows;
+    double pages;
+} TableInfo;
+
+static int loadTableInfo(MagBase *db, uint16_t table_id, TableInfo *info) {
+    memset(info, 0, sizeof(TableInfo));
+    info->table_id = table_id;
+    info->schema = readTableSchema(db, table_id);
+    if (!info->schema) {
+        return -1;
+    }
+
+    // Prefer the analyzed numbers, the page headers are the fallback
+    if (readTableStats(db, table_id, &info->stats) == 0) {
+        info->has_stats = 1;
+        info->rows = (double)info->stats.row_count;
+        info->pages = (double)info->stats.page_count;
+    } else {
+        uint64_t pages = 0;
+        info->rows = (double)countRecords(db, table_id, &pages);
+        info->pages = (double)pages;
+    }
+    return 0;
+}
+
+static double defaultSelectivity(const Predicate *predicate) {
+    if (predicate->value.is_null) {
+        return predicate->op == PRED_EQ ? DEFAULT_NULL_SELECTIVITY : 1.0 - DEFAULT_NULL_SELECTIVITY;
+    }
+    switch (predicate->op) {
+        case PRED_EQ:
+            return DEFAULT_EQ_SELECTIVITY;
+        case PRED_NE:
+            return 1.0 - DEFAULT_EQ_SELECTIVITY;
+        default:
+            return DEFAULT_RANGE_SELECTIVITY;
+    }
+}
+
+// Predicates are assumed independent
+static double filterSelectivity(TableInfo *info, const Filter *filter) {
+    double selectivity = 1.0;
+    if (!filter) {
+        return selectivity;
+    }
+
+    for (uint16_t p = 0; p < filter->count; p++) {
+        const Predicate *predicate = &filter->predicates[p];
+        selectivity *= info->has_stats ? estimatePredicateSelectivity(&info->stats, predicate)
+                                       : defaultSelectivity(predicate);
+    }
+    return selectivity;
+}
+
+// Distinct values of a column among the rows left after filtering
+static double estimateDistinct(TableInfo *info, uint16_t column, double filtered_rows) {
+    double distinct = DEFAULT_DISTINCT;
+    if (info->has_stats && column < info->stats.column_count) {
+        distinct = (double)info->stats.columns[column].distinct_count;
+    }
+    if (distinct > filtered_rows) {
+        distinct = filtered_rows;
+    }
+    return distinct < 1.0 ? 1.0 : distinct;
+}
+
+// Average on-disk bytes per row, to size spills
+static double averageRowBytes(TableInfo *info, MagBase *db) {
+    if (info->rows < 1.0 || info->pages < 1.0) {
+        return DEFAULT_ROW_BYTES;
+    }
+    return info->pages * (double)db->page_size / info->rows;
+}
+
+static PlanNode *newPlanNode(uint8_t type) {
+    PlanNode *node = calloc(1, sizeof(PlanNode));
+    if (node) {
+        node->type = type;
+    }
+    return node;
+}
+
+static PlanNode *planScan(TableInfo *info, const Filter *filter) {
+    PlanNode *node = newPlanNode(PLAN_SEQ_SCAN);
+    if (!node) {
+        return NULL;
+    }
+
+    node->table_id = info->table_id;
+    uint16_t predicate_count = filter ? filter->count : 0;
+    node->estimated_rows = info->rows * filterSelectivity(info, filter);
+    node->estimated_cost = info->pages * SEQ_PAGE_COST + info->rows * CPU_TUPLE_COST +
+                           info->rows * predicate_count * CPU_OPERATOR_COST;
+
+    size_t used = (size_t)snprintf(node->detail, sizeof(node->detail), "on %s", info->schema->table_name);
+    for (uint16_t p = 0; p < predicate_count && used < sizeof(node->detail); p++) {
+        char text[96];
+        formatPredicate(info->schema, &filter->predicates[p], text, sizeof(text));
+        used += (size_t)snprintf(node->detail + used, sizeof(node->detail) - used, "%s%s",
+                                 p == 0 ? "  Filter: " : " AND ", text);
+    }
+    if (!info->has_stats && used < sizeof(node->detail)) {
+        snprintf(node->detail + used, sizeof(node->detail) - used, "  (not analyzed)");
+    }
+    return node;
+}
+
+static double log2AtLeastOne(double x) {
+    return x > 2.0 ? log2(x) : 1.0;
+}
+
+PlanNode *planSelect(MagBase *db, uint16_t table_id, const SortSpec *spec) {
+    if (!db || !spec) {
+        return NULL;
+    }
+
+    TableInfo info;
+    if (loadTableInfo(db, table_id, &info) != 0) {
+        return NULL;
+    }
+
+    PlanNode *plan = planScan(&info, spec->filter);
+    if (!plan) {
+        free(info.schema);
+        return NULL;
+    }
+
+    if (spec->key_count > 0) {
+        double input_rows = plan->estimated_rows;
+        uint16_t field_count = info.schema->column_count;
+        PlanNode *sort;
+
+        if (sortUsesTopK(spec, field_count)) {
+            sort = newPlanNode(PLAN_TOP_K);
+            if (sort) {
+                double kept = (double)spec->limit < input_rows ? (double)spec->limit : input_rows;
+                sort->estimated_rows = kept;
+                sort->estimated_cost = plan->estimated_cost +
+                                       input_rows * log2AtLeastOne((double)spec->limit) * 2 * CPU_OPERATOR_COST;
+            }
+        } else {
+            double bytes = input_rows * (double)sortRowMemorySize(field_count);
+            double compare_cost = input_rows * log2AtLeastOne(input_rows) * 2 * CPU_OPERATOR_COST;
+
+            if (bytes <= (double)spec->memory_budget) {
+                sort = newPlanNode(PLAN_SORT);
+                if (sort) {
+                    sort->estimated_cost = plan->estimated_cost + compare_cost;
+                }
+            } else {
+                // Every pass writes and rereads the whole input
+                sort = newPlanNode(PLAN_EXTERNAL_SORT);
+                if (sort) {
+                    double runs = ceil(bytes / (double)(spec->memory_budget ? spec->memory_budget : 1));
+                    double passes = runs > 1.0 ? ceil(log(runs) / log((double)SORT_MERGE_FAN_IN)) : 1.0;
+                    double spill_pages = input_rows * averageRowBytes(&info, db) / (double)db->page_size;
+                    sort->estimated_cost =
+                        plan->estimated_cost + compare_cost + spill_pages * (passes < 1.0 ? 1.0 : passes) * SPILL_PAGE_COST;
+                }
+            }
+            if (sort) {
+                sort->estimated_rows = input_rows;
+            }
+        }
+
+        if (!sort) {
+            freePlan(plan);
+            free(info.schema);
+            return NULL;
+        }
+
+        size_t used = (size_t)snprintf(sort->detail, sizeof(sort->detail), "by");
+        for (uint16_t k = 0; k < spec->key_count && used < sizeof(sort->detail); k++) {
+            used += (size_t)snprintf(sort->detail + used, sizeof(sort->detail) - used, "%s %s%s",
+                                     k == 0 ? "" : ",", info.schema->columns[spec->keys[k].column].name,
+                                     spec->keys[k].descending ? " desc" : "");
+        }
+        sort->children[0] = plan;
+        sort->child_count = 1;
+        plan = sort;
+    }
+
+    if (spec->limit > 0) {
+        PlanNode *limit = newPlanNode(PLAN_LIMIT);
+        if (!limit) {
+            freePlan(plan);
+            free(info.schema);
+            return NULL;
+        }
+
+        limit->estimated_rows = (double)spec->limit < plan->estimated_rows ? (double)spec->limit : plan->estimated_rows;
+        limit->estimated_cost = plan->estimated_cost;
+        snprintf(limit->detail, sizeof(limit->detail), "%lu", (unsigned long)spec->limit);
+        limit->children[0] = plan;
+        limit->child_count = 1;
+        plan = limit;
+    }
+
+    free(info.schema);
+    return plan;
+}
+
+// Cost of the join when build is hashed and probe is streamed, excluding the two scans
+static double hashJoinCost(TableInfo *build, PlanNode *build_scan, TableInfo *probe, PlanNode *probe_scan,
+                           double output_rows, size_t memory_budget, int *grace) {
+    double cost = build_scan->estimated_rows * HASH_BUILD_COST +
+                  probe_scan->estimated_rows * (CPU_TUPLE_COST + CPU_OPERATOR_COST) + output_rows * CPU_TUPLE_COST;
+
+    // Mirrors openHashJoin, which partitions once the rows the filter keeps outgrow the budget
+    double build_bytes = build_scan->estimated_rows * (double)joinBuildRowMemorySize(build->schema->column_count);
+    *grace = build_bytes > (double)memory_budget;
+    if (*grace) {
+        cost += (build->pages + probe->pages) * SPILL_PAGE_COST;
+    }
+    return cost;
+}
+
+PlanNode *planJoin(MagBase *db, JoinSpec *spec, uint64_t limit) {
+    if (!db || !spec) {
+        return NULL;
+    }
+
+    TableInfo left, right;
+    if (loadTableInfo(db, spec->left_table, &left) != 0) {
+        return NULL;
+    }
+    if (loadTableInfo(db, spec->right_table, &right) != 0) {
+        free(left.schema);
+        return NULL;
+    }
+
+    PlanNode *left_scan = planScan(&left, spec->left_filter);
+    PlanNode *right_scan = planScan(&right, spec->right_filter);
+    PlanNode *join = NULL;
+    if (!left_scan || !right_scan) {
+        goto fail;
+    }
+
+    // |L join R| = |L| * |R| / max(distinct(L.a), distinct(R.b))
+    double left_distinct = estimateDistinct(&left, spec->left_column, left_scan->estimated_rows);
+    double right_distinct = estimateDistinct(&right, spec->right_column, right_scan->estimated_rows);
+    double output_rows = left_scan->estimated_rows * right_scan->estimated_rows /
+                         (left_distinct > right_distinct ? left_distinct : right_distinct);
+
+    // Join order: cost hashing either side and keep the cheaper one
+    int left_grace, right_grace;
+    double build_left_cost =
+        hashJoinCost(&left, left_scan, &right, right_scan, output_rows, spec->memory_budget, &left_grace);
+    double build_right_cost =
+        hashJoinCost(&right, right_scan, &left, left_scan, output_rows, spec->memory_budget, &right_grace);
+    int build_left = build_left_cost <= build_right_cost;
+
+    spec->build_side = build_left ? JOIN_BUILD_LEFT : JOIN_BUILD_RIGHT;
+    join = newPlanNode((build_left ? left_grace : right_grace) ? PLAN_GRACE_HASH_JOIN : PLAN_HASH_JOIN);
+    if (!join) {
+        goto fail;
+    }
+
+    join->estimated_rows = output_rows;
+    join->estimated_cost = left_scan->estimated_cost + right_scan->estimated_cost +
+                           (build_left ? build_left_cost : build_right_cost);
+    snprintf(join->detail, sizeof(join->detail), "%s.%s = %s.%s  (hash %s)", left.schema->table_name,
+             left.schema->columns[spec->left_column].name, right.schema->table_name,
+             right.schema->columns[spec->right_column].name,
+             build_left ? left.schema->table_name : right.schema->table_name);
+
+    // The hashed side is listed first
+    join->children[0] = build_left ? left_scan : right_scan;
+    join->children[1] = build_left ? right_scan : left_scan;
+    join->child_count = 2;
+    left_scan = right_scan = NULL;
+
+    if (limit > 0) {
+        PlanNode *limit_node = newPlanNode(PLAN_LIMIT);
+        if (!limit_node) {
+            goto fail;
+        }
+        limit_node->estimated_rows = (double)limit < join->estimated_rows ? (double)limit : join->estimated_rows;
+        limit_node->estimated_cost = join->estimated_cost;
+        snprintf(limit_node->detail, sizeof(limit_node->detail), "%lu", (unsigned long)limit);
+        limit_node->children[0] = join;
+        limit_node->child_count = 1;
+        join = limit_node;
+    }
+
+    free(left.schema);
+    free(right.schema);
+    return join;
+
+fail:
+    freePlan(left_scan);
+    freePlan(right_scan);
+    freePlan(join);
+    free(left.schema);
+    free(right.schema);
+    return NULL;
+}
+
+PlanNode *planAggregate(MagBase *db, uint16_t table_id, const Filter *filter, const AggregateSpec *spec,
+                        uint32_t thread_count) {
+    if (!db || !spec) {
+        return NULL;
+    }
+
+    TableInfo info;
+    if (loadTableInfo(db, table_id, &info) != 0) {
+        return NULL;
+    }
+
+    PlanNode *scan = planScan(&info, filter);
+    PlanNode *aggregate = newPlanNode(PLAN_AGGREGATE);
+    if (!scan || !aggregate) {
+        freePlan(scan);
+        freePlan(aggregate);
+        free(info.schema);
+        return NULL;
+    }
+
+    // Morsels are spread evenly, so the scan takes about 1/workers of the serial time
+    uint32_t workers = thread_count ? thread_count : 1;
+    uint64_t morsels = ((uint64_t)info.pages + SCAN_MORSEL_PAGES - 1) / SCAN_MORSEL_PAGES;
+    if (morsels > 0 && workers > morsels) {
+        workers = (uint32_t)morsels;
+    }
+    scan->type = PLAN_PARALLEL_SEQ_SCAN;
+    scan->estimated_cost = scan->estimated_cost / workers + PARALLEL_SETUP_COST;
+    size_t used = strlen(scan->detail);
+    snprintf(scan->detail + used, sizeof(scan->detail) - used, "  (workers=%u)", thread_count);
+
+    aggregate->estimated_rows = 1;
+    aggregate->estimated_cost = scan->estimated_cost + scan->estimated_rows * spec->count * CPU_OPERATOR_COST / workers;
+    used = 0;
+    for (uint16_t a = 0; a < spec->count && used < sizeof(aggregate->detail); a++) {
+        char text[64];
+        formatAggregate(info.schema, &spec->aggregates[a], text, sizeof(text));
+        used += (size_t)snprintf(aggregate->detail + used, sizeof(aggregate->detail) - used, "%s%s",
+                                 a == 0 ? "" : ", ", text);
+    }
+    aggregate->children[0] = scan;
+    aggregate->child_count = 1;
+
+    free(info.schema);
+    return aggregate;
+}
+
+static void printPlanNode(PlanNode *node, int depth) {
+    if (depth == 0) {
+        printf("%s", node_names[node->type]);
+    } else {
+        printf("%*s-> %s", depth * 4 - 2, "", node_names[node->type]);
+    }
+
+    if (node->detail[0]) {
+        printf(" %s", node->detail);
+    }
+    printf("  (cost=%.2f rows=%.0f)", node->estimated_cost, node->estimated_rows);
+    if (node->has_actual && (node->type == PLAN_SORT || node->type == PLAN_EXTERNAL_SORT)) {
+        printf(" (actual rows=%lu spilled runs=%lu)", (unsigned long)node->actual_rows,
+               (unsigned long)node->actual_runs);
+    } else if (node->has_actual && (node->type == PLAN_HASH_JOIN || node->type == PLAN_GRACE_HASH_JOIN)) {
+        printf(" (actual rows=%lu partitions=%lu)", (unsigned long)node->actual_rows,
+               (unsigned long)node->actual_runs);
+    } else if (node->has_actual) {
+        printf(" (actual rows=%lu)", (unsigned long)node->actual_rows);
+    }
+    printf("\n");
+
+    for (uint8_t c = 0; c < node->child_count; c++) {
+        printPlanNode(node->children[c], depth + 1);
+    }
+}
+
+void printPlan(PlanNode *plan) {
+    if (plan) {
+        printPlanNode(plan, 0);
+    }
+}
+
+void freePlan(PlanNode *plan) {
+    if (!plan) {
+        return;
+    }
+
+    for (uint8_t c = 0; c < plan->child_count; c++) {
+        freePlan(plan->children[c]);
+    }
+    free(plan);
+}
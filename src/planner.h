@@ -0,0 +1,58 @@
+//     Keagan Anderson
+//        MagBase
+//       10/19/2026
+//
+//     Cost based planning for -list-records, -join and -aggregate, printed by -explain
+
+#pragma once
+
+#include "db-init.h"
+#include "join.h"
+#include "parallel-scan.h"
+#include "sort.h"
+#include <stdint.h>
+
+typedef enum {
+    PLAN_SEQ_SCAN,
+    PLAN_SORT,
+    PLAN_EXTERNAL_SORT,
+    PLAN_TOP_K,
+    PLAN_LIMIT,
+    PLAN_HASH_JOIN,
+    PLAN_GRACE_HASH_JOIN,
+    PLAN_AGGREGATE,
+    PLAN_PARALLEL_SEQ_SCAN
+} PlanNodeType;
+
+typedef struct PlanNode {
+    uint8_t type;                       // PlanNodeType
+    uint16_t table_id;                  // Scanned table, 0 for other nodes
+    char detail[192];                   // Table name, sort keys, filter... for display
+    double estimated_rows;
+    double estimated_cost;              // Includes the cost of the children
+    uint64_t actual_rows;               // Filled in by the caller after running the plan
+    uint64_t actual_runs;               // Runs a sort or partitions a join really spilled, the planner's choice of
+                                        // operator is an estimate
+    uint8_t has_actual;
+    struct PlanNode *children[2];
+    uint8_t child_count;
+} PlanNode;
+
+// Plan a single table query: scan with spec->filter, optionally sorted and limited by spec
+// Returns NULL on error, free with freePlan
+PlanNode *planSelect(MagBase *db, uint16_t table_id, const SortSpec *spec);
+
+// Plan an equi-join. Both build sides are costed and the cheaper one is stored in
+// spec->build_side, so running openHashJoin with the spec executes this plan
+// Returns NULL on error, free with freePlan
+PlanNode *planJoin(MagBase *db, JoinSpec *spec, uint64_t limit);
+
+// Plan aggregates computed by a parallel scan with thread_count workers
+// Returns NULL on error, free with freePlan
+PlanNode *planAggregate(MagBase *db, uint16_t table_id, const struct Filter *filter, const AggregateSpec *spec,
+                        uint32_t thread_count);
+
+// Print the plan tree, with actual row counts where they were filled in
+void printPlan(PlanNode *plan);
+
+void freePlan(PlanNode *plan);
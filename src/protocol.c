@@ -0,0 +1,261 @@
+//     Keagan Anderson
+//        MagBase
+//       10/19/2026
+//
+//     Wire protocol between magbased and its clients (see protocol.h)
+
+#include "protocol.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int defaultSocketPath(const char *db_path, char *out, size_t out_size) {
+    size_t length = strlen(db_path);
+    bool has_extension = length >= 4 && !strcmp(db_path + length - 4, ".mab");
+    int written = snprintf(out, out_size, "%s%s-sock", db_path, has_extension ? "" : ".mab");
+    return written < 0 || (size_t)written >= out_size ? -1 : 0;
+}
+
+int reserveWire(WireBuffer *buffer, size_t extra) {
+    if (buffer->length + extra <= buffer->capacity) {
+        return 0;
+    }
+
+    size_t capacity = buffer->capacity ? buffer->capacity : 4096;
+    while (capacity < buffer->length + extra) {
+        capacity *= 2;
+    }
+    uint8_t *data = realloc(buffer->data, capacity);
+    if (!data) {
+        return -1;
+    }
+    buffer->data = data;
+    buffer->capacity = capacity;
+    return 0;
+}
+
+void consumeWire(WireBuffer *buffer, size_t count) {
+    if (count >= buffer->length) {
+        buffer->length = 0;
+        return;
+    }
+    memmove(buffer->data, buffer->data + count, buffer->length - count);
+    buffer->length -= count;
+}
+
+void freeWire(WireBuffer *buffer) {
+    free(buffer->data);
+    memset(buffer, 0, sizeof(WireBuffer));
+}
+
+static int putBytes(WireBuffer *buffer, const void *bytes, size_t count) {
+    if (reserveWire(buffer, count) != 0) {
+        return -1;
+    }
+    memcpy(buffer->data + buffer->length, bytes, count);
+    buffer->length += count;
+    return 0;
+}
+
+int putU8(WireBuffer *buffer, uint8_t value) { return putBytes(buffer, &value, sizeof(value)); }
+int putU16(WireBuffer *buffer, uint16_t value) { return putBytes(buffer, &value, sizeof(value)); }
+int putU32(WireBuffer *buffer, uint32_t value) { return putBytes(buffer, &value, sizeof(value)); }
+int putU64(WireBuffer *buffer, uint64_t value) { return putBytes(buffer, &value, sizeof(value)); }
+
+size_t beginFrame(WireBuffer *buffer, uint32_t request_id, uint8_t code) {
+    size_t frame = buffer->length;
+    putU32(buffer, 0);
+    putU32(buffer, request_id);
+    putU8(buffer, code);
+    return frame;
+}
+
+void endFrame(WireBuffer *buffer, size_t frame) {
+    if (buffer->length < frame + FRAME_HEADER_SIZE) {
+        return;
+    }
+    uint32_t length = (uint32_t)(buffer->length - frame - sizeof(uint32_t));
+    memcpy(buffer->data + frame, &length, sizeof(length));
+}
+
+int putString(WireBuffer *buffer, const char *text) {
+    size_t length = text ? strlen(text) : 0;
+    if (length > UINT16_MAX - 1) {
+        return -1;
+    }
+    if (reserveWire(buffer, sizeof(uint16_t) + length + 1) != 0) {
+        return -1;
+    }
+    putU16(buffer, (uint16_t)length);
+    putBytes(buffer, text ? text : "", length);
+    return putU8(buffer, 0);
+}
+
+int putValues(WireBuffer *buffer, const MagbaseValue *values, uint16_t count) {
+    if (putU16(buffer, count) != 0) {
+        return -1;
+    }
+    for (uint16_t i = 0; i < count; i++) {
+        const MagbaseValue *value = &values[i];
+        if (putU8(buffer, value->type) != 0 || putU8(buffer, value->is_null) != 0) {
+            return -1;
+        }
+        if (value->is_null) {
+            continue;
+        }
+
+        int result = -1;
+        switch (value->type) {
+            case MAGBASE_INT:
+                result = putU32(buffer, (uint32_t)value->value.int_val);
+                break;
+            case MAGBASE_BOOL:
+                result = putU8(buffer, value->value.bool_val ? 1 : 0);
+                break;
+            case MAGBASE_TEXT:
+                result = putString(buffer, value->value.text_val);
+                break;
+        }
+        if (result != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int putColumns(WireBuffer *buffer, const MagbaseColumn *columns, uint16_t count) {
+    if (putU16(buffer, count) != 0) {
+        return -1;
+    }
+    for (uint16_t i = 0; i < count; i++) {
+        if (putString(buffer, columns[i].name) != 0 || putU8(buffer, columns[i].type) != 0 ||
+            putU8(buffer, columns[i].nullable ? 1 : 0) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+long completeFrame(const uint8_t *data, size_t length, size_t max_frame) {
+    if (length < sizeof(uint32_t)) {
+        return 0;
+    }
+    uint32_t frame_length;
+    memcpy(&frame_length, data, sizeof(frame_length));
+    size_t total = sizeof(uint32_t) + (size_t)frame_length;
+    if (total < FRAME_HEADER_SIZE || total > max_frame) {
+        return -1;
+    }
+    return length >= total ? (long)total : 0;
+}
+
+WireReader frameReader(const uint8_t *frame, size_t frame_length, uint32_t *request_id, uint8_t *code) {
+    WireReader reader = {frame, frame_length, sizeof(uint32_t), false};
+    uint32_t id = getU32(&reader);
+    uint8_t value = getU8(&reader);
+    if (request_id) {
+        *request_id = id;
+    }
+    if (code) {
+        *code = value;
+    }
+    return reader;
+}
+
+// Returns a pointer to the next count bytes, or NULL past the end
+static const uint8_t *getBytes(WireReader *reader, size_t count) {
+    if (reader->failed || reader->length - reader->offset < count) {
+        reader->failed = true;
+        return NULL;
+    }
+    const uint8_t *bytes = reader->data + reader->offset;
+    reader->offset += count;
+    return bytes;
+}
+
+uint8_t getU8(WireReader *reader) {
+    const uint8_t *bytes = getBytes(reader, sizeof(uint8_t));
+    return bytes ? *bytes : 0;
+}
+
+uint16_t getU16(WireReader *reader) {
+    uint16_t value = 0;
+    const uint8_t *bytes = getBytes(reader, sizeof(value));
+    if (bytes) {
+        memcpy(&value, bytes, sizeof(value));
+    }
+    return value;
+}
+
+uint32_t getU32(WireReader *reader) {
+    uint32_t value = 0;
+    const uint8_t *bytes = getBytes(reader, sizeof(value));
+    if (bytes) {
+        memcpy(&value, bytes, sizeof(value));
+    }
+    return value;
+}
+
+uint64_t getU64(WireReader *reader) {
+    uint64_t value = 0;
+    const uint8_t *bytes = getBytes(reader, sizeof(value));
+    if (bytes) {
+        memcpy(&value, bytes, sizeof(value));
+    }
+    return value;
+}
+
+const char *getString(WireReader *reader) {
+    uint16_t length = getU16(reader);
+    const uint8_t *bytes = getBytes(reader, (size_t)length + 1);
+    if (!bytes || bytes[length] != '\0' || memchr(bytes, '\0', length)) {
+        reader->failed = true;
+        return NULL;
+    }
+    return (const char *)bytes;
+}
+
+int getValues(WireReader *reader, MagbaseValue *values, uint16_t *count, uint16_t max_count) {
+    *count = getU16(reader);
+    if (reader->failed || *count > max_count) {
+        return -1;
+    }
+    for (uint16_t i = 0; i < *count; i++) {
+        MagbaseValue *value = &values[i];
+        memset(value, 0, sizeof(MagbaseValue));
+        value->type = getU8(reader);
+        value->is_null = getU8(reader) != 0;
+        if (value->is_null) {
+            continue;
+        }
+
+        switch (value->type) {
+            case MAGBASE_INT:
+                value->value.int_val = (int32_t)getU32(reader);
+                break;
+            case MAGBASE_BOOL:
+                value->value.bool_val = getU8(reader) != 0;
+                break;
+            case MAGBASE_TEXT:
+                value->value.text_val = getString(reader);
+                break;
+            default:
+                reader->failed = true;
+                break;
+        }
+    }
+    return reader->failed ? -1 : 0;
+}
+
+int getColumns(WireReader *reader, MagbaseColumn *columns, uint16_t *count, uint16_t max_count) {
+    *count = getU16(reader);
+    if (reader->failed || *count > max_count) {
+        return -1;
+    }
+    for (uint16_t i = 0; i < *count; i++) {
+        columns[i].name = getString(reader);
+        columns[i].type = getU8(reader);
+        columns[i].nullable = getU8(reader) != 0;
+    }
+    return reader->failed ? -1 : 0;
+}
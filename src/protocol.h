@@ -0,0 +1,111 @@
+//     Keagan Anderson
+//        MagBase
+//       10/19/2026
+//
+//     Wire protocol between magbased and its clients. Every message is a frame:
+//     u32 length (of the rest), u32 request id, u8 opcode (requests) or status (responses), payload
+//     Integers are in host byte order since both ends run on the same machine. A client may send
+//     many requests before reading, responses come back in request order
+
+#pragma once
+
+#include "magbase.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define FRAME_HEADER_SIZE 9         // length, request id, opcode or status
+#define WIRE_MAX_CONDITIONS 16      // Conditions a scan may send, as many as a filter holds
+
+// Requests, the payload of each is listed with its response payload
+typedef enum {
+    OP_PING,            // -> nothing
+    OP_CREATE_TABLE,    // string name, u16 count, columns -> u16 table id
+    OP_DROP_TABLE,      // u16 table id -> nothing
+    OP_FIND_TABLE,      // string name -> u16 table id
+    OP_TABLE_STATS,     // u16 table id -> string name, u16 count, columns, u64 rows, u64 pages
+    OP_INSERT,          // u16 table id, u16 count, values -> u64 record id
+    OP_READ,            // u16 table id, u64 record id -> u16 count, values
+    OP_UPDATE,          // u16 table id, u64 record id, u16 count, values -> nothing
+    OP_DELETE,          // u16 table id, u64 record id -> nothing
+    OP_SCAN,            // u16 table id, u16 count, strings (col<op>value) -> a STATUS_ROW frame
+                        // per row (u64 record id, u16 count, values), then u64 rows
+} Opcode;
+
+typedef enum {
+    STATUS_OK,
+    STATUS_ROW,         // One row of a scan, more frames follow for the same request
+    STATUS_NOT_FOUND,
+    STATUS_ERROR,
+} Status;
+
+// Growable byte buffer frames are built in and read from
+typedef struct {
+    uint8_t *data;
+    size_t length;
+    size_t capacity;
+} WireBuffer;
+
+// Bounds checked reader over one frame payload, failed is set by any read past the end
+typedef struct {
+    const uint8_t *data;
+    size_t length;
+    size_t offset;
+    bool failed;
+} WireReader;
+
+// Socket magbased listens on for a database: the path with .mab added if needed, then -sock
+// Returns 0 on success, -1 if it does not fit in out_size
+int defaultSocketPath(const char *db_path, char *out, size_t out_size);
+
+// Make room for extra more bytes
+// Returns 0 on success, -1 if out of memory
+int reserveWire(WireBuffer *buffer, size_t extra);
+
+// Drop the first count bytes of a buffer
+void consumeWire(WireBuffer *buffer, size_t count);
+
+void freeWire(WireBuffer *buffer);
+
+// Start a frame, the length is filled in by endFrame
+// Returns the offset of the frame for endFrame
+size_t beginFrame(WireBuffer *buffer, uint32_t request_id, uint8_t code);
+void endFrame(WireBuffer *buffer, size_t frame);
+
+// Writers, they return -1 when out of memory
+int putU8(WireBuffer *buffer, uint8_t value);
+int putU16(WireBuffer *buffer, uint16_t value);
+int putU32(WireBuffer *buffer, uint32_t value);
+int putU64(WireBuffer *buffer, uint64_t value);
+
+// Strings are a u16 length and the bytes with their terminator, so readers use them in place
+int putString(WireBuffer *buffer, const char *text);
+
+// A value is u8 type, u8 is_null and, unless NULL, an i32, a u8 or a string
+int putValues(WireBuffer *buffer, const MagbaseValue *values, uint16_t count);
+
+// Columns are a string name, u8 type and u8 nullable each
+int putColumns(WireBuffer *buffer, const MagbaseColumn *columns, uint16_t count);
+
+// Returns the length of the first frame in data when it is complete (FRAME_HEADER_SIZE
+// included), 0 if more bytes are needed, or -1 if the frame is longer than max_frame
+long completeFrame(const uint8_t *data, size_t length, size_t max_frame);
+
+// Reader over the payload of a complete frame, request_id and code get the header
+WireReader frameReader(const uint8_t *frame, size_t frame_length, uint32_t *request_id, uint8_t *code);
+
+uint8_t getU8(WireReader *reader);
+uint16_t getU16(WireReader *reader);
+uint32_t getU32(WireReader *reader);
+uint64_t getU64(WireReader *reader);
+
+// Returns the string in place in the frame, or NULL (and sets failed) if it is malformed
+const char *getString(WireReader *reader);
+
+// Read count values into values, text points into the frame
+// Returns 0 on success, -1 if malformed or more than max_count
+int getValues(WireReader *reader, MagbaseValue *values, uint16_t *count, uint16_t max_count);
+
+// Read count columns into columns, names point into the frame
+// Returns 0 on success, -1 if malformed or more than max_count
+int getColumns(WireReader *reader, MagbaseColumn *columns, uint16_t *count, uint16_t max_count);
@@ -7,7 +7,12 @@
 #include "records.h"
 #include "schema.h"
 #include "buffer.h"
+#include "dictionary.h"
 #include "globals.h"
+#include "filter.h"
+#include "page-directory.h"
+#include "row-codec.h"
+#include "zone-map.h"
 #include <stdlib.h>
 #include <string.h>
 
@@ -47,7 +52,7 @@ void freeRecord(Record *record) {
 }
 
 // Serialize a record into a buffer
-static void serializeRecord(uint8_t *buffer, Record *record) {
+void serializeRecord(uint8_t *buffer, Record *record) {
     uint8_t *ptr = buffer;
 
     // Write header
@@ -95,7 +100,7 @@ static void serializeRecord(uint8_t *buffer, Record *record) {
 
 // Deserialize a record from a buffer
 // Returns the number of bytes consumed
-static size_t deserializeRecord(uint8_t *buffer, Record *record) {
+size_t deserializeRecord(uint8_t *buffer, Record *record) {
     uint8_t *ptr = buffer;
 
     // Read header
@@ -155,7 +160,7 @@ static size_t deserializeRecord(uint8_t *buffer, Record *record) {
 }
 
 // Calculate the serialized size of a record
-static size_t getRecordSize(Record *record) {
+size_t getRecordSize(Record *record) {
     size_t size = sizeof(uint64_t) + sizeof(uint16_t) + sizeof(uint16_t);  // header
 
     for (uint16_t i = 0; i < record->field_count; i++) {
@@ -179,41 +184,258 @@ static size_t getRecordSize(Record *record) {
     return size;
 }
 
+int serializeRow(MagBase *db, const RowCodec *codec, uint8_t *buffer, Record *record) {
+    if (db->version_size > 0) {
+        RowVersion version = {writerTxn(db), 0};
+        memcpy(buffer, &version, sizeof(RowVersion));
+    }
+    if (!db->compact_rows) {
+        serializeRecord(buffer + db->version_size, record);
+        return 0;
+    }
+    // A row stored with the wrong code would read back as another value
+    if (encodeRow(codec, buffer + db->version_size, record) == 0) {
+        fprintf(stderr, "A value of a dictionary column of table %u has no code\n", codec->table_id);
+        return -1;
+    }
+    return 0;
+}
+
+size_t deserializeRow(MagBase *db, const RowCodec *codec, uint8_t *buffer, Record *record) {
+    if (db->compact_rows) {
+        return db->version_size + codec->decode(codec, buffer + db->version_size, record);
+    }
+    return db->version_size + deserializeRecord(buffer + db->version_size, record);
+}
+
+size_t getRowSize(MagBase *db, const RowCodec *codec, Record *record) {
+    return db->version_size + (db->compact_rows ? encodedRowSize(codec, record) : getRecordSize(record));
+}
+
+uint64_t rowRecordId(MagBase *db, const uint8_t *row) {
+    row += db->version_size;
+    if (db->compact_rows) {
+        return decodeRowId(row);
+    }
+    uint64_t record_id;
+    memcpy(&record_id, row, sizeof(uint64_t));
+    return record_id;
+}
+
+size_t skipRow(MagBase *db, const RowCodec *codec, uint8_t *row, Record *scratch) {
+    if (db->compact_rows) {
+        return db->version_size + encodedRowLength(codec, row + db->version_size);
+    }
+    return deserializeRow(db, codec, row, scratch);
+}
+
+Snapshot takeSnapshot(MagBase *db) {
+    Snapshot snapshot;
+    // next_txn first: the writer publishes writing_txn before it moves next_txn past it
+    snapshot.next_txn = db->next_txn;
+    snapshot.writing_txn = db->writing_txn;
+    snapshot.own_writes = isPoolWriter(db->buffer_pool);
+    return snapshot;
+}
+
+static bool committedIn(const Snapshot *snapshot, uint64_t txn) {
+    if (txn == snapshot->writing_txn) {
+        return snapshot->own_writes;
+    }
+    return txn < snapshot->next_txn;
+}
+
+bool rowVisible(MagBase *db, const Snapshot *snapshot, const uint8_t *row) {
+    if (db->version_size == 0) {
+        return true;
+    }
+
+    RowVersion version;
+    memcpy(&version, row, sizeof(RowVersion));
+    return committedIn(snapshot, version.created_txn) &&
+           (version.deleted_txn == 0 || !committedIn(snapshot, version.deleted_txn));
+}
+
+// Mark a data page dirty after a change, pages of a compressed table get written compressed
+static void markRowPageDirty(MagBase *db, const TableSchemaRecord *schema, uint64_t page_num) {
+    markPageDirty(db->buffer_pool, page_num);
+    if (schema->flags & TABLE_COMPRESSED) {
+        markPageCompressed(db->buffer_pool, page_num, true);
+    }
+}
+
+// Remove the rows of a page whose delete committed, the rows after them move down. The caller
+// keeps readers out of the table, so no snapshot needs such a row anymore. Rows deleted by the
+// writer's own transaction stay in case it rolls back
+// Returns the number of rows removed
+static uint16_t compactPage(MagBase *db, const RowCodec *codec, char *page_buffer, Record *scratch) {
+    PageHeader *page_header = (PageHeader *)page_buffer;
+    uint64_t writing_txn = db->writing_txn;
+    uint8_t *read_ptr = (uint8_t *)page_buffer + sizeof(PageHeader);
+    uint8_t *write_ptr = read_ptr;
+    uint16_t kept = 0;
+    uint16_t dead = 0;
+    uint16_t dead_bytes = 0;
+    for (uint16_t i = 0; i < page_header->slot_count; i++) {
+        size_t size = skipRow(db, codec, read_ptr, scratch);
+        RowVersion version;
+        memcpy(&version, read_ptr, sizeof(RowVersion));
+        if (version.deleted_txn == 0 || version.deleted_txn == writing_txn) {
+            memmove(write_ptr, read_ptr, size);
+            write_ptr += size;
+            kept++;
+            if (version.deleted_txn != 0) {
+                dead++;
+                dead_bytes += (uint16_t)size;
+            }
+        }
+        read_ptr += size;
+    }
+
+    // The freed end is zeroed, so the page logs and compresses like a fresh one
+    memset(write_ptr, 0, (size_t)(read_ptr - write_ptr));
+    uint16_t removed = page_header->slot_count - kept;
+    page_header->slot_count = kept;
+    page_header->free_space_offset = (uint16_t)(write_ptr - (uint8_t *)page_buffer);
+    page_header->dead_count = dead;
+    page_header->dead_bytes = dead_bytes;
+    return removed;
+}
+
 uint64_t insertRecord(MagBase *db, Record *record) {
     if (!db || !record) {
         return 0;
     }
 
-    TableSchemaRecord *schema = readTableSchema(db, record->table_id);
+    TableSchemaRecord *schema = getTableSchema(db, record->table_id);
     if (!schema) {
         return 0;
     }
 
-    // Generate record_id from schema's next_record_id (only if not already set)
+    return appendRecord(db, schema, record);
+}
+
+// Make room for a row of size bytes in a data page. A page without it is compacted when its
+// deleted rows would free enough and db->compact_pages allows it
+// Returns true if the row fits
+static bool makeRoom(MagBase *db, const TableSchemaRecord *schema, const RowCodec *codec, uint64_t page_num,
+                     char *page_buffer, size_t size) {
+    PageHeader *page_header = (PageHeader *)page_buffer;
+    size_t needed = size + sizeof(uint16_t);
+    size_t available_space = db->usable_page_size - page_header->free_space_offset;
+    if (available_space >= needed) {
+        return true;
+    }
+    if (!db->compact_pages || page_header->dead_count == 0 || available_space + page_header->dead_bytes < needed) {
+        return false;
+    }
+
+    Record *scratch = createRecord(schema->table_id, schema->column_count);
+    if (!scratch) {
+        return false;
+    }
+    if (compactPage(db, codec, page_buffer, scratch) > 0) {
+        markRowPageDirty(db, schema, page_num);
+    }
+    freeRecord(scratch);
+    return db->usable_page_size - page_header->free_space_offset >= needed;
+}
+
+// The first page from the table's free page on that has room for a row of size bytes, the free
+// page moves to it. last_page, where the search ends, was found full already
+// Returns 0 if there is none
+static uint64_t findFreePage(MagBase *db, const TableSchemaRecord *schema, const RowCodec *codec,
+                             uint64_t last_page, size_t size) {
+    uint64_t page_num = getFreeTablePage(db, schema->table_id);
+    while (page_num != 0 && page_num != last_page) {
+        char *page_buffer = readPageFromBuffer(db->buffer_pool, page_num, db->file_pointer, db->page_size);
+        if (!page_buffer) {
+            break;
+        }
+        if (makeRoom(db, schema, codec, page_num, page_buffer, size)) {
+            setFreeTablePage(db, schema->table_id, page_num);
+            return page_num;
+        }
+        page_num = ((PageHeader *)page_buffer)->next_page;
+    }
+
+    setFreeTablePage(db, schema->table_id, 0);
+    return 0;
+}
+
+// Link a new, empty page after the table's last page
+// Returns 0 on success, -1 on error
+static int linkTablePage(MagBase *db, TableSchemaRecord *schema, uint64_t last_page, uint64_t page_num) {
+    char *page_buffer = readPageFromBuffer(db->buffer_pool, last_page, db->file_pointer, db->page_size);
+    if (!page_buffer) {
+        return -1;
+    }
+    ((PageHeader *)page_buffer)->next_page = page_num;
+    markRowPageDirty(db, schema, last_page);
+    if (appendTablePage(db, schema, page_num) != 0) {
+        return -1;
+    }
+
+    page_buffer = readPageFromBuffer(db->buffer_pool, page_num, db->file_pointer, db->page_size);
+    if (!page_buffer) {
+        return -1;
+    }
+    PageHeader *page_header = (PageHeader *)page_buffer;
+    page_header->slot_count = 0;
+    page_header->free_space_offset = sizeof(PageHeader);
+    page_header->dead_count = 0;
+    page_header->dead_bytes = 0;
+    page_header->next_page = 0;
+    return 0;
+}
+
+// Write a row to the table. near_page, a page of the table or 0, is tried before the last page
+// Returns the record_id, or 0 on error
+static uint64_t storeRecord(MagBase *db, TableSchemaRecord *schema, Record *record, uint64_t near_page) {
+
+    // Generate record_id from the table's reserved range (only if not already set)
     if (record->record_id == 0) {
-        record->record_id = schema->next_record_id;
-        schema->next_record_id++;
+        record->record_id = allocateRecordId(db, schema->table_id);
+        if (record->record_id == 0) {
+            return 0;
+        }
     }
 
-    size_t record_size = getRecordSize(record);
+    const RowCodec *codec = getRowCodec(db, schema->table_id);
+    if (!codec || addDictionaryValues(db, codec, record) != 0) {
+        return 0;
+    }
+    size_t record_size = getRowSize(db, codec, record);
 
     // Find or allocate page for records
     uint64_t page_num = schema->root_page;
     if (page_num == 0) {
-        // Allocate first data page
+        // Allocate first data page. The schema may be the cached one readers look at, it is
+        // changed on a copy and saved through updateTableSchema
+        TableSchemaRecord table = *schema;
         page_num = db->header->page_count++;
-        schema->root_page = page_num;
+        table.root_page = page_num;
         // Update the schema with the new root_page
-        if (updateTableSchema(db, schema) != 0) {
+        if (appendTablePage(db, &table, page_num) != 0 || updateTableSchema(db, &table) != 0) {
             fprintf(stderr, "[ERROR] Failed to update table schema with root_page\n");
-            free(schema);
+            return 0;
+        }
+        if (schema->root_page == 0) {
+            schema->root_page = table.root_page;
+            schema->directory_page = table.directory_page;
+        }
+    } else if (near_page != 0) {
+        page_num = near_page;
+    } else {
+        // Records are appended to the last page, the page directory knows which one it is
+        page_num = lastTablePage(db, schema);
+        if (page_num == 0) {
             return 0;
         }
     }
 
     char *page_buffer = readPageFromBuffer(db->buffer_pool, page_num, db->file_pointer, db->page_size);
     if (!page_buffer) {
-        free(schema);
         return 0;
     }
 
@@ -223,96 +445,177 @@ uint64_t insertRecord(MagBase *db, Record *record) {
     if (page_header->free_space_offset == 0) {
         page_header->slot_count = 0;
         page_header->free_space_offset = sizeof(PageHeader);
+        page_header->dead_count = 0;
+        page_header->dead_bytes = 0;
         page_header->next_page = 0;
     }
-    
-    uint16_t available_space = db->page_size - page_header->free_space_offset;
-
-    // Check if record fits
-    if (available_space < record_size + sizeof(uint16_t)) {
-        // Allocate new page
-        uint64_t new_page_num = db->header->page_count++;
-        page_header->next_page = new_page_num;
-        markPageDirty(db->buffer_pool, page_num);
 
-        // Initialize new page
-        page_buffer = readPageFromBuffer(db->buffer_pool, new_page_num, db->file_pointer, db->page_size);
+    // A near page without room leaves the row to the last page
+    if (page_num == near_page && !makeRoom(db, schema, codec, page_num, page_buffer, record_size)) {
+        page_num = lastTablePage(db, schema);
+        page_buffer = page_num ? readPageFromBuffer(db->buffer_pool, page_num, db->file_pointer, db->page_size) : NULL;
         if (!page_buffer) {
-            free(schema);
             return 0;
         }
+        page_header = (PageHeader *)page_buffer;
+    }
 
+    // A full last page is followed by the pages vacuum left room in, the file grows last
+    if (!makeRoom(db, schema, codec, page_num, page_buffer, record_size)) {
+        uint64_t last_page = page_num;
+        page_num = findFreePage(db, schema, codec, last_page, record_size);
+        if (page_num == 0) {
+            page_num = db->header->page_count++;
+            if (linkTablePage(db, schema, last_page, page_num) != 0) {
+                return 0;
+            }
+        }
+
+        page_buffer = readPageFromBuffer(db->buffer_pool, page_num, db->file_pointer, db->page_size);
+        if (!page_buffer) {
+            return 0;
+        }
         page_header = (PageHeader *)page_buffer;
-        page_header->slot_count = 0;
-        page_header->free_space_offset = sizeof(PageHeader);
-        page_header->next_page = 0;
-        page_num = new_page_num;
     }
 
     // Write record
     uint8_t *write_ptr = (uint8_t *)page_buffer + page_header->free_space_offset;
-    serializeRecord(write_ptr, record);
+    if (serializeRow(db, codec, write_ptr, record) != 0) {
+        return 0;
+    }
 
     // Update page header
     page_header->slot_count++;
     page_header->free_space_offset += (uint16_t)record_size;
 
-    markPageDirty(db->buffer_pool, page_num);
-
-    // Persist updated next_record_id to schema
-    updateTableSchema(db, schema);
-    free(schema);
+    markRowPageDirty(db, schema, page_num);
 
+    if (addZoneMapRow(db, schema->table_id, page_num, record) != 0) {
+        return 0;
+    }
     return record->record_id;
 }
 
+uint64_t appendRecord(MagBase *db, TableSchemaRecord *schema, Record *record) {
+    if (!db || !schema || !record) {
+        return 0;
+    }
+    return storeRecord(db, schema, record, 0);
+}
+
 Record *readRecord(MagBase *db, uint16_t table_id, uint64_t record_id) {
     if (!db || table_id == 0 || record_id == 0) {
         return NULL;
     }
 
-    TableSchemaRecord *schema = readTableSchema(db, table_id);
-    if (!schema) {
+    TableSchemaRecord schema;
+    if (copyTableSchema(db, table_id, &schema) != 0) {
+        return NULL;
+    }
+    const RowCodec *codec = getRowCodec(db, table_id);
+    Record *record = codec ? createRecord(table_id, schema.column_count) : NULL;
+    if (!record) {
         return NULL;
     }
 
-    uint64_t page_num = schema->root_page;
+    // Updated records have older versions too, the snapshot sees one of them at most
+    Snapshot snapshot = takeSnapshot(db);
+    uint64_t page_num = schema.root_page;
 
     while (page_num != 0) {
         char *page_buffer = readPageFromBuffer(db->buffer_pool, page_num, db->file_pointer, db->page_size);
         if (!page_buffer) {
-            free(schema);
-            return NULL;
+            break;
         }
 
         PageHeader *page_header = (PageHeader *)page_buffer;
         uint8_t *record_ptr = (uint8_t *)page_buffer + sizeof(PageHeader);
 
-        // Search through records in this page
+        // Search through records in this page, only the one asked for is decoded
         for (uint16_t i = 0; i < page_header->slot_count; i++) {
-            Record *record = createRecord(table_id, schema->column_count);
-            if (!record) {
-                free(schema);
-                return NULL;
+            uint8_t *row = record_ptr;
+            if (rowRecordId(db, row) == record_id && rowVisible(db, &snapshot, row)) {
+                deserializeRow(db, codec, row, record);
+                return record;
             }
+            record_ptr += skipRow(db, codec, row, record);
+        }
 
-            deserializeRecord(record_ptr, record);
+        page_num = page_header->next_page;
+    }
 
-            if (record->record_id == record_id) {
-                free(schema);
-                return record;
-            }
+    freeRecord(record);
+    return NULL;
+}
+
+// Where a row sits, rows of 1.4 files only move when their page is compacted
+typedef struct {
+    uint64_t page_num;
+    uint16_t offset;
+    uint16_t size;
+} RowLocation;
+
+// Find the live version of a record as the writer sees it, every other one is deleted
+// Returns 0 if found, -1 otherwise
+static int findLiveRow(MagBase *db, TableSchemaRecord *schema, uint64_t record_id, RowLocation *location) {
+    const RowCodec *codec = getRowCodec(db, schema->table_id);
+    Record *scratch = codec ? createRecord(schema->table_id, schema->column_count) : NULL;
+    if (!scratch) {
+        return -1;
+    }
 
-            size_t consumed = getRecordSize(record);
-            freeRecord(record);
-            record_ptr += consumed;
+    int found = -1;
+    uint64_t page_num = schema->root_page;
+    while (page_num != 0 && found != 0) {
+        char *page_buffer = readPageFromBuffer(db->buffer_pool, page_num, db->file_pointer, db->page_size);
+        if (!page_buffer) {
+            break;
         }
 
+        PageHeader *page_header = (PageHeader *)page_buffer;
+        uint16_t offset = sizeof(PageHeader);
+        for (uint16_t i = 0; i < page_header->slot_count; i++) {
+            uint8_t *row = (uint8_t *)page_buffer + offset;
+            size_t size = skipRow(db, codec, row, scratch);
+
+            RowVersion version;
+            memcpy(&version, row, sizeof(RowVersion));
+            if (version.deleted_txn == 0 && rowRecordId(db, row) == record_id) {
+                location->page_num = page_num;
+                location->offset = offset;
+                location->size = (uint16_t)size;
+                found = 0;
+                break;
+            }
+            offset += (uint16_t)size;
+        }
         page_num = page_header->next_page;
     }
 
-    free(schema);
-    return NULL;
+    freeRecord(scratch);
+    return found;
+}
+
+// Mark a row deleted by the writer's transaction, snapshots older than its commit still see it.
+// The row keeps its place, its page counts the bytes compacting would free
+// Returns 0 on success, -1 on error
+static int markRowDeleted(MagBase *db, const TableSchemaRecord *schema, const RowLocation *location) {
+    char *page_buffer = readPageFromBuffer(db->buffer_pool, location->page_num, db->file_pointer, db->page_size);
+    if (!page_buffer) {
+        return -1;
+    }
+
+    uint8_t *row = (uint8_t *)page_buffer + location->offset;
+    RowVersion version;
+    memcpy(&version, row, sizeof(RowVersion));
+    version.deleted_txn = writerTxn(db);
+    memcpy(row, &version, sizeof(RowVersion));
+
+    PageHeader *page_header = (PageHeader *)page_buffer;
+    page_header->dead_count++;
+    page_header->dead_bytes += location->size;
+    markRowPageDirty(db, schema, location->page_num);
+    return 0;
 }
 
 int updateRecord(MagBase *db, Record *record) {
@@ -320,18 +623,36 @@ int updateRecord(MagBase *db, Record *record) {
         return -1;
     }
 
-    TableSchemaRecord *schema = readTableSchema(db, record->table_id);
+    TableSchemaRecord *schema = getTableSchema(db, record->table_id);
     if (!schema) {
         return -1;
     }
 
-    uint64_t page_num = schema->root_page;
+    if (db->version_size > 0) {
+        // The old version is marked first: making room may compact pages, which moves rows but
+        // keeps the ones the writer's own transaction deleted. It stays where it is until vacuum,
+        // the new version goes to its page when compacting that frees enough, so a table whose
+        // rows are rewritten over and over stops growing
+        RowLocation location;
+        if (findLiveRow(db, schema, record->record_id, &location) != 0 ||
+            markRowDeleted(db, schema, &location) != 0) {
+            return -1;
+        }
+        return storeRecord(db, schema, record, location.page_num) != 0 ? 0 : -1;
+    }
 
-    while (page_num != 0) {
+    Record *temp_record = createRecord(schema->table_id, schema->column_count);
+    if (!temp_record) {
+        return -1;
+    }
+
+    int status = -1;
+    bool found = false;
+    uint64_t page_num = schema->root_page;
+    while (page_num != 0 && !found) {
         char *page_buffer = readPageFromBuffer(db->buffer_pool, page_num, db->file_pointer, db->page_size);
         if (!page_buffer) {
-            free(schema);
-            return -1;
+            break;
         }
 
         PageHeader *page_header = (PageHeader *)page_buffer;
@@ -339,46 +660,34 @@ int updateRecord(MagBase *db, Record *record) {
 
         // Find the record to update
         for (uint16_t i = 0; i < page_header->slot_count; i++) {
-            Record temp_record = {0};
-            temp_record.fields = malloc(schema->column_count * sizeof(RecordField));
-            if (!temp_record.fields) {
-                free(schema);
-                return -1;
+            size_t old_size = deserializeRecord(record_ptr, temp_record);
+            if (temp_record->record_id != record->record_id) {
+                record_ptr += old_size;
+                continue;
             }
-            temp_record.field_count = schema->column_count;
-
-            deserializeRecord(record_ptr, &temp_record);
-
-            if (temp_record.record_id == record->record_id) {
-                // Found it - only allow updates if new record is same size or smaller
-                size_t old_size = getRecordSize(&temp_record);
-                size_t new_size = getRecordSize(record);
-                
-                if (new_size <= old_size) {
-                    // Safe to update in place
-                    serializeRecord(record_ptr, record);
-                    markPageDirty(db->buffer_pool, page_num);
-                    free(temp_record.fields);
-                    free(schema);
-                    return 0;
-                } else {
-                    // Record is getting larger - cannot update in place
-                    free(temp_record.fields);
-                    free(schema);
-                    return -1;
-                }
+
+            // Found it - the records after it move by the change in size, so a record may
+            // only grow into the free space of its page
+            found = true;
+            size_t new_size = getRecordSize(record);
+            if (new_size > old_size && new_size - old_size > db->usable_page_size - page_header->free_space_offset) {
+                break;
             }
 
-            size_t consumed = getRecordSize(&temp_record);
-            free(temp_record.fields);
-            record_ptr += consumed;
+            uint8_t *page_end = (uint8_t *)page_buffer + page_header->free_space_offset;
+            memmove(record_ptr + new_size, record_ptr + old_size, page_end - (record_ptr + old_size));
+            serializeRecord(record_ptr, record);
+            page_header->free_space_offset = (uint16_t)(page_header->free_space_offset + new_size - old_size);
+            markRowPageDirty(db, schema, page_num);
+            status = 0;
+            break;
         }
 
         page_num = page_header->next_page;
     }
 
-    free(schema);
-    return -1;  // Record not found
+    freeRecord(temp_record);
+    return status;
 }
 
 int deleteRecord(MagBase *db, uint16_t table_id, uint64_t record_id) {
@@ -386,18 +695,30 @@ int deleteRecord(MagBase *db, uint16_t table_id, uint64_t record_id) {
         return -1;
     }
 
-    TableSchemaRecord *schema = readTableSchema(db, table_id);
+    TableSchemaRecord *schema = getTableSchema(db, table_id);
     if (!schema) {
         return -1;
     }
 
-    uint64_t page_num = schema->root_page;
+    if (db->version_size > 0) {
+        RowLocation location;
+        if (findLiveRow(db, schema, record_id, &location) != 0) {
+            return -1;
+        }
+        return markRowDeleted(db, schema, &location);
+    }
 
-    while (page_num != 0) {
+    Record *temp_record = createRecord(table_id, schema->column_count);
+    if (!temp_record) {
+        return -1;
+    }
+
+    int status = -1;
+    uint64_t page_num = schema->root_page;
+    while (page_num != 0 && status != 0) {
         char *page_buffer = readPageFromBuffer(db->buffer_pool, page_num, db->file_pointer, db->page_size);
         if (!page_buffer) {
-            free(schema);
-            return -1;
+            break;
         }
 
         PageHeader *page_header = (PageHeader *)page_buffer;
@@ -405,42 +726,29 @@ int deleteRecord(MagBase *db, uint16_t table_id, uint64_t record_id) {
 
         // Find and remove the record
         for (uint16_t i = 0; i < page_header->slot_count; i++) {
-            Record temp_record = {0};
-            temp_record.fields = malloc(schema->column_count * sizeof(RecordField));
-            if (!temp_record.fields) {
-                free(schema);
-                return -1;
+            size_t consumed = deserializeRecord(record_ptr, temp_record);
+            if (temp_record->record_id != record_id) {
+                record_ptr += consumed;
+                continue;
             }
-            temp_record.field_count = schema->column_count;
-
-            deserializeRecord(record_ptr, &temp_record);
-
-            if (temp_record.record_id == record_id) {
-                // Found it - shift remaining records back
-                size_t consumed = getRecordSize(&temp_record);
-                uint8_t *next_record_ptr = record_ptr + consumed;
-                size_t remaining = page_header->free_space_offset - (size_t)(next_record_ptr - (uint8_t *)page_buffer);
-
-                memmove(record_ptr, next_record_ptr, remaining);
 
-                page_header->slot_count--;
-                page_header->free_space_offset -= (uint16_t)consumed;
+            // Found it - shift remaining records back
+            uint8_t *next_record_ptr = record_ptr + consumed;
+            size_t remaining = page_header->free_space_offset - (size_t)(next_record_ptr - (uint8_t *)page_buffer);
+            memmove(record_ptr, next_record_ptr, remaining);
 
-                markPageDirty(db->buffer_pool, page_num);
-                free(temp_record.fields);
-                free(schema);
-                return 0;
-            }
-
-            free(temp_record.fields);
-            record_ptr += getRecordSize(&temp_record);
+            page_header->slot_count--;
+            page_header->free_space_offset -= (uint16_t)consumed;
+            markRowPageDirty(db, schema, page_num);
+            status = 0;
+            break;
         }
 
         page_num = page_header->next_page;
     }
 
-    free(schema);
-    return -1;
+    freeRecord(temp_record);
+    return status;
 }
 
 Record **readAllRecords(MagBase *db, uint16_t table_id, uint64_t *num_records) {
@@ -448,19 +756,18 @@ Record **readAllRecords(MagBase *db, uint16_t table_id, uint64_t *num_records) {
         return NULL;
     }
 
-    TableSchemaRecord *schema = readTableSchema(db, table_id);
-    if (!schema) {
+    TableSchemaRecord schema;
+    if (copyTableSchema(db, table_id, &schema) != 0) {
         return NULL;
     }
 
-    // First pass: count records
+    // First pass: count records, with the versions a snapshot may skip
     uint64_t total_records = 0;
-    uint64_t page_num = schema->root_page;
+    uint64_t page_num = schema.root_page;
 
     while (page_num != 0) {
         char *page_buffer = readPageFromBuffer(db->buffer_pool, page_num, db->file_pointer, db->page_size);
         if (!page_buffer) {
-            free(schema);
             return NULL;
         }
 
@@ -471,55 +778,347 @@ Record **readAllRecords(MagBase *db, uint16_t table_id, uint64_t *num_records) {
 
     if (total_records == 0) {
         *num_records = 0;
-        free(schema);
         return NULL;
     }
 
-    // Allocate array
-    Record **records = malloc(total_records * sizeof(Record *));
+    // Allocate array, and a record that invisible rows are skipped with
+    const RowCodec *codec = getRowCodec(db, table_id);
+    Record *scratch = codec ? createRecord(table_id, schema.column_count) : NULL;
+    Record **records = scratch ? malloc(total_records * sizeof(Record *)) : NULL;
     if (!records) {
-        free(schema);
+        freeRecord(scratch);
         return NULL;
     }
 
     // Second pass: read all records
+    Snapshot snapshot = takeSnapshot(db);
     uint64_t record_index = 0;
-    page_num = schema->root_page;
+    page_num = schema.root_page;
 
-    while (page_num != 0) {
+    while (page_num != 0 && record_index < total_records) {
         char *page_buffer = readPageFromBuffer(db->buffer_pool, page_num, db->file_pointer, db->page_size);
         if (!page_buffer) {
             for (uint64_t i = 0; i < record_index; i++) {
                 freeRecord(records[i]);
             }
             free(records);
-            free(schema);
+            freeRecord(scratch);
             return NULL;
         }
 
         PageHeader *page_header = (PageHeader *)page_buffer;
         uint8_t *record_ptr = (uint8_t *)page_buffer + sizeof(PageHeader);
 
-        for (uint16_t i = 0; i < page_header->slot_count; i++) {
-            Record *record = createRecord(table_id, schema->column_count);
+        for (uint16_t i = 0; i < page_header->slot_count && record_index < total_records; i++) {
+            uint8_t *row = record_ptr;
+            if (!rowVisible(db, &snapshot, row)) {
+                record_ptr += skipRow(db, codec, row, scratch);
+                continue;
+            }
+
+            Record *record = createRecord(table_id, schema.column_count);
             if (!record) {
                 for (uint64_t j = 0; j < record_index; j++) {
                     freeRecord(records[j]);
                 }
                 free(records);
-                free(schema);
+                freeRecord(scratch);
                 return NULL;
             }
-
-            deserializeRecord(record_ptr, record);
+            record_ptr += deserializeRow(db, codec, row, record);
             records[record_index++] = record;
-            record_ptr += getRecordSize(record);
         }
 
         page_num = page_header->next_page;
     }
 
-    *num_records = total_records;
-    free(schema);
+    freeRecord(scratch);
+    *num_records = record_index;
     return records;
 }
+
+RecordScan *openRecordScan(MagBase *db, uint16_t table_id) {
+    if (!db || table_id == 0) {
+        return NULL;
+    }
+
+    TableSchemaRecord *schema = readTableSchema(db, table_id);
+    const RowCodec *codec = getRowCodec(db, table_id);
+    if (!schema || !codec) {
+        free(schema);
+        return NULL;
+    }
+
+    RecordScan *scan = malloc(sizeof(RecordScan));
+    if (!scan) {
+        free(schema);
+        return NULL;
+    }
+
+    scan->db = db;
+    scan->schema = schema;
+    scan->codec = codec;
+    scan->filter = NULL;
+    scan->snapshot = takeSnapshot(db);
+    scan->page_num = schema->root_page;
+    scan->pages = NULL;
+    scan->page_count = 0;
+    scan->page_index = 0;
+    scan->slot = 0;
+    scan->offset = sizeof(PageHeader);
+    scan->rows_scanned = 0;
+    scan->rows_matched = 0;
+    scan->pages_skipped = 0;
+    return scan;
+}
+
+// Walk the pages of a filtered scan the zone map does not rule out, instead of the whole chain
+// Returns 0 on success, -1 on error
+static int pruneScanPages(RecordScan *scan) {
+    uint64_t *pages = NULL;
+    uint64_t page_count = 0;
+    if (readTablePages(scan->db, scan->schema, &pages, &page_count) != 0) {
+        return -1;
+    }
+
+    int64_t removed = pruneTablePages(scan->db, scan->schema, scan->filter, pages, &page_count);
+    if (removed <= 0) {
+        free(pages);
+        return removed < 0 ? -1 : 0;
+    }
+    scan->pages = pages;
+    scan->page_count = page_count;
+    scan->page_num = pages[0];
+    scan->pages_skipped = (uint64_t)removed;
+    return 0;
+}
+
+RecordScan *openFilteredScan(MagBase *db, uint16_t table_id, const Filter *filter) {
+    RecordScan *scan = openRecordScan(db, table_id);
+    if (scan && filter && filter->count > 0) {
+        scan->filter = malloc(sizeof(Filter));
+        if (!scan->filter) {
+            closeRecordScan(scan);
+            return NULL;
+        }
+        *scan->filter = *filter;
+        bindFilterCodes(scan->filter, scan->codec);
+        if (scan->schema->zone_map_page != 0 && pruneScanPages(scan) != 0) {
+            closeRecordScan(scan);
+            return NULL;
+        }
+    }
+    return scan;
+}
+
+int nextRecord(RecordScan *scan, Record *record) {
+    if (!scan || !record) {
+        return -1;
+    }
+
+    while (scan->page_num != 0) {
+        // The page is looked up again on every call since the buffer pool may have evicted it
+        char *page_buffer = readPageFromBuffer(scan->db->buffer_pool, scan->page_num,
+                                               scan->db->file_pointer, scan->db->page_size);
+        if (!page_buffer) {
+            return -1;
+        }
+
+        PageHeader *page_header = (PageHeader *)page_buffer;
+        while (scan->slot < page_header->slot_count) {
+            uint8_t *row = (uint8_t *)page_buffer + scan->offset;
+            record->field_count = scan->schema->column_count;
+            scan->slot++;
+            if (!rowVisible(scan->db, &scan->snapshot, row)) {
+                scan->offset += (uint16_t)skipRow(scan->db, scan->codec, row, record);
+                continue;
+            }
+            scan->rows_scanned++;
+
+            // Encoded rows are filtered before they are decoded
+            if (scan->filter && scan->db->compact_rows &&
+                !rowMatchesFilter(scan->filter, scan->codec, row + scan->db->version_size)) {
+                scan->offset += (uint16_t)skipRow(scan->db, scan->codec, row, record);
+                continue;
+            }
+            scan->offset += (uint16_t)deserializeRow(scan->db, scan->codec, row, record);
+
+            if (!scan->filter || scan->db->compact_rows || recordMatchesFilter(scan->filter, record)) {
+                scan->rows_matched++;
+                return 1;
+            }
+        }
+
+        // Pages added since the scan opened follow the last listed one
+        if (scan->pages && ++scan->page_index < scan->page_count) {
+            scan->page_num = scan->pages[scan->page_index];
+        } else {
+            scan->page_num = page_header->next_page;
+        }
+        scan->slot = 0;
+        scan->offset = sizeof(PageHeader);
+    }
+
+    return 0;
+}
+
+void closeRecordScan(RecordScan *scan) {
+    if (scan) {
+        free(scan->schema);
+        free(scan->filter);
+        free(scan->pages);
+        free(scan);
+    }
+}
+
+uint64_t countRecords(MagBase *db, uint16_t table_id, uint64_t *page_count) {
+    if (page_count) {
+        *page_count = 0;
+    }
+
+    TableSchemaRecord schema;
+    if (copyTableSchema(db, table_id, &schema) != 0) {
+        return 0;
+    }
+
+    // Only page headers are touched, no record is decoded
+    uint64_t total_records = 0;
+    uint64_t page_num = schema.root_page;
+    while (page_num != 0) {
+        char *page_buffer = readPageFromBuffer(db->buffer_pool, page_num, db->file_pointer, db->page_size);
+        if (!page_buffer) {
+            break;
+        }
+
+        PageHeader *page_header = (PageHeader *)page_buffer;
+        total_records += page_header->slot_count - (db->version_size > 0 ? page_header->dead_count : 0);
+        page_num = page_header->next_page;
+        if (page_count) {
+            (*page_count)++;
+        }
+    }
+
+    return total_records;
+}
+
+int vacuumTable(MagBase *db, uint16_t table_id, uint64_t *removed) {
+    *removed = 0;
+    TableSchemaRecord *schema = getTableSchema(db, table_id);
+    if (!schema) {
+        return -1;
+    }
+    if (db->version_size == 0) {
+        return 0;
+    }
+    const RowCodec *codec = getRowCodec(db, table_id);
+    Record *record = codec ? createRecord(table_id, schema->column_count) : NULL;
+    if (!record) {
+        return -1;
+    }
+
+    // Inserts that find the last page full go on to the first page before it with room
+    int status = 0;
+    uint64_t free_page = getFreeTablePage(db, table_id);
+    uint64_t first_free = 0;
+    uint64_t page_num = schema->root_page;
+    while (page_num != 0) {
+        char *page_buffer = readPageFromBuffer(db->buffer_pool, page_num, db->file_pointer, db->page_size);
+        if (!page_buffer) {
+            status = -1;
+            break;
+        }
+
+        PageHeader *page_header = (PageHeader *)page_buffer;
+        bool compacted = false;
+        if (page_header->dead_count > 0) {
+            uint16_t page_removed = compactPage(db, codec, page_buffer, record);
+            *removed += page_removed;
+            compacted = page_removed > 0;
+            markRowPageDirty(db, schema, page_num);
+        }
+        if (first_free == 0 && page_header->next_page != 0 && (compacted || page_num == free_page)) {
+            first_free = page_num;
+        }
+        page_num = page_header->next_page;
+    }
+
+    freeRecord(record);
+    if (status == 0) {
+        setFreeTablePage(db, table_id, first_free);
+    }
+    return status;
+}
+
+int setTableCompression(MagBase *db, uint16_t table_id, bool compressed, uint64_t *pages) {
+    *pages = 0;
+    TableSchemaRecord *schema = getTableSchema(db, table_id);
+    if (!schema || !hasTableFlags(db)) {
+        return -1;
+    }
+    if (compressed && db->page_size <= COMPRESS_BLOCK_SIZE) {
+        fprintf(stderr, "Compression needs pages larger than %d bytes, this database has %zu byte pages\n",
+                COMPRESS_BLOCK_SIZE, db->page_size);
+        return -1;
+    }
+
+    if (compressed) {
+        schema->flags |= TABLE_COMPRESSED;
+    } else {
+        schema->flags &= (uint16_t)~TABLE_COMPRESSED;
+    }
+    if (updateTableSchema(db, schema) != 0) {
+        return -1;
+    }
+
+    // Nothing in the pages changes, they are only written again in the new form
+    uint64_t page_num = schema->root_page;
+    while (page_num != 0) {
+        char *page_buffer = readPageFromBuffer(db->buffer_pool, page_num, db->file_pointer, db->page_size);
+        if (!page_buffer) {
+            return -1;
+        }
+        markPageDirty(db->buffer_pool, page_num);
+        markPageCompressed(db->buffer_pool, page_num, compressed);
+        (*pages)++;
+        page_num = ((PageHeader *)page_buffer)->next_page;
+    }
+    return 0;
+}
+
+int compareFields(RecordField *a, RecordField *b) {
+    switch (a->type) {
+        case COL_INT:
+            return (a->value.int_val > b->value.int_val) - (a->value.int_val < b->value.int_val);
+        case COL_BOOL:
+            return (int)a->value.bool_val - (int)b->value.bool_val;
+        case COL_TEXT:
+            return strcmp(a->value.text_val, b->value.text_val);
+    }
+    return 0;
+}
+
+// fmix64 of MurmurHash3: every input bit reaches every output bit, the top ones included
+static uint64_t mixHash(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xFF51AFD7ED558CCDULL;
+    x ^= x >> 33;
+    x *= 0xC4CEB9FE1A85EC53ULL;
+    return x ^ (x >> 33);
+}
+
+uint64_t hashRecordField(RecordField *field) {
+    if (field->type != COL_TEXT) {
+        uint64_t x = field->type == COL_INT ? (uint64_t)(uint32_t)field->value.int_val
+                                            : (uint64_t)field->value.bool_val;
+        return mixHash(x + 0x9E3779B97F4A7C15ULL);
+    }
+
+    // FNV-1a leaves the last characters in the low bits, values differing only there would
+    // share the top bits HyperLogLog and the join partitions look at
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    for (const unsigned char *c = (const unsigned char *)field->value.text_val; *c; c++) {
+        hash ^= *c;
+        hash *= 0x100000001B3ULL;
+    }
+    return mixHash(hash);
+}
@@ -8,6 +8,7 @@
 
 #include "db-init.h"
 #include "structs/schemaStruct.h"
+#include <stdbool.h>
 #include <stdint.h>
 
 // Maximum size for a record value (for text fields)
@@ -32,6 +33,37 @@ typedef struct {
     uint16_t field_count;               // Number of fields
 } Record;
 
+// The row versions a reader sees: those of transactions committed when it was taken, and the
+// writer's own uncommitted rows when the writer took it
+typedef struct {
+    uint64_t next_txn;                  // Transactions from this id on started later
+    uint64_t writing_txn;               // Not committed when the snapshot was taken, 0 if none
+    bool own_writes;                    // Taken by the writer, which sees writing_txn's rows
+} Snapshot;
+
+struct Filter;
+struct RowCodec;
+
+// Forward cursor over the records of one table, following the page chain
+typedef struct {
+    MagBase *db;
+    TableSchemaRecord *schema;          // Owned by the scan
+    const struct RowCodec *codec;       // Codec plan of the table, owned by the catalog
+    struct Filter *filter;              // Rows not matching are skipped, NULL for every row. A copy
+                                        // bound to the table's dictionaries, owned by the scan
+    Snapshot snapshot;                  // Taken when the scan opened, rows written later are skipped
+    uint64_t page_num;                  // Current page, 0 once the chain is exhausted
+    uint64_t *pages;                    // Pages of a filtered scan the zone map does not rule out, the
+                                        // chain goes on from the last. NULL to follow the chain
+    uint64_t page_count;
+    uint64_t page_index;                // Index of the current page in pages
+    uint16_t slot;                      // Next slot to read in the current page
+    uint16_t offset;                    // Byte offset of that slot in the page
+    uint64_t rows_scanned;              // Visible rows read so far
+    uint64_t rows_matched;              // Rows returned so far
+    uint64_t pages_skipped;             // Pages the zone map ruled out, never read
+} RecordScan;
+
 // Create a new empty record for a table
 // Returns a pointer to the record, caller must free it
 Record *createRecord(uint16_t table_id, uint16_t field_count);
@@ -43,21 +75,110 @@ void freeRecord(Record *record);
 // Returns the record_id of the inserted record, or 0 on error
 uint64_t insertRecord(MagBase *db, Record *record);
 
-// Read a record by record_id and table_id
+// Insert a record with a schema the caller already holds, for many inserts in a row. When the
+// last page is full but its deleted rows would make room, it is compacted if db->compact_pages.
+// Otherwise the pages vacuumTable left room in are filled before the table gets a new page
+// Returns the record_id of the inserted record, or 0 on error
+uint64_t appendRecord(MagBase *db, TableSchemaRecord *schema, Record *record);
+
+// Read a record by record_id and table_id, the version visible in a snapshot taken now
 // Returns a pointer to the record (allocated), or NULL if not found
 // Caller must free the returned record
 Record *readRecord(MagBase *db, uint16_t table_id, uint64_t record_id);
 
-// Update an existing record
+// Update an existing record. From 1.4 on the old version is marked deleted and the new one
+// written to its page when that has room once compacted, otherwise appended to the table. Older
+// files rewrite the row in place, where it may only grow into the free space of its page
 // Returns 0 on success, -1 on error
 int updateRecord(MagBase *db, Record *record);
 
-// Delete a record by record_id and table_id
+// Delete a record by record_id and table_id. From 1.4 on the row is only marked deleted, it
+// takes up its space until its page is compacted by vacuumTable or an append that needs it.
+// Older files have no room for the mark, the rows after it move down at once
 // Returns 0 on success, -1 on error
 int deleteRecord(MagBase *db, uint16_t table_id, uint64_t record_id);
 
+// Remove the row versions deleted or replaced by committed writes and compact the pages of a
+// table. Nothing may read the table meanwhile, the rows after a removed one move. removed gets
+// the number of versions removed. The file does not shrink, inserts reuse the space
+// Returns 0 on success (nothing to do before 1.4), -1 on error
+int vacuumTable(MagBase *db, uint16_t table_id, uint64_t *removed);
+
+// Turn page compression of a table on or off (1.6 files). Every data page of the table is
+// marked dirty, it is stored in the new form when it is next written to the file. pages gets
+// the number of pages. A page is only stored compressed when that frees a COMPRESS_BLOCK_SIZE
+// block, so turning it on needs a larger page size
+// Returns 0 on success, -1 for older files, pages too small to compress or on error
+int setTableCompression(MagBase *db, uint16_t table_id, bool compressed, uint64_t *pages);
+
+// Returns a snapshot of the committed transactions, as of now. The writer's own snapshot
+// includes its uncommitted rows
+Snapshot takeSnapshot(MagBase *db);
+
+// Returns true if the row starting at row is visible in the snapshot, always before 1.4
+bool rowVisible(MagBase *db, const Snapshot *snapshot, const uint8_t *row);
+
 // Read all records from a table
 // Returns an array of Record pointers
 // num_records is set to the count of records found
 // Caller must free each record and the array itself
 Record **readAllRecords(MagBase *db, uint16_t table_id, uint64_t *num_records);
+
+// Serialize a record into a buffer, the buffer must hold getRecordSize(record) bytes
+void serializeRecord(uint8_t *buffer, Record *record);
+
+// Deserialize a record from a buffer, record->fields must hold MAX_COLUMNS or field_count entries
+// Returns the number of bytes consumed
+size_t deserializeRecord(uint8_t *buffer, Record *record);
+
+// Calculate the serialized size of a record
+size_t getRecordSize(Record *record);
+
+// Serialize a record as a row of a data page: from 1.4 on its RowVersion, created by the
+// writer's transaction, comes first. From 1.5 on the record is encoded by the codec plan of
+// its table (see row-codec.h). The buffer must hold getRowSize(db, codec, record) bytes
+// Returns 0 on success, -1 if a value of a dictionary column has no code
+int serializeRow(MagBase *db, const struct RowCodec *codec, uint8_t *buffer, Record *record);
+
+// Deserialize a row of a data page of the codec's table, whatever its version. record->fields
+// must hold the table's column_count entries
+// Returns the number of bytes consumed
+size_t deserializeRow(MagBase *db, const struct RowCodec *codec, uint8_t *buffer, Record *record);
+
+// Calculate the size of a record as a row of a data page
+size_t getRowSize(MagBase *db, const struct RowCodec *codec, Record *record);
+
+// Returns the record_id of a row of a data page, without decoding the row
+uint64_t rowRecordId(MagBase *db, const uint8_t *row);
+
+// Returns the bytes a row of a data page takes up. Rows from 1.5 on are not decoded, older
+// ones are decoded into scratch, which must hold the table's column_count fields
+size_t skipRow(MagBase *db, const struct RowCodec *codec, uint8_t *row, Record *scratch);
+
+// Open a streaming scan over a table, only one page is touched at a time
+// Returns NULL if the table does not exist, caller must close it with closeRecordScan
+RecordScan *openRecordScan(MagBase *db, uint16_t table_id);
+
+// Open a streaming scan that only returns records matching filter (which may be NULL). Pages
+// the table's zone map rules out are not read
+RecordScan *openFilteredScan(MagBase *db, uint16_t table_id, const struct Filter *filter);
+
+// Read the next record of the scan into a record created with createRecord
+// Returns 1 if a record was read, 0 at the end of the table, -1 on error
+int nextRecord(RecordScan *scan, Record *record);
+
+// Close a scan and free its schema, filter and pages
+void closeRecordScan(RecordScan *scan);
+
+// Count the records of a table from the page headers, page_count (optional) gets the page count.
+// Rows the writer has not committed yet are counted as if they were
+// Returns 0 if the table does not exist
+uint64_t countRecords(MagBase *db, uint16_t table_id, uint64_t *page_count);
+
+// Compare two non NULL values of the same type
+// Returns <0, 0 or >0 like strcmp
+int compareFields(RecordField *a, RecordField *b);
+
+// 64 bit hash of a non NULL value, finished with a mixer so every bit (the top ones that
+// HyperLogLog indexes with too) depends on the whole value
+uint64_t hashRecordField(RecordField *field);
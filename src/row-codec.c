@@ -0,0 +1,312 @@
+//     Keagan Anderson
+//        MagBase
+//       10/19/2026
+//
+//     Compact row encoding and codec plans (see row-codec.h)
+
+#include "row-codec.h"
+#include "dictionary.h"
+#include <string.h>
+
+static size_t varintSize(uint64_t value) {
+    size_t size = 1;
+    while (value >= 0x80) {
+        value >>= 7;
+        size++;
+    }
+    return size;
+}
+
+// Write value 7 bits a byte, low bits first, the high bit set on every byte but the last
+// Returns the position after it
+static uint8_t *putVarint(uint8_t *ptr, uint64_t value) {
+    while (value >= 0x80) {
+        *ptr++ = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    *ptr++ = (uint8_t)value;
+    return ptr;
+}
+
+static const uint8_t *getVarint(const uint8_t *ptr, uint64_t *value) {
+    uint64_t result = 0;
+    int shift = 0;
+    while ((*ptr & 0x80) && shift < 63) {
+        result |= (uint64_t)(*ptr++ & 0x7f) << shift;
+        shift += 7;
+    }
+    result |= (uint64_t)*ptr++ << shift;
+    *value = result;
+    return ptr;
+}
+
+static bool bitSet(const uint8_t *bitmap, uint16_t column) { return (bitmap[column / 8] >> (column % 8)) & 1; }
+
+static bool fieldIsNull(Record *record, uint16_t column) {
+    return column >= record->field_count || record->fields[column].is_null;
+}
+
+// End offset of a text slot in the text bytes, the slot before it gives the start
+static uint16_t textEnd(const uint8_t *table, uint16_t slot) {
+    uint16_t end;
+    memcpy(&end, table + slot * sizeof(uint16_t), sizeof(uint16_t));
+    return end;
+}
+
+static void decodeText(const uint8_t *table, const uint8_t *text, uint16_t slot, RecordField *field) {
+    uint16_t start = slot == 0 ? 0 : textEnd(table, slot - 1);
+    size_t length = (size_t)(textEnd(table, slot) - start);
+    if (length >= MAX_RECORD_VALUE_SIZE) {
+        length = MAX_RECORD_VALUE_SIZE - 1;
+    }
+    memcpy(field->value.text_val, text + start, length);
+    field->value.text_val[length] = '\0';
+}
+
+// Every column is an INT, the fixed section is an array of them
+static size_t decodeAllInt(const RowCodec *codec, const uint8_t *row, Record *record) {
+    const uint8_t *nulls = getVarint(row, &record->record_id);
+    const uint8_t *fixed = nulls + codec->bitmap_size;
+    record->table_id = codec->table_id;
+    record->field_count = codec->column_count;
+
+    for (uint16_t i = 0; i < codec->column_count; i++) {
+        RecordField *field = &record->fields[i];
+        field->type = COL_INT;
+        field->is_null = bitSet(nulls, i);
+        memcpy(&field->value.int_val, fixed + i * sizeof(int32_t), sizeof(int32_t));
+    }
+    return (size_t)(fixed + codec->fixed_size - row);
+}
+
+// Text of the code stored at ptr, a code the dictionary does not have reads as empty text
+static void decodeCode(const RowCodec *codec, uint8_t column, const uint8_t *ptr, RecordField *field) {
+    uint16_t code;
+    memcpy(&code, ptr, sizeof(uint16_t));
+    const DictionaryValue *value = dictionaryValue(codec->dictionaries[column], code);
+    size_t length = value ? value->length : 0;
+    if (length >= MAX_RECORD_VALUE_SIZE) {
+        length = MAX_RECORD_VALUE_SIZE - 1;
+    }
+    if (value) {
+        memcpy(field->value.text_val, value->text, length);
+    }
+    field->value.text_val[length] = '\0';
+}
+
+static void decodeFixedColumns(const RowCodec *codec, const uint8_t *nulls, const uint8_t *fixed, Record *record) {
+    for (uint16_t i = 0; i < codec->int_count; i++) {
+        uint8_t column = codec->int_columns[i];
+        RecordField *field = &record->fields[column];
+        field->type = COL_INT;
+        field->is_null = bitSet(nulls, column);
+        memcpy(&field->value.int_val, fixed + codec->offsets[column], sizeof(int32_t));
+    }
+    for (uint16_t i = 0; i < codec->bool_count; i++) {
+        uint8_t column = codec->bool_columns[i];
+        RecordField *field = &record->fields[column];
+        field->type = COL_BOOL;
+        field->is_null = bitSet(nulls, column);
+        field->value.bool_val = fixed[codec->offsets[column]];
+    }
+    for (uint16_t i = 0; i < codec->dictionary_count; i++) {
+        uint8_t column = codec->dictionary_columns[i];
+        RecordField *field = &record->fields[column];
+        field->type = COL_TEXT;
+        field->is_null = bitSet(nulls, column);
+        if (!field->is_null) {
+            decodeCode(codec, column, fixed + codec->offsets[column], field);
+        }
+    }
+}
+
+// INT, BOOL and dictionary columns only, the row ends with the fixed section
+static size_t decodeFixed(const RowCodec *codec, const uint8_t *row, Record *record) {
+    const uint8_t *nulls = getVarint(row, &record->record_id);
+    const uint8_t *fixed = nulls + codec->bitmap_size;
+    record->table_id = codec->table_id;
+    record->field_count = codec->column_count;
+
+    decodeFixedColumns(codec, nulls, fixed, record);
+    return (size_t)(fixed + codec->fixed_size - row);
+}
+
+// Any shape with TEXT columns
+static size_t decodeWithText(const RowCodec *codec, const uint8_t *row, Record *record) {
+    const uint8_t *nulls = getVarint(row, &record->record_id);
+    const uint8_t *fixed = nulls + codec->bitmap_size;
+    const uint8_t *table = fixed + codec->fixed_size;
+    const uint8_t *text = table + codec->text_count * sizeof(uint16_t);
+    record->table_id = codec->table_id;
+    record->field_count = codec->column_count;
+
+    decodeFixedColumns(codec, nulls, fixed, record);
+    for (uint16_t i = 0; i < codec->text_count; i++) {
+        uint8_t column = codec->text_columns[i];
+        RecordField *field = &record->fields[column];
+        field->type = COL_TEXT;
+        field->is_null = bitSet(nulls, column);
+        if (!field->is_null) {
+            decodeText(table, text, i, field);
+        }
+    }
+    return (size_t)(text + textEnd(table, codec->text_count - 1) - row);
+}
+
+void buildRowCodec(RowCodec *codec, const TableSchemaRecord *schema) {
+    memset(codec, 0, sizeof(RowCodec));
+    codec->table_id = schema->table_id;
+    codec->column_count = schema->column_count <= MAX_COLUMNS ? schema->column_count : MAX_COLUMNS;
+    codec->bitmap_size = (uint16_t)((codec->column_count + 7) / 8);
+
+    for (uint16_t i = 0; i < codec->column_count; i++) {
+        codec->types[i] = schema->columns[i].type;
+        switch (schema->columns[i].type) {
+            case COL_INT:
+                codec->int_columns[codec->int_count++] = (uint8_t)i;
+                codec->offsets[i] = codec->fixed_size;
+                codec->fixed_size += sizeof(int32_t);
+                break;
+            case COL_BOOL:
+                codec->bool_columns[codec->bool_count++] = (uint8_t)i;
+                codec->offsets[i] = codec->fixed_size;
+                codec->fixed_size += sizeof(uint8_t);
+                break;
+            case COL_TEXT:
+                if (schema->dictionary_columns & (1u << i)) {
+                    codec->dictionary_columns[codec->dictionary_count++] = (uint8_t)i;
+                    codec->offsets[i] = codec->fixed_size;
+                    codec->fixed_size += sizeof(uint16_t);
+                    break;
+                }
+                codec->offsets[i] = codec->text_count;
+                codec->text_columns[codec->text_count++] = (uint8_t)i;
+                break;
+        }
+    }
+
+    if (codec->text_count > 0) {
+        codec->decode = decodeWithText;
+    } else if (codec->int_count == codec->column_count) {
+        codec->decode = decodeAllInt;
+    } else {
+        codec->decode = decodeFixed;
+    }
+}
+
+size_t encodeRow(const RowCodec *codec, uint8_t *buffer, Record *record) {
+    uint8_t *nulls = putVarint(buffer, record->record_id);
+    uint8_t *fixed = nulls + codec->bitmap_size;
+    uint8_t *table = fixed + codec->fixed_size;
+    uint8_t *text = table + codec->text_count * sizeof(uint16_t);
+    memset(nulls, 0, codec->bitmap_size + codec->fixed_size);
+
+    for (uint16_t i = 0; i < codec->column_count; i++) {
+        if (fieldIsNull(record, i)) {
+            nulls[i / 8] |= (uint8_t)(1u << (i % 8));
+        }
+    }
+    for (uint16_t i = 0; i < codec->int_count; i++) {
+        uint8_t column = codec->int_columns[i];
+        if (!fieldIsNull(record, column)) {
+            memcpy(fixed + codec->offsets[column], &record->fields[column].value.int_val, sizeof(int32_t));
+        }
+    }
+    for (uint16_t i = 0; i < codec->bool_count; i++) {
+        uint8_t column = codec->bool_columns[i];
+        if (!fieldIsNull(record, column)) {
+            fixed[codec->offsets[column]] = record->fields[column].value.bool_val;
+        }
+    }
+    for (uint16_t i = 0; i < codec->dictionary_count; i++) {
+        uint8_t column = codec->dictionary_columns[i];
+        if (!fieldIsNull(record, column)) {
+            int32_t found = findDictionaryCode(codec->dictionaries[column], record->fields[column].value.text_val);
+            if (found < 0) {
+                return 0;
+            }
+            uint16_t code = (uint16_t)found;
+            memcpy(fixed + codec->offsets[column], &code, sizeof(uint16_t));
+        }
+    }
+
+    uint16_t end = 0;
+    for (uint16_t i = 0; i < codec->text_count; i++) {
+        uint8_t column = codec->text_columns[i];
+        if (!fieldIsNull(record, column)) {
+            size_t length = strlen(record->fields[column].value.text_val);
+            memcpy(text + end, record->fields[column].value.text_val, length);
+            end += (uint16_t)length;
+        }
+        memcpy(table + i * sizeof(uint16_t), &end, sizeof(uint16_t));
+    }
+    return (size_t)(text + end - buffer);
+}
+
+size_t encodedRowSize(const RowCodec *codec, Record *record) {
+    size_t size = varintSize(record->record_id) + codec->bitmap_size + codec->fixed_size +
+                  codec->text_count * sizeof(uint16_t);
+    for (uint16_t i = 0; i < codec->text_count; i++) {
+        uint8_t column = codec->text_columns[i];
+        if (!fieldIsNull(record, column)) {
+            size += strlen(record->fields[column].value.text_val);
+        }
+    }
+    return size;
+}
+
+size_t encodedRowLength(const RowCodec *codec, const uint8_t *row) {
+    uint64_t record_id;
+    const uint8_t *table = getVarint(row, &record_id) + codec->bitmap_size + codec->fixed_size;
+    size_t length = (size_t)(table - row);
+    if (codec->text_count > 0) {
+        length += codec->text_count * sizeof(uint16_t) + textEnd(table, codec->text_count - 1);
+    }
+    return length;
+}
+
+uint64_t decodeRowId(const uint8_t *row) {
+    uint64_t record_id;
+    getVarint(row, &record_id);
+    return record_id;
+}
+
+void decodeRowField(const RowCodec *codec, const uint8_t *row, uint16_t column, RecordField *field) {
+    uint64_t record_id;
+    const uint8_t *nulls = getVarint(row, &record_id);
+    const uint8_t *fixed = nulls + codec->bitmap_size;
+    field->type = codec->types[column];
+    field->is_null = bitSet(nulls, column);
+    if (field->is_null) {
+        return;
+    }
+
+    switch (field->type) {
+        case COL_INT:
+            memcpy(&field->value.int_val, fixed + codec->offsets[column], sizeof(int32_t));
+            break;
+        case COL_BOOL:
+            field->value.bool_val = fixed[codec->offsets[column]];
+            break;
+        case COL_TEXT: {
+            if (codec->dictionaries[column]) {
+                decodeCode(codec, (uint8_t)column, fixed + codec->offsets[column], field);
+                break;
+            }
+            const uint8_t *table = fixed + codec->fixed_size;
+            decodeText(table, table + codec->text_count * sizeof(uint16_t), codec->offsets[column], field);
+            break;
+        }
+    }
+}
+
+int32_t decodeRowCode(const RowCodec *codec, const uint8_t *row, uint16_t column) {
+    uint64_t record_id;
+    const uint8_t *nulls = getVarint(row, &record_id);
+    if (bitSet(nulls, column)) {
+        return -1;
+    }
+    uint16_t code;
+    memcpy(&code, nulls + codec->bitmap_size + codec->offsets[column], sizeof(uint16_t));
+    return code;
+}
@@ -0,0 +1,67 @@
+//     Keagan Anderson
+//        MagBase
+//       10/19/2026
+//
+//     Compact row encoding of 1.5 files, driven by a codec plan built once per table schema:
+//     where every column sits in a row and which decode loop fits the schema's shape
+
+#pragma once
+
+#include "records.h"
+#include "structs/schemaStruct.h"
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct RowCodec RowCodec;
+struct Dictionary;
+
+// Decodes a whole row into a record, returns the bytes the row takes up
+typedef size_t (*RowDecoder)(const RowCodec *codec, const uint8_t *row, Record *record);
+
+// A row is the record_id as a varint, a null bitmap, the fixed section with every INT and BOOL
+// column and the uint16 code of every dictionary column at a fixed offset (null or not), the end
+// offset of every other TEXT column as a uint16 and then the text bytes. Any column is found
+// without looking at the columns before it
+struct RowCodec {
+    uint16_t table_id;
+    uint16_t column_count;
+    uint16_t bitmap_size;               // Bytes of the null bitmap, a bit per column
+    uint16_t fixed_size;                // Bytes of the fixed section
+    uint16_t int_count;
+    uint16_t bool_count;
+    uint16_t text_count;
+    uint16_t dictionary_count;
+    uint8_t int_columns[MAX_COLUMNS];   // The columns of each type, in column order
+    uint8_t bool_columns[MAX_COLUMNS];
+    uint8_t text_columns[MAX_COLUMNS];
+    uint8_t dictionary_columns[MAX_COLUMNS];
+    uint8_t types[MAX_COLUMNS];         // ColumnType of every column
+    uint16_t offsets[MAX_COLUMNS];      // Offset in the fixed section, or slot in the end offset table for TEXT
+    struct Dictionary *dictionaries[MAX_COLUMNS]; // Of the dictionary columns, set by loadDictionaries
+    RowDecoder decode;                  // Loop specialised for the schema's shape
+};
+
+// Build the codec plan of a schema
+void buildRowCodec(RowCodec *codec, const TableSchemaRecord *schema);
+
+// Encode a record, the buffer must hold encodedRowSize(codec, record) bytes. Fields past
+// record->field_count are stored as NULL, the values of dictionary columns must have codes
+// (see addDictionaryValues)
+// Returns the number of bytes written, 0 if a value of a dictionary column has no code
+size_t encodeRow(const RowCodec *codec, uint8_t *buffer, Record *record);
+
+// Bytes a record takes up once encoded
+size_t encodedRowSize(const RowCodec *codec, Record *record);
+
+// Bytes an encoded row takes up, without decoding its fields
+size_t encodedRowLength(const RowCodec *codec, const uint8_t *row);
+
+// The record_id of an encoded row
+uint64_t decodeRowId(const uint8_t *row);
+
+// Decode one column of an encoded row into field
+void decodeRowField(const RowCodec *codec, const uint8_t *row, uint16_t column, RecordField *field);
+
+// The code of a dictionary column in an encoded row
+// Returns the code, or -1 if the column is NULL
+int32_t decodeRowCode(const RowCodec *codec, const uint8_t *row, uint16_t column);
@@ -6,22 +6,52 @@
 
 #include "schema.h"
 #include "buffer.h"
+#include "catalog.h"
+#include "dictionary.h"
 #include "globals.h"
 #include <stdlib.h>
 #include <string.h>
 
+bool hasPageDirectories(MagBase *db) {
+    return db->header->version.major > 1 || (db->header->version.major == 1 && db->header->version.minor >= 1);
+}
+
+bool hasTableFlags(MagBase *db) {
+    return db->header->version.major > 1 || (db->header->version.major == 1 && db->header->version.minor >= 6);
+}
+
+bool hasDictionaries(MagBase *db) {
+    return db->header->version.major > 1 || (db->header->version.major == 1 && db->header->version.minor >= 7);
+}
+
+bool hasZoneMaps(MagBase *db) {
+    return db->header->version.major > 1 || (db->header->version.major == 1 && db->header->version.minor >= 8);
+}
+
 // Calculate the serialized size of a TableSchemaRecord
-static size_t getSchemaRecordSize(TableSchemaRecord *schema) {
+static size_t getSchemaRecordSize(MagBase *db, TableSchemaRecord *schema) {
     // Fixed fields: table_id (2) + column_count (2) + root_page (4) + next_record_id (8) + name_len (2)
     // Variable: table_name (up to MAX_TABLE_NAME) + columns array (MAX_COLUMNS * size)
     size_t size = sizeof(uint16_t) + sizeof(uint16_t) + sizeof(uint32_t) + sizeof(uint64_t) + sizeof(uint16_t);
+    if (hasPageDirectories(db)) {
+        size += sizeof(uint32_t);  // directory_page, files from 1.1 on
+    }
+    if (hasTableFlags(db)) {
+        size += sizeof(uint16_t);  // flags, files from 1.6 on
+    }
+    if (hasDictionaries(db)) {
+        size += sizeof(uint16_t) + sizeof(uint32_t);  // dictionary_columns and dictionary_page, files from 1.7 on
+    }
+    if (hasZoneMaps(db)) {
+        size += sizeof(uint32_t);  // zone_map_page, files from 1.8 on
+    }
     size += schema->name_len;  // actual name length
     size += schema->column_count * sizeof(SchemaColumn);
     return size;
 }
 
 // Serialize a TableSchemaRecord into a buffer
-static void serializeSchemaRecord(uint8_t *buffer, TableSchemaRecord *schema) {
+static void serializeSchemaRecord(MagBase *db, uint8_t *buffer, TableSchemaRecord *schema) {
     uint8_t *ptr = buffer;
 
     // Write fixed fields
@@ -34,6 +64,28 @@ static void serializeSchemaRecord(uint8_t *buffer, TableSchemaRecord *schema) {
     memcpy(ptr, &schema->root_page, sizeof(uint32_t));
     ptr += sizeof(uint32_t);
 
+    if (hasPageDirectories(db)) {
+        memcpy(ptr, &schema->directory_page, sizeof(uint32_t));
+        ptr += sizeof(uint32_t);
+    }
+
+    if (hasTableFlags(db)) {
+        memcpy(ptr, &schema->flags, sizeof(uint16_t));
+        ptr += sizeof(uint16_t);
+    }
+
+    if (hasDictionaries(db)) {
+        memcpy(ptr, &schema->dictionary_columns, sizeof(uint16_t));
+        ptr += sizeof(uint16_t);
+        memcpy(ptr, &schema->dictionary_page, sizeof(uint32_t));
+        ptr += sizeof(uint32_t);
+    }
+
+    if (hasZoneMaps(db)) {
+        memcpy(ptr, &schema->zone_map_page, sizeof(uint32_t));
+        ptr += sizeof(uint32_t);
+    }
+
     memcpy(ptr, &schema->next_record_id, sizeof(uint64_t));
     ptr += sizeof(uint64_t);
 
@@ -62,7 +114,7 @@ static void serializeSchemaRecord(uint8_t *buffer, TableSchemaRecord *schema) {
 
 // Deserialize a TableSchemaRecord from a buffer
 // Returns the number of bytes consumed
-static size_t deserializeSchemaRecord(uint8_t *buffer, TableSchemaRecord *schema) {
+static size_t deserializeSchemaRecord(MagBase *db, uint8_t *buffer, TableSchemaRecord *schema) {
     uint8_t *ptr = buffer;
 
     // Read fixed fields
@@ -81,6 +133,33 @@ static size_t deserializeSchemaRecord(uint8_t *buffer, TableSchemaRecord *schema
     memcpy(&schema->root_page, ptr, sizeof(uint32_t));
     ptr += sizeof(uint32_t);
 
+    schema->directory_page = 0;
+    if (hasPageDirectories(db)) {
+        memcpy(&schema->directory_page, ptr, sizeof(uint32_t));
+        ptr += sizeof(uint32_t);
+    }
+
+    schema->flags = 0;
+    if (hasTableFlags(db)) {
+        memcpy(&schema->flags, ptr, sizeof(uint16_t));
+        ptr += sizeof(uint16_t);
+    }
+
+    schema->dictionary_columns = 0;
+    schema->dictionary_page = 0;
+    if (hasDictionaries(db)) {
+        memcpy(&schema->dictionary_columns, ptr, sizeof(uint16_t));
+        ptr += sizeof(uint16_t);
+        memcpy(&schema->dictionary_page, ptr, sizeof(uint32_t));
+        ptr += sizeof(uint32_t);
+    }
+
+    schema->zone_map_page = 0;
+    if (hasZoneMaps(db)) {
+        memcpy(&schema->zone_map_page, ptr, sizeof(uint32_t));
+        ptr += sizeof(uint32_t);
+    }
+
     memcpy(&schema->next_record_id, ptr, sizeof(uint64_t));
     ptr += sizeof(uint64_t);
 
@@ -126,7 +205,12 @@ int writeTableSchema(MagBase *db, TableSchemaRecord *schema) {
         return -1;
     }
 
-    size_t record_size = getSchemaRecordSize(schema);
+    // Records may move or get new ids, the catalog is read again on the next lookup. The
+    // reserved record ids are saved first, they would be skipped otherwise
+    releaseRecordIds(db);
+    invalidateCatalog(db);
+
+    size_t record_size = getSchemaRecordSize(db, schema);
 
     // Find available space in schema pages, starting from schema_root
     uint64_t page_num = db->header->schema_root;
@@ -148,7 +232,7 @@ int writeTableSchema(MagBase *db, TableSchemaRecord *schema) {
             schema_header->next_schema_page = 0;
         }
         
-        uint16_t available_space = db->page_size - schema_header->free_space_offset;
+        size_t available_space = db->usable_page_size - schema_header->free_space_offset;
 
         // Check if record fits in this page
         if (available_space >= record_size + sizeof(uint16_t)) {  // +2 for offset entry
@@ -160,7 +244,7 @@ int writeTableSchema(MagBase *db, TableSchemaRecord *schema) {
             
             // Write the record
             uint8_t *write_ptr = (uint8_t *)page_buffer + schema_header->free_space_offset;
-            serializeSchemaRecord(write_ptr, schema);
+            serializeSchemaRecord(db, write_ptr, schema);
 
             // Update schema header
             schema_header->free_space_offset += (uint16_t)record_size;
@@ -200,112 +284,194 @@ int writeTableSchema(MagBase *db, TableSchemaRecord *schema) {
     return -1;
 }
 
-TableSchemaRecord *readTableSchema(MagBase *db, uint16_t table_id) {
-    if (!db || table_id == 0) {
+// Walk the schema pages once and collect every schema
+static Catalog *loadCatalog(MagBase *db) {
+    Catalog *catalog = createCatalog();
+    if (!catalog) {
         return NULL;
     }
 
     uint64_t page_num = db->header->schema_root;
+    TableSchemaRecord schema;
 
     while (page_num != 0) {
-        // Read the schema page
         char *page_buffer = readPageFromBuffer(db->buffer_pool, page_num, db->file_pointer, db->page_size);
         if (!page_buffer) {
+            freeCatalog(catalog);
             return NULL;
         }
 
         SchemaPageHeader *schema_header = (SchemaPageHeader *)page_buffer;
         uint8_t *record_ptr = (uint8_t *)page_buffer + sizeof(SchemaPageHeader);
 
-        // Search through records in this page
         for (uint16_t i = 0; i < schema_header->table_count; i++) {
-            TableSchemaRecord *schema = malloc(sizeof(TableSchemaRecord));
-            if (!schema) {
+            deserializeSchemaRecord(db, record_ptr, &schema);
+            uint16_t offset = (uint16_t)(record_ptr - (uint8_t *)page_buffer);
+            if (addCatalogEntry(catalog, &schema, page_num, offset) != 0) {
+                freeCatalog(catalog);
                 return NULL;
             }
 
-            size_t consumed = deserializeSchemaRecord(record_ptr, schema);
+            // Records are laid out by getSchemaRecordSize (see writeTableSchema), not by the
+            // bytes deserialized
+            record_ptr += getSchemaRecordSize(db, &schema);
+        }
 
-            if (schema->table_id == table_id) {
-                return schema;
-            }
+        page_num = schema_header->next_schema_page;
+    }
 
-            free(schema);
-            record_ptr += consumed;
+    for (uint32_t i = 0; i < catalog->count; i++) {
+        CatalogEntry *entry = &catalog->entries[i];
+        if (loadDictionaries(db, &entry->schema, &entry->codec) != 0) {
+            freeCatalog(catalog);
+            return NULL;
         }
+    }
 
-        // Move to next schema page
-        page_num = schema_header->next_schema_page;
+    // Tables the header has hints for go on where they stopped. A high-water mark moved since, by
+    // a writer that did not keep the header's ids, means a hint is out of date
+    pthread_mutex_lock(&db->catalog_lock);
+    for (uint32_t i = 0; i < catalog->count; i++) {
+        CatalogEntry *entry = &catalog->entries[i];
+        for (int h = 0; h < RECORD_ID_HINTS; h++) {
+            const RecordIdHint *hint = &db->header->id_hints[h];
+            if (hint->table_id != 0 && hint->table_id == entry->schema.table_id &&
+                hint->high_water == entry->schema.next_record_id && hint->ids_left < hint->high_water) {
+                entry->next_record_id = hint->high_water - hint->ids_left;
+                break;
+            }
+        }
     }
+    pthread_mutex_unlock(&db->catalog_lock);
 
-    return NULL;
+    if (buildCatalogIndexes(catalog) != 0) {
+        freeCatalog(catalog);
+        return NULL;
+    }
+    return catalog;
 }
 
-TableSchemaRecord **readAllTableSchemas(MagBase *db, uint16_t *num_tables) {
-    if (!db || !num_tables) {
+// Readers share the catalog, one that finds it missing loads it. Pages are read outside
+// catalog_lock, so it is never held while waiting for a frame, and the first load published wins
+static Catalog *openCatalog(MagBase *db) {
+    Catalog *catalog = db->catalog;
+    if (catalog) {
+        return catalog;
+    }
+
+    Catalog *loaded = loadCatalog(db);
+    if (!loaded) {
         return NULL;
     }
+    pthread_mutex_lock(&db->catalog_lock);
+    catalog = db->catalog;
+    if (!catalog) {
+        db->catalog = catalog = loaded;
+        loaded = NULL;
+    }
+    pthread_mutex_unlock(&db->catalog_lock);
+    freeCatalog(loaded);
+    return catalog;
+}
 
-    // First pass: count total tables
-    uint16_t total_tables = 0;
-    uint64_t page_num = db->header->schema_root;
+void invalidateCatalog(MagBase *db) {
+    if (!db) {
+        return;
+    }
 
-    while (page_num != 0) {
-        char *page_buffer = readPageFromBuffer(db->buffer_pool, page_num, db->file_pointer, db->page_size);
-        if (!page_buffer) {
-            return NULL;
-        }
+    // Schemas and column names handed out point into the catalog, it is retired rather than freed
+    pthread_mutex_lock(&db->catalog_lock);
+    Catalog *catalog = db->catalog;
+    if (catalog) {
+        catalog->retired = db->retired_catalogs;
+        db->retired_catalogs = catalog;
+        db->catalog = NULL;
+    }
+    pthread_mutex_unlock(&db->catalog_lock);
+}
 
-        SchemaPageHeader *schema_header = (SchemaPageHeader *)page_buffer;
-        total_tables += schema_header->table_count;
-        page_num = schema_header->next_schema_page;
+TableSchemaRecord *getTableSchema(MagBase *db, uint16_t table_id) {
+    if (!db || table_id == 0) {
+        return NULL;
     }
 
-    if (total_tables == 0) {
-        *num_tables = 0;
+    CatalogEntry *entry = findCatalogEntry(openCatalog(db), table_id);
+    return entry ? &entry->schema : NULL;
+}
+
+const RowCodec *getRowCodec(MagBase *db, uint16_t table_id) {
+    if (!db || table_id == 0) {
         return NULL;
     }
 
-    // Allocate array
-    TableSchemaRecord **schemas = malloc(total_tables * sizeof(TableSchemaRecord *));
-    if (!schemas) {
+    CatalogEntry *entry = findCatalogEntry(openCatalog(db), table_id);
+    return entry ? &entry->codec : NULL;
+}
+
+TableSchemaRecord *getTableSchemaByName(MagBase *db, const char *name) {
+    if (!db || !name) {
         return NULL;
     }
 
-    // Second pass: read all schemas
-    uint16_t schema_index = 0;
-    page_num = db->header->schema_root;
+    CatalogEntry *entry = findCatalogEntryByName(openCatalog(db), name);
+    return entry ? &entry->schema : NULL;
+}
 
-    while (page_num != 0) {
-        char *page_buffer = readPageFromBuffer(db->buffer_pool, page_num, db->file_pointer, db->page_size);
-        if (!page_buffer) {
-            free(schemas);
-            return NULL;
-        }
+int copyTableSchema(MagBase *db, uint16_t table_id, TableSchemaRecord *out) {
+    TableSchemaRecord *cached = getTableSchema(db, table_id);
+    if (!cached) {
+        return -1;
+    }
 
-        SchemaPageHeader *schema_header = (SchemaPageHeader *)page_buffer;
-        uint8_t *record_ptr = (uint8_t *)page_buffer + sizeof(SchemaPageHeader);
+    pthread_mutex_lock(&db->catalog_lock);
+    *out = *cached;
+    pthread_mutex_unlock(&db->catalog_lock);
+    return 0;
+}
 
-        for (uint16_t i = 0; i < schema_header->table_count; i++) {
-            TableSchemaRecord *schema = malloc(sizeof(TableSchemaRecord));
-            if (!schema) {
-                // Free previously allocated schemas on error
-                for (uint16_t j = 0; j < schema_index; j++) {
-                    free(schemas[j]);
-                }
-                free(schemas);
-                return NULL;
-            }
+TableSchemaRecord *readTableSchema(MagBase *db, uint16_t table_id) {
+    TableSchemaRecord *schema = malloc(sizeof(TableSchemaRecord));
+    if (schema && copyTableSchema(db, table_id, schema) != 0) {
+        free(schema);
+        return NULL;
+    }
+    return schema;
+}
 
-            deserializeSchemaRecord(record_ptr, schema);
-            schemas[schema_index++] = schema;
-            record_ptr += getSchemaRecordSize(schema);
-        }
+TableSchemaRecord **readAllTableSchemas(MagBase *db, uint16_t *num_tables) {
+    if (!db || !num_tables) {
+        return NULL;
+    }
 
-        page_num = schema_header->next_schema_page;
+    Catalog *catalog = openCatalog(db);
+    if (!catalog) {
+        return NULL;
     }
 
-    *num_tables = total_tables;
+    if (catalog->count == 0) {
+        *num_tables = 0;
+        return NULL;
+    }
+
+    TableSchemaRecord **schemas = malloc(catalog->count * sizeof(TableSchemaRecord *));
+    if (!schemas) {
+        return NULL;
+    }
+
+    for (uint32_t i = 0; i < catalog->count; i++) {
+        schemas[i] = malloc(sizeof(TableSchemaRecord));
+        if (!schemas[i]) {
+            // Free previously allocated schemas on error
+            for (uint32_t j = 0; j < i; j++) {
+                free(schemas[j]);
+            }
+            free(schemas);
+            return NULL;
+        }
+        *schemas[i] = catalog->entries[i].schema;
+    }
+
+    *num_tables = (uint16_t)catalog->count;
     return schemas;
 }
 
@@ -313,6 +479,8 @@ int deleteTableSchema(MagBase *db, uint16_t table_id) {
     if (!db || table_id == 0) {
         return -1;
     }
+    releaseRecordIds(db);
+    invalidateCatalog(db);
 
     uint64_t page_num = db->header->schema_root;
     TableSchemaRecord temp_schema;
@@ -329,7 +497,8 @@ int deleteTableSchema(MagBase *db, uint16_t table_id) {
 
         // Find and remove the schema
         for (uint16_t i = 0; i < schema_header->table_count; i++) {
-            size_t consumed = deserializeSchemaRecord(record_ptr, &temp_schema);
+            deserializeSchemaRecord(db, record_ptr, &temp_schema);
+            size_t consumed = getSchemaRecordSize(db, &temp_schema);
 
             if (temp_schema.table_id == table_id) {
                 // Found it - shift remaining records back
@@ -355,54 +524,155 @@ int deleteTableSchema(MagBase *db, uint16_t table_id) {
     return -1;  // Table not found
 }
 
+// Readers hold pointers into cached schemas. Writes only move root_page, directory_page and
+// next_record_id, the other fields are rewritten only when DDL changed them (no reader runs then).
+// dictionary_page and zone_map_page are only set on the cached schema, a copy may predate them
+static void refreshCachedSchema(TableSchemaRecord *cached, const TableSchemaRecord *schema) {
+    TableSchemaRecord moved = *cached;
+    moved.root_page = schema->root_page;
+    moved.directory_page = schema->directory_page;
+    moved.next_record_id = schema->next_record_id;
+    TableSchemaRecord copy = *schema;
+    copy.dictionary_page = cached->dictionary_page;
+    copy.zone_map_page = cached->zone_map_page;
+    if (memcmp(&moved, &copy, sizeof(TableSchemaRecord)) != 0) {
+        *cached = copy;
+        return;
+    }
+    cached->root_page = schema->root_page;
+    cached->directory_page = schema->directory_page;
+    cached->next_record_id = schema->next_record_id;
+}
+
 int updateTableSchema(MagBase *db, TableSchemaRecord *schema) {
     if (!db || !schema || schema->table_id == 0) {
         return -1;
     }
 
-    uint64_t page_num = db->header->schema_root;
-    TableSchemaRecord temp_schema;
+    // The catalog knows where the record is, no need to walk the schema pages
+    CatalogEntry *entry = findCatalogEntry(openCatalog(db), schema->table_id);
+    if (!entry) {
+        return -1;  // Table not found
+    }
 
-    while (page_num != 0) {
-        char *page_buffer = readPageFromBuffer(db->buffer_pool, page_num, db->file_pointer, db->page_size);
-        if (!page_buffer) {
-            return -1;
+    char *page_buffer = readPageFromBuffer(db->buffer_pool, entry->page_num, db->file_pointer, db->page_size);
+    if (!page_buffer) {
+        return -1;
+    }
+
+    if (&entry->schema != schema) {
+        // A copy may predate ids handed out since it was read, the high-water mark never goes
+        // back. If the copy handed out ids of its own the next ones follow them
+        pthread_mutex_lock(&db->catalog_lock);
+        uint64_t high_water = entry->schema.next_record_id;
+        refreshCachedSchema(&entry->schema, schema);
+        if (schema->next_record_id > high_water) {
+            entry->next_record_id = schema->next_record_id;
+        } else {
+            entry->schema.next_record_id = high_water;
         }
+        pthread_mutex_unlock(&db->catalog_lock);
+    }
 
-        SchemaPageHeader *schema_header = (SchemaPageHeader *)page_buffer;
-        uint8_t *record_ptr = (uint8_t *)page_buffer + sizeof(SchemaPageHeader);
+    // Re-serialize in place, only fixed size fields (root_page, next_record_id, ...) change here
+    serializeSchemaRecord(db, (uint8_t *)page_buffer + entry->offset, &entry->schema);
+    markPageDirty(db->buffer_pool, entry->page_num);
+    return 0;
+}
 
-        // Find the schema record to update
-        for (uint16_t i = 0; i < schema_header->table_count; i++) {
-            uint8_t *current_ptr = record_ptr;
-            size_t consumed = deserializeSchemaRecord(record_ptr, &temp_schema);
-
-            if (temp_schema.table_id == schema->table_id) {
-                // Found it - update in place by re-serializing
-                // Note: This only works if the new size matches the old size!
-                size_t new_size = getSchemaRecordSize(schema);
-                size_t old_size = consumed;
-                
-                if (new_size == old_size) {
-                    // Can update in place
-                    serializeSchemaRecord(current_ptr, schema);
-                    markPageDirty(db->buffer_pool, page_num);
-                    return 0;
-                } else {
-                    // Size mismatch - just update anyway (safe for fields that don't change size)
-                    serializeSchemaRecord(current_ptr, schema);
-                    markPageDirty(db->buffer_pool, page_num);
-                    return 0;
-                }
+// Move the saved high-water mark, readers may be copying the schema
+static void setNextRecordId(MagBase *db, CatalogEntry *entry, uint64_t next_record_id) {
+    pthread_mutex_lock(&db->catalog_lock);
+    entry->schema.next_record_id = next_record_id;
+    pthread_mutex_unlock(&db->catalog_lock);
+}
+
+uint64_t allocateRecordId(MagBase *db, uint16_t table_id) {
+    if (!db || table_id == 0) {
+        return 0;
+    }
+
+    Catalog *catalog = openCatalog(db);
+    CatalogEntry *entry = findCatalogEntry(catalog, table_id);
+    if (!entry) {
+        return 0;
+    }
+
+    // The header keeps the next ids of the tables that handed ids out last. A table without a
+    // slot takes the least recent one, whose table saves its own next id first
+    RecordIdHint *hints = db->header->id_hints;
+    int slot = 0;
+    while (slot < RECORD_ID_HINTS - 1 && hints[slot].table_id != table_id) {
+        slot++;
+    }
+    if (hints[slot].table_id != table_id) {
+        CatalogEntry *evicted = hints[slot].table_id != 0 ? findCatalogEntry(catalog, hints[slot].table_id) : NULL;
+        if (evicted && evicted->next_record_id < evicted->schema.next_record_id) {
+            setNextRecordId(db, evicted, evicted->next_record_id);
+            if (updateTableSchema(db, &evicted->schema) != 0) {
+                return 0;
             }
+        }
+    }
 
-            record_ptr += consumed;
+    if (entry->next_record_id >= entry->schema.next_record_id) {
+        // Range used up, the end of the next one is saved before any id of it is handed out
+        uint64_t high_water = entry->schema.next_record_id;
+        setNextRecordId(db, entry, entry->next_record_id + RECORD_ID_BATCH);
+        if (updateTableSchema(db, &entry->schema) != 0) {
+            setNextRecordId(db, entry, high_water);
+            return 0;
         }
+    }
+    uint64_t record_id = entry->next_record_id++;
+
+    // The table's slot moves to the front
+    pthread_mutex_lock(&db->catalog_lock);
+    memmove(&hints[1], &hints[0], slot * sizeof(RecordIdHint));
+    hints[0].table_id = table_id;
+    hints[0].reserved = 0;
+    hints[0].ids_left = (uint32_t)(entry->schema.next_record_id - entry->next_record_id);
+    hints[0].high_water = entry->schema.next_record_id;
+    pthread_mutex_unlock(&db->catalog_lock);
+    return record_id;
+}
 
-        page_num = schema_header->next_schema_page;
+uint64_t getFreeTablePage(MagBase *db, uint16_t table_id) {
+    CatalogEntry *entry = db ? findCatalogEntry(openCatalog(db), table_id) : NULL;
+    return entry ? entry->free_page : 0;
+}
+
+void setFreeTablePage(MagBase *db, uint16_t table_id, uint64_t page_num) {
+    CatalogEntry *entry = db ? findCatalogEntry(openCatalog(db), table_id) : NULL;
+    if (entry) {
+        entry->free_page = page_num;
+    }
+}
+
+int releaseRecordIds(MagBase *db) {
+    Catalog *catalog = db ? db->catalog : NULL;
+    if (!catalog) {
+        return 0;
     }
 
-    return -1;  // Table not found
+    int released = 0;
+    for (uint32_t i = 0; i < catalog->count; i++) {
+        CatalogEntry *entry = &catalog->entries[i];
+        if (entry->next_record_id < entry->schema.next_record_id) {
+            setNextRecordId(db, entry, entry->next_record_id);
+            if (updateTableSchema(db, &entry->schema) != 0) {
+                return -1;
+            }
+            released++;
+        }
+    }
+    return released;
+}
+
+// Rows of 1.5 files are laid out by the codec plan of the schema they were written with, the
+// columns of a table only change before it has a data page
+static bool columnsFixed(MagBase *db, const TableSchemaRecord *schema) {
+    return db->compact_rows && schema->root_page != 0;
 }
 
 int addColumnToTable(MagBase *db, uint16_t table_id, SchemaColumn *column) {
@@ -416,7 +686,7 @@ int addColumnToTable(MagBase *db, uint16_t table_id, SchemaColumn *column) {
     }
 
     // Check if we can add more columns
-    if (schema->column_count >= MAX_COLUMNS) {
+    if (schema->column_count >= MAX_COLUMNS || columnsFixed(db, schema)) {
         free(schema);
         return -1;
     }
@@ -439,7 +709,7 @@ int removeColumnFromTable(MagBase *db, uint16_t table_id, uint16_t column_index)
     }
 
     TableSchemaRecord *schema = readTableSchema(db, table_id);
-    if (!schema || column_index >= schema->column_count) {
+    if (!schema || column_index >= schema->column_count || columnsFixed(db, schema)) {
         if (schema) free(schema);
         return -1;
     }
@@ -449,6 +719,9 @@ int removeColumnFromTable(MagBase *db, uint16_t table_id, uint16_t column_index)
         memcpy(&schema->columns[i], &schema->columns[i + 1], sizeof(SchemaColumn));
     }
     schema->column_count--;
+    uint16_t below = (uint16_t)((1u << column_index) - 1);
+    schema->dictionary_columns = (uint16_t)((schema->dictionary_columns & below) |
+                                            ((schema->dictionary_columns >> 1) & ~below));
 
     // Delete old schema and write updated one
     deleteTableSchema(db, table_id);
@@ -464,13 +737,16 @@ int updateTableColumn(MagBase *db, uint16_t table_id, uint16_t column_index, Sch
     }
 
     TableSchemaRecord *schema = readTableSchema(db, table_id);
-    if (!schema || column_index >= schema->column_count) {
+    if (!schema || column_index >= schema->column_count || columnsFixed(db, schema)) {
         if (schema) free(schema);
         return -1;
     }
 
-    // Update the column
+    // Update the column, only a text column keeps a dictionary
     memcpy(&schema->columns[column_index], new_column, sizeof(SchemaColumn));
+    if (new_column->type != COL_TEXT) {
+        schema->dictionary_columns &= (uint16_t)~(1u << column_index);
+    }
 
     // Delete old schema and write updated one
     deleteTableSchema(db, table_id);
@@ -479,3 +755,16 @@ int updateTableColumn(MagBase *db, uint16_t table_id, uint16_t column_index, Sch
     free(schema);
     return (result > 0) ? 0 : -1;
 }
+
+int findColumn(TableSchemaRecord *schema, const char *name) {
+    if (!schema || !name) {
+        return -1;
+    }
+
+    for (uint16_t col = 0; col < schema->column_count; col++) {
+        if (!strcmp(schema->columns[col].name, name)) {
+            return col;
+        }
+    }
+    return -1;
+}
@@ -7,14 +7,69 @@
 #pragma once
 
 #include "db-init.h"
+#include "row-codec.h"
 #include "structs/schemaStruct.h"
+#include <stdbool.h>
 #include <stdint.h>
 
+// Files created by 1.1 and later keep a page directory per table (see page-directory.h)
+// Older files only have the next_page chain
+bool hasPageDirectories(MagBase *db);
+
+// Schemas of files from 1.6 on carry TABLE_ flags, older tables have none
+bool hasTableFlags(MagBase *db);
+
+// Files from 1.7 on may store text columns as dictionary codes (see dictionary.h)
+bool hasDictionaries(MagBase *db);
+
+// Files from 1.8 on keep a zone map per table, scans skip the pages it rules out (see zone-map.h)
+bool hasZoneMaps(MagBase *db);
+
 // Write a table schema to the schema pages
 // Returns the table_id of the written schema, or -1 on error
 int writeTableSchema(MagBase *db, TableSchemaRecord *schema);
 
-// Read a table schema by table_id
+// Look up a table schema in the catalog, which is read from the schema pages on first use
+// Returns the cached schema, or NULL if not found. It belongs to the catalog and is stale after
+// the next schema write or delete (its memory lasts until close), changes are saved with
+// updateTableSchema. Threads may look schemas up at once
+TableSchemaRecord *getTableSchema(MagBase *db, uint16_t table_id);
+TableSchemaRecord *getTableSchemaByName(MagBase *db, const char *name);
+
+// Look up the codec plan rows of a table are encoded with, built when the catalog loads the
+// schema. Like the schema its memory lasts until close
+// Returns NULL if not found
+const RowCodec *getRowCodec(MagBase *db, uint16_t table_id);
+
+// Retire the catalog, the next lookup reads the schema pages again
+void invalidateCatalog(MagBase *db);
+
+// Hand out the next record id of a table. Ids are reserved RECORD_ID_BATCH at a time, the
+// schema only saves the end of the reserved range, so after a crash the ids not handed out are
+// skipped and none is used twice. The header keeps the next ids of the RECORD_ID_HINTS tables
+// that handed ids out last, they are committed along with the write, and the next open of the
+// file goes on from there instead of skipping the rest of the range. Only a table that loses its
+// slot to another saves its next id in its schema before its range is used up
+// Returns the record id, or 0 on error
+uint64_t allocateRecordId(MagBase *db, uint16_t table_id);
+
+// Save each table's next record id as its high-water mark, handing back the reserved ids not
+// used. DDL does it before the catalog is read again, the save is part of its commit
+// Returns the number of tables saved, or -1 on error
+int releaseRecordIds(MagBase *db);
+
+// The first page before the last one of a table that may have room for rows. Vacuum sets it and
+// inserts that find the last page full move it along, it is forgotten with the catalog
+// Returns 0 if none is known
+uint64_t getFreeTablePage(MagBase *db, uint16_t table_id);
+void setFreeTablePage(MagBase *db, uint16_t table_id, uint64_t page_num);
+
+// Copy a table schema into out. Unlike the cached schema, where a writer may be moving
+// root_page or next_record_id, the copy is safe to read beside the writer
+// Returns 0 on success, -1 if not found
+int copyTableSchema(MagBase *db, uint16_t table_id, TableSchemaRecord *out);
+
+// Read a table schema by table_id, a copy like copyTableSchema
 // Returns a pointer to the schema (allocated), or NULL if not found
 // Caller must free the returned pointer
 TableSchemaRecord *readTableSchema(MagBase *db, uint16_t table_id);
@@ -33,7 +88,8 @@ int deleteTableSchema(MagBase *db, uint16_t table_id);
 // Returns 0 on success, -1 on error  
 int updateTableSchema(MagBase *db, TableSchemaRecord *schema);
 
-// Add a column to an existing table schema
+// Add a column to an existing table schema. Columns of a 1.5 file only change while the table
+// has no data page, the same goes for the two below
 // Returns 0 on success, -1 on error
 int addColumnToTable(MagBase *db, uint16_t table_id, SchemaColumn *column);
 
@@ -44,3 +100,7 @@ int removeColumnFromTable(MagBase *db, uint16_t table_id, uint16_t column_index)
 // Update a column in a table schema
 // Returns 0 on success, -1 on error
 int updateTableColumn(MagBase *db, uint16_t table_id, uint16_t column_index, SchemaColumn *new_column);
+
+// Find a column by name
+// Returns the column index, or -1 if the table has no such column
+int findColumn(TableSchemaRecord *schema, const char *name);
@@ -0,0 +1,643 @@
+//     Keagan Anderson
+//        MagBase
+//       10/19/2026
+//
+//     magbased: serves one database to many local clients over a Unix socket (see server.h)
+
+#include "server.h"
+#include "globals.h"
+#include "magbase.h"
+#include "protocol.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#define SERVER_EVENTS 64 // Events taken from epoll per wait
+
+typedef struct Connection {
+    int fd;
+    WireBuffer in;
+    WireBuffer out;
+    bool busy;                          // With a worker, only the worker touches the buffers
+    bool eof;                           // The client sent everything, close once answered
+    bool dead;                          // The socket failed, close once the worker is done
+    struct Connection *next_job;        // Work queue, done list or closed list
+    struct Connection *previous;        // Every open connection
+    struct Connection *next;
+} Connection;
+
+typedef struct {
+    MagbaseDb *db;
+    int epoll_fd;
+    int listen_fd;
+    int wake_fd;                        // eventfd the workers signal when a connection is done
+    int signal_fd;
+    Connection *connections;
+    Connection *closed;                 // Freed after the current batch of events, which may name them
+
+    pthread_mutex_t lock;               // Guards everything below
+    pthread_cond_t work_ready;
+    Connection *queue_head;             // Waiting for a worker, in arrival order
+    Connection *queue_tail;
+    Connection *done;                   // Served, waiting for the event loop
+    bool shutdown;
+} Server;
+
+// Answer one request into out
+static void serveRequest(Server *server, WireBuffer *out, const uint8_t *frame, size_t frame_length) {
+    uint32_t request_id;
+    uint8_t opcode;
+    WireReader reader = frameReader(frame, frame_length, &request_id, &opcode);
+
+    MagbaseValue values[MAGBASE_MAX_COLUMNS];
+    uint16_t count = 0;
+    uint8_t status = STATUS_ERROR;
+    bool answered = false;              // Set once a frame with a payload is written
+    size_t response = out->length;
+    size_t frame_start;
+
+    // The handle is shared by every worker, reads run at once and writes queue in the engine
+    switch (opcode) {
+        case OP_PING:
+            status = STATUS_OK;
+            break;
+
+        case OP_CREATE_TABLE: {
+            const char *name = getString(&reader);
+            MagbaseColumn columns[MAGBASE_MAX_COLUMNS];
+            if (getColumns(&reader, columns, &count, MAGBASE_MAX_COLUMNS) != 0 || !name) {
+                break;
+            }
+            int table_id = magbaseCreateTable(server->db, name, columns, count);
+            if (table_id > 0) {
+                frame_start = beginFrame(out, request_id, STATUS_OK);
+                putU16(out, (uint16_t)table_id);
+                endFrame(out, frame_start);
+                answered = true;
+            }
+            break;
+        }
+
+        case OP_DROP_TABLE: {
+            uint16_t table_id = getU16(&reader);
+            if (!reader.failed && magbaseDropTable(server->db, table_id) == 0) {
+                status = STATUS_OK;
+            }
+            break;
+        }
+
+        case OP_FIND_TABLE: {
+            const char *name = getString(&reader);
+            int table_id = name ? magbaseFindTable(server->db, name) : -1;
+            if (table_id > 0) {
+                frame_start = beginFrame(out, request_id, STATUS_OK);
+                putU16(out, (uint16_t)table_id);
+                endFrame(out, frame_start);
+                answered = true;
+            } else if (name) {
+                status = STATUS_NOT_FOUND;
+            }
+            break;
+        }
+
+        case OP_TABLE_STATS: {
+            uint16_t table_id = getU16(&reader);
+            MagbaseTableStats stats;
+            if (reader.failed) {
+                break;
+            }
+            if (magbaseTableStats(server->db, table_id, &stats) != 0) {
+                status = STATUS_NOT_FOUND;
+                break;
+            }
+            frame_start = beginFrame(out, request_id, STATUS_OK);
+            putString(out, stats.name);
+            putColumns(out, stats.columns, stats.column_count);
+            putU64(out, stats.row_count);
+            putU64(out, stats.page_count);
+            endFrame(out, frame_start);
+            answered = true;
+            break;
+        }
+
+        case OP_INSERT: {
+            uint16_t table_id = getU16(&reader);
+            if (getValues(&reader, values, &count, MAGBASE_MAX_COLUMNS) != 0) {
+                break;
+            }
+            uint64_t record_id = magbaseInsert(server->db, table_id, values, count);
+            if (record_id != 0) {
+                frame_start = beginFrame(out, request_id, STATUS_OK);
+                putU64(out, record_id);
+                endFrame(out, frame_start);
+                answered = true;
+            }
+            break;
+        }
+
+        case OP_READ: {
+            uint16_t table_id = getU16(&reader);
+            uint64_t record_id = getU64(&reader);
+            MagbaseTableStats stats;
+            if (reader.failed) {
+                break;
+            }
+            if (magbaseTableStats(server->db, table_id, &stats) != 0 ||
+                magbaseRead(server->db, table_id, record_id, values, MAGBASE_MAX_COLUMNS) != 0) {
+                status = STATUS_NOT_FOUND;
+                break;
+            }
+            frame_start = beginFrame(out, request_id, STATUS_OK);
+            putValues(out, values, stats.column_count);
+            endFrame(out, frame_start);
+            answered = true;
+            break;
+        }
+
+        case OP_UPDATE: {
+            uint16_t table_id = getU16(&reader);
+            uint64_t record_id = getU64(&reader);
+            if (getValues(&reader, values, &count, MAGBASE_MAX_COLUMNS) == 0 &&
+                magbaseUpdate(server->db, table_id, record_id, values, count) == 0) {
+                status = STATUS_OK;
+            }
+            break;
+        }
+
+        case OP_DELETE: {
+            uint16_t table_id = getU16(&reader);
+            uint64_t record_id = getU64(&reader);
+            if (!reader.failed) {
+                status = magbaseDelete(server->db, table_id, record_id) == 0 ? STATUS_OK : STATUS_NOT_FOUND;
+            }
+            break;
+        }
+
+        case OP_SCAN: {
+            uint16_t table_id = getU16(&reader);
+            uint16_t where_count = getU16(&reader);
+            const char *where[WIRE_MAX_CONDITIONS];
+            if (reader.failed || where_count > WIRE_MAX_CONDITIONS) {
+                break;
+            }
+            for (uint16_t i = 0; i < where_count; i++) {
+                where[i] = getString(&reader);
+            }
+            MagbaseTableStats stats;
+            if (reader.failed || magbaseTableStats(server->db, table_id, &stats) != 0) {
+                status = reader.failed ? STATUS_ERROR : STATUS_NOT_FOUND;
+                break;
+            }
+            MagbaseCursor *cursor = magbaseOpenCursor(server->db, table_id, where, where_count);
+            if (!cursor) {
+                break;
+            }
+
+            uint64_t rows = 0;
+            uint64_t record_id;
+            int result;
+            while ((result = magbaseNext(cursor, &record_id, values, MAGBASE_MAX_COLUMNS)) == 1) {
+                frame_start = beginFrame(out, request_id, STATUS_ROW);
+                putU64(out, record_id);
+                putValues(out, values, stats.column_count);
+                endFrame(out, frame_start);
+                rows++;
+            }
+            magbaseCloseCursor(cursor);
+            if (result != 0) {
+                out->length = response; // The rows sent so far would look like the whole answer
+                break;
+            }
+            frame_start = beginFrame(out, request_id, STATUS_OK);
+            putU64(out, rows);
+            endFrame(out, frame_start);
+            answered = true;
+            break;
+        }
+    }
+
+    // Requests without a payload in their answer
+    if (!answered) {
+        frame_start = beginFrame(out, request_id, status);
+        endFrame(out, frame_start);
+    }
+}
+
+// Answer every complete request a connection sent, in order
+static void serveConnection(Server *server, Connection *connection) {
+    size_t offset = 0;
+    long frame_length;
+    while ((frame_length = completeFrame(connection->in.data + offset, connection->in.length - offset,
+                                         SERVER_MAX_FRAME)) > 0) {
+        serveRequest(server, &connection->out, connection->in.data + offset, (size_t)frame_length);
+        offset += (size_t)frame_length;
+    }
+    consumeWire(&connection->in, offset);
+}
+
+static void *serverWorker(void *arg) {
+    Server *server = arg;
+    uint64_t one = 1;
+
+    while (1) {
+        pthread_mutex_lock(&server->lock);
+        while (!server->queue_head && !server->shutdown) {
+            pthread_cond_wait(&server->work_ready, &server->lock);
+        }
+        Connection *connection = server->queue_head;
+        if (!connection) {
+            pthread_mutex_unlock(&server->lock);
+            return NULL;
+        }
+        server->queue_head = connection->next_job;
+        if (!server->queue_head) {
+            server->queue_tail = NULL;
+        }
+        pthread_mutex_unlock(&server->lock);
+
+        serveConnection(server, connection);
+
+        pthread_mutex_lock(&server->lock);
+        connection->next_job = server->done;
+        server->done = connection;
+        pthread_mutex_unlock(&server->lock);
+        if (write(server->wake_fd, &one, sizeof(one)) < 0) {
+            // The event loop still finds the connection on its next wake up
+        }
+    }
+}
+
+// Watch a connection for what it can do now: nothing while a worker has it, reads while its
+// unsent answers are below SERVER_OUTPUT_LIMIT, writes while answers are waiting
+static void watchConnection(Server *server, Connection *connection) {
+    struct epoll_event event = {0};
+    event.data.ptr = connection;
+    if (!connection->busy) {
+        if (!connection->eof && connection->out.length < SERVER_OUTPUT_LIMIT) {
+            event.events |= EPOLLIN;
+        }
+        if (connection->out.length > 0) {
+            event.events |= EPOLLOUT;
+        }
+    }
+    epoll_ctl(server->epoll_fd, EPOLL_CTL_MOD, connection->fd, &event);
+}
+
+static void closeConnection(Server *server, Connection *connection) {
+    epoll_ctl(server->epoll_fd, EPOLL_CTL_DEL, connection->fd, NULL);
+    close(connection->fd);
+    connection->fd = -1;
+    if (connection->previous) {
+        connection->previous->next = connection->next;
+    } else {
+        server->connections = connection->next;
+    }
+    if (connection->next) {
+        connection->next->previous = connection->previous;
+    }
+    connection->next_job = server->closed;
+    server->closed = connection;
+}
+
+static void freeClosedConnections(Server *server) {
+    while (server->closed) {
+        Connection *connection = server->closed;
+        server->closed = connection->next_job;
+        freeWire(&connection->in);
+        freeWire(&connection->out);
+        free(connection);
+    }
+}
+
+// Hand a connection with complete requests to the workers
+static void queueConnection(Server *server, Connection *connection) {
+    connection->busy = true;
+    watchConnection(server, connection);
+
+    pthread_mutex_lock(&server->lock);
+    connection->next_job = NULL;
+    if (server->queue_tail) {
+        server->queue_tail->next_job = connection;
+    } else {
+        server->queue_head = connection;
+    }
+    server->queue_tail = connection;
+    pthread_cond_signal(&server->work_ready);
+    pthread_mutex_unlock(&server->lock);
+}
+
+// Write as much of the answers as the socket takes
+// Returns 0 on success, -1 if the socket failed
+static int flushConnection(Connection *connection) {
+    size_t sent = 0;
+    while (sent < connection->out.length) {
+        ssize_t written = send(connection->fd, connection->out.data + sent, connection->out.length - sent,
+                               MSG_NOSIGNAL);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+            return -1;
+        }
+        sent += (size_t)written;
+    }
+    consumeWire(&connection->out, sent);
+    return 0;
+}
+
+// After reading, writing or a worker finishing: queue, watch or close the connection
+static void settleConnection(Server *server, Connection *connection) {
+    long frame_length = completeFrame(connection->in.data, connection->in.length, SERVER_MAX_FRAME);
+    if (frame_length < 0) {
+        fprintf(stderr, "Closing a client that sent a frame over %d bytes\n", SERVER_MAX_FRAME);
+        closeConnection(server, connection);
+        return;
+    }
+    if (frame_length > 0 && connection->out.length < SERVER_OUTPUT_LIMIT) {
+        queueConnection(server, connection);
+        return;
+    }
+    if (connection->eof && connection->out.length == 0) {
+        closeConnection(server, connection);
+        return;
+    }
+    watchConnection(server, connection);
+}
+
+static void readConnection(Server *server, Connection *connection) {
+    while (1) {
+        if (reserveWire(&connection->in, 64 * 1024) != 0) {
+            closeConnection(server, connection);
+            return;
+        }
+        ssize_t received = recv(connection->fd, connection->in.data + connection->in.length,
+                                connection->in.capacity - connection->in.length, 0);
+        if (received > 0) {
+            connection->in.length += (size_t)received;
+            if (completeFrame(connection->in.data, connection->in.length, SERVER_MAX_FRAME) != 0) {
+                break; // Serve what arrived before reading more
+            }
+            continue;
+        }
+        if (received == 0) {
+            connection->eof = true;
+            break;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            break;
+        }
+        closeConnection(server, connection);
+        return;
+    }
+    settleConnection(server, connection);
+}
+
+static void acceptConnections(Server *server) {
+    while (1) {
+        int fd = accept(server->listen_fd, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+        Connection *connection = calloc(1, sizeof(Connection));
+        struct epoll_event event = {.events = EPOLLIN, .data.ptr = connection};
+        if (!connection || epoll_ctl(server->epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0) {
+            free(connection);
+            close(fd);
+            continue;
+        }
+        connection->fd = fd;
+        connection->next = server->connections;
+        if (server->connections) {
+            server->connections->previous = connection;
+        }
+        server->connections = connection;
+    }
+}
+
+// Take back the connections the workers finished
+static void finishConnections(Server *server) {
+    uint64_t count;
+    if (read(server->wake_fd, &count, sizeof(count)) < 0) {
+        // Nothing to clear, the done list is checked anyway
+    }
+
+    pthread_mutex_lock(&server->lock);
+    Connection *connection = server->done;
+    server->done = NULL;
+    pthread_mutex_unlock(&server->lock);
+
+    while (connection) {
+        Connection *next = connection->next_job;
+        connection->busy = false;
+        if (connection->dead || flushConnection(connection) != 0) {
+            closeConnection(server, connection);
+        } else {
+            settleConnection(server, connection);
+        }
+        connection = next;
+    }
+}
+
+static void handleConnectionEvent(Server *server, Connection *connection, uint32_t events) {
+    if (connection->fd < 0) {
+        return;
+    }
+    if (connection->busy) {
+        // Only errors are reported while a worker has the connection, stop watching it until then
+        connection->dead = true;
+        epoll_ctl(server->epoll_fd, EPOLL_CTL_DEL, connection->fd, NULL);
+        return;
+    }
+    if (events & EPOLLOUT) {
+        if (flushConnection(connection) != 0) {
+            closeConnection(server, connection);
+            return;
+        }
+    }
+    if (events & EPOLLIN) {
+        readConnection(server, connection);
+        return;
+    }
+    if (events & (EPOLLERR | EPOLLHUP)) {
+        closeConnection(server, connection);
+        return;
+    }
+    settleConnection(server, connection);
+}
+
+// Bind the listening socket, a socket file left behind by a server that is gone is replaced
+// Returns the socket, or -1 on error
+static int listenOn(const char *socket_path) {
+    struct sockaddr_un address = {.sun_family = AF_UNIX};
+    if (strlen(socket_path) >= sizeof(address.sun_path)) {
+        fprintf(stderr, "Socket path is too long: %s\n", socket_path);
+        return -1;
+    }
+    strcpy(address.sun_path, socket_path);
+
+    int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (probe >= 0) {
+        int serving = connect(probe, (struct sockaddr *)&address, sizeof(address)) == 0;
+        close(probe);
+        if (serving) {
+            fprintf(stderr, "A server is already listening on %s\n", socket_path);
+            return -1;
+        }
+    }
+    unlink(socket_path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0 || bind(fd, (struct sockaddr *)&address, sizeof(address)) != 0 || listen(fd, SERVER_BACKLOG) != 0) {
+        perror("Failed to listen on the socket");
+        if (fd >= 0) {
+            close(fd);
+        }
+        return -1;
+    }
+    return fd;
+}
+
+static void addWatch(Server *server, int fd) {
+    struct epoll_event event = {.events = EPOLLIN, .data.ptr = NULL};
+    if (fd == server->listen_fd) {
+        event.data.ptr = &server->listen_fd;
+    } else if (fd == server->wake_fd) {
+        event.data.ptr = &server->wake_fd;
+    } else {
+        event.data.ptr = &server->signal_fd;
+    }
+    epoll_ctl(server->epoll_fd, EPOLL_CTL_ADD, fd, &event);
+}
+
+int runServer(const char *db_path, const char *socket_path, uint32_t thread_count, MagbaseSyncMode sync_mode) {
+    if (!db_path || !socket_path) {
+        return -1;
+    }
+    if (thread_count == 0) {
+        thread_count = SERVER_WORKER_THREADS;
+    }
+
+    Server server = {0};
+    server.db = magbaseOpen(db_path, NULL);
+    if (!server.db) {
+        return -1;
+    }
+    if (magbaseSetSyncMode(server.db, sync_mode) != 0) {
+        magbaseClose(server.db);
+        return -1;
+    }
+    server.listen_fd = listenOn(socket_path);
+    if (server.listen_fd < 0) {
+        magbaseClose(server.db);
+        return -1;
+    }
+
+    // SIGINT and SIGTERM are read from signal_fd, the workers inherit the mask
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, NULL);
+
+    server.epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    server.wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    server.signal_fd = signalfd(-1, &signals, SFD_NONBLOCK | SFD_CLOEXEC);
+    pthread_mutex_init(&server.lock, NULL);
+    pthread_cond_init(&server.work_ready, NULL);
+
+    pthread_t *workers = calloc(thread_count, sizeof(pthread_t));
+    uint32_t started = 0;
+    int status = -1;
+    if (server.epoll_fd >= 0 && server.wake_fd >= 0 && server.signal_fd >= 0 && workers) {
+        addWatch(&server, server.listen_fd);
+        addWatch(&server, server.wake_fd);
+        addWatch(&server, server.signal_fd);
+        while (started < thread_count && pthread_create(&workers[started], NULL, serverWorker, &server) == 0) {
+            started++;
+        }
+        status = started == thread_count ? 0 : -1;
+    }
+
+    if (status == 0) {
+        printf("Serving %s on %s with %u workers\n", db_path, socket_path, thread_count);
+        fflush(stdout);
+    }
+
+    struct epoll_event events[SERVER_EVENTS];
+    bool running = status == 0;
+    while (running) {
+        int ready = epoll_wait(server.epoll_fd, events, SERVER_EVENTS, -1);
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("epoll_wait");
+            status = -1;
+            break;
+        }
+
+        for (int i = 0; i < ready; i++) {
+            void *source = events[i].data.ptr;
+            if (source == &server.listen_fd) {
+                acceptConnections(&server);
+            } else if (source == &server.wake_fd) {
+                finishConnections(&server);
+            } else if (source == &server.signal_fd) {
+                running = false;
+            } else {
+                handleConnectionEvent(&server, source, events[i].events);
+            }
+        }
+        freeClosedConnections(&server);
+    }
+
+    // Let the workers finish what they have, then drop every connection
+    pthread_mutex_lock(&server.lock);
+    server.shutdown = true;
+    pthread_cond_broadcast(&server.work_ready);
+    pthread_mutex_unlock(&server.lock);
+    for (uint32_t i = 0; i < started; i++) {
+        pthread_join(workers[i], NULL);
+    }
+    free(workers);
+    while (server.connections) {
+        closeConnection(&server, server.connections);
+    }
+    freeClosedConnections(&server);
+
+    close(server.listen_fd);
+    unlink(socket_path);
+    if (server.epoll_fd >= 0) close(server.epoll_fd);
+    if (server.wake_fd >= 0) close(server.wake_fd);
+    if (server.signal_fd >= 0) close(server.signal_fd);
+    pthread_cond_destroy(&server.work_ready);
+    pthread_mutex_destroy(&server.lock);
+
+    if (magbaseClose(server.db) != 0) {
+        status = -1;
+    }
+    return status;
+}
@@ -0,0 +1,17 @@
+//     Keagan Anderson
+//        MagBase
+//       10/19/2026
+//
+//     magbased: serves one database to many local clients over a Unix socket, so they share
+//     one buffer pool and catalog (see protocol.h for the wire format)
+
+#pragma once
+
+#include "magbase.h"
+#include <stdint.h>
+
+// Serve the database at db_path on socket_path until SIGINT or SIGTERM. An epoll loop reads the
+// requests and hands connections with complete frames to thread_count workers (0 for
+// SERVER_WORKER_THREADS), which answer them in order. Commits sync as sync_mode says
+// Returns 0 after a clean shutdown, -1 if the server could not start
+int runServer(const char *db_path, const char *socket_path, uint32_t thread_count, MagbaseSyncMode sync_mode);
@@ -0,0 +1,201 @@
+//     Keagan Anderson
+//        MagBase
+//       10/19/2026
+//
+//     Sessions: many commands read from a script or typed at a prompt, run against one open
+//     database so the buffer pool and catalog stay warm between them
+
+#include "session.h"
+#include "commands.h"
+#include "file-lock.h"
+#include "globals.h"
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+
+static bool isBlank(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+
+// Split a line into words in place, "" inside quotes is a quote
+// Returns the number of words, or -1 if there are too many or a quote is not closed
+static int splitWords(char *line, char **words, int max_words) {
+    int count = 0;
+    char *read = line;
+
+    while (1) {
+        while (isBlank(*read)) {
+            read++;
+        }
+        if (*read == '\0' || *read == '#') {
+            return count;
+        }
+        if (count == max_words) {
+            return -1;
+        }
+
+        // The word is written over itself, it never grows
+        char *write = read;
+        words[count++] = write;
+        bool quoted = false;
+        while (*read != '\0' && (quoted || !isBlank(*read))) {
+            if (*read == '"') {
+                if (quoted && read[1] == '"') {
+                    *write++ = '"';
+                    read += 2;
+                } else {
+                    quoted = !quoted;
+                    read++;
+                }
+                continue;
+            }
+            *write++ = *read++;
+        }
+        if (quoted) {
+            return -1;
+        }
+
+        bool last = *read == '\0';
+        *write = '\0';
+        if (last) {
+            return count;
+        }
+        read++;
+    }
+}
+
+static int beginTransaction(Session *session) {
+    if (session->in_transaction) {
+        fprintf(stderr, "A transaction is already open\n");
+        return -1;
+    }
+    session->in_transaction = true;
+    return 0;
+}
+
+static int commitTransaction(Session *session) {
+    if (!session->in_transaction) {
+        fprintf(stderr, "No transaction is open\n");
+        return -1;
+    }
+    session->in_transaction = false;
+
+    // The first write of the transaction took the writer lock of the file
+    int result = 0;
+    if (commitDatabase(session->db) != 0) {
+        rollbackDatabase(session->db);
+        fprintf(stderr, "Commit failed, transaction rolled back\n");
+        result = -1;
+    }
+    if (unlockFileWriter(session->db) != 0) {
+        result = -1;
+    }
+    return result;
+}
+
+static int rollbackTransaction(Session *session) {
+    if (!session->in_transaction) {
+        fprintf(stderr, "No transaction is open\n");
+        return -1;
+    }
+    session->in_transaction = false;
+
+    int result = rollbackDatabase(session->db);
+    unlockFileWriter(session->db);
+    if (result != 0) {
+        fprintf(stderr, "Files older than 1.2 are written in place, the transaction cannot be rolled back\n");
+        return -1;
+    }
+    return 0;
+}
+
+static void printSessionHelp(Session *session) {
+    printf("Commands:\n");
+    printCommands(session);
+    printf("  begin, commit, rollback\n");
+    printf("  explain <command ...>\n");
+    printf("  help, quit\n");
+}
+
+int runSession(MagBase *db, FILE *input) {
+    if (!db || !input) {
+        return -1;
+    }
+
+    Session session = {0};
+    session.db = db;
+    bool interactive = isatty(fileno(input));
+
+    char *line = NULL;
+    size_t line_capacity = 0;
+    char *words[SESSION_MAX_WORDS];
+    uint64_t line_number = 0;
+    int status = 0;
+
+    while (1) {
+        if (interactive) {
+            printf(session.in_transaction ? "magbase*> " : "magbase> ");
+            fflush(stdout);
+        }
+        if (getline(&line, &line_capacity, input) < 0) {
+            break;
+        }
+        line_number++;
+
+        int count = splitWords(line, words, SESSION_MAX_WORDS);
+        if (count < 0) {
+            fprintf(stderr, "Line %lu: unclosed quote or more than %d words\n", (unsigned long)line_number,
+                    SESSION_MAX_WORDS);
+            status = -1;
+            continue;
+        }
+        if (count == 0) {
+            continue;
+        }
+
+        // Command line flags work too
+        int first = 0;
+        char *name = words[0][0] == '-' ? words[0] + 1 : words[0];
+        session.explain = false;
+        if (!strcasecmp(name, "explain") && count > 1) {
+            session.explain = true;
+            first = 1;
+            name = words[1][0] == '-' ? words[1] + 1 : words[1];
+        }
+
+        int result = 0;
+        if (!strcasecmp(name, "quit") || !strcasecmp(name, "exit")) {
+            break;
+        } else if (!strcasecmp(name, "help")) {
+            printSessionHelp(&session);
+        } else if (!strcasecmp(name, "begin")) {
+            result = beginTransaction(&session);
+        } else if (!strcasecmp(name, "commit")) {
+            result = commitTransaction(&session);
+        } else if (!strcasecmp(name, "rollback")) {
+            result = rollbackTransaction(&session);
+        } else if (isCommand(name)) {
+            result = runCommand(&session, name, count - first - 1, words + first + 1);
+        } else {
+            fprintf(stderr, "Unknown command: %s, try help\n", name);
+            result = -1;
+        }
+
+        if (result != 0) {
+            status = -1;
+            if (!interactive) {
+                fprintf(stderr, "Line %lu: %s failed\n", (unsigned long)line_number, name);
+            }
+        }
+    }
+
+    if (session.in_transaction) {
+        rollbackDatabase(db);
+        unlockFileWriter(db);
+        fprintf(stderr, "Transaction was not committed, rolled back\n");
+        status = -1;
+    }
+
+    free(line);
+    return status;
+}
@@ -0,0 +1,18 @@
+//     Keagan Anderson
+//        MagBase
+//       10/19/2026
+//
+//     Sessions: many commands read from a script or typed at a prompt, run against one open
+//     database so the buffer pool and catalog stay warm between them
+
+#pragma once
+
+#include "db-init.h"
+#include <stdio.h>
+
+// Run every command line of input against db until the end of input or quit. Lines take the
+// command names without the leading - and without the database path, "quoted words" may hold
+// spaces and # starts a comment. BEGIN ... COMMIT batches writes into one commit, ROLLBACK
+// drops them. A transaction still open at the end is rolled back
+// Returns 0 if every command succeeded, -1 otherwise
+int runSession(MagBase *db, FILE *input);
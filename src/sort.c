@@ -0,0 +1,580 @@
+//     Keagan Anderson
+//        MagBase
+//       10/19/2026
+//
+//     ORDER BY support, in memory sorts with external merge sort and top-K fallbacks
+
+#include "sort.h"
+#include "globals.h"
+#include "schema.h"
+#include "filter.h"
+#include <stdlib.h>
+#include <string.h>
+
+// K-way merge over spilled runs, a min heap of readers keyed by their current record
+typedef struct MergeState {
+    const SortSpec *spec;
+    TempRunReader *readers;
+    Record **current;                   // Current record of each reader
+    size_t *heap;                       // Reader indices, heap[0] holds the smallest record
+    size_t heap_size;
+    size_t reader_count;
+} MergeState;
+
+void initSortSpec(SortSpec *spec) {
+    memset(spec, 0, sizeof(SortSpec));
+    spec->memory_budget = SORT_MEMORY_BUDGET;
+}
+
+int parseSortKeys(TableSchemaRecord *schema, const char *order_by, SortSpec *spec) {
+    if (!schema || !order_by || !spec) {
+        return -1;
+    }
+
+    char list[512];
+    strncpy(list, order_by, sizeof(list) - 1);
+    list[sizeof(list) - 1] = '\0';
+
+    char *save_list = NULL;
+    for (char *item = strtok_r(list, ",", &save_list); item; item = strtok_r(NULL, ",", &save_list)) {
+        char *save_item = NULL;
+        char *name = strtok_r(item, ":", &save_item);
+        char *direction = strtok_r(NULL, ":", &save_item);
+
+        if (!name || spec->key_count >= MAX_COLUMNS) {
+            return -1;
+        }
+
+        int column = findColumn(schema, name);
+        if (column < 0) {
+            fprintf(stderr, "Unknown column in ORDER BY: %s\n", name);
+            return -1;
+        }
+
+        uint8_t descending = 0;
+        if (direction) {
+            if (!strcmp(direction, "desc")) {
+                descending = 1;
+            } else if (strcmp(direction, "asc") != 0) {
+                fprintf(stderr, "Unknown sort direction: %s (use asc or desc)\n", direction);
+                return -1;
+            }
+        }
+
+        spec->keys[spec->key_count].column = (uint16_t)column;
+        spec->keys[spec->key_count].descending = descending;
+        spec->key_count++;
+    }
+
+    return spec->key_count > 0 ? 0 : -1;
+}
+
+int compareRecords(const SortSpec *spec, Record *a, Record *b) {
+    for (uint16_t k = 0; k < spec->key_count; k++) {
+        RecordField *fa = &a->fields[spec->keys[k].column];
+        RecordField *fb = &b->fields[spec->keys[k].column];
+        int cmp = 0;
+
+        if (fa->is_null || fb->is_null) {
+            cmp = (int)fb->is_null - (int)fa->is_null;
+        } else {
+            cmp = compareFields(fa, fb);
+        }
+
+        if (cmp != 0) {
+            return spec->keys[k].descending ? -cmp : cmp;
+        }
+    }
+
+    return 0;
+}
+
+size_t sortRowMemorySize(uint16_t field_count) {
+    return sizeof(Record) + field_count * sizeof(RecordField);
+}
+
+int sortUsesTopK(const SortSpec *spec, uint16_t field_count) {
+    if (spec->limit == 0) {
+        return 0;
+    }
+
+    // Divide the budget rather than multiply the limit, so a huge limit cannot overflow and just
+    // means a full sort
+    size_t row_bytes = sortRowMemorySize(field_count);
+    return spec->limit <= spec->memory_budget / row_bytes;
+}
+
+// Stable top-down merge sort, scratch must hold count pointers
+static void mergeSortRecords(Record **records, Record **scratch, uint64_t count, const SortSpec *spec) {
+    if (count < 2) {
+        return;
+    }
+
+    uint64_t middle = count / 2;
+    mergeSortRecords(records, scratch, middle, spec);
+    mergeSortRecords(records + middle, scratch, count - middle, spec);
+
+    uint64_t left = 0, right = middle, out = 0;
+    while (left < middle && right < count) {
+        if (compareRecords(spec, records[right], records[left]) < 0) {
+            scratch[out++] = records[right++];
+        } else {
+            scratch[out++] = records[left++];
+        }
+    }
+    while (left < middle) {
+        scratch[out++] = records[left++];
+    }
+    while (right < count) {
+        scratch[out++] = records[right++];
+    }
+
+    memcpy(records, scratch, count * sizeof(Record *));
+}
+
+static int sortRecordArray(Record **records, uint64_t count, const SortSpec *spec) {
+    if (count < 2) {
+        return 0;
+    }
+
+    Record **scratch = malloc(count * sizeof(Record *));
+    if (!scratch) {
+        return -1;
+    }
+    mergeSortRecords(records, scratch, count, spec);
+    free(scratch);
+    return 0;
+}
+
+// Sift down in a max heap of records, the worst row by the sort order sits at the top
+static void siftDownWorst(Record **heap, uint64_t size, uint64_t index, const SortSpec *spec) {
+    while (1) {
+        uint64_t largest = index;
+        uint64_t left = index * 2 + 1;
+        uint64_t right = left + 1;
+
+        if (left < size && compareRecords(spec, heap[left], heap[largest]) > 0) {
+            largest = left;
+        }
+        if (right < size && compareRecords(spec, heap[right], heap[largest]) > 0) {
+            largest = right;
+        }
+        if (largest == index) {
+            return;
+        }
+
+        Record *temp = heap[index];
+        heap[index] = heap[largest];
+        heap[largest] = temp;
+        index = largest;
+    }
+}
+
+static void siftUpWorst(Record **heap, uint64_t index, const SortSpec *spec) {
+    while (index > 0) {
+        uint64_t parent = (index - 1) / 2;
+        if (compareRecords(spec, heap[index], heap[parent]) <= 0) {
+            return;
+        }
+
+        Record *temp = heap[index];
+        heap[index] = heap[parent];
+        heap[parent] = temp;
+        index = parent;
+    }
+}
+
+// Sort the buffered records, write them as one run and free them
+static int spillRun(TempSpace *space, Record **records, uint64_t count, const SortSpec *spec, TempRun *run) {
+    if (sortRecordArray(records, count, spec) != 0) {
+        return -1;
+    }
+
+    initTempRun(run);
+    int result = 0;
+    for (uint64_t i = 0; i < count; i++) {
+        if (result == 0 && appendToTempRun(space, run, records[i]) != 0) {
+            result = -1;
+        }
+        freeRecord(records[i]);
+    }
+    return result;
+}
+
+// Reader a is ahead of reader b, ties go to the earlier run so the sort stays stable
+static int mergeLess(MergeState *merge, size_t a, size_t b) {
+    int cmp = compareRecords(merge->spec, merge->current[a], merge->current[b]);
+    return cmp < 0 || (cmp == 0 && a < b);
+}
+
+static void siftDownMerge(MergeState *merge, size_t index) {
+    while (1) {
+        size_t smallest = index;
+        size_t left = index * 2 + 1;
+        size_t right = left + 1;
+
+        if (left < merge->heap_size && mergeLess(merge, merge->heap[left], merge->heap[smallest])) {
+            smallest = left;
+        }
+        if (right < merge->heap_size && mergeLess(merge, merge->heap[right], merge->heap[smallest])) {
+            smallest = right;
+        }
+        if (smallest == index) {
+            return;
+        }
+
+        size_t temp = merge->heap[index];
+        merge->heap[index] = merge->heap[smallest];
+        merge->heap[smallest] = temp;
+        index = smallest;
+    }
+}
+
+static void closeMerge(MergeState *merge) {
+    if (!merge) {
+        return;
+    }
+
+    for (size_t i = 0; i < merge->reader_count; i++) {
+        freeRecord(merge->current[i]);
+    }
+    free(merge->current);
+    free(merge->readers);
+    free(merge->heap);
+    free(merge);
+}
+
+static MergeState *openMerge(TempSpace *space, TempRun *runs, size_t run_count, const SortSpec *spec,
+                             uint16_t table_id, uint16_t field_count) {
+    MergeState *merge = calloc(1, sizeof(MergeState));
+    if (!merge) {
+        return NULL;
+    }
+
+    merge->spec = spec;
+    merge->readers = malloc(run_count * sizeof(TempRunReader));
+    merge->current = calloc(run_count, sizeof(Record *));
+    merge->heap = malloc(run_count * sizeof(size_t));
+    if (!merge->readers || !merge->current || !merge->heap) {
+        closeMerge(merge);
+        return NULL;
+    }
+    merge->reader_count = run_count;
+
+    for (size_t i = 0; i < run_count; i++) {
+        merge->current[i] = createRecord(table_id, field_count);
+        if (!merge->current[i]) {
+            closeMerge(merge);
+            return NULL;
+        }
+
+        openTempRunReader(space, &runs[i], &merge->readers[i]);
+        int result = nextTempRecord(&merge->readers[i], merge->current[i]);
+        if (result < 0) {
+            closeMerge(merge);
+            return NULL;
+        }
+        if (result == 1) {
+            merge->heap[merge->heap_size++] = i;
+        }
+    }
+
+    for (size_t i = merge->heap_size / 2; i-- > 0;) {
+        siftDownMerge(merge, i);
+    }
+    return merge;
+}
+
+// Smallest record of the merge, NULL once every run is exhausted
+static Record *peekMerge(MergeState *merge) {
+    return merge->heap_size > 0 ? merge->current[merge->heap[0]] : NULL;
+}
+
+// Move past the record returned by peekMerge
+static int advanceMerge(MergeState *merge) {
+    size_t reader = merge->heap[0];
+    int result = nextTempRecord(&merge->readers[reader], merge->current[reader]);
+    if (result < 0) {
+        return -1;
+    }
+    if (result == 0) {
+        merge->heap[0] = merge->heap[--merge->heap_size];
+    }
+    siftDownMerge(merge, 0);
+    return 0;
+}
+
+// Merge runs in groups of SORT_MERGE_FAN_IN until one final merge can read them all at once
+static int reduceRuns(TempSpace *space, TempRun **runs, size_t *run_count, const SortSpec *spec,
+                      uint16_t table_id, uint16_t field_count) {
+    while (*run_count > SORT_MERGE_FAN_IN) {
+        size_t merged_count = (*run_count + SORT_MERGE_FAN_IN - 1) / SORT_MERGE_FAN_IN;
+        TempRun *merged = malloc(merged_count * sizeof(TempRun));
+        if (!merged) {
+            return -1;
+        }
+
+        for (size_t group = 0; group < merged_count; group++) {
+            size_t first = group * SORT_MERGE_FAN_IN;
+            size_t count = *run_count - first < SORT_MERGE_FAN_IN ? *run_count - first : SORT_MERGE_FAN_IN;
+
+            MergeState *merge = openMerge(space, &(*runs)[first], count, spec, table_id, field_count);
+            if (!merge) {
+                free(merged);
+                return -1;
+            }
+
+            initTempRun(&merged[group]);
+            Record *record;
+            while ((record = peekMerge(merge)) != NULL) {
+                if (appendToTempRun(space, &merged[group], record) != 0 || advanceMerge(merge) != 0) {
+                    closeMerge(merge);
+                    free(merged);
+                    return -1;
+                }
+            }
+            closeMerge(merge);
+
+            for (size_t i = first; i < first + count; i++) {
+                releaseTempRun(space, &(*runs)[i]);
+            }
+        }
+
+        free(*runs);
+        *runs = merged;
+        *run_count = merged_count;
+    }
+
+    return 0;
+}
+
+// ORDER BY ... LIMIT k, keep the best k rows in a heap instead of sorting the table
+static int topKSort(SortedScan *sorted, RecordScan *scan, uint16_t table_id) {
+    uint64_t limit = sorted->spec.limit;
+    sorted->records = malloc(limit * sizeof(Record *));
+    Record *incoming = createRecord(table_id, scan->schema->column_count);
+    if (!sorted->records || !incoming) {
+        freeRecord(incoming);
+        return -1;
+    }
+
+    int result;
+    while ((result = nextRecord(scan, incoming)) == 1) {
+        if (sorted->record_count < limit) {
+            sorted->records[sorted->record_count] = incoming;
+            siftUpWorst(sorted->records, sorted->record_count, &sorted->spec);
+            sorted->record_count++;
+
+            incoming = createRecord(table_id, scan->schema->column_count);
+            if (!incoming) {
+                return -1;
+            }
+        } else if (compareRecords(&sorted->spec, incoming, sorted->records[0]) < 0) {
+            // Swap the pointers, the evicted row becomes the buffer for the next read
+            Record *evicted = sorted->records[0];
+            sorted->records[0] = incoming;
+            incoming = evicted;
+            siftDownWorst(sorted->records, sorted->record_count, 0, &sorted->spec);
+        }
+    }
+
+    freeRecord(incoming);
+    if (result < 0) {
+        return -1;
+    }
+
+    return sortRecordArray(sorted->records, sorted->record_count, &sorted->spec);
+}
+
+// Full sort, in memory when the table fits the budget, external merge sort otherwise
+static int externalSort(SortedScan *sorted, RecordScan *scan, uint16_t table_id) {
+    uint16_t field_count = scan->schema->column_count;
+    size_t row_bytes = sortRowMemorySize(field_count);
+    uint64_t capacity = 64;
+    uint64_t count = 0;
+    size_t used_bytes = 0;
+
+    Record **buffered = malloc(capacity * sizeof(Record *));
+    TempRun *runs = NULL;
+    size_t run_count = 0;
+    if (!buffered) {
+        return -1;
+    }
+
+    int result;
+    while (1) {
+        Record *record = createRecord(table_id, field_count);
+        if (!record) {
+            result = -1;
+            break;
+        }
+
+        result = nextRecord(scan, record);
+        if (result != 1) {
+            freeRecord(record);
+            break;
+        }
+
+        if (count == capacity) {
+            capacity *= 2;
+            Record **grown = realloc(buffered, capacity * sizeof(Record *));
+            if (!grown) {
+                freeRecord(record);
+                result = -1;
+                break;
+            }
+            buffered = grown;
+        }
+        buffered[count++] = record;
+        used_bytes += row_bytes;
+
+        // Over budget, spill what we have as a sorted run
+        if (used_bytes >= sorted->spec.memory_budget) {
+            if (!sorted->space) {
+                sorted->space = openTempSpace(scan->db->page_size);
+                if (!sorted->space) {
+                    result = -1;
+                    break;
+                }
+            }
+
+            TempRun *grown = realloc(runs, (run_count + 1) * sizeof(TempRun));
+            if (!grown) {
+                result = -1;
+                break;
+            }
+            runs = grown;
+
+            result = spillRun(sorted->space, buffered, count, &sorted->spec, &runs[run_count++]);
+            count = 0;
+            used_bytes = 0;
+            if (result != 0) {
+                break;
+            }
+        }
+    }
+
+    if (result < 0) {
+        for (uint64_t i = 0; i < count; i++) {
+            freeRecord(buffered[i]);
+        }
+        free(buffered);
+        free(runs);
+        return -1;
+    }
+
+    // Everything fit, hand out the in memory array
+    if (run_count == 0) {
+        sorted->records = buffered;
+        sorted->record_count = count;
+        return sortRecordArray(buffered, count, &sorted->spec);
+    }
+
+    // Spill the tail so every row lives in a run, then merge
+    if (count > 0) {
+        TempRun *grown = realloc(runs, (run_count + 1) * sizeof(TempRun));
+        if (!grown || spillRun(sorted->space, buffered, count, &sorted->spec, &grown[run_count]) != 0) {
+            free(buffered);
+            free(grown ? grown : runs);
+            return -1;
+        }
+        runs = grown;
+        run_count++;
+    }
+    free(buffered);
+
+    sorted->spilled_runs = run_count;
+    if (reduceRuns(sorted->space, &runs, &run_count, &sorted->spec, table_id, field_count) != 0) {
+        free(runs);
+        return -1;
+    }
+
+    sorted->merge = openMerge(sorted->space, runs, run_count, &sorted->spec, table_id, field_count);
+    free(runs); // Readers keep their own position, the run descriptors are not needed anymore
+    return sorted->merge ? 0 : -1;
+}
+
+SortedScan *openSortedScan(MagBase *db, uint16_t table_id, SortSpec *spec) {
+    if (!db || !spec) {
+        return NULL;
+    }
+
+    SortedScan *sorted = calloc(1, sizeof(SortedScan));
+    if (!sorted) {
+        return NULL;
+    }
+    sorted->spec = *spec;
+
+    RecordScan *scan = openFilteredScan(db, table_id, spec->filter);
+    if (!scan) {
+        free(sorted);
+        return NULL;
+    }
+
+    int result;
+    if (sortUsesTopK(spec, scan->schema->column_count)) {
+        result = topKSort(sorted, scan, table_id);
+    } else {
+        result = externalSort(sorted, scan, table_id);
+    }
+
+    sorted->input_rows = scan->rows_matched;
+    closeRecordScan(scan);
+    if (result != 0) {
+        closeSortedScan(sorted);
+        return NULL;
+    }
+    return sorted;
+}
+
+// Copy values into the caller's record so it never aliases sort owned memory
+static void copyRecordInto(Record *dest, Record *src) {
+    dest->record_id = src->record_id;
+    dest->table_id = src->table_id;
+    dest->field_count = src->field_count;
+    memcpy(dest->fields, src->fields, src->field_count * sizeof(RecordField));
+}
+
+int nextSortedRecord(SortedScan *sorted, Record *record) {
+    if (!sorted || !record) {
+        return -1;
+    }
+    if (sorted->spec.limit > 0 && sorted->emitted >= sorted->spec.limit) {
+        return 0;
+    }
+
+    if (sorted->merge) {
+        Record *next = peekMerge(sorted->merge);
+        if (!next) {
+            return 0;
+        }
+        copyRecordInto(record, next);
+        if (advanceMerge(sorted->merge) != 0) {
+            return -1;
+        }
+    } else {
+        if (sorted->position >= sorted->record_count) {
+            return 0;
+        }
+        copyRecordInto(record, sorted->records[sorted->position++]);
+    }
+
+    sorted->emitted++;
+    return 1;
+}
+
+void closeSortedScan(SortedScan *sorted) {
+    if (!sorted) {
+        return;
+    }
+
+    if (sorted->records) {
+        for (uint64_t i = 0; i < sorted->record_count; i++) {
+            freeRecord(sorted->records[i]);
+        }
+        free(sorted->records);
+    }
+    closeMerge(sorted->merge);
+    closeTempSpace(sorted->space);
+    free(sorted);
+}
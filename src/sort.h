@@ -0,0 +1,72 @@
+//     Keagan Anderson
+//        MagBase
+//       10/19/2026
+//
+//     ORDER BY support, in memory sorts with external merge sort and top-K fallbacks
+
+#pragma once
+
+#include "db-init.h"
+#include "records.h"
+#include "structs/schemaStruct.h"
+#include "temp-pages.h"
+#include <stdint.h>
+
+// One ORDER BY column
+typedef struct {
+    uint16_t column;                    // Column index in the table schema
+    uint8_t descending;                 // 1 for DESC, 0 for ASC
+} SortKey;
+
+struct Filter;
+
+typedef struct {
+    SortKey keys[MAX_COLUMNS];
+    uint16_t key_count;
+    uint64_t limit;                     // Rows to return, 0 for all of them
+    size_t memory_budget;               // Bytes of rows held in memory before spilling a run
+    const struct Filter *filter;        // Only matching rows are sorted, NULL for every row
+} SortSpec;
+
+// Streaming sorted output of a table
+typedef struct {
+    SortSpec spec;
+    Record **records;                   // Sorted rows when everything fit in memory
+    uint64_t record_count;
+    uint64_t position;                  // Next row of records to return
+    TempSpace *space;                   // Spilled runs, NULL if nothing spilled
+    struct MergeState *merge;           // Final merge over the runs in space
+    uint64_t emitted;                   // Rows returned so far, for the limit
+    uint64_t input_rows;                // Rows fed into the sort, for reporting
+    uint64_t spilled_runs;              // Runs written during the sort, for reporting
+} SortedScan;
+
+// Fill a spec with defaults: no keys, no limit, SORT_MEMORY_BUDGET
+void initSortSpec(SortSpec *spec);
+
+// Parse an ORDER BY list like "name:desc,id" against a schema and append the keys to spec
+// Returns 0 on success, -1 on an unknown column or direction
+int parseSortKeys(TableSchemaRecord *schema, const char *order_by, SortSpec *spec);
+
+// Compare two records of the same table by the keys of spec, NULL sorts before any value
+// Returns <0, 0 or >0 like strcmp
+int compareRecords(const SortSpec *spec, Record *a, Record *b);
+
+// Bytes one buffered row of field_count columns costs against the memory budget
+size_t sortRowMemorySize(uint16_t field_count);
+
+// Returns 1 if the spec is served by a bounded top-K heap instead of a full sort
+int sortUsesTopK(const SortSpec *spec, uint16_t field_count);
+
+// Sort a table. Rows are buffered up to spec->memory_budget bytes, past that sorted runs are
+// spilled to temporary pages and merged. With a limit that fits the budget a bounded heap is
+// used instead of a full sort
+// Returns NULL on error, caller must close it with closeSortedScan
+SortedScan *openSortedScan(MagBase *db, uint16_t table_id, SortSpec *spec);
+
+// Copy the next sorted record into a record created with createRecord
+// Returns 1 if a record was read, 0 at the end, -1 on error
+int nextSortedRecord(SortedScan *sorted, Record *record);
+
+// Free the sort and its temporary pages
+void closeSortedScan(SortedScan *sorted);
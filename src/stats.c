@@ -0,0 +1,342 @@
+//     Keagan Anderson
+//        MagBase
+//       10/19/2026
+//
+//     Table statistics (-analyze) and selectivity estimates for the planner
+
+#include "stats.h"
+#include "buffer.h"
+#include "schema.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HLL_REGISTERS (1 << STATS_HLL_BITS)
+
+// Per column state while scanning
+typedef struct {
+    uint8_t registers[HLL_REGISTERS];
+    int64_t *sample;
+    uint64_t sample_count;              // Non NULL values seen so far
+} ColumnCollector;
+
+int64_t statsKey(RecordField *field) {
+    switch (field->type) {
+        case COL_INT:
+            return field->value.int_val;
+        case COL_BOOL:
+            return field->value.bool_val;
+        case COL_TEXT: {
+            // Big endian prefix with the sign bit flipped so signed compares keep byte order
+            uint64_t prefix = 0;
+            const unsigned char *text = (const unsigned char *)field->value.text_val;
+            for (int i = 0; i < 8; i++) {
+                prefix <<= 8;
+                if (*text) {
+                    prefix |= *text++;
+                }
+            }
+            return (int64_t)(prefix ^ 0x8000000000000000ULL);
+        }
+    }
+    return 0;
+}
+
+void formatStatsKey(uint8_t type, int64_t key, char *out, size_t out_size) {
+    switch (type) {
+        case COL_INT:
+            snprintf(out, out_size, "%lld", (long long)key);
+            break;
+        case COL_BOOL:
+            snprintf(out, out_size, "%s", key ? "true" : "false");
+            break;
+        case COL_TEXT: {
+            uint64_t prefix = (uint64_t)key ^ 0x8000000000000000ULL;
+            char text[9];
+            for (int i = 0; i < 8; i++) {
+                text[i] = (char)(prefix >> (56 - 8 * i));
+            }
+            text[8] = '\0';
+            snprintf(out, out_size, "'%s'", text);
+            break;
+        }
+    }
+}
+
+// Small deterministic generator so re-analyzing unchanged data gives the same histogram
+static uint64_t nextRandom(uint64_t *state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+static void addToHyperLogLog(uint8_t *registers, uint64_t hash) {
+    uint32_t index = (uint32_t)(hash >> (64 - STATS_HLL_BITS));
+    uint64_t rest = hash << STATS_HLL_BITS;
+    uint8_t rank = rest ? (uint8_t)(__builtin_clzll(rest) + 1) : (uint8_t)(64 - STATS_HLL_BITS + 1);
+    if (rank > registers[index]) {
+        registers[index] = rank;
+    }
+}
+
+static uint64_t estimateHyperLogLog(uint8_t *registers) {
+    double sum = 0.0;
+    int zeros = 0;
+    for (int i = 0; i < HLL_REGISTERS; i++) {
+        sum += ldexp(1.0, -registers[i]);
+        if (registers[i] == 0) {
+            zeros++;
+        }
+    }
+
+    double m = HLL_REGISTERS;
+    double estimate = (0.7213 / (1.0 + 1.079 / m)) * m * m / sum;
+
+    // Linear counting is more accurate while many registers are still empty
+    if (estimate <= 2.5 * m && zeros > 0) {
+        estimate = m * log(m / zeros);
+    }
+    return (uint64_t)(estimate + 0.5);
+}
+
+static int compareKeys(const void *a, const void *b) {
+    int64_t x = *(const int64_t *)a;
+    int64_t y = *(const int64_t *)b;
+    return (x > y) - (x < y);
+}
+
+// Find the stats page of a table, returns 0 if it has none
+static uint64_t findStatsPage(MagBase *db, uint16_t table_id) {
+    uint64_t page_num = db->header->stats_root;
+
+    while (page_num != 0) {
+        char *page_buffer = readPageFromBuffer(db->buffer_pool, page_num, db->file_pointer, db->page_size);
+        if (!page_buffer) {
+            return 0;
+        }
+
+        StatsPageHeader *stats_header = (StatsPageHeader *)page_buffer;
+        if (stats_header->table_id == table_id) {
+            return page_num;
+        }
+        page_num = stats_header->next_stats_page;
+    }
+
+    return 0;
+}
+
+static int writeTableStats(MagBase *db, TableStats *stats) {
+    uint64_t page_num = findStatsPage(db, stats->table_id);
+    uint64_t previous_root = db->header->stats_root;
+    bool new_page = page_num == 0;
+
+    // First analyze of this table, push a new page on the front of the chain
+    if (new_page) {
+        page_num = db->header->page_count++;
+        db->header->stats_root = page_num;
+    }
+
+    char *page_buffer = readPageFromBuffer(db->buffer_pool, page_num, db->file_pointer, db->page_size);
+    if (!page_buffer) {
+        return -1;
+    }
+
+    StatsPageHeader *stats_header = (StatsPageHeader *)page_buffer;
+    if (new_page) {
+        stats_header->next_stats_page = previous_root;
+    }
+    stats_header->table_id = stats->table_id;
+    memcpy(page_buffer + sizeof(StatsPageHeader), stats, sizeof(TableStats));
+
+    markPageDirty(db->buffer_pool, page_num);
+    return 0;
+}
+
+int readTableStats(MagBase *db, uint16_t table_id, TableStats *stats) {
+    if (!db || !stats || table_id == 0) {
+        return -1;
+    }
+
+    uint64_t page_num = findStatsPage(db, table_id);
+    if (page_num == 0) {
+        return -1;
+    }
+
+    char *page_buffer = readPageFromBuffer(db->buffer_pool, page_num, db->file_pointer, db->page_size);
+    if (!page_buffer) {
+        return -1;
+    }
+    memcpy(stats, page_buffer + sizeof(StatsPageHeader), sizeof(TableStats));
+    return 0;
+}
+
+int analyzeTable(MagBase *db, uint16_t table_id, TableStats *stats) {
+    if (!db || !stats) {
+        return -1;
+    }
+
+    RecordScan *scan = openRecordScan(db, table_id);
+    if (!scan) {
+        return -1;
+    }
+
+    uint16_t column_count = scan->schema->column_count;
+    memset(stats, 0, sizeof(TableStats));
+    stats->table_id = table_id;
+    stats->column_count = column_count;
+    countRecords(db, table_id, &stats->page_count);
+
+    ColumnCollector *collectors = calloc(column_count, sizeof(ColumnCollector));
+    Record *record = createRecord(table_id, column_count);
+    int result = (collectors && record) ? 0 : -1;
+    for (uint16_t col = 0; result == 0 && col < column_count; col++) {
+        collectors[col].sample = malloc(STATS_SAMPLE_SIZE * sizeof(int64_t));
+        if (!collectors[col].sample) {
+            result = -1;
+        }
+    }
+
+    uint64_t random_state = 0x2545F4914F6CDD1DULL;
+    while (result == 0 && (result = nextRecord(scan, record)) == 1) {
+        result = 0;
+        stats->row_count++;
+
+        for (uint16_t col = 0; col < column_count; col++) {
+            RecordField *field = &record->fields[col];
+            ColumnStats *column = &stats->columns[col];
+            ColumnCollector *collector = &collectors[col];
+
+            if (field->is_null) {
+                column->null_count++;
+                continue;
+            }
+
+            int64_t key = statsKey(field);
+            if (collector->sample_count == 0 || key < column->min_key) {
+                column->min_key = key;
+            }
+            if (collector->sample_count == 0 || key > column->max_key) {
+                column->max_key = key;
+            }
+
+            addToHyperLogLog(collector->registers, hashRecordField(field));
+
+            // Reservoir sampling (algorithm R) keeps a uniform sample for the histogram
+            if (collector->sample_count < STATS_SAMPLE_SIZE) {
+                collector->sample[collector->sample_count] = key;
+            } else {
+                uint64_t slot = nextRandom(&random_state) % (collector->sample_count + 1);
+                if (slot < STATS_SAMPLE_SIZE) {
+                    collector->sample[slot] = key;
+                }
+            }
+            collector->sample_count++;
+        }
+    }
+
+    if (result == 0) {
+        for (uint16_t col = 0; col < column_count; col++) {
+            ColumnStats *column = &stats->columns[col];
+            ColumnCollector *collector = &collectors[col];
+            if (collector->sample_count == 0) {
+                continue;
+            }
+
+            column->distinct_count = estimateHyperLogLog(collector->registers);
+            if (column->distinct_count == 0) {
+                column->distinct_count = 1;
+            }
+
+            // Equi-depth bounds from the sorted sample, the ends are the exact min and max
+            uint64_t sample_size =
+                collector->sample_count < STATS_SAMPLE_SIZE ? collector->sample_count : STATS_SAMPLE_SIZE;
+            qsort(collector->sample, sample_size, sizeof(int64_t), compareKeys);
+
+            uint16_t buckets = sample_size < STATS_HISTOGRAM_BUCKETS ? (uint16_t)sample_size : STATS_HISTOGRAM_BUCKETS;
+            column->bucket_count = buckets;
+            column->bounds[0] = column->min_key;
+            for (uint16_t b = 1; b < buckets; b++) {
+                column->bounds[b] = collector->sample[(b * sample_size) / buckets];
+            }
+            column->bounds[buckets] = column->max_key;
+        }
+
+        result = writeTableStats(db, stats);
+    }
+
+    if (collectors) {
+        for (uint16_t col = 0; col < column_count; col++) {
+            free(collectors[col].sample);
+        }
+    }
+    free(collectors);
+    freeRecord(record);
+    closeRecordScan(scan);
+    return result;
+}
+
+// Fraction of non NULL values <= key, interpolating linearly inside a histogram bucket
+static double fractionAtMost(const ColumnStats *column, int64_t key) {
+    uint16_t buckets = column->bucket_count;
+    if (buckets == 0 || key < column->bounds[0]) {
+        return 0.0;
+    }
+    if (key >= column->bounds[buckets]) {
+        return 1.0;
+    }
+
+    for (uint16_t b = 0; b < buckets; b++) {
+        int64_t low = column->bounds[b];
+        int64_t high = column->bounds[b + 1];
+        if (key < high) {
+            double within = high > low ? ((double)key - (double)low) / ((double)high - (double)low) : 1.0;
+            return (b + within) / buckets;
+        }
+    }
+    return 1.0;
+}
+
+double estimatePredicateSelectivity(const TableStats *stats, const Predicate *predicate) {
+    if (!stats || stats->row_count == 0 || predicate->column >= stats->column_count) {
+        return 1.0;
+    }
+
+    const ColumnStats *column = &stats->columns[predicate->column];
+    double null_fraction = (double)column->null_count / (double)stats->row_count;
+    double value_fraction = 1.0 - null_fraction;
+
+    if (predicate->value.is_null) {
+        return predicate->op == PRED_EQ ? null_fraction : value_fraction;
+    }
+    if (column->bucket_count == 0) {
+        return 0.0;
+    }
+
+    int64_t key = statsKey((RecordField *)&predicate->value);
+    double equal = 1.0 / (double)(column->distinct_count ? column->distinct_count : 1);
+    if (key < column->min_key || key > column->max_key) {
+        equal = 0.0;
+    }
+
+    double at_most = fractionAtMost(column, key);
+    double below = at_most - equal > 0.0 ? at_most - equal : 0.0;
+    double selectivity = 0.0;
+
+    switch (predicate->op) {
+        case PRED_EQ: selectivity = equal; break;
+        case PRED_NE: selectivity = 1.0 - equal; break;
+        case PRED_LT: selectivity = below; break;
+        case PRED_LE: selectivity = at_most; break;
+        case PRED_GT: selectivity = 1.0 - at_most; break;
+        case PRED_GE: selectivity = 1.0 - below; break;
+    }
+
+    if (selectivity < 0.0) {
+        selectivity = 0.0;
+    }
+    if (selectivity > 1.0) {
+        selectivity = 1.0;
+    }
+    return selectivity * value_fraction;
+}
@@ -0,0 +1,60 @@
+//     Keagan Anderson
+//        MagBase
+//       10/19/2026
+//
+//     Table statistics (-analyze) and selectivity estimates for the planner
+
+#pragma once
+
+#include "db-init.h"
+#include "filter.h"
+#include "globals.h"
+#include "records.h"
+#include "structs/schemaStruct.h"
+#include <stdint.h>
+
+// Values are summarised as order preserving 64 bit keys, see statsKey
+typedef struct {
+    uint64_t null_count;
+    uint64_t distinct_count;            // HyperLogLog estimate over non NULL values
+    int64_t min_key;                    // Only meaningful when some value is non NULL
+    int64_t max_key;
+    uint16_t bucket_count;              // Equi-depth histogram, 0 if every value is NULL
+    int64_t bounds[STATS_HISTOGRAM_BUCKETS + 1]; // Bucket i covers [bounds[i], bounds[i + 1]]
+} ColumnStats;
+
+// Written raw after a StatsPageHeader, one page per analyzed table
+typedef struct {
+    uint16_t table_id;
+    uint16_t column_count;
+    uint64_t row_count;
+    uint64_t page_count;
+    ColumnStats columns[MAX_COLUMNS];
+} TableStats;
+
+// Stats pages form a chain from Header.stats_root
+typedef struct {
+    uint16_t table_id;
+    uint64_t next_stats_page;
+} StatsPageHeader;
+
+_Static_assert(sizeof(StatsPageHeader) + sizeof(TableStats) <= MIN_PAGE_SIZE - sizeof(PageTrailer),
+               "TableStats must fit in one page");
+
+// Order preserving key of a non NULL value. INT and BOOL map to themselves, TEXT to its
+// first 8 bytes so keys of text columns only order by prefix
+int64_t statsKey(RecordField *field);
+
+// Render a key of a column type for display into out
+void formatStatsKey(uint8_t type, int64_t key, char *out, size_t out_size);
+
+// Scan a table, collect its statistics into stats and store them in the table's stats page
+// Returns 0 on success, -1 on error
+int analyzeTable(MagBase *db, uint16_t table_id, TableStats *stats);
+
+// Load the statistics stored by the last -analyze of a table
+// Returns 0 if found, -1 if the table was never analyzed
+int readTableStats(MagBase *db, uint16_t table_id, TableStats *stats);
+
+// Estimated fraction of rows satisfying a predicate, from the column's statistics
+double estimatePredicateSelectivity(const TableStats *stats, const Predicate *predicate);
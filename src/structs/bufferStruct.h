@@ -1,10 +1,62 @@
+#include "../globals.h"
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
 
 #pragma once
 
+struct Wal;
+
+// Uncommitted page pushed out of the pool, kept in memory until the next commit
+typedef struct {
+    size_t page_id;
+    char *page;
+    char *base;
+    bool compress;            // The frame had FRAME_COMPRESS
+} DeferredPage;
+
+#define FRAME_IN_USE 0x01     // Holds page_id and is linked into its partition
+#define FRAME_REFERENCED 0x02 // Used since the clock hand last passed, skipped once
+#define FRAME_DIRTY 0x04      // Modified in memory and not written to disk
+#define FRAME_PENDING 0x08    // Changed since the last commit (no_steal only)
+#define FRAME_COMPRESS 0x10   // Written as a compressed image when that saves space (see page-compress.h)
+
+// One page of the pool. flags, page_id, next and pins change under the lock of the partition
+// the page hashes to, the bytes of page under latch
+typedef struct {
+    char *page;               // Allocated when the frame first holds a page
+    char *base;               // The page as of the last commit (no_steal only)
+    size_t page_id;
+    int next;                 // Next frame of the same partition, -1 at the end
+    int pins;                 // Threads holding the page, a pinned frame is never evicted
+    uint8_t flags;
+    pthread_rwlock_t latch;   // Shared while a reader copies the page, exclusive while a writer holds it
+} BufferFrame;
+
+// A slice of the page table, page ids hash to one by their low bits
+typedef struct {
+    pthread_mutex_t lock;
+    int head;                 // First frame, -1 if none
+} BufferPartition;
+
+// The last pages handed out to a thread stay pinned, so a caller may hold two at once
+typedef struct {
+    int frames[2];            // Oldest first, -1 if empty
+} PageWindow;
+
 typedef struct {
-    char **pages;     // An array of 4096 char bytes each storing a page
-    size_t *page_ids; // An parallel array to pages with the id of the page
-    int num_pages;    // The number of pages loaded
-    int *dirty_flags; // Dirty means the file is modified in memory and not written to disk
-} BufferPool;         // Logic needs implementation
+    BufferFrame *frames;      // BUFFER_SIZE frames
+    size_t page_size;         // Bytes of every page the frames hold
+    BufferPartition partitions[BUFFER_PARTITIONS];
+    pthread_mutex_t clock_lock; // Guards clock_hand and claiming a frame for a new page
+    int clock_hand;
+    PageWindow window;        // Window of threads that did not enter the pool, one at a time
+    int no_steal;             // Set with a WAL, uncommitted pages never reach the file before their log
+    pthread_mutex_t deferred_lock; // Guards the deferred list
+    DeferredPage *deferred;   // Pending pages evicted from the frames
+    size_t deferred_count;
+    size_t deferred_capacity;
+    int checksums;            // Pages carry a CRC32C, sealed on every write and checked on every read
+    struct Wal *wal;          // Synced before a page is written, set when commits leave it unsynced
+} BufferPool;
@@ -8,6 +8,10 @@
 
 typedef enum { COL_INT, COL_TEXT, COL_BOOL } ColumnType;
 
+#define TABLE_COMPRESSED 0x0001     // Data pages are stored compressed (see page-compress.h)
+
+_Static_assert(MAX_COLUMNS <= 16, "dictionary_columns has a bit per column");
+
 typedef struct {
     uint8_t type;               // ColumnType
     uint8_t nullable;           // 0 or 1
@@ -19,6 +23,11 @@ typedef struct {
     uint16_t table_id;
     uint16_t column_count;
     uint32_t root_page;
+    uint32_t directory_page;    // First page directory page, 0 until the table has a page
+    uint16_t flags;             // TABLE_ bits, files from 1.6 on
+    uint16_t dictionary_columns; // Bit per column whose values rows hold as dictionary codes, files from 1.7 on
+    uint32_t dictionary_page;   // First dictionary page, 0 until a dictionary column gets a value
+    uint32_t zone_map_page;     // First zone map page, 0 until the table has a row, files from 1.8 on
     uint64_t next_record_id;    // Next sequential record ID
     uint16_t name_len;
     char table_name[MAX_TABLE_NAME];
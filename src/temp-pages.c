@@ -0,0 +1,190 @@
+//     Keagan Anderson
+//        MagBase
+//       10/19/2026
+//
+//     Temporary page space for operators that spill (sorts, joins)
+
+#include "temp-pages.h"
+#include "buffer.h"
+#include "globals.h"
+#include <stdlib.h>
+#include <string.h>
+
+TempSpace *openTempSpace(size_t page_size) {
+    TempSpace *space = malloc(sizeof(TempSpace));
+    if (!space) {
+        return NULL;
+    }
+
+    space->file_pointer = tmpfile();
+    if (!space->file_pointer) {
+        fprintf(stderr, "Failed to create temporary file for spilling\n");
+        free(space);
+        return NULL;
+    }
+
+    space->buffer_pool = createBufferPool(page_size);
+    if (!space->buffer_pool) {
+        fprintf(stderr, "Failed to create the buffer pool for spilling\n");
+        fclose(space->file_pointer);
+        free(space);
+        return NULL;
+    }
+    space->page_size = page_size;
+    space->fill_limit = page_size < UINT16_MAX ? page_size : UINT16_MAX;
+    space->page_count = 1;
+    space->free_pages = NULL;
+    space->free_count = 0;
+    space->free_capacity = 0;
+    return space;
+}
+
+void closeTempSpace(TempSpace *space) {
+    if (!space) {
+        return;
+    }
+
+    // Nothing is flushed, the file is thrown away
+    freeBufferPool(space->buffer_pool);
+    fclose(space->file_pointer);
+    free(space->free_pages);
+    free(space);
+}
+
+void initTempRun(TempRun *run) {
+    run->first_page = 0;
+    run->last_page = 0;
+    run->record_count = 0;
+}
+
+// Hand out a page id, preferring pages released by earlier runs
+static uint64_t allocateTempPage(TempSpace *space) {
+    if (space->free_count > 0) {
+        return space->free_pages[--space->free_count];
+    }
+    return space->page_count++;
+}
+
+// Load a temp page and reset it to an empty record page
+static char *initTempPage(TempSpace *space, uint64_t page_num) {
+    char *page_buffer =
+        readPageFromBuffer(space->buffer_pool, page_num, space->file_pointer, space->page_size);
+    if (!page_buffer) {
+        return NULL;
+    }
+
+    PageHeader *page_header = (PageHeader *)page_buffer;
+    page_header->slot_count = 0;
+    page_header->free_space_offset = sizeof(PageHeader);
+    page_header->next_page = 0;
+    markPageDirty(space->buffer_pool, page_num);
+    return page_buffer;
+}
+
+int appendToTempRun(TempSpace *space, TempRun *run, Record *record) {
+    if (!space || !run || !record) {
+        return -1;
+    }
+
+    size_t record_size = getRecordSize(record);
+    if (record_size > space->fill_limit - sizeof(PageHeader)) {
+        fprintf(stderr, "Record too large to spill to a temporary page\n");
+        return -1;
+    }
+
+    char *page_buffer = NULL;
+    if (run->last_page == 0) {
+        run->first_page = allocateTempPage(space);
+        run->last_page = run->first_page;
+        page_buffer = initTempPage(space, run->last_page);
+    } else {
+        page_buffer = readPageFromBuffer(space->buffer_pool, run->last_page, space->file_pointer,
+                                         space->page_size);
+    }
+    if (!page_buffer) {
+        return -1;
+    }
+
+    PageHeader *page_header = (PageHeader *)page_buffer;
+
+    // Chain a fresh page when the record does not fit
+    if (space->fill_limit - page_header->free_space_offset < record_size) {
+        uint64_t new_page_num = allocateTempPage(space);
+        page_header->next_page = new_page_num;
+        markPageDirty(space->buffer_pool, run->last_page);
+
+        page_buffer = initTempPage(space, new_page_num);
+        if (!page_buffer) {
+            return -1;
+        }
+        page_header = (PageHeader *)page_buffer;
+        run->last_page = new_page_num;
+    }
+
+    serializeRecord((uint8_t *)page_buffer + page_header->free_space_offset, record);
+    page_header->slot_count++;
+    page_header->free_space_offset += (uint16_t)record_size;
+    markPageDirty(space->buffer_pool, run->last_page);
+
+    run->record_count++;
+    return 0;
+}
+
+void openTempRunReader(TempSpace *space, TempRun *run, TempRunReader *reader) {
+    reader->space = space;
+    reader->page_num = run->first_page;
+    reader->slot = 0;
+    reader->offset = sizeof(PageHeader);
+}
+
+int nextTempRecord(TempRunReader *reader, Record *record) {
+    TempSpace *space = reader->space;
+
+    while (reader->page_num != 0) {
+        char *page_buffer = readPageFromBuffer(space->buffer_pool, reader->page_num,
+                                               space->file_pointer, space->page_size);
+        if (!page_buffer) {
+            return -1;
+        }
+
+        PageHeader *page_header = (PageHeader *)page_buffer;
+        if (reader->slot < page_header->slot_count) {
+            reader->offset += (uint16_t)deserializeRecord((uint8_t *)page_buffer + reader->offset, record);
+            reader->slot++;
+            return 1;
+        }
+
+        reader->page_num = page_header->next_page;
+        reader->slot = 0;
+        reader->offset = sizeof(PageHeader);
+    }
+
+    return 0;
+}
+
+void releaseTempRun(TempSpace *space, TempRun *run) {
+    uint64_t page_num = run->first_page;
+
+    while (page_num != 0) {
+        char *page_buffer =
+            readPageFromBuffer(space->buffer_pool, page_num, space->file_pointer, space->page_size);
+        if (!page_buffer) {
+            break;
+        }
+        uint64_t next_page = ((PageHeader *)page_buffer)->next_page;
+
+        if (space->free_count == space->free_capacity) {
+            size_t new_capacity = space->free_capacity ? space->free_capacity * 2 : 64;
+            uint64_t *grown = realloc(space->free_pages, new_capacity * sizeof(uint64_t));
+            if (!grown) {
+                break;
+            }
+            space->free_pages = grown;
+            space->free_capacity = new_capacity;
+        }
+        space->free_pages[space->free_count++] = page_num;
+        page_num = next_page;
+    }
+
+    initTempRun(run);
+}
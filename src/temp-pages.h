@@ -0,0 +1,63 @@
+//     Keagan Anderson
+//        MagBase
+//       10/19/2026
+//
+//     Temporary page space for operators that spill (sorts, joins)
+
+#pragma once
+
+#include "db-init.h"
+#include "records.h"
+#include <stdint.h>
+#include <stdio.h>
+
+// A scratch file with its own buffer pool, spilled pages never evict table pages
+// Page 0 is never handed out so 0 can mean "no page" like in the table page chains
+typedef struct {
+    FILE *file_pointer;       // Anonymous tmpfile(), removed by the OS once closed
+    BufferPool *buffer_pool;  // Private pool for the scratch pages
+    size_t page_size;
+    size_t fill_limit;        // Bytes of a page records may fill, offsets of PageHeader stop at UINT16_MAX
+    uint64_t page_count;      // Next never used page id
+    uint64_t *free_pages;     // Pages returned by releaseTempRun, reused before growing the file
+    size_t free_count;
+    size_t free_capacity;
+} TempSpace;
+
+// A sequence of records written to a chain of temp pages
+typedef struct {
+    uint64_t first_page;
+    uint64_t last_page;
+    uint64_t record_count;
+} TempRun;
+
+// Forward cursor over a TempRun
+typedef struct {
+    TempSpace *space;
+    uint64_t page_num;
+    uint16_t slot;
+    uint16_t offset;
+} TempRunReader;
+
+// Create the scratch file, returns NULL if it can't be created
+TempSpace *openTempSpace(size_t page_size);
+
+// Close the scratch file, every run in it becomes invalid
+void closeTempSpace(TempSpace *space);
+
+// Start an empty run
+void initTempRun(TempRun *run);
+
+// Append a record to the end of a run
+// Returns 0 on success, -1 on error (record larger than a page, I/O failure)
+int appendToTempRun(TempSpace *space, TempRun *run, Record *record);
+
+// Position a reader at the start of a run
+void openTempRunReader(TempSpace *space, TempRun *run, TempRunReader *reader);
+
+// Read the next record of a run into a record created with createRecord
+// Returns 1 if a record was read, 0 at the end of the run, -1 on error
+int nextTempRecord(TempRunReader *reader, Record *record);
+
+// Give the pages of a run back to the space so later runs can reuse them
+void releaseTempRun(TempSpace *space, TempRun *run);
@@ -0,0 +1,208 @@
+//     Keagan Anderson
+//        MagBase
+//       10/19/2026
+//
+//     Fixed pool of worker threads that run morsels of work with work stealing
+
+#include "thread-pool.h"
+#include "globals.h"
+#include <stdlib.h>
+#include <unistd.h>
+
+uint32_t defaultThreadCount(void) {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cores < 1) {
+        return 1;
+    }
+    return cores > SCAN_MAX_THREADS ? SCAN_MAX_THREADS : (uint32_t)cores;
+}
+
+// Take the next morsel of the worker's own range
+static int takeMorsel(PoolWorker *worker, uint64_t *morsel) {
+    int found = 0;
+    pthread_mutex_lock(&worker->lock);
+    if (worker->head < worker->tail) {
+        *morsel = worker->head++;
+        found = 1;
+    }
+    pthread_mutex_unlock(&worker->lock);
+    return found;
+}
+
+// Move the back half of another worker's range into this one, the fullest victim is picked
+// Returns 1 if anything was stolen, 0 once every range is empty
+static int stealMorsels(PoolWorker *thief) {
+    ThreadPool *pool = thief->pool;
+
+    while (1) {
+        PoolWorker *victim = NULL;
+        uint64_t most = 0;
+        for (uint32_t i = 1; i < pool->thread_count; i++) {
+            PoolWorker *candidate = &pool->workers[(thief->index + i) % pool->thread_count];
+            pthread_mutex_lock(&candidate->lock);
+            uint64_t left = candidate->tail - candidate->head;
+            pthread_mutex_unlock(&candidate->lock);
+            if (left > most) {
+                most = left;
+                victim = candidate;
+            }
+        }
+        if (!victim) {
+            return 0;
+        }
+
+        pthread_mutex_lock(&victim->lock);
+        uint64_t left = victim->tail - victim->head;
+        uint64_t take = (left + 1) / 2;
+        uint64_t first = victim->tail - take;
+        if (take > 0) {
+            victim->tail = first;
+        }
+        pthread_mutex_unlock(&victim->lock);
+
+        // The victim may have drained its range since the look, try again
+        if (take > 0) {
+            pthread_mutex_lock(&thief->lock);
+            thief->head = first;
+            thief->tail = first + take;
+            thief->steals++;
+            pthread_mutex_unlock(&thief->lock);
+            return 1;
+        }
+    }
+}
+
+static void *workerMain(void *arg) {
+    PoolWorker *worker = arg;
+    ThreadPool *pool = worker->pool;
+    uint64_t seen = 0;
+
+    while (1) {
+        pthread_mutex_lock(&pool->lock);
+        while (!pool->shutdown && pool->generation == seen) {
+            pthread_cond_wait(&pool->work_ready, &pool->lock);
+        }
+        if (pool->shutdown) {
+            pthread_mutex_unlock(&pool->lock);
+            return NULL;
+        }
+        seen = pool->generation;
+        MorselFunction function = pool->function;
+        void *context = pool->context;
+        pthread_mutex_unlock(&pool->lock);
+
+        // No morsels are added during a job, so once stealing finds nothing the job is done
+        uint64_t morsel;
+        do {
+            while (takeMorsel(worker, &morsel)) {
+                function(context, worker->index, morsel);
+            }
+        } while (stealMorsels(worker));
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->running == 0) {
+            pthread_cond_signal(&pool->work_done);
+        }
+        pthread_mutex_unlock(&pool->lock);
+    }
+}
+
+ThreadPool *createThreadPool(uint32_t thread_count) {
+    if (thread_count == 0) {
+        thread_count = defaultThreadCount();
+    }
+    if (thread_count > SCAN_MAX_THREADS) {
+        thread_count = SCAN_MAX_THREADS;
+    }
+
+    ThreadPool *pool = calloc(1, sizeof(ThreadPool));
+    if (!pool) {
+        return NULL;
+    }
+    pool->workers = calloc(thread_count, sizeof(PoolWorker));
+    if (!pool->workers) {
+        free(pool);
+        return NULL;
+    }
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work_ready, NULL);
+    pthread_cond_init(&pool->work_done, NULL);
+
+    for (uint32_t i = 0; i < thread_count; i++) {
+        PoolWorker *worker = &pool->workers[i];
+        worker->pool = pool;
+        worker->index = i;
+        pthread_mutex_init(&worker->lock, NULL);
+        if (pthread_create(&worker->thread, NULL, workerMain, worker) != 0) {
+            pthread_mutex_destroy(&worker->lock);
+            freeThreadPool(pool);
+            return NULL;
+        }
+        pool->thread_count++;
+    }
+
+    return pool;
+}
+
+int runMorsels(ThreadPool *pool, uint64_t morsel_count, MorselFunction function, void *context, uint64_t *steals) {
+    if (!pool || !function) {
+        return -1;
+    }
+    if (steals) {
+        *steals = 0;
+    }
+    if (morsel_count == 0) {
+        return 0;
+    }
+
+    // Hand every worker an equal contiguous slice up front, stealing evens out the rest
+    pthread_mutex_lock(&pool->lock);
+    for (uint32_t i = 0; i < pool->thread_count; i++) {
+        PoolWorker *worker = &pool->workers[i];
+        pthread_mutex_lock(&worker->lock);
+        worker->head = morsel_count * i / pool->thread_count;
+        worker->tail = morsel_count * (i + 1) / pool->thread_count;
+        worker->steals = 0;
+        pthread_mutex_unlock(&worker->lock);
+    }
+    pool->function = function;
+    pool->context = context;
+    pool->running = pool->thread_count;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->work_ready);
+
+    while (pool->running > 0) {
+        pthread_cond_wait(&pool->work_done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    if (steals) {
+        for (uint32_t i = 0; i < pool->thread_count; i++) {
+            *steals += pool->workers[i].steals;
+        }
+    }
+    return 0;
+}
+
+void freeThreadPool(ThreadPool *pool) {
+    if (!pool) {
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = 1;
+    pthread_cond_broadcast(&pool->work_ready);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (uint32_t i = 0; i < pool->thread_count; i++) {
+        pthread_join(pool->workers[i].thread, NULL);
+        pthread_mutex_destroy(&pool->workers[i].lock);
+    }
+
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->work_ready);
+    pthread_cond_destroy(&pool->work_done);
+    free(pool->workers);
+    free(pool);
+}
@@ -0,0 +1,55 @@
+//     Keagan Anderson
+//        MagBase
+//       10/19/2026
+//
+//     Fixed pool of worker threads that run morsels of work with work stealing
+
+#pragma once
+
+#include <pthread.h>
+#include <stdint.h>
+
+// Runs one morsel, worker is the index of the calling thread (0 .. thread_count - 1)
+typedef void (*MorselFunction)(void *context, uint32_t worker, uint64_t morsel);
+
+struct ThreadPool;
+
+// One worker thread and the contiguous range of morsels it owns. The owner takes from the
+// head and thieves take the back half, so each worker mostly walks its pages in order
+typedef struct {
+    pthread_t thread;
+    struct ThreadPool *pool;
+    uint32_t index;
+    pthread_mutex_t lock;               // Guards head and tail
+    uint64_t head;                      // Next morsel the owner runs
+    uint64_t tail;                      // One past the last morsel in the range
+    uint64_t steals;                    // Ranges this worker took from others
+} PoolWorker;
+
+typedef struct ThreadPool {
+    PoolWorker *workers;
+    uint32_t thread_count;
+    pthread_mutex_t lock;               // Guards everything below
+    pthread_cond_t work_ready;
+    pthread_cond_t work_done;
+    uint64_t generation;                // Bumped for every job so sleeping workers wake up
+    uint32_t running;                   // Workers still busy with the current job
+    uint8_t shutdown;
+    MorselFunction function;
+    void *context;
+} ThreadPool;
+
+// Number of online cores, capped at SCAN_MAX_THREADS
+uint32_t defaultThreadCount(void);
+
+// Start thread_count workers (0 for defaultThreadCount), they sleep until runMorsels
+// Returns NULL on error, free with freeThreadPool
+ThreadPool *createThreadPool(uint32_t thread_count);
+
+// Run function on every morsel in [0, morsel_count) and wait for all of them to finish
+// steals (optional) gets how many ranges were stolen between workers
+// Returns 0 on success, -1 on error
+int runMorsels(ThreadPool *pool, uint64_t morsel_count, MorselFunction function, void *context, uint64_t *steals);
+
+// Stop and join the workers
+void freeThreadPool(ThreadPool *pool);
@@ -0,0 +1,638 @@
+//     Keagan Anderson
+//        MagBase
+//       10/19/2026
+//
+//     Write-ahead log: changed byte ranges of pages and header images are appended to
+//     <db>-wal and synced once per commit, the pages reach the database file later. The first
+//     change to a page after a checkpoint logs the whole page, so a torn write is repaired
+
+#include "wal.h"
+#include "buffer.h"
+#include "globals.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static uint32_t fnv1a(uint32_t hash, const void *data, size_t length) {
+    const uint8_t *bytes = data;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= bytes[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static uint32_t recordChecksum(WalRecordHeader record, const void *payload) {
+    record.checksum = 0;
+    uint32_t hash = fnv1a(2166136261u, &record, sizeof(WalRecordHeader));
+    return fnv1a(hash, payload, record.length);
+}
+
+static int writeAll(int fd, const char *data, size_t length, off_t offset) {
+    while (length > 0) {
+        ssize_t written = pwrite(fd, data, length, offset);
+        if (written <= 0) {
+            return -1;
+        }
+        data += written;
+        length -= (size_t)written;
+        offset += written;
+    }
+    return 0;
+}
+
+static int writeFileHeader(Wal *wal) {
+    WalFileHeader file_header;
+    memset(&file_header, 0, sizeof(WalFileHeader));
+    memcpy(file_header.magic, WAL_MAGIC, sizeof(file_header.magic));
+    file_header.base_lsn = wal->base_lsn;
+    file_header.page_size = wal->page_size;
+    return writeAll(wal->fd, (const char *)&file_header, sizeof(WalFileHeader), 0);
+}
+
+// Append a record to the in memory log
+// Returns its LSN, 0 on error
+static uint64_t appendRecord(Wal *wal, uint8_t type, uint8_t flags, uint64_t txn_id, uint64_t page_num,
+                             uint32_t offset, const void *payload, uint32_t length) {
+    WalRecordHeader record;
+    memset(&record, 0, sizeof(WalRecordHeader));
+    record.txn_id = txn_id;
+    record.page_num = page_num;
+    record.offset = offset;
+    record.length = length;
+    record.type = type;
+    record.flags = flags;
+
+    size_t size = sizeof(WalRecordHeader) + length;
+    pthread_mutex_lock(&wal->lock);
+    if (wal->buffer_used + size > wal->buffer_capacity) {
+        size_t capacity = wal->buffer_capacity ? wal->buffer_capacity : 64 * 1024;
+        while (capacity < wal->buffer_used + size) {
+            capacity *= 2;
+        }
+        char *grown = realloc(wal->buffer, capacity);
+        if (!grown) {
+            pthread_mutex_unlock(&wal->lock);
+            return 0;
+        }
+        wal->buffer = grown;
+        wal->buffer_capacity = capacity;
+    }
+
+    record.lsn = wal->next_lsn;
+    record.checksum = recordChecksum(record, payload);
+    memcpy(wal->buffer + wal->buffer_used, &record, sizeof(WalRecordHeader));
+    if (length > 0) {
+        memcpy(wal->buffer + wal->buffer_used + sizeof(WalRecordHeader), payload, length);
+    }
+    wal->buffer_used += size;
+    wal->next_lsn += size;
+    pthread_mutex_unlock(&wal->lock);
+    return record.lsn;
+}
+
+// Walk the records of the log body, the first one that is cut short or fails its checksum
+// ends the log: it was being written when the process died
+// Returns the length of the valid prefix
+static size_t validPrefix(Wal *wal, MagBase *db, const char *body, size_t body_length) {
+    size_t position = 0;
+    while (position + sizeof(WalRecordHeader) <= body_length) {
+        WalRecordHeader record;
+        memcpy(&record, body + position, sizeof(WalRecordHeader));
+        if (record.lsn != wal->base_lsn + position || record.length > body_length - position - sizeof(WalRecordHeader)) {
+            break;
+        }
+        if (record.type == WAL_PAGE_WRITE &&
+            (record.page_num == 0 || (size_t)record.offset + record.length > db->usable_page_size)) {
+            break;
+        }
+        // Header images stop after their last change, and logs written before the header grew hold
+        // shorter ones too
+        if (record.type == WAL_HEADER_WRITE && (record.length == 0 || record.length > sizeof(Header))) {
+            break;
+        }
+        if ((record.flags & WAL_RECORD_IMAGE) && (record.type != WAL_PAGE_WRITE || record.offset != 0)) {
+            break;
+        }
+        if (record.type < WAL_PAGE_WRITE || record.type > WAL_COMMIT) {
+            break;
+        }
+        if (recordChecksum(record, body + position + sizeof(WalRecordHeader)) != record.checksum) {
+            break;
+        }
+        position += sizeof(WalRecordHeader) + record.length;
+    }
+    return position;
+}
+
+static bool pageImaged(Wal *wal, uint64_t page_num) {
+    return page_num / 8 < wal->imaged_size && (wal->imaged[page_num / 8] & (1u << (page_num % 8)));
+}
+
+// A page without its bit is logged whole again, so running out of memory here only costs log space
+static void setPageImaged(Wal *wal, uint64_t page_num) {
+    if (page_num / 8 >= wal->imaged_size) {
+        size_t size = wal->imaged_size ? wal->imaged_size : 1024;
+        while (size <= page_num / 8) {
+            size *= 2;
+        }
+        uint8_t *grown = realloc(wal->imaged, size);
+        if (!grown) {
+            return;
+        }
+        memset(grown + wal->imaged_size, 0, size - wal->imaged_size);
+        wal->imaged = grown;
+        wal->imaged_size = size;
+    }
+    wal->imaged[page_num / 8] |= (uint8_t)(1u << (page_num % 8));
+}
+
+// After a checkpoint, or when another process wrote the log, every page is logged whole again
+static void forgetPageImages(Wal *wal) {
+    if (wal->imaged) {
+        memset(wal->imaged, 0, wal->imaged_size);
+    }
+}
+
+static int compareTxn(const void *a, const void *b) {
+    uint64_t left = *(const uint64_t *)a;
+    uint64_t right = *(const uint64_t *)b;
+    return (left > right) - (left < right);
+}
+
+// txns is sorted
+static int isCommitted(const uint64_t *txns, size_t count, uint64_t txn_id) {
+    return count > 0 && bsearch(&txn_id, txns, count, sizeof(uint64_t), compareTxn) != NULL;
+}
+
+// Redo the committed records the database file is missing. Records of transactions without a
+// commit stay in the log, their id is never reused so they are skipped for good
+static int recoverWal(Wal *wal, MagBase *db, size_t file_size) {
+    size_t body_length = file_size - sizeof(WalFileHeader);
+    char *body = malloc(body_length ? body_length : 1);
+    if (!body) {
+        return -1;
+    }
+    size_t done = 0;
+    while (done < body_length) {
+        ssize_t got = pread(wal->fd, body + done, body_length - done, (off_t)(sizeof(WalFileHeader) + done));
+        if (got <= 0) {
+            break;
+        }
+        done += (size_t)got;
+    }
+    size_t valid = validPrefix(wal, db, body, done);
+
+    // Pass 1: which transactions made it to their commit record
+    uint64_t *committed = NULL;
+    size_t committed_count = 0;
+    size_t committed_capacity = 0;
+    for (size_t position = 0; position < valid;) {
+        WalRecordHeader record;
+        memcpy(&record, body + position, sizeof(WalRecordHeader));
+        if (record.txn_id >= wal->next_txn) {
+            wal->next_txn = record.txn_id + 1;
+        }
+        if (record.type == WAL_COMMIT) {
+            if (committed_count == committed_capacity) {
+                committed_capacity = committed_capacity ? committed_capacity * 2 : 64;
+                uint64_t *grown = realloc(committed, committed_capacity * sizeof(uint64_t));
+                if (!grown) {
+                    free(committed);
+                    free(body);
+                    return -1;
+                }
+                committed = grown;
+            }
+            committed[committed_count++] = record.txn_id;
+        }
+        position += sizeof(WalRecordHeader) + record.length;
+    }
+    if (committed_count > 0) {
+        qsort(committed, committed_count, sizeof(uint64_t), compareTxn);
+    }
+
+    // Pass 2: apply them in log order. A page whose trailer already carries the LSN was written
+    // after the record, applying it again would be harmless but is skipped. A whole image stands
+    // in for a copy in the file that may be torn, the records after it follow
+    uint64_t applied = 0;
+    int status = 0;
+    Header header = *db->header;
+    int header_logged = 0;
+    for (size_t position = 0; position < valid && status == 0;) {
+        WalRecordHeader record;
+        memcpy(&record, body + position, sizeof(WalRecordHeader));
+        const char *payload = body + position + sizeof(WalRecordHeader);
+        position += sizeof(WalRecordHeader) + record.length;
+
+        if (record.lsn < db->header->checkpoint_lsn || !isCommitted(committed, committed_count, record.txn_id)) {
+            continue;
+        }
+
+        if (record.type == WAL_PAGE_WRITE) {
+            char *page_buffer =
+                (record.flags & WAL_RECORD_IMAGE)
+                    ? readPageOrImage(db->buffer_pool, record.page_num, db->file_pointer, db->page_size, payload,
+                                      record.length)
+                    : readPageFromBuffer(db->buffer_pool, record.page_num, db->file_pointer, db->page_size);
+            if (!page_buffer) {
+                status = -1;
+                break;
+            }
+            PageTrailer *trailer = pageTrailer(db, page_buffer);
+            if (trailer->lsn >= record.lsn) {
+                continue;
+            }
+            memcpy(page_buffer + record.offset, payload, record.length);
+            trailer->lsn = record.lsn;
+            markPageDirty(db->buffer_pool, record.page_num);
+            applied++;
+        } else if (record.type == WAL_HEADER_WRITE) {
+            memcpy(&header, payload, record.length);
+            header_logged = 1;
+        }
+    }
+
+    // The images laid over each other in log order give the newest header
+    if (header_logged) {
+        header.checkpoint_lsn = db->header->checkpoint_lsn;
+        if (memcmp(&header, db->header, sizeof(Header)) != 0) {
+            *db->header = header;
+            db->committed_header = header;
+            applied++;
+        }
+    }
+
+    if (status == 0 && applied > 0) {
+        printf("Recovered %lu changes from %s\n", (unsigned long)applied, wal->path);
+    }
+
+    // Drop a torn tail so new records follow the last whole one
+    if (status == 0 && valid < body_length && ftruncate(wal->fd, (off_t)(sizeof(WalFileHeader) + valid)) != 0) {
+        status = -1;
+    }
+
+    // The last run may not have synced its commits (SYNC_NORMAL). The log counts as unsynced
+    // instead of being synced here, the next commit's sync covers it and a redone page only
+    // reaches the file after walSync
+    wal->next_lsn = wal->base_lsn + valid;
+    wal->flushed_lsn = wal->next_lsn;
+    wal->synced_lsn = wal->base_lsn;
+    free(committed);
+    free(body);
+    return status;
+}
+
+Wal *openWal(MagBase *db, bool newFile) {
+    if (!db || !db->filePath) {
+        return NULL;
+    }
+
+    Wal *wal = calloc(1, sizeof(Wal));
+    if (!wal) {
+        return NULL;
+    }
+    wal->path = malloc(strlen(db->filePath) + 5);
+    if (!wal->path) {
+        free(wal);
+        return NULL;
+    }
+    sprintf(wal->path, "%s-wal", db->filePath);
+    pthread_mutex_init(&wal->lock, NULL);
+    pthread_cond_init(&wal->synced, NULL);
+    wal->fd = -1;
+    wal->page_size = (uint32_t)db->page_size;
+    wal->next_txn = 1;
+    wal->sync_mode = db->sync_mode;
+
+    // A log left next to a file that is being created belongs to an older database
+    if (newFile) {
+        unlink(wal->path);
+    }
+
+    wal->fd = open(wal->path, O_RDWR | O_CREAT, 0644);
+    struct stat info;
+    if (wal->fd < 0 || fstat(wal->fd, &info) != 0) {
+        fprintf(stderr, "Failed to open the write-ahead log %s\n", wal->path);
+        closeWal(wal);
+        return NULL;
+    }
+
+    uint64_t checkpoint_lsn = db->header->checkpoint_lsn > 0 ? db->header->checkpoint_lsn : 1;
+    WalFileHeader file_header;
+    if ((size_t)info.st_size < sizeof(WalFileHeader)) {
+        wal->base_lsn = checkpoint_lsn;
+        wal->next_lsn = wal->base_lsn;
+        wal->flushed_lsn = wal->base_lsn;
+        wal->synced_lsn = wal->base_lsn;
+        if (ftruncate(wal->fd, 0) != 0 || writeFileHeader(wal) != 0 || fdatasync(wal->fd) != 0) {
+            fprintf(stderr, "Failed to create the write-ahead log %s\n", wal->path);
+            closeWal(wal);
+            return NULL;
+        }
+        return wal;
+    }
+
+    if (pread(wal->fd, &file_header, sizeof(WalFileHeader), 0) != sizeof(WalFileHeader) ||
+        memcmp(file_header.magic, WAL_MAGIC, sizeof(file_header.magic)) != 0 || file_header.page_size != db->page_size) {
+        fprintf(stderr, "%s is not a write-ahead log of this database\n", wal->path);
+        closeWal(wal);
+        return NULL;
+    }
+
+    wal->base_lsn = file_header.base_lsn;
+    if (recoverWal(wal, db, (size_t)info.st_size) != 0) {
+        fprintf(stderr, "Failed to recover from the write-ahead log %s\n", wal->path);
+        closeWal(wal);
+        return NULL;
+    }
+
+    // A log cut off between the checkpoint's header write and its truncate still holds records
+    // the file has, new records must not reuse LSNs below the checkpoint
+    if (wal->next_lsn < checkpoint_lsn) {
+        wal->next_lsn = checkpoint_lsn;
+        wal->flushed_lsn = checkpoint_lsn;
+        wal->synced_lsn = checkpoint_lsn;
+        if (walCheckpoint(wal, db) != 0) {
+            closeWal(wal);
+            return NULL;
+        }
+    }
+    return wal;
+}
+
+uint64_t walBegin(Wal *wal) {
+    pthread_mutex_lock(&wal->lock);
+    uint64_t txn_id = wal->next_txn++;
+    pthread_mutex_unlock(&wal->lock);
+    return txn_id;
+}
+
+int walLogPage(Wal *wal, uint64_t txn_id, uint64_t page_num, const char *page, const char *base, size_t length,
+               uint64_t *last_lsn) {
+    *last_lsn = 0;
+
+    size_t position = 0;
+    while (position < length && page[position] == base[position]) {
+        position++;
+    }
+    if (position < length && !pageImaged(wal, page_num)) {
+        *last_lsn = appendRecord(wal, WAL_PAGE_WRITE, WAL_RECORD_IMAGE, txn_id, page_num, 0, page, (uint32_t)length);
+        return *last_lsn == 0 ? -1 : 0;
+    }
+
+    while (position < length) {
+        if (page[position] == base[position]) {
+            position++;
+            continue;
+        }
+
+        // Extend the range over short runs of equal bytes, a record header costs more than they do
+        size_t start = position;
+        size_t end = position + 1;
+        size_t equal = 0;
+        for (size_t i = end; i < length && equal < WAL_DIFF_MERGE_GAP; i++) {
+            if (page[i] == base[i]) {
+                equal++;
+            } else {
+                equal = 0;
+                end = i + 1;
+            }
+        }
+
+        uint64_t lsn = appendRecord(wal, WAL_PAGE_WRITE, 0, txn_id, page_num, (uint32_t)start, page + start,
+                                    (uint32_t)(end - start));
+        if (lsn == 0) {
+            return -1;
+        }
+        *last_lsn = lsn;
+        position = end;
+    }
+    return 0;
+}
+
+int walLogHeader(Wal *wal, uint64_t txn_id, const Header *header, const Header *committed) {
+    const char *bytes = (const char *)header;
+    size_t length = sizeof(Header);
+    while (length > 1 && bytes[length - 1] == ((const char *)committed)[length - 1]) {
+        length--;
+    }
+    return appendRecord(wal, WAL_HEADER_WRITE, 0, txn_id, 0, 0, header, (uint32_t)length) == 0 ? -1 : 0;
+}
+
+typedef struct {
+    Wal *wal;
+    MagBase *db;
+    uint64_t txn_id;
+    int logged;
+} PendingLog;
+
+static int logPendingPage(void *context, size_t page_id, char *page, const char *base) {
+    PendingLog *log = context;
+    uint64_t lsn;
+    if (walLogPage(log->wal, log->txn_id, page_id, page, base, log->db->usable_page_size, &lsn) != 0) {
+        return -1;
+    }
+    if (lsn != 0) {
+        pageTrailer(log->db, page)->lsn = lsn;
+        log->logged++;
+    }
+    return 0;
+}
+
+int walLogPendingPages(Wal *wal, MagBase *db, uint64_t txn_id) {
+    PendingLog log = {wal, db, txn_id, 0};
+    if (visitPendingPages(db->buffer_pool, logPendingPage, &log) != 0) {
+        return -1;
+    }
+    return log.logged;
+}
+
+int walCommit(Wal *wal, uint64_t txn_id, uint64_t *commit_lsn) {
+    if (appendRecord(wal, WAL_COMMIT, 0, txn_id, 0, 0, NULL, 0) == 0) {
+        return -1;
+    }
+
+    // The writer is the only one appending, the buffer stays put while it is written
+    pthread_mutex_lock(&wal->lock);
+    uint64_t start = wal->flushed_lsn;
+    size_t used = wal->buffer_used;
+    pthread_mutex_unlock(&wal->lock);
+
+    off_t offset = (off_t)(sizeof(WalFileHeader) + (start - wal->base_lsn));
+    if (writeAll(wal->fd, wal->buffer, used, offset) != 0) {
+        fprintf(stderr, "Failed to write the write-ahead log %s\n", wal->path);
+        return -1;
+    }
+
+    // Images only count once committed, the records of a transaction that failed before its
+    // commit are skipped by recovery
+    for (size_t position = 0; position < used;) {
+        WalRecordHeader record;
+        memcpy(&record, wal->buffer + position, sizeof(WalRecordHeader));
+        if (record.txn_id == txn_id && (record.flags & WAL_RECORD_IMAGE)) {
+            setPageImaged(wal, record.page_num);
+        }
+        position += sizeof(WalRecordHeader) + record.length;
+    }
+
+    pthread_mutex_lock(&wal->lock);
+    wal->flushed_lsn = start + used;
+    wal->buffer_used = 0;
+    wal->commits++;
+    *commit_lsn = wal->flushed_lsn;
+    pthread_mutex_unlock(&wal->lock);
+    return 0;
+}
+
+// Sync the log up to target. One caller syncs at a time, for everything written when it
+// starts, the others wait for it and find their records covered or sync next
+// Returns 0 on success, -1 on error
+static int syncLog(Wal *wal, uint64_t target) {
+    int status = 0;
+    pthread_mutex_lock(&wal->lock);
+    while (wal->synced_lsn < target) {
+        if (wal->syncing) {
+            pthread_cond_wait(&wal->synced, &wal->lock);
+            continue;
+        }
+
+        // Records below flushed_lsn are whole in the file, a commit writing past it does not matter
+        wal->syncing = 1;
+        uint64_t flushed = wal->flushed_lsn;
+        pthread_mutex_unlock(&wal->lock);
+        int failed = fdatasync(wal->fd) != 0;
+        pthread_mutex_lock(&wal->lock);
+
+        wal->syncing = 0;
+        wal->syncs++;
+        if (!failed && wal->synced_lsn < flushed) {
+            wal->synced_lsn = flushed;
+        }
+        pthread_cond_broadcast(&wal->synced);
+        if (failed) {
+            fprintf(stderr, "Failed to sync the write-ahead log %s\n", wal->path);
+            status = -1;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&wal->lock);
+    return status;
+}
+
+int walAwait(Wal *wal, uint64_t commit_lsn) {
+    if (wal->sync_mode < SYNC_FULL) {
+        return 0;
+    }
+    return syncLog(wal, commit_lsn);
+}
+
+int walSync(Wal *wal) {
+    pthread_mutex_lock(&wal->lock);
+    uint64_t target = wal->flushed_lsn;
+    pthread_mutex_unlock(&wal->lock);
+    return syncLog(wal, target);
+}
+
+int walCheckpoint(Wal *wal, MagBase *db) {
+    if (!wal || !db) {
+        return -1;
+    }
+
+    // The log has to be on disk before the file holds its changes
+    int sync = wal->sync_mode != SYNC_OFF;
+    if ((sync && walSync(wal) != 0) || flushAllDirtyPages(db->buffer_pool, db) != 0) {
+        return -1;
+    }
+
+    // The header tells recovery which records the file already has, and other processes that
+    // their cached pages are stale
+    db->committed_header.checkpoint_lsn = wal->next_lsn;
+    db->header->checkpoint_lsn = wal->next_lsn;
+    db->committed_header.change_counter++;
+    db->header->change_counter = db->committed_header.change_counter;
+    if (pwrite(fileno(db->file_pointer), &db->committed_header, sizeof(Header), 0) != (ssize_t)sizeof(Header) ||
+        (sync && fsync(fileno(db->file_pointer)) != 0) ||
+        (wal->sync_mode == SYNC_FULL_DIR && syncDirectory(db) != 0)) {
+        fprintf(stderr, "Failed to checkpoint %s\n", db->filePath);
+        return -1;
+    }
+
+    // Readers evicting pages and committers waiting for a sync meanwhile find the empty log synced
+    pthread_mutex_lock(&wal->lock);
+    wal->base_lsn = wal->next_lsn;
+    wal->flushed_lsn = wal->next_lsn;
+    wal->synced_lsn = wal->next_lsn;
+    wal->buffer_used = 0;
+    forgetPageImages(wal);
+    int status = ftruncate(wal->fd, 0) != 0 || writeFileHeader(wal) != 0 || (sync && fdatasync(wal->fd) != 0);
+    pthread_mutex_unlock(&wal->lock);
+    if (status) {
+        fprintf(stderr, "Failed to reset the write-ahead log %s\n", wal->path);
+        return -1;
+    }
+    return 0;
+}
+
+uint64_t walSize(Wal *wal) { return wal->next_lsn - wal->base_lsn; }
+
+bool walCurrent(Wal *wal) {
+    struct stat info;
+    WalFileHeader file_header;
+    if (fstat(wal->fd, &info) != 0 || pread(wal->fd, &file_header, sizeof(WalFileHeader), 0) != sizeof(WalFileHeader)) {
+        return false;
+    }
+    return file_header.base_lsn == wal->base_lsn &&
+           (uint64_t)info.st_size == sizeof(WalFileHeader) + (wal->flushed_lsn - wal->base_lsn);
+}
+
+int walAdopt(Wal *wal, MagBase *db) {
+    struct stat info;
+    WalFileHeader file_header;
+    if (fstat(wal->fd, &info) != 0 || (size_t)info.st_size < sizeof(WalFileHeader) ||
+        pread(wal->fd, &file_header, sizeof(WalFileHeader), 0) != sizeof(WalFileHeader) ||
+        memcmp(file_header.magic, WAL_MAGIC, sizeof(file_header.magic)) != 0) {
+        fprintf(stderr, "%s is not a write-ahead log of this database\n", wal->path);
+        return -1;
+    }
+
+    pthread_mutex_lock(&wal->lock);
+    wal->base_lsn = file_header.base_lsn;
+    wal->next_lsn = wal->base_lsn;
+    wal->flushed_lsn = wal->base_lsn;
+    wal->synced_lsn = wal->base_lsn;
+    wal->buffer_used = 0;
+    forgetPageImages(wal);
+    pthread_mutex_unlock(&wal->lock);
+    if ((size_t)info.st_size == sizeof(WalFileHeader)) {
+        return 0;
+    }
+
+    // Records another process committed but did not write to the file, redone like at open
+    if (recoverWal(wal, db, (size_t)info.st_size) != 0 || markPagesCommitted(db->buffer_pool, db) != 0) {
+        fprintf(stderr, "Failed to recover from the write-ahead log %s\n", wal->path);
+        return -1;
+    }
+    if (db->header->next_txn_id > db->next_txn) {
+        db->next_txn = db->header->next_txn_id;
+    }
+    return 0;
+}
+
+void closeWal(Wal *wal) {
+    if (!wal) {
+        return;
+    }
+    if (wal->fd >= 0) {
+        close(wal->fd);
+    }
+    pthread_mutex_destroy(&wal->lock);
+    pthread_cond_destroy(&wal->synced);
+    free(wal->buffer);
+    free(wal->imaged);
+    free(wal->path);
+    free(wal);
+}
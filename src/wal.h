@@ -0,0 +1,126 @@
+//     Keagan Anderson
+//        MagBase
+//       10/19/2026
+//
+//     Write-ahead log: changed byte ranges of pages and header images are appended to
+//     <db>-wal and synced once per commit, the pages reach the database file later. The first
+//     change to a page after a checkpoint logs the whole page, so a torn write is repaired
+
+#pragma once
+
+#include "db-init.h"
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define WAL_MAGIC "MAGWAL\0\0"
+
+typedef enum { WAL_PAGE_WRITE = 1, WAL_HEADER_WRITE, WAL_COMMIT } WalRecordType;
+
+#define WAL_RECORD_IMAGE 0x01 // A page write holding the whole page, recovery does not read the file's copy
+
+// Start of the log file
+typedef struct {
+    char magic[8];
+    uint64_t base_lsn;                  // LSN of the first record
+    uint32_t page_size;
+    uint32_t reserved;
+} WalFileHeader;
+
+// Every record, the payload (length bytes) follows. The LSN of a record is base_lsn plus
+// its offset after the file header, so LSNs grow across checkpoints
+typedef struct {
+    uint64_t lsn;
+    uint64_t txn_id;
+    uint64_t page_num;                  // 0 for header and commit records
+    uint32_t checksum;                  // FNV-1a of this header (checksum zeroed) and the payload
+    uint32_t offset;                    // Where the payload goes in the page
+    uint32_t length;
+    uint8_t type;                       // WalRecordType
+    uint8_t flags;                      // WAL_RECORD_IMAGE, 0 in logs of older builds
+    uint8_t reserved[2];
+} WalRecordHeader;
+
+typedef struct Wal {
+    int fd;
+    char *path;
+    uint32_t page_size;                 // Page size of the database, recorded in the file header
+    uint64_t base_lsn;
+    uint64_t next_lsn;                  // LSN of the next record appended
+    uint64_t flushed_lsn;               // Everything below is written to the log file
+    uint64_t synced_lsn;                // Everything below is on disk, behind flushed_lsn below SYNC_FULL
+    SyncMode sync_mode;
+    uint64_t next_txn;
+    char *buffer;                       // Records appended since the last flush, only the writer appends
+    size_t buffer_used;
+    size_t buffer_capacity;
+    pthread_mutex_t lock;
+    pthread_cond_t synced;
+    int syncing;                        // A committer is syncing for everyone waiting
+    uint64_t commits;
+    uint64_t syncs;                     // Lower than commits when commits were grouped or not synced
+    uint8_t *imaged;                    // Bit per page whose image a commit logged since the checkpoint,
+    size_t imaged_size;                 // only the writer uses it
+} Wal;
+
+// Open or create the log of a database and redo every committed record the file is missing.
+// The pool must not be in no-steal mode yet
+// Returns NULL on error
+Wal *openWal(MagBase *db, bool newFile);
+
+// Start a transaction
+// Returns its id
+uint64_t walBegin(Wal *wal);
+
+// Log the bytes of page that differ from base within the first length bytes, all length bytes
+// if no commit logged the page whole since the last checkpoint: the file's copy may be torn
+// when it is written next. *last_lsn is the LSN of the last record written for the page, 0 if
+// nothing differed
+// Returns 0 on success, -1 on error
+int walLogPage(Wal *wal, uint64_t txn_id, uint64_t page_num, const char *page, const char *base, size_t length,
+               uint64_t *last_lsn);
+
+// Log a new header image. Recovery lays each image over the header of the last checkpoint, so
+// the bytes after the last one that differs from committed are left out
+// Returns 0 on success, -1 on error
+int walLogHeader(Wal *wal, uint64_t txn_id, const Header *header, const Header *committed);
+
+// Log every pending page of the pool and stamp their trailers
+// Returns the number of pages logged, -1 on error
+int walLogPendingPages(Wal *wal, MagBase *db, uint64_t txn_id);
+
+// Append the commit record and write the transaction's records to the log file, without a
+// sync. *commit_lsn gets the end of the commit, what walAwait waits for
+// Returns 0 on success, -1 on error
+int walCommit(Wal *wal, uint64_t txn_id, uint64_t *commit_lsn);
+
+// Wait until the log is synced up to commit_lsn from SYNC_FULL on, at once below it. Called
+// after the writer lets go of its locks: the first committer to arrive syncs everything
+// written so far, those arriving meanwhile wait and are covered by the next sync
+// Returns 0 on success, -1 on error
+int walAwait(Wal *wal, uint64_t commit_lsn);
+
+// Sync what commits wrote to the log but left unsynced. Called before a page reaches the
+// database file, so the file never holds a change the log could lose
+// Returns 0 on success, -1 on error
+int walSync(Wal *wal);
+
+// Write the committed pages and header to the database file, sync it and empty the log
+// (no syncs with SYNC_OFF).
+// Nothing may be appended while it runs
+// Returns 0 on success, -1 on error
+int walCheckpoint(Wal *wal, MagBase *db);
+
+// Bytes of log since the last checkpoint
+uint64_t walSize(Wal *wal);
+
+// Returns true if the log file is as this process last left it, another process writing or
+// checkpointing the database changes it
+bool walCurrent(Wal *wal);
+
+// Take the log over as another process left it and redo the committed records it holds. The
+// caller holds the writer lock of the file
+// Returns 0 on success, -1 on error
+int walAdopt(Wal *wal, MagBase *db);
+
+void closeWal(Wal *wal);
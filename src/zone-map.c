@@ -0,0 +1,326 @@
+//     Keagan Anderson
+//        MagBase
+//       10/19/2026
+//
+//     Zone maps: per data page synopses of every column (min, max and null counts), so
+//     filtered scans can pass over pages whose values cannot match without reading them
+
+#include "zone-map.h"
+#include "buffer.h"
+#include "schema.h"
+#include "stats.h"
+#include <pthread.h>
+#include <string.h>
+
+#define ZONE_ENTRY_SIZE(column_count) (sizeof(ZoneEntry) + (size_t)(column_count) * sizeof(ZoneColumn))
+
+static ZoneEntry *zoneEntry(char *page_buffer, uint16_t column_count, uint16_t index) {
+    return (ZoneEntry *)(page_buffer + sizeof(ZoneMapPageHeader) + index * ZONE_ENTRY_SIZE(column_count));
+}
+
+static ZoneColumn *zoneColumns(ZoneEntry *entry) {
+    return (ZoneColumn *)((char *)entry + sizeof(ZoneEntry));
+}
+
+// Counts saturate, a count that once went past 0 never reads as 0 again
+static void countZoneRow(uint32_t *count) {
+    if (*count < UINT32_MAX) {
+        (*count)++;
+    }
+}
+
+// Rows only ever widen an entry and value_count goes up after min and max cover the value, so a
+// reader racing the writer still finds every committed row covered
+static void widenZone(ZoneEntry *entry, ZoneColumn *columns, uint16_t column_count, Record *record) {
+    countZoneRow(&entry->row_count);
+    for (uint16_t col = 0; col < column_count && col < record->field_count; col++) {
+        ZoneColumn *column = &columns[col];
+        RecordField *field = &record->fields[col];
+        if (field->is_null) {
+            countZoneRow(&column->null_count);
+            continue;
+        }
+
+        int64_t key = statsKey(field);
+        if (column->value_count == 0 || key < column->min_key) {
+            column->min_key = key;
+        }
+        if (column->value_count == 0 || key > column->max_key) {
+            column->max_key = key;
+        }
+        countZoneRow(&column->value_count);
+    }
+}
+
+void startPageZone(PageZone *zone, uint64_t page_num) {
+    memset(zone, 0, sizeof(PageZone));
+    zone->entry.page_num = page_num;
+}
+
+void addZoneRow(PageZone *zone, uint16_t column_count, Record *record) {
+    widenZone(&zone->entry, zone->columns, column_count, record);
+}
+
+// Allocate and clear a zone map page
+static uint64_t newZoneMapPage(MagBase *db) {
+    uint64_t page_num = db->header->page_count++;
+    char *page_buffer = readPageFromBuffer(db->buffer_pool, page_num, db->file_pointer, db->page_size);
+    if (!page_buffer) {
+        return 0;
+    }
+
+    memset(page_buffer, 0, db->usable_page_size);
+    ((ZoneMapPageHeader *)page_buffer)->last_zone_page = page_num;
+    markPageDirty(db->buffer_pool, page_num);
+    return page_num;
+}
+
+// Start the table's zone map if it has none yet
+// Returns 0 on success, -1 on error
+static int startZoneMap(MagBase *db, TableSchemaRecord *schema) {
+    if (schema->zone_map_page != 0) {
+        return 0;
+    }
+
+    uint64_t first = newZoneMapPage(db);
+    if (first == 0) {
+        return -1;
+    }
+    // Readers may be copying the cached schema
+    pthread_mutex_lock(&db->catalog_lock);
+    schema->zone_map_page = (uint32_t)first;
+    pthread_mutex_unlock(&db->catalog_lock);
+    return updateTableSchema(db, schema);
+}
+
+// Tail page of the table's zone map
+// Returns 0 on error
+static uint64_t lastZoneMapPage(MagBase *db, const TableSchemaRecord *schema) {
+    char *page_buffer = readPageFromBuffer(db->buffer_pool, schema->zone_map_page, db->file_pointer, db->page_size);
+    if (!page_buffer) {
+        return 0;
+    }
+    return ((ZoneMapPageHeader *)page_buffer)->last_zone_page;
+}
+
+// Widen the entry of a page before the table's last one, found by walking the zone map. Pages
+// are allocated in chain order, so entries are in page number order too
+// Returns 0 on success (or when the page has no entry, it is never pruned), -1 on error
+static int widenPageZone(MagBase *db, const TableSchemaRecord *schema, uint64_t page_num, Record *record) {
+    uint64_t zone_page = schema->zone_map_page;
+    while (zone_page != 0) {
+        char *page_buffer = readPageFromBuffer(db->buffer_pool, zone_page, db->file_pointer, db->page_size);
+        if (!page_buffer) {
+            return -1;
+        }
+
+        ZoneMapPageHeader *header = (ZoneMapPageHeader *)page_buffer;
+        uint16_t count = header->entry_count;
+        if (count > 0 && zoneEntry(page_buffer, schema->column_count, count - 1)->page_num >= page_num) {
+            for (uint16_t e = 0; e < count; e++) {
+                ZoneEntry *entry = zoneEntry(page_buffer, schema->column_count, e);
+                if (entry->page_num == page_num) {
+                    widenZone(entry, zoneColumns(entry), schema->column_count, record);
+                    markPageDirty(db->buffer_pool, zone_page);
+                    return 0;
+                }
+            }
+            return 0;
+        }
+        zone_page = header->next_zone_page;
+    }
+    return 0;
+}
+
+int addZoneMapRow(MagBase *db, uint16_t table_id, uint64_t page_num, Record *record) {
+    if (!db || !record) {
+        return -1;
+    }
+    if (!hasZoneMaps(db)) {
+        return 0;
+    }
+
+    TableSchemaRecord *schema = getTableSchema(db, table_id);
+    if (!schema || startZoneMap(db, schema) != 0) {
+        return -1;
+    }
+
+    // Most rows go to the last page, whose entry is the last one if it has any
+    uint64_t tail = lastZoneMapPage(db, schema);
+    char *page_buffer = tail ? readPageFromBuffer(db->buffer_pool, tail, db->file_pointer, db->page_size) : NULL;
+    if (!page_buffer) {
+        return -1;
+    }
+    ZoneMapPageHeader *header = (ZoneMapPageHeader *)page_buffer;
+    if (header->entry_count > 0) {
+        ZoneEntry *last = zoneEntry(page_buffer, schema->column_count, header->entry_count - 1);
+        if (last->page_num == page_num) {
+            widenZone(last, zoneColumns(last), schema->column_count, record);
+            markPageDirty(db->buffer_pool, tail);
+            return 0;
+        }
+        if (last->page_num > page_num) {
+            return widenPageZone(db, schema, page_num, record);
+        }
+    }
+
+    PageZone zone;
+    startPageZone(&zone, page_num);
+    addZoneRow(&zone, schema->column_count, record);
+    return appendPageZone(db, table_id, &zone);
+}
+
+// Copy an entry into its place in a zone map page, the count moves past it once it is there
+static void putZone(char *page_buffer, uint16_t column_count, const PageZone *zone) {
+    ZoneMapPageHeader *header = (ZoneMapPageHeader *)page_buffer;
+    ZoneEntry *entry = zoneEntry(page_buffer, column_count, header->entry_count);
+    memcpy(entry, &zone->entry, sizeof(ZoneEntry));
+    memcpy(zoneColumns(entry), zone->columns, column_count * sizeof(ZoneColumn));
+    header->entry_count++;
+}
+
+int appendPageZone(MagBase *db, uint16_t table_id, const PageZone *zone) {
+    if (!db || !zone) {
+        return -1;
+    }
+    if (!hasZoneMaps(db)) {
+        return 0;
+    }
+
+    TableSchemaRecord *schema = getTableSchema(db, table_id);
+    if (!schema || startZoneMap(db, schema) != 0) {
+        return -1;
+    }
+    uint16_t column_count = schema->column_count;
+
+    // The page pointers are not held across reads, the pool may evict them
+    uint64_t tail = lastZoneMapPage(db, schema);
+    char *page_buffer = tail ? readPageFromBuffer(db->buffer_pool, tail, db->file_pointer, db->page_size) : NULL;
+    if (!page_buffer) {
+        return -1;
+    }
+    size_t entries_per_page = (db->usable_page_size - sizeof(ZoneMapPageHeader)) / ZONE_ENTRY_SIZE(column_count);
+    if (((ZoneMapPageHeader *)page_buffer)->entry_count < entries_per_page) {
+        putZone(page_buffer, column_count, zone);
+        markPageDirty(db->buffer_pool, tail);
+        return 0;
+    }
+
+    // Tail is full, chain a new zone map page
+    uint64_t new_tail = newZoneMapPage(db);
+    if (new_tail == 0) {
+        return -1;
+    }
+    page_buffer = readPageFromBuffer(db->buffer_pool, new_tail, db->file_pointer, db->page_size);
+    if (!page_buffer) {
+        return -1;
+    }
+    putZone(page_buffer, column_count, zone);
+    markPageDirty(db->buffer_pool, new_tail);
+
+    page_buffer = readPageFromBuffer(db->buffer_pool, tail, db->file_pointer, db->page_size);
+    if (!page_buffer) {
+        return -1;
+    }
+    ((ZoneMapPageHeader *)page_buffer)->next_zone_page = new_tail;
+    markPageDirty(db->buffer_pool, tail);
+
+    page_buffer = readPageFromBuffer(db->buffer_pool, schema->zone_map_page, db->file_pointer, db->page_size);
+    if (!page_buffer) {
+        return -1;
+    }
+    ((ZoneMapPageHeader *)page_buffer)->last_zone_page = new_tail;
+    markPageDirty(db->buffer_pool, schema->zone_map_page);
+    return 0;
+}
+
+// Returns false if no value summarised by column can satisfy predicate
+static bool predicateMayMatch(const Predicate *predicate, const ZoneColumn *column, uint8_t type) {
+    if (predicate->value.is_null) {
+        return predicate->op == PRED_EQ ? column->null_count > 0 : column->value_count > 0;
+    }
+    if (column->value_count == 0) {
+        return false;
+    }
+
+    // A TEXT key only holds a prefix, values sharing the bound's prefix may fall on either side
+    bool exact = type != COL_TEXT;
+    int64_t key = statsKey((RecordField *)&predicate->value);
+    switch (predicate->op) {
+        case PRED_EQ:
+            return key >= column->min_key && key <= column->max_key;
+        case PRED_NE:
+            return !exact || column->min_key != key || column->max_key != key;
+        case PRED_LT:
+            return exact ? column->min_key < key : column->min_key <= key;
+        case PRED_LE:
+            return column->min_key <= key;
+        case PRED_GT:
+            return exact ? column->max_key > key : column->max_key >= key;
+        case PRED_GE:
+            return column->max_key >= key;
+    }
+    return true;
+}
+
+static bool zoneMayMatch(const TableSchemaRecord *schema, const Filter *filter, ZoneEntry *entry) {
+    ZoneColumn *columns = zoneColumns(entry);
+    for (uint16_t p = 0; p < filter->count; p++) {
+        const Predicate *predicate = &filter->predicates[p];
+        if (predicate->column < schema->column_count &&
+            !predicateMayMatch(predicate, &columns[predicate->column], schema->columns[predicate->column].type)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int64_t pruneTablePages(MagBase *db, const TableSchemaRecord *schema, const Filter *filter, uint64_t *pages,
+                        uint64_t *page_count) {
+    if (!db || !schema || !page_count) {
+        return -1;
+    }
+    if (!filter || filter->count == 0 || schema->zone_map_page == 0 || *page_count < 2) {
+        return 0;
+    }
+
+    // Entries and pages are both in chain order. pages[next] is the first page not matched with
+    // an entry yet, a page without one is kept
+    uint64_t count = *page_count;
+    uint64_t kept = 0;
+    uint64_t next = 0;
+    uint64_t zone_page = schema->zone_map_page;
+    while (zone_page != 0 && next + 1 < count) {
+        char *page_buffer = readPageFromBuffer(db->buffer_pool, zone_page, db->file_pointer, db->page_size);
+        if (!page_buffer) {
+            return -1;
+        }
+
+        ZoneMapPageHeader *header = (ZoneMapPageHeader *)page_buffer;
+        for (uint16_t e = 0; e < header->entry_count && next + 1 < count; e++) {
+            ZoneEntry *entry = zoneEntry(page_buffer, schema->column_count, e);
+            uint64_t found = next;
+            while (found + 1 < count && pages[found] != entry->page_num) {
+                found++;
+            }
+            if (found + 1 == count) {
+                continue;
+            }
+
+            while (next < found) {
+                pages[kept++] = pages[next++];
+            }
+            if (zoneMayMatch(schema, filter, entry)) {
+                pages[kept++] = pages[found];
+            }
+            next = found + 1;
+        }
+        zone_page = header->next_zone_page;
+    }
+    while (next < count) {
+        pages[kept++] = pages[next++];
+    }
+
+    *page_count = kept;
+    return (int64_t)(count - kept);
+}
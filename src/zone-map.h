@@ -0,0 +1,66 @@
+//     Keagan Anderson
+//        MagBase
+//       10/19/2026
+//
+//     Zone maps: per data page synopses of every column (min, max and null counts), so
+//     filtered scans can pass over pages whose values cannot match without reading them
+
+#pragma once
+
+#include "db-init.h"
+#include "filter.h"
+#include "records.h"
+#include "structs/schemaStruct.h"
+#include <stdint.h>
+
+// Zone map pages form a chain from TableSchemaRecord.zone_map_page, entries follow the header
+typedef struct {
+    uint16_t entry_count;               // Entries stored in this page
+    uint64_t next_zone_page;            // 0 on the last page
+    uint64_t last_zone_page;            // Tail of the chain, only kept on the first page
+} ZoneMapPageHeader;
+
+// One column of a data page over every row version ever written to it, so it only widens.
+// Values are statsKey keys, TEXT columns are summarised by their 8 byte prefix. A page is
+// compacted and written again without end, the counts stop at UINT32_MAX instead of wrapping
+typedef struct {
+    int64_t min_key;                    // Only meaningful when value_count > 0
+    int64_t max_key;
+    uint32_t null_count;
+    uint32_t value_count;               // Non NULL values
+} ZoneColumn;
+
+// Entry of a data page in a zone map page, the table's column_count ZoneColumns follow it.
+// Entries are in chain order, like the page directory
+typedef struct {
+    uint64_t page_num;
+    uint32_t row_count;
+} ZoneEntry;
+
+// A zone map entry being built in memory
+typedef struct {
+    ZoneEntry entry;
+    ZoneColumn columns[MAX_COLUMNS];
+} PageZone;
+
+// Start an empty entry for a data page
+void startPageZone(PageZone *zone, uint64_t page_num);
+
+// Widen an entry by a row
+void addZoneRow(PageZone *zone, uint16_t column_count, Record *record);
+
+// Widen the entry of a data page by a row just written to it. A page past the last entry gets
+// one at the end of the zone map, earlier pages are looked up. Allocates the first zone map page
+// and saves the schema if needed
+// Returns 0 on success (or when the file has no zone maps), -1 on error
+int addZoneMapRow(MagBase *db, uint16_t table_id, uint64_t page_num, Record *record);
+
+// Append the entry of a data page just linked onto the end of the table's chain
+// Returns 0 on success (or when the file has no zone maps), -1 on error
+int appendPageZone(MagBase *db, uint16_t table_id, const PageZone *zone);
+
+// Remove the pages whose entry rules filter out from a list of the table's pages in chain order.
+// The last page of the list is always kept, rows are still added to it
+// Returns the number of pages removed, -1 on error
+int64_t pruneTablePages(MagBase *db, const TableSchemaRecord *schema, const Filter *filter, uint64_t *pages,
+                        uint64_t *page_count);
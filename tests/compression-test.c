@@ -0,0 +1,89 @@
+//     Keagan Anderson
+//        MagBase
+//       10/19/2026
+//
+//     Compressing a table of 16 KiB pages hands most of their space back to the file system and
+//     keeps every row, a database of 4 KiB pages refuses to compress at all
+
+#include "db-init.h"
+#include "file-lock.h"
+#include "magbase.h"
+#include "records.h"
+#include "test.h"
+#include <sys/stat.h>
+
+#define TEST_PATH "compression-test.mab"
+#define SMALL_PATH "compression-test-small.mab"
+#define ROWS 3000
+
+// Create a database of page_size pages holding a table of repetitive rows
+// Returns the table's id
+static uint16_t createTable(const char *path, uint32_t page_size) {
+    removeTestDatabase(path);
+    MagbaseOptions options = {.create_if_missing = true, .page_size = page_size};
+    MagbaseDb *db = magbaseOpen(path, &options);
+    CHECK(db != NULL);
+    CHECK(magbaseSetSyncMode(db, MAGBASE_SYNC_OFF) == 0);
+
+    MagbaseColumn columns[] = {{"event", MAGBASE_TEXT, false}, {"seq", MAGBASE_INT, false}};
+    int table_id = magbaseCreateTable(db, "events", columns, 2);
+    CHECK(table_id > 0);
+    MagbaseValue values[2] = {{.type = MAGBASE_TEXT}, {.type = MAGBASE_INT}};
+    values[0].value.text_val = "page viewed by a visitor from the newsletter link";
+    for (int32_t row = 0; row < ROWS; row++) {
+        values[1].value.int_val = row;
+        CHECK(magbaseInsert(db, (uint16_t)table_id, values, 2) != 0);
+    }
+    CHECK(magbaseClose(db) == 0);
+    return (uint16_t)table_id;
+}
+
+// Turn compression of a table on, the command is not part of the library's API
+// Returns what setTableCompression did
+static int compressTable(const char *path, uint16_t table_id) {
+    MagBase *magBase = openMagBase((char *)path);
+    CHECK(magBase != NULL);
+    CHECK(lockFileWriter(magBase) == 0);
+    uint64_t pages = 0;
+    int status = setTableCompression(magBase, table_id, true, &pages);
+    if (status == 0) {
+        CHECK(pages > 0);
+        CHECK(commitDatabase(magBase) == 0);
+    } else {
+        rollbackDatabase(magBase);
+    }
+    CHECK(unlockFileWriter(magBase) == 0);
+    freeDatabase(magBase);
+    return status;
+}
+
+static uint64_t allocatedBytes(const char *path) {
+    struct stat info;
+    CHECK(stat(path, &info) == 0);
+    return (uint64_t)info.st_blocks * 512;
+}
+
+int main(void) {
+    uint16_t table_id = createTable(TEST_PATH, 16384);
+    uint64_t before = allocatedBytes(TEST_PATH);
+    CHECK(compressTable(TEST_PATH, table_id) == 0);
+    uint64_t after = allocatedBytes(TEST_PATH);
+    printf("%lu bytes allocated before compression, %lu after\n", (unsigned long)before, (unsigned long)after);
+    CHECK(after < before * 3 / 4);
+
+    MagbaseOptions options = {0};
+    MagbaseDb *db = magbaseOpen(TEST_PATH, &options);
+    CHECK(db != NULL);
+    MagbaseTableStats stats;
+    CHECK(magbaseTableStats(db, table_id, &stats) == 0);
+    CHECK(stats.row_count == ROWS);
+    CHECK(magbaseClose(db) == 0);
+
+    // No 4 KiB page can free a block, the table is left as it was
+    uint16_t small_id = createTable(SMALL_PATH, 4096);
+    CHECK(compressTable(SMALL_PATH, small_id) != 0);
+
+    removeTestDatabase(TEST_PATH);
+    removeTestDatabase(SMALL_PATH);
+    return 0;
+}
@@ -0,0 +1,72 @@
+//     Keagan Anderson
+//        MagBase
+//       10/19/2026
+//
+//     -analyze estimates the distinct values of a column within the error HyperLogLog allows,
+//     for values that only differ in their last characters too
+
+#include "db-init.h"
+#include "file-lock.h"
+#include "magbase.h"
+#include "stats.h"
+#include "test.h"
+#include <math.h>
+
+#define TEST_PATH "distinct-count-test.mab"
+#define ROWS 20000
+#define COLUMNS 4
+
+// Distinct values of each column, a column holds row % distinct
+static const int32_t distinct[COLUMNS] = {100, 1000, ROWS, 5000};
+
+// Four standard errors of 2^STATS_HLL_BITS registers
+#define TOLERANCE (4 * 1.04 / sqrt(1 << STATS_HLL_BITS))
+
+int main(void) {
+    removeTestDatabase(TEST_PATH);
+    MagbaseOptions options = {.create_if_missing = true};
+    MagbaseDb *db = magbaseOpen(TEST_PATH, &options);
+    CHECK(db != NULL);
+    CHECK(magbaseSetSyncMode(db, MAGBASE_SYNC_OFF) == 0);
+
+    MagbaseColumn columns[COLUMNS] = {{"region", MAGBASE_TEXT, false},
+                                      {"city", MAGBASE_TEXT, false},
+                                      {"customer", MAGBASE_TEXT, false},
+                                      {"zip", MAGBASE_INT, false}};
+    int table_id = magbaseCreateTable(db, "customers", columns, COLUMNS);
+    CHECK(table_id > 0);
+
+    char text[3][32];
+    MagbaseValue values[COLUMNS];
+    for (int32_t row = 0; row < ROWS; row++) {
+        for (int col = 0; col < 3; col++) {
+            snprintf(text[col], sizeof(text[col]), "customer-%06d", (int)(row % distinct[col]));
+            values[col].type = MAGBASE_TEXT;
+            values[col].value.text_val = text[col];
+        }
+        values[3].type = MAGBASE_INT;
+        values[3].value.int_val = row % distinct[3];
+        CHECK(magbaseInsert(db, (uint16_t)table_id, values, COLUMNS) != 0);
+    }
+    CHECK(magbaseClose(db) == 0);
+
+    // The estimates are not part of the library's API, the engine analyzes the table itself
+    MagBase *magBase = openMagBase(TEST_PATH);
+    CHECK(magBase != NULL);
+    CHECK(lockFileWriter(magBase) == 0);
+    TableStats stats;
+    CHECK(analyzeTable(magBase, (uint16_t)table_id, &stats) == 0);
+    CHECK(commitDatabase(magBase) == 0);
+    CHECK(unlockFileWriter(magBase) == 0);
+    freeDatabase(magBase);
+
+    for (int col = 0; col < COLUMNS; col++) {
+        double error = fabs((double)stats.columns[col].distinct_count - distinct[col]) / distinct[col];
+        printf("column %d: %d distinct, estimated %lu\n", col, (int)distinct[col],
+               (unsigned long)stats.columns[col].distinct_count);
+        CHECK(error <= TOLERANCE);
+    }
+
+    removeTestDatabase(TEST_PATH);
+    return 0;
+}
@@ -0,0 +1,83 @@
+//     Keagan Anderson
+//        MagBase
+//       10/19/2026
+//
+//     Threads inserting into one handle at once share syncs of the log. Linked with
+//     --wrap=fdatasync, so every sync is counted and takes a millisecond like a disk would
+
+#include "magbase.h"
+#include "test.h"
+#include <pthread.h>
+#include <stdatomic.h>
+
+#define TEST_PATH "group-commit-test.mab"
+#define THREADS 8
+#define INSERTS 200
+
+static atomic_int syncs;
+
+int __real_fdatasync(int fd);
+
+int __wrap_fdatasync(int fd) {
+    atomic_fetch_add(&syncs, 1);
+    usleep(1000);
+    return __real_fdatasync(fd);
+}
+
+typedef struct {
+    MagbaseDb *db;
+    uint16_t table_id;
+    int32_t thread;
+    int failed;
+} Inserter;
+
+static void *insertRows(void *argument) {
+    Inserter *inserter = argument;
+    MagbaseValue values[2] = {{.type = MAGBASE_INT}, {.type = MAGBASE_INT}};
+    values[0].value.int_val = inserter->thread;
+    for (int32_t row = 0; row < INSERTS; row++) {
+        values[1].value.int_val = row;
+        if (magbaseInsert(inserter->db, inserter->table_id, values, 2) == 0) {
+            inserter->failed = 1;
+        }
+    }
+    return NULL;
+}
+
+int main(void) {
+    removeTestDatabase(TEST_PATH);
+    MagbaseOptions options = {.create_if_missing = true};
+    MagbaseDb *db = magbaseOpen(TEST_PATH, &options);
+    CHECK(db != NULL);
+    CHECK(magbaseSetSyncMode(db, MAGBASE_SYNC_FULL) == 0);
+
+    MagbaseColumn columns[] = {{"thread", MAGBASE_INT, false}, {"row", MAGBASE_INT, false}};
+    int table_id = magbaseCreateTable(db, "commits", columns, 2);
+    CHECK(table_id > 0);
+
+    atomic_store(&syncs, 0);
+    pthread_t threads[THREADS];
+    Inserter inserters[THREADS];
+    for (int32_t thread = 0; thread < THREADS; thread++) {
+        inserters[thread] = (Inserter){db, (uint16_t)table_id, thread, 0};
+        CHECK(pthread_create(&threads[thread], NULL, insertRows, &inserters[thread]) == 0);
+    }
+    for (int thread = 0; thread < THREADS; thread++) {
+        pthread_join(threads[thread], NULL);
+        CHECK(!inserters[thread].failed);
+    }
+
+    // Every insert is its own commit, waiting ones are synced together
+    int commits = THREADS * INSERTS;
+    int synced = atomic_load(&syncs);
+    printf("%d commits, %d syncs\n", commits, synced);
+    CHECK(synced > 0 && synced < commits / 2);
+
+    MagbaseTableStats stats;
+    CHECK(magbaseTableStats(db, (uint16_t)table_id, &stats) == 0);
+    CHECK(stats.row_count == (uint64_t)commits);
+
+    CHECK(magbaseClose(db) == 0);
+    removeTestDatabase(TEST_PATH);
+    return 0;
+}
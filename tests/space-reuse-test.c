@@ -0,0 +1,88 @@
+//     Keagan Anderson
+//        MagBase
+//       10/19/2026
+//
+//     Rewriting every row of a table again and again reuses the space of the old versions
+//     instead of growing the table, with or without a vacuum after each round
+
+#include "magbase.h"
+#include "test.h"
+
+#define TEST_PATH "space-reuse-test.mab"
+#define ROWS 2000
+#define ROUNDS 3
+
+// Count the rows of the table written by a round, the zone map of a reused page has to cover them
+static int countRows(MagbaseDb *db, uint16_t table_id, int32_t round) {
+    char where[32];
+    snprintf(where, sizeof(where), "round=%d", (int)round);
+    const char *conditions[] = {where};
+    MagbaseCursor *cursor = magbaseOpenCursor(db, table_id, conditions, 1);
+    CHECK(cursor != NULL);
+    MagbaseValue values[2];
+    int rows = 0;
+    while (magbaseNext(cursor, NULL, values, 2) == 1) {
+        CHECK(values[1].value.int_val == round);
+        rows++;
+    }
+    magbaseCloseCursor(cursor);
+    return rows;
+}
+
+int main(void) {
+    removeTestDatabase(TEST_PATH);
+    MagbaseOptions options = {.create_if_missing = true};
+    MagbaseDb *db = magbaseOpen(TEST_PATH, &options);
+    CHECK(db != NULL);
+    CHECK(magbaseSetSyncMode(db, MAGBASE_SYNC_OFF) == 0);
+
+    MagbaseColumn columns[] = {{"name", MAGBASE_TEXT, false}, {"round", MAGBASE_INT, false}};
+    int table_id = magbaseCreateTable(db, "rewritten", columns, 2);
+    CHECK(table_id > 0);
+
+    static uint64_t ids[ROWS];
+    MagbaseValue values[2] = {{.type = MAGBASE_TEXT}, {.type = MAGBASE_INT}};
+    values[0].value.text_val = "a row rewritten by every round of the test";
+    values[1].value.int_val = 0;
+    for (int row = 0; row < ROWS; row++) {
+        ids[row] = magbaseInsert(db, (uint16_t)table_id, values, 2);
+        CHECK(ids[row] != 0);
+    }
+
+    MagbaseTableStats stats;
+    CHECK(magbaseTableStats(db, (uint16_t)table_id, &stats) == 0);
+    uint64_t first_pages = stats.page_count;
+
+    for (int32_t round = 1; round <= ROUNDS; round++) {
+        values[1].value.int_val = round;
+        for (int row = 0; row < ROWS; row++) {
+            CHECK(magbaseUpdate(db, (uint16_t)table_id, ids[row], values, 2) == 0);
+        }
+        uint64_t removed = 0;
+        CHECK(magbaseVacuum(db, (uint16_t)table_id, &removed) == 0);
+        CHECK(removed <= ROWS);
+        CHECK(countRows(db, (uint16_t)table_id, round) == ROWS);
+    }
+
+    // A round needs room for one more version of every row, never more
+    CHECK(magbaseTableStats(db, (uint16_t)table_id, &stats) == 0);
+    CHECK(stats.row_count == ROWS);
+    CHECK(stats.page_count <= first_pages * 2 + 1);
+
+    // Without vacuum, updates compact the pages of the versions they replace
+    uint64_t vacuumed_pages = stats.page_count;
+    for (int32_t round = ROUNDS + 1; round <= ROUNDS * 2; round++) {
+        values[1].value.int_val = round;
+        for (int row = 0; row < ROWS; row++) {
+            CHECK(magbaseUpdate(db, (uint16_t)table_id, ids[row], values, 2) == 0);
+        }
+        CHECK(countRows(db, (uint16_t)table_id, round) == ROWS);
+    }
+    CHECK(magbaseTableStats(db, (uint16_t)table_id, &stats) == 0);
+    CHECK(stats.row_count == ROWS);
+    CHECK(stats.page_count <= vacuumed_pages + 1);
+
+    CHECK(magbaseClose(db) == 0);
+    removeTestDatabase(TEST_PATH);
+    return 0;
+}
@@ -0,0 +1,29 @@
+//     Keagan Anderson
+//        MagBase
+//       10/19/2026
+//
+//     Helpers shared by the test programs, each of which is one ctest test that exits 0 when
+//     every check passes
+
+#pragma once
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+// Fail the test with the line of the check that did not hold
+#define CHECK(condition)                                                                   \
+    do {                                                                                   \
+        if (!(condition)) {                                                                \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition);  \
+            exit(1);                                                                       \
+        }                                                                                  \
+    } while (0)
+
+// Remove a database and its log left by an earlier run
+static inline void removeTestDatabase(const char *path) {
+    char wal_path[600];
+    snprintf(wal_path, sizeof(wal_path), "%s-wal", path);
+    unlink(path);
+    unlink(wal_path);
+}
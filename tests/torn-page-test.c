@@ -0,0 +1,82 @@
+//     Keagan Anderson
+//        MagBase
+//       10/19/2026
+//
+//     A page torn by a crash while it is written to the file is rebuilt from the log. Linked
+//     with --wrap=pwrite, so a child process can die half way through writing a page
+
+#include "magbase.h"
+#include "test.h"
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#define TEST_PATH "torn-page-test.mab"
+#define ROWS 300
+
+static int tearing;
+
+ssize_t __real_pwrite(int fd, const void *data, size_t length, off_t offset);
+
+// Once tearing, the first page written to the database file only gets its first half there
+ssize_t __wrap_pwrite(int fd, const void *data, size_t length, off_t offset) {
+    if (tearing && offset > 0 && length >= 1024 && offset % (off_t)length == 0) {
+        __real_pwrite(fd, data, length / 2, offset);
+        _exit(0);
+    }
+    return __real_pwrite(fd, data, length, offset);
+}
+
+static void insertRows(MagbaseDb *db, uint16_t table_id, int32_t first, int32_t count) {
+    MagbaseValue values[2] = {{.type = MAGBASE_TEXT}, {.type = MAGBASE_INT}};
+    values[0].value.text_val = "a row on a page that is torn when it is written";
+    for (int32_t row = first; row < first + count; row++) {
+        values[1].value.int_val = row;
+        CHECK(magbaseInsert(db, table_id, values, 2) != 0);
+    }
+}
+
+int main(void) {
+    removeTestDatabase(TEST_PATH);
+    MagbaseOptions options = {.create_if_missing = true};
+    MagbaseDb *db = magbaseOpen(TEST_PATH, &options);
+    CHECK(db != NULL);
+    MagbaseColumn columns[] = {{"name", MAGBASE_TEXT, false}, {"row", MAGBASE_INT, false}};
+    int table_id = magbaseCreateTable(db, "torn", columns, 2);
+    CHECK(table_id > 0);
+    insertRows(db, (uint16_t)table_id, 0, ROWS);
+    CHECK(magbaseClose(db) == 0);
+
+    // The child commits more rows, then dies writing the pages they changed back on close
+    pid_t child = fork();
+    CHECK(child >= 0);
+    if (child == 0) {
+        db = magbaseOpen(TEST_PATH, &options);
+        CHECK(db != NULL);
+        insertRows(db, (uint16_t)table_id, ROWS, ROWS);
+        tearing = 1;
+        magbaseClose(db);
+        _exit(1);
+    }
+    int status = 0;
+    CHECK(waitpid(child, &status, 0) == child);
+    CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    db = magbaseOpen(TEST_PATH, &options);
+    CHECK(db != NULL);
+    MagbaseCursor *cursor = magbaseOpenCursor(db, (uint16_t)table_id, NULL, 0);
+    CHECK(cursor != NULL);
+    MagbaseValue values[2];
+    int32_t rows = 0;
+    int64_t sum = 0;
+    while (magbaseNext(cursor, NULL, values, 2) == 1) {
+        sum += values[1].value.int_val;
+        rows++;
+    }
+    magbaseCloseCursor(cursor);
+    CHECK(rows == ROWS * 2);
+    CHECK(sum == (int64_t)ROWS * 2 * (ROWS * 2 - 1) / 2);
+
+    CHECK(magbaseClose(db) == 0);
+    removeTestDatabase(TEST_PATH);
+    return 0;
+}
@@ -0,0 +1,96 @@
+//     Keagan Anderson
+//        MagBase
+//       10/19/2026
+//
+//     A vacuum waiting for a cursor keeps neither the reads of the cursor's thread nor other
+//     writers waiting, and runs once the cursor is closed
+
+#include "magbase.h"
+#include "test.h"
+#include <pthread.h>
+#include <time.h>
+
+#define TEST_PATH "vacuum-wait-test.mab"
+#define ROWS 500
+
+// Stays well below the 5 second lock timeout a stalled call ends with
+#define MAX_WAIT_MS 1000
+
+typedef struct {
+    MagbaseDb *db;
+    uint16_t table_id;
+    uint64_t removed;
+    int result;
+} Vacuum;
+
+static long elapsedMs(const struct timespec *start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (long)(now.tv_sec - start->tv_sec) * 1000 + (now.tv_nsec - start->tv_nsec) / 1000000;
+}
+
+static void *runVacuum(void *argument) {
+    Vacuum *vacuum = argument;
+    vacuum->result = magbaseVacuum(vacuum->db, vacuum->table_id, &vacuum->removed);
+    return NULL;
+}
+
+int main(void) {
+    removeTestDatabase(TEST_PATH);
+    MagbaseOptions options = {.create_if_missing = true};
+    MagbaseDb *db = magbaseOpen(TEST_PATH, &options);
+    CHECK(db != NULL);
+    CHECK(magbaseSetSyncMode(db, MAGBASE_SYNC_OFF) == 0);
+
+    MagbaseColumn columns[] = {{"name", MAGBASE_TEXT, false}, {"version", MAGBASE_INT, false}};
+    int table_id = magbaseCreateTable(db, "versions", columns, 2);
+    CHECK(table_id > 0);
+
+    static uint64_t ids[ROWS];
+    MagbaseValue values[2] = {{.type = MAGBASE_TEXT}, {.type = MAGBASE_INT}};
+    values[0].value.text_val = "a row updated once before the vacuum";
+    values[1].value.int_val = 0;
+    for (int row = 0; row < ROWS; row++) {
+        ids[row] = magbaseInsert(db, (uint16_t)table_id, values, 2);
+        CHECK(ids[row] != 0);
+    }
+
+    // Every update leaves an old version for the vacuum, the open cursor keeps pages from being
+    // compacted meanwhile
+    MagbaseCursor *cursor = magbaseOpenCursor(db, (uint16_t)table_id, NULL, 0);
+    CHECK(cursor != NULL);
+    values[1].value.int_val = 1;
+    for (int row = 0; row < ROWS; row++) {
+        CHECK(magbaseUpdate(db, (uint16_t)table_id, ids[row], values, 2) == 0);
+    }
+    Vacuum vacuum = {db, (uint16_t)table_id, 0, -1};
+    pthread_t thread;
+    CHECK(pthread_create(&thread, NULL, runVacuum, &vacuum) == 0);
+    usleep(50000);
+
+    // The thread of the cursor reads the table and inserts into it while the vacuum waits
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    MagbaseValue read_values[2];
+    CHECK(magbaseRead(db, (uint16_t)table_id, ids[0], read_values, 2) == 0);
+    CHECK(read_values[1].value.int_val == 1);
+    CHECK(magbaseInsert(db, (uint16_t)table_id, values, 2) != 0);
+    printf("read and insert beside the waiting vacuum took %ld ms\n", elapsedMs(&start));
+    CHECK(elapsedMs(&start) < MAX_WAIT_MS);
+
+    int rows = 0;
+    while (magbaseNext(cursor, NULL, read_values, 2) == 1) {
+        rows++;
+    }
+    CHECK(rows == ROWS);
+    magbaseCloseCursor(cursor);
+
+    pthread_join(thread, NULL);
+    printf("vacuum removed %lu row versions\n", (unsigned long)vacuum.removed);
+    CHECK(vacuum.result == 0);
+    CHECK(vacuum.removed == ROWS);
+
+    CHECK(magbaseClose(db) == 0);
+    removeTestDatabase(TEST_PATH);
+    return 0;
+}
@@ -0,0 +1,76 @@
+//     Keagan Anderson
+//        MagBase
+//       10/19/2026
+//
+//     Zone maps over a page written more often than a 16 bit count can hold still let filtered
+//     scans find every row of it
+
+#include "magbase.h"
+#include "test.h"
+#include <string.h>
+
+#define TEST_PATH "zone-map-test.mab"
+#define WRITES 70000
+
+// Count the rows of the table matching where
+static int countMatches(MagbaseDb *db, uint16_t table_id, const char *where, int32_t *value) {
+    MagbaseCursor *cursor = magbaseOpenCursor(db, table_id, &where, 1);
+    CHECK(cursor != NULL);
+    MagbaseValue values[2];
+    int matches = 0;
+    while (magbaseNext(cursor, NULL, values, 2) == 1) {
+        *value = values[0].value.int_val;
+        matches++;
+    }
+    magbaseCloseCursor(cursor);
+    return matches;
+}
+
+int main(void) {
+    removeTestDatabase(TEST_PATH);
+    MagbaseOptions options = {.create_if_missing = true};
+    MagbaseDb *db = magbaseOpen(TEST_PATH, &options);
+    CHECK(db != NULL);
+    CHECK(magbaseSetSyncMode(db, MAGBASE_SYNC_OFF) == 0);
+
+    MagbaseColumn columns[] = {{"a", MAGBASE_INT, false}, {"b", MAGBASE_TEXT, false}};
+    int table_id = magbaseCreateTable(db, "zones", columns, 2);
+    CHECK(table_id > 0);
+
+    MagbaseValue values[2] = {{.type = MAGBASE_INT}, {.type = MAGBASE_TEXT}};
+    values[1].value.text_val = "kept";
+    values[0].value.int_val = 100;
+    CHECK(magbaseInsert(db, (uint16_t)table_id, values, 2) != 0);
+    values[1].value.text_val = "rewritten";
+    values[0].value.int_val = 5;
+    uint64_t rewritten = magbaseInsert(db, (uint16_t)table_id, values, 2);
+    CHECK(rewritten != 0);
+
+    // Compaction keeps every version on the first page, its counts pass 65535
+    for (int write = 0; write < WRITES; write++) {
+        CHECK(magbaseDelete(db, (uint16_t)table_id, rewritten) == 0);
+        rewritten = magbaseInsert(db, (uint16_t)table_id, values, 2);
+        CHECK(rewritten != 0);
+    }
+
+    // Fill the first page so the table gets a second one, the last page is never pruned
+    MagbaseTableStats stats;
+    values[0].value.int_val = 7;
+    for (int row = 0; row < 10000; row++) {
+        CHECK(magbaseTableStats(db, (uint16_t)table_id, &stats) == 0);
+        if (stats.page_count > 1) {
+            break;
+        }
+        CHECK(magbaseInsert(db, (uint16_t)table_id, values, 2) != 0);
+    }
+    CHECK(stats.page_count > 1);
+
+    int32_t value = 0;
+    CHECK(countMatches(db, (uint16_t)table_id, "a=100", &value) == 1 && value == 100);
+    CHECK(countMatches(db, (uint16_t)table_id, "a<6", &value) == 1 && value == 5);
+    CHECK(countMatches(db, (uint16_t)table_id, "a>50", &value) == 1 && value == 100);
+
+    CHECK(magbaseClose(db) == 0);
+    removeTestDatabase(TEST_PATH);
+    return 0;
+}